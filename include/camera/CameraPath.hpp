@@ -0,0 +1,85 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "Camera.hpp"
+#include "CinematicCamera.hpp"
+
+/**
+ * One key of a camera timeline
+ */
+struct CameraKeyframe {
+  double time = 0.0;      // Seconds from the start of the path
+  Vector3 position;
+  Vector3 target;         // Look-at point (default: the black hole)
+  double fov = 60.0;      // Field of view in degrees
+  double roll = 0.0;      // Degrees around the view direction
+};
+
+/**
+ * Keyframed camera timeline, evaluable at any absolute time
+ *
+ * Position, target, fov and roll follow C1 cubic Hermite splines through the
+ * keys (Catmull-Rom tangents taken over the key times). Tangents are computed
+ * once when the keys change; a pose is a binary search over the key times plus
+ * one segment evaluation, so any frame can be seeked without replaying the
+ * path from the start.
+ *
+ * Timelines are read from JSON:
+ *   {"keyframes": [{"time": 0, "position": [0, 3, -20], "target": [0, 0, 0], "fov": 60, "roll": 0}, ...]}
+ * (target, fov and roll are optional), or from the binary .campath format
+ * written by save().
+ */
+class CameraPath {
+public:
+  // Load a .campath file, or JSON for any other extension. On failure the path
+  // is left unchanged and `error` says why
+  bool load(const std::string &path, std::string &error);
+
+  // Write the keys as .campath (binary) or JSON, chosen by the extension
+  bool save(const std::string &path) const;
+
+  // Replace the keys (sorted by time; a key at the same time as another replaces it)
+  void setKeyframes(std::vector<CameraKeyframe> keys);
+  const std::vector<CameraKeyframe> &getKeyframes() const { return keyframes; }
+
+  bool empty() const { return keyframes.empty(); }
+  double duration() const { return keyframes.empty() ? 0.0 : times.back(); }
+
+  // Camera at `time` seconds (clamped to the first/last key); an empty path
+  // gives the default view of the hole
+  Camera evaluate(double time) const;
+
+  // Cameras of frames [firstFrame, firstFrame + count) at `fps`, as one contiguous
+  // array in frame order. Frames walk the segments forward, so only the first
+  // frame needs a search
+  void evaluateFrames(int firstFrame, int count, int fps, std::vector<Camera> &poses) const;
+
+  // Sample a built-in cinematic mode into keys every `keyInterval` seconds, so
+  // it can be saved and edited as a timeline. Discontinuities in the mode
+  // (the rising spiral's height reset) become a fast move between two keys
+  static CameraPath fromCinematic(CinematicMode mode, const Camera &start, double duration, double keyInterval);
+
+private:
+  // Spline channels of a key, packed so each segment reads two contiguous entries
+  struct Tangent {
+    Vector3 position;
+    Vector3 target;
+    double fov = 0.0;
+    double roll = 0.0;
+  };
+
+  std::vector<CameraKeyframe> keyframes;
+  std::vector<double> times;       // Key times alone, for the search
+  std::vector<Tangent> tangents;   // d/dt of every channel at each key
+
+  void computeTangents();
+  size_t segmentAt(double time) const;
+  Camera evaluateSegment(size_t segment, double time) const;
+
+  bool parseJSON(const std::string &text, std::vector<CameraKeyframe> &keys, std::string &error) const;
+  bool saveJSON(const std::string &path) const;
+  bool saveBinary(const std::string &path) const;
+  bool loadBinary(const std::string &path, std::vector<CameraKeyframe> &keys, std::string &error) const;
+  static bool isBinaryPath(const std::string &path);
+};
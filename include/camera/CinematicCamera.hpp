@@ -21,11 +21,15 @@ public:
   CinematicCamera(Camera &camera, const Vector3 &initialPosition);
   
   // Update camera position based on current mode and delta time
+  // keyStates is indexed by SDL scancode; nullptr means no input (headless rendering)
   void update(double deltaTime, const uint8_t *keyStates);
   
   // Cycle to next cinematic mode
   void cycleMode();
   
+  // Switch to a specific mode (restarts its motion like cycleMode)
+  void setMode(CinematicMode newMode);
+  
   // Get current mode
   CinematicMode getMode() const { return mode; }
   
@@ -57,7 +61,7 @@ private:
   
   // Update camera look direction based on rotation
   // Rotations are applied incrementally each frame only when keys are pressed
-  void updateCameraLookDirection(double deltaTime);
+  void updateCameraLookDirection(double deltaTime, const uint8_t *keyStates);
 };
 
 // Helper function to get mode name from enum
@@ -3,13 +3,20 @@
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_ttf.h>
 #include <SDL2/SDL_mixer.h>
+#include <chrono>
+#include <deque>
+#include <future>
 #include "../camera/Camera.hpp"
 #include "../camera/CinematicCamera.hpp"
 #include "../ui/HUD.hpp"
 #include "../rendering/MetalRTRenderer.h"
+#include "../rendering/CPURenderer.hpp"
 #include "../physics/BlackHole.hpp"
 #include "../utils/ResolutionManager.hpp"
+#include "../utils/QualityController.hpp"
 #include "../utils/VideoRecorder.hpp"
+#include "../utils/FrameProfiler.hpp"
+#include "../utils/ScreenshotWriter.hpp"
 
 /**
  * Main application class managing the simulation lifecycle
@@ -24,6 +31,24 @@ public:
   
   // Main application loop
   void run();
+  
+  // Trace on the CPU reference renderer instead of Metal (call before initialize)
+  void setCPURendering(bool enabled) { forceCPURendering = enabled; }
+  
+  // Stream per-stage frame timings to a CSV or Chrome trace (.json) file (call before initialize)
+  void setProfileExport(const std::string &path) { profileExportPath = path; }
+  
+  // Stream the clean render to a URL or HLS playlist as soon as the music has loaded (call before initialize)
+  void setStreamOutput(const std::string &url) { streamOutput = url; }
+
+  // Sky image for the Metal renderer instead of the procedural starfield (call before initialize)
+  void setSkybox(const std::string &path) { skyboxPath = path; }
+
+  // Per-frame renderer logging, for --xray sessions (call before initialize)
+  void setVerboseLogging(bool enabled) { verboseLogging = enabled; }
+
+  // Deflate level of screenshots (PNG_STORED, PNG_FAST or PNG_DEFAULT); -1 picks it by frame size
+  void setScreenshotCompression(int level) { screenshotCompression = level; }
 
 private:
   // SDL components
@@ -34,7 +59,12 @@ private:
   
   // Rendering
   MetalRTRenderer *gpuRenderer;
-  SDL_Texture *gpuTexture;
+  SDL_Texture *gpuTexture;      // Readback fallback only (unused with GPU presentation)
+  void *metalLayer;             // SDL renderer's CAMetalLayer, null if not the Metal backend
+  bool gpuPresentation;         // Draw frames straight into the SDL Metal drawable
+  CPURenderer *cpuRenderer;     // Used instead of gpuRenderer when Metal is unavailable
+  bool forceCPURendering;
+  bool verboseLogging;
   
   // Simulation components
   BlackHole *blackHole;
@@ -42,7 +72,16 @@ private:
   CinematicCamera *cinematicCamera;
   HUD *hud;
   ResolutionManager *resolutionManager;
+  QualityController *qualityController; // Automatic render scale (dynamic quality)
   VideoRecorder *videoRecorder;
+  ScreenshotWriter *screenshotWriter; // Encodes screenshots off the main thread
+  int screenshotCompression; // -1 = ScreenshotWriter::compressionLevelFor
+  std::deque<long> recordingReadbacks; // Software recording: GPU frame copies not handed to the recorder yet
+  FrameProfiler *frameProfiler; // Per-stage frame timings (graph toggled with P)
+  std::string profileExportPath;
+  std::string streamOutput; // Live stream target (see VideoRecorder::isStreamURL), empty = none
+  bool streamStarted;
+  std::string skyboxPath; // See metal_rt_renderer_load_skybox, empty = procedural starfield
   
   // Window properties (dynamic)
   int windowWidth;
@@ -58,29 +97,53 @@ private:
   bool isRecording;
   int colorMode; // 0=blue, 1=orange, 2=red, 3=white
   float colorIntensity; // Brightness multiplier for accretion disk (default 1.0)
+  int traceMode; // Ray tracing strategy (METAL_RT_TRACE_*)
+  float integratorTolerance; // Adaptive Binet step error bound (cycled with B)
+  float spin; // Kerr a / M of the hole (,/. keys, Metal only)
+  float exposure; // Linear exposure before tone mapping ([/] keys, half a stop per press)
+  bool paused; // Space: scene time and camera frozen, so the Metal renderer refines the still frame
+  double pausedDuration; // Wall-clock seconds spent paused (subtracted from the scene time)
+  bool foveatedRendering; // Coarse tile pass with selective full-resolution tracing
   bool isMusicMuted; // Music mute state
   float currentMusicVolume; // Current music volume (0.0 to 1.0)
   float targetMusicVolume; // Target music volume for fading
   bool isMusicFading; // Whether music is currently fading
+  bool showProfiler; // Frame timing graph overlay
+  bool diagnosticsView; // Step count heatmap instead of the image (Metal only)
   double currentElapsedTime; // Current elapsed time for rendering (updated each frame)
+  long lastDisplayedFrame; // Last frame index fed to the quality controller
+
+  // Startup: font and music load in the background while the first frames render
+  std::chrono::high_resolution_clock::time_point launchTime; // Start of initialize
+  bool firstFrameShown; // Time to first frame has been logged
+  std::future<TTF_Font *> fontLoad;
+  std::future<Mix_Music *> musicLoad;
   
   // Private methods
   void handleEvents();
+  void pollStartupAssets(); // Hand finished background loads to the HUD and the mixer
   void update(double deltaTime);
   void render(double elapsedTime);
+  bool presentFrame(const SDL_Rect &dstRect);
+  void presentFrameWithReadback(const SDL_Rect &dstRect);
   void updateWindowTitle();
   void cleanup();
   void toggleFullscreen();
   void handleWindowResize(int width, int height);
   void recreateRenderTargets();
   void changeResolution(bool increase);
+  void applyQualityScale();
   
   // Video recording
   void startRecording();
   void stopRecording();
+  void drainRecordingReadbacks(size_t keep); // Pass finished readbacks to the recorder, waiting on the GPU only while more than `keep` are in flight
+  
+  // Screenshot (encoded in the background); hdr also writes the linear color as a float TIFF
+  void takeScreenshot(bool hdr = false);
   
-  // Screenshot
-  void takeScreenshot();
+  // Heatmap PNG plus raw per-pixel diagnostics (PFM) of a full-resolution frame
+  void saveDiagnostics();
   
   // Helper to convert camera data for GPU
   void prepareCameraData(CameraData &data);
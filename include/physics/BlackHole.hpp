@@ -1,4 +1,6 @@
 #pragma once
+#include "DiskShadingLUT.hpp"
+#include "../utils/SimdFloat.hpp"
 #include "../utils/Vector3.hpp"
 #include <vector>
 
@@ -7,18 +9,61 @@ public:
   double mass;
   double rs; // Schwarzschild radius
 
+  // Rays integrated together by tracePacket (SIMD width; the same for the
+  // portable and AVX2 paths on x86)
+  static constexpr int PACKET_SIZE = SimdFloat::LANES;
+
+  // Structure-of-arrays bundle of rays for tracePacket
+  struct RayPacket {
+    float originX[PACKET_SIZE], originY[PACKET_SIZE], originZ[PACKET_SIZE];
+    float dirX[PACKET_SIZE], dirY[PACKET_SIZE], dirZ[PACKET_SIZE];  // Normalized
+    float red[PACKET_SIZE], green[PACKET_SIZE], blue[PACKET_SIZE];  // Output: linear color
+  };
+
   BlackHole(double mass = 1.0);
 
-  // Integrate a ray and return the final accumulated color
-  Vector3 trace(const Ray &ray, double stepSize = 0.1,
-                double maxDist = 100.0) const;
+  // Integrate a ray and return the final accumulated color (volumetric mode,
+  // mirrors trace_ray in RayTracing.metal; reference for validating the shader)
+  Vector3 trace(const Ray &ray, double time = 0.0, int colorMode = 0, double colorIntensity = 1.0,
+                double stepSize = 0.1, double maxDist = 100.0) const;
+
+  // Same integration for PACKET_SIZE rays at once: RK4 steps run in single
+  // precision SIMD (like the shader), disk shading and the background per lane
+  void tracePacket(RayPacket &packet, double time = 0.0, int colorMode = 0, double colorIntensity = 1.0) const;
+
+  // Local error bound per adaptive Binet step, relative to the horizon's u = 1/rs
+  static constexpr double DEFAULT_INTEGRATOR_TOLERANCE = 1e-6;
+
+  // Adaptive trace (mirrors trace_ray_binet in RayTracing.metal): the orbit
+  // u(phi) in the ray's plane is integrated with error-controlled
+  // Dormand-Prince 5(4) steps and the disk is shaded as a slab where the orbit
+  // crosses it. Far fewer steps than trace for the same accuracy
+  Vector3 traceBinet(const Ray &ray, double time = 0.0, int colorMode = 0, double colorIntensity = 1.0,
+                     double tolerance = DEFAULT_INTEGRATOR_TOLERANCE) const;
 
 private:
+  static constexpr double MIN_STEP = 0.02;
+  static constexpr double MAX_STEP = 0.5;
+
+  // tracePacket for one SimdFloat implementation (see SimdFloat.hpp)
+  template <typename Float, typename Mask>
+  void tracePacketLanes(RayPacket &packet, double time, int colorMode, double colorIntensity) const;
+#if SIMD_FLOAT_AVX2
+  void tracePacketAVX2(RayPacket &packet, double time, int colorMode, double colorIntensity) const;
+#endif
+
+  DiskShadingLUT diskShading; // Same tables as the shader's blackbody palette
+
   Vector3 acceleration(const Vector3 &pos, const Vector3 &vel) const;
 
   // Helper for accretion disk texture/noise
-  double diskDensity(const Vector3 &pos) const;
-  Vector3 diskColor(double density, double r, const Vector3 &pos, const Vector3 &rayDir, int colorMode = 0) const;
+  double diskDensity(const Vector3 &pos, double time) const;
+  Vector3 diskColor(double density, double r, const Vector3 &pos, const Vector3 &rayDir, int colorMode,
+                    double colorIntensity) const;
   double dopplerFactor(const Vector3 &pos, const Vector3 &rayDir) const;
-  Vector3 sampleBackground(const Vector3 &dir) const;
+  Vector3 sampleBackground(const Vector3 &dir, double time) const;
+
+  // Shade one step of a lane inside the disk slab (Beer's law, like trace)
+  void accumulateDisk(const Vector3 &pos, const Vector3 &dir, double time, int colorMode, double colorIntensity,
+                      double stepSize, Vector3 &color, double &transmittance) const;
 };
@@ -0,0 +1,54 @@
+#pragma once
+#include <vector>
+
+/**
+ * Precomputed tables for the blackbody disk palette (colour mode 4)
+ *
+ * The disk radiates as a blackbody at a Novikov-Thorne style temperature,
+ * T(r)^4 ~ r^-3 (1 - sqrt(r_in / r)) with zero torque at the inner edge,
+ * normalized so the hottest ring is at PEAK_TEMPERATURE. Light reaching the
+ * camera is shifted by g = delta * sqrt(1 - RS / r) (Doppler times
+ * gravitational redshift); I_nu / nu^3 is invariant, so what arrives is again
+ * a blackbody, at g * T. Everything that only depends on r or T is tabulated
+ * here, leaving one fetch from each table per disk sample.
+ *
+ * Layout (must match the DISK_PROFILE_* and BLACKBODY_* constants in RayTracing.metal):
+ *  - profileTable[i]:   {T / PEAK_TEMPERATURE, sqrt(1 - RS / r), beta, gamma} at
+ *                       r = inner + (outer - inner) * i / (PROFILE_SAMPLES - 1),
+ *                       beta and gamma of the Keplerian orbit (as doppler_factor)
+ *  - blackbodyTable[i]: linear sRGB radiance {r, g, b, 1} of a blackbody at
+ *                       T = MIN_TEMPERATURE * (MAX_TEMPERATURE / MIN_TEMPERATURE)^(i / (BLACKBODY_SAMPLES - 1)),
+ *                       scaled to luminance 1 at PEAK_TEMPERATURE
+ */
+class DiskShadingLUT {
+public:
+  static constexpr int PROFILE_SAMPLES = 256;
+  static constexpr int BLACKBODY_SAMPLES = 256;
+  static constexpr double MIN_TEMPERATURE = 500.0; // Kelvin
+  static constexpr double MAX_TEMPERATURE = 50000.0;
+  static constexpr double PEAK_TEMPERATURE = 9000.0;
+  static constexpr double MAX_ORBITAL_BETA = 0.5; // Same cap as doppler_factor
+
+  std::vector<float> profileTable;   // PROFILE_SAMPLES x 4
+  std::vector<float> blackbodyTable; // BLACKBODY_SAMPLES x 4
+
+  DiskShadingLUT(double mass, double innerRadius, double outerRadius);
+
+  // Fill both tables (well under a millisecond)
+  void build();
+
+  // Table lookups with linear interpolation, clamped at the ends like the GPU sampler
+  void profileAt(double r, float out[4]) const;
+  void blackbodyAt(double kelvin, float out[3]) const;
+
+  double radiusForSample(int i) const;
+  static double temperatureForSample(int i);
+
+private:
+  double mass;
+  double innerRadius;
+  double outerRadius;
+
+  // Planck spectrum integrated against the CIE 1931 observer, in linear sRGB (unscaled)
+  static void planckRGB(double kelvin, double rgb[3]);
+};
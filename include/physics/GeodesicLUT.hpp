@@ -0,0 +1,48 @@
+#pragma once
+#include <vector>
+
+/**
+ * Precomputed Schwarzschild photon orbits (geometrized units, RS = 2 * mass)
+ *
+ * A photon's orbit only depends on its impact parameter b. Every orbit is the
+ * inbound branch of the Binet equation u'' + u = 3 * mass * u^2 (u = 1/r, ' = d/dphi)
+ * swept from infinity to periapsis - or to the horizon for captured rays - plus
+ * its mirror image. The tables below describe that inbound branch, so they do
+ * not depend on the camera and only need to be built once.
+ *
+ * Layout (must match the LUT_* constants in RayTracing.metal):
+ *  - rows: impact parameter; the first CAPTURED_ROWS rows cover b < b_crit,
+ *    the rest b > b_crit, both clustered quadratically towards b_crit
+ *  - radiusTable[row][i]: u at phi = Phi(b) * t, t = i / (BRANCH_SAMPLES - 1)
+ *  - angleTable[row][i]:  phi at u = uEnd(b) * (1 - (1 - w)^2), w = i / (BRANCH_SAMPLES - 1)
+ *  - branchTable[row]:    {Phi(b), uEnd(b)} - total inbound sweep and final u
+ *    (uploaded as a one-column texture so rows line up with the other tables)
+ */
+class GeodesicLUT {
+public:
+  static constexpr int IMPACT_SAMPLES = 512;
+  static constexpr int CAPTURED_ROWS = 256;
+  static constexpr int BRANCH_SAMPLES = 256;
+  static constexpr double MAX_IMPACT = 64.0;
+  static constexpr double CRITICAL_EPSILON = 1e-3; // Gap kept around b_crit (relative)
+
+  std::vector<float> radiusTable; // IMPACT_SAMPLES x BRANCH_SAMPLES
+  std::vector<float> angleTable;  // IMPACT_SAMPLES x BRANCH_SAMPLES
+  std::vector<float> branchTable; // IMPACT_SAMPLES x 2
+
+  explicit GeodesicLUT(double mass = 1.0);
+
+  // Integrate every row (a few tens of milliseconds)
+  void build();
+
+  // Impact parameter sampled by a table row
+  double impactForRow(int row) const;
+
+  // Critical impact parameter 3 * sqrt(3) * mass (photon sphere)
+  double criticalImpact() const;
+
+private:
+  double mass;
+
+  void buildRow(int row);
+};
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+#include "../camera/CinematicCamera.hpp"
+#include "MetalRTRenderer.h"
+
+/**
+ * Settings of a benchmark run over fixed camera poses and resolution presets
+ */
+struct BenchmarkSettings {
+  std::vector<int> presets;  // ResolutionManager::PRESETS indices (empty = all)
+  int warmupFrames = 3;      // Untimed frames per case (pipeline variants, caches, clocks)
+  int frames = 10;           // Timed frames per case
+  int traceMode = METAL_RT_TRACE_VOLUMETRIC;
+  int colorMode = 0;
+  float colorIntensity = 1.0f;
+  std::string outputPath = "bench.json";
+  std::string baselinePath;    // Empty = no comparison
+  double threshold = 5.0;      // Allowed GPU time increase over the baseline, in percent
+};
+
+/**
+ * Timings of one pose at one resolution
+ */
+struct BenchmarkResult {
+  std::string name;         // "<preset>/<camera mode>@<time>", stable across runs
+  int width = 0;
+  int height = 0;
+  double gpuMs = 0.0;       // Median GPU time per frame
+  double gpuMsMin = 0.0;
+  double gpuMsMax = 0.0;
+  double readbackMs = 0.0;  // Median GPU->CPU copy of the finished frame
+  double raysPerSecond = 0.0;
+  double meanSteps = 0.0;   // Integration steps per pixel (diagnostics frame)
+  double stepsPerSecond = 0.0;
+};
+
+/**
+ * Headless, reproducible benchmark of the ray tracing kernel
+ *
+ * Every case renders the same camera pose: each cinematic path is stepped at
+ * a fixed 1/60 s timestep from its start up to fixed times, so the poses do
+ * not depend on wall-clock time or the machine. The geodesic cache,
+ * foveation and repeated-frame detection (progressive refinement) are off, so
+ * every timed frame traces every pixel. Steps per pixel come from one extra frame with diagnostics enabled (which slows the kernel,
+ * so it is not timed); steps/s divides them by the median GPU time.
+ */
+class BenchmarkRunner {
+public:
+  explicit BenchmarkRunner(const BenchmarkSettings &settings);
+  ~BenchmarkRunner();
+
+  // Run every case, write settings.outputPath and compare against the baseline.
+  // Returns false on failure or if any case regressed past the threshold
+  bool run();
+
+  const std::vector<BenchmarkResult> &getResults() const { return results; }
+
+private:
+  struct Pose {
+    CinematicMode mode;
+    double time;  // Seconds along the path (also the shader time)
+  };
+
+  BenchmarkSettings settings;
+  MetalRTRenderer *renderer;
+  std::vector<BenchmarkResult> results;
+  std::string deviceName;
+
+  static std::vector<Pose> poses();
+  bool runCase(const Pose &pose, int width, int height, const char *presetName, BenchmarkResult &result);
+  bool writeJSON(const std::string &path) const;
+
+  // "name WxH" -> median GPU ms of a file written by writeJSON, plus its device
+  // and trace mode (-1 if missing); false if unreadable
+  static bool readBaseline(const std::string &path, std::map<std::string, double> &gpuMs, std::string &device,
+                           int &traceMode);
+  bool compareBaseline() const;
+};
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "../physics/BlackHole.hpp"
+#include "../utils/WorkStealingPool.hpp"
+#include "MetalRTRenderer.h"
+
+/**
+ * CPU reference renderer (volumetric and adaptive Binet trace modes)
+ *
+ * Fallback when Metal is unavailable and golden reference for shader changes.
+ * Rows are spread across all cores by a work-stealing pool; within a row,
+ * BlackHole::tracePacket integrates BlackHole::PACKET_SIZE adjacent pixels at
+ * once (volumetric) or BlackHole::traceBinet traces them one by one. Camera
+ * rays, tone mapping and the output format match the Metal renderer, so
+ * getPixels can be used wherever metal_rt_renderer_get_pixels is.
+ */
+class CPURenderer {
+public:
+  CPURenderer(int width, int height, unsigned threadCount = 0);
+
+  // Reallocate the output for a new render size
+  void resize(int width, int height);
+
+  // METAL_RT_TRACE_VOLUMETRIC or METAL_RT_TRACE_ADAPTIVE_BINET; returns false for other modes
+  bool setTraceMode(int mode);
+  int getTraceMode() const { return traceMode; }
+
+  // Step error bound of the adaptive Binet mode (see metal_rt_renderer_set_integrator_tolerance)
+  void setIntegratorTolerance(float tolerance);
+
+  // Linear exposure before tone mapping (see metal_rt_renderer_set_exposure)
+  void setExposure(float exposure);
+
+  // Trace a full frame (blocks until done)
+  void render(const CameraData &camera, float time, int colorMode, float colorIntensity);
+
+  // BGRA8 pixels of the last frame, width * 4 bytes per row
+  const void *getPixels() const { return pixels.data(); }
+
+  int getWidth() const { return width; }
+  int getHeight() const { return height; }
+  unsigned getThreadCount() const { return pool.getThreadCount(); }
+
+  // Wall-clock time of the last render in milliseconds
+  double getLastFrameTimeMs() const { return lastFrameMs; }
+
+private:
+  BlackHole blackHole;
+  WorkStealingPool pool;
+  int width;
+  int height;
+  std::vector<uint8_t> pixels;
+  double lastFrameMs;
+  int traceMode;
+  double integratorTolerance;
+  float exposure;
+
+  void renderRow(int y, const CameraData &camera, float time, int colorMode, float colorIntensity);
+};
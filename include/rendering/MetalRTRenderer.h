@@ -2,6 +2,7 @@
 #define METAL_RT_RENDERER_H
 
 #include <stddef.h>
+#include <stdbool.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -19,28 +20,237 @@ typedef struct {
   float fov;
 } CameraData;
 
-// Create Metal renderer
+// Ray tracing strategies (must match TRACE_* in RayTracing.metal)
+enum {
+  METAL_RT_TRACE_VOLUMETRIC = 0,      // Sample disk density at every integration step
+  METAL_RT_TRACE_DISK_CROSSING = 1,   // Shade only at refined disk-plane crossings
+  METAL_RT_TRACE_GEODESIC_LUT = 2,    // Look up precomputed Schwarzschild orbits
+  METAL_RT_TRACE_ADAPTIVE_BINET = 3,  // Error-controlled integration of the orbit u(phi) per ray
+  METAL_RT_TRACE_MODE_COUNT
+};
+
+// Default local error bound of the adaptive Binet integrator (see set_integrator_tolerance)
+#define METAL_RT_DEFAULT_INTEGRATOR_TOLERANCE 1e-6f
+
+// Why a ray's trace stopped (diagnostics view, must match TERMINATION_* in RayTracing.metal)
+enum {
+  METAL_RT_TERMINATION_ESCAPED = 0,    // Outbound past the disk, or reached infinity
+  METAL_RT_TERMINATION_HORIZON = 1,    // Crossed the event horizon
+  METAL_RT_TERMINATION_OPAQUE = 2,     // Transmittance hit the 0.01 cutoff (volumetric)
+  METAL_RT_TERMINATION_EXHAUSTED = 3,  // MAX_DIST or the step budget ran out first
+  METAL_RT_TERMINATION_COUNT
+};
+
+// Per-frame totals of the diagnostics view
+typedef struct {
+  double meanSteps;  // Integration steps per pixel
+  int p99Steps;
+  int maxSteps;
+  double terminationFraction[METAL_RT_TERMINATION_COUNT];  // Share of pixels per METAL_RT_TERMINATION_*
+  long frameIndex;  // Frame the totals were measured on
+} RayDiagnostics;
+
+// Pixels of a finished asynchronous capture (valid until the capture is released)
+typedef struct {
+  const void *pixels;      // BGRA8, bytesPerRow apart
+  const float *hdrPixels;  // Linear RGBA32F before tone mapping, hdrBytesPerRow apart (nullptr if not requested)
+  int width;
+  int height;
+  size_t bytesPerRow;
+  size_t hdrBytesPerRow;
+} MetalRTCapture;
+
+// Create Metal renderer on the system default device
 MetalRTRenderer *metal_rt_renderer_create(int width, int height);
 
+// Multi-GPU: devices are numbered in MTLCopyAllDevices order
+int metal_rt_renderer_get_device_count(void);
+
+// Writes the device name (flagged external/low power) into name; false if the index is invalid
+bool metal_rt_renderer_get_device_name(int deviceIndex, char *name, size_t size);
+
+// Create a renderer on a specific device (-1 = system default). Renderers are
+// independent, so one per device can render different frames or tiles concurrently
+MetalRTRenderer *metal_rt_renderer_create_on_device(int deviceIndex, int width, int height);
+
 // Destroy Metal renderer
 void metal_rt_renderer_destroy(MetalRTRenderer *renderer);
 
 // Resize renderer (recreates textures and buffers)
 void metal_rt_renderer_resize(MetalRTRenderer *renderer, int width, int height);
 
-// Render a frame
+// Dynamic quality: trace new frames into the top-left width x height sub-rect of
+// the output texture (clamped to the renderer size). No reallocation; presentation
+// and readback use the sub-rect of whichever frame is displayed
+void metal_rt_renderer_set_viewport(MetalRTRenderer *renderer, int width, int height);
+
+// Size of the sub-rect holding the displayed frame
+void metal_rt_renderer_get_displayed_size(MetalRTRenderer *renderer, int *width, int *height);
+
+// GPU execution time (GPUEndTime - GPUStartTime) of the latest completed frame, in ms
+double metal_rt_renderer_get_gpu_time_ms(MetalRTRenderer *renderer);
+
+// Render a frame (synchronous: submits, waits for the GPU and makes it the displayed frame)
 void metal_rt_renderer_render(MetalRTRenderer *renderer,
                               const CameraData *camera, float time, int colorMode, float colorIntensity);
 
-// Get output texture data (RGBA8)
+// Asynchronous frame pipeline (triple-buffered)
+// begin_frame encodes and commits a frame without waiting for the GPU; it only
+// blocks when two frames are already in flight. Returns the frame index, or -1 on error.
+long metal_rt_renderer_begin_frame(MetalRTRenderer *renderer,
+                                   const CameraData *camera, float time, int colorMode, float colorIntensity);
+
+// Latch the newest frame the GPU has finished as the displayed frame (used by
+// present/get_pixels). Returns the displayed frame index, or -1 if none has completed yet
+long metal_rt_renderer_acquire_completed(MetalRTRenderer *renderer);
+
+// Block until frame `frameIndex` (returned by begin_frame) has finished and latch
+// exactly that frame as the displayed one, even if newer frames completed too.
+// Used by offline sequences, which must encode every frame in order.
+// Returns false if the frame failed or its slot was already reused
+bool metal_rt_renderer_display_frame(MetalRTRenderer *renderer, long frameIndex);
+
+// Block until every submitted frame has finished on the GPU
+void metal_rt_renderer_wait_idle(MetalRTRenderer *renderer);
+
+// Get output texture data (BGRA8, matches SDL_PIXELFORMAT_ARGB8888)
+// The GPU->CPU readback happens here, only when pixels are actually requested
+// Rows are renderer-width pixels long; only the displayed sub-rect is valid
 const void *metal_rt_renderer_get_pixels(MetalRTRenderer *renderer);
 
+// Zero-copy presentation: draw the last rendered frame into the current render
+// pass of a CAMetalLayer drawable (e.g. SDL_RenderGetMetalCommandEncoder /
+// SDL_RenderGetMetalLayer). x, y, w, h is the destination rect in drawable pixels.
+// Returns false if the layer can't be used (other device, pipeline failure)
+bool metal_rt_renderer_present(MetalRTRenderer *renderer, void *renderEncoder, void *metalLayer,
+                               int x, int y, int w, int h);
+
+// Hardware video encoding: convert the displayed frame (scaled to the buffer size)
+// into an IOSurface-backed NV12 CVPixelBuffer (kCVPixelFormatType_420YpCbCr8BiPlanarVideoRange,
+// BT.709 video range) on the GPU. Blocks until the buffer is filled
+bool metal_rt_renderer_convert_to_nv12(MetalRTRenderer *renderer, void *pixelBuffer);
+
+// Render a frame and present it without any CPU readback
+bool metal_rt_renderer_render_and_present(MetalRTRenderer *renderer,
+                                          const CameraData *camera, float time, int colorMode, float colorIntensity,
+                                          void *renderEncoder, void *metalLayer,
+                                          int x, int y, int w, int h);
+
 // Render and get pixels atomically (for screenshots - ensures fresh render)
 // Returns pointer to pixel data, or nullptr on error
 // The pixel data is valid until the next render call
 const void *metal_rt_renderer_render_and_get_pixels(MetalRTRenderer *renderer,
                                                      const CameraData *camera, float time, int colorMode, float colorIntensity);
 
+// Asynchronous screenshots: submit a full-size frame whose output (and, with
+// hdr, its linear color before tone mapping) is copied into a pooled staging
+// buffer on the GPU. Returns immediately with a capture id, or -1 if every
+// staging buffer is still held by an unreleased capture
+long metal_rt_renderer_begin_capture(MetalRTRenderer *renderer, const CameraData *camera, float time,
+                                     int colorMode, float colorIntensity, bool hdr);
+
+// Queue a copy of the displayed frame, scaled to width x height, into a tight
+// BGRA8 staging buffer (software video recording). Doesn't wait for the GPU:
+// read it later with finish/release_capture. Returns -1 if no staging buffer is free
+long metal_rt_renderer_begin_readback(MetalRTRenderer *renderer, int width, int height);
+
+// Whether the capture's copy has finished (or failed) on the GPU, without waiting
+bool metal_rt_renderer_capture_ready(MetalRTRenderer *renderer, long captureId);
+
+// Block until the capture's copy has finished (callable from any thread) and
+// point `capture` at its pixels. Returns false if the GPU work failed
+bool metal_rt_renderer_finish_capture(MetalRTRenderer *renderer, long captureId, MetalRTCapture *capture);
+
+// Hand the capture's staging buffer back to the pool
+void metal_rt_renderer_release_capture(MetalRTRenderer *renderer, long captureId);
+
+// Offline tiled rendering (stills larger than the maximum texture size)
+// Traces the tileWidth x tileHeight region at (tileX, tileY) of an imageWidth x imageHeight
+// image with `samples` jittered samples per pixel, averaged in a float accumulation
+// buffer. Each pass is its own command buffer; blocks until the tile is done.
+// pixels receives tileWidth * tileHeight BGRA8 pixels. Returns false on error
+bool metal_rt_renderer_render_tile(MetalRTRenderer *renderer, const CameraData *camera, float time,
+                                   int colorMode, float colorIntensity, int imageWidth, int imageHeight,
+                                   int tileX, int tileY, int tileWidth, int tileHeight, int samples,
+                                   void *pixels);
+
+// Select the ray tracing strategy (METAL_RT_TRACE_*) for subsequent frames
+void metal_rt_renderer_set_trace_mode(MetalRTRenderer *renderer, int traceMode);
+
+// Per-step error bound of METAL_RT_TRACE_ADAPTIVE_BINET, relative to the horizon's
+// u = 1/RS (clamped to [1e-7, 1e-3]). Smaller is more accurate near the photon ring
+void metal_rt_renderer_set_integrator_tolerance(MetalRTRenderer *renderer, float tolerance);
+
+// Kerr spin a / M of the hole (clamped to +-0.998; negative spins counter-rotate
+// against the disk). Nonzero spin traces every mode with the Kerr integrator
+// in dedicated pipeline variants; 0 restores the Schwarzschild paths. Foveation
+// pauses while spinning, and tiled/offline renders stay Schwarzschild. A
+// nonzero spin needs the Kerr pipeline of `colorMode`, the palette about to be
+// rendered: returns false (keeping the old spin) while it is still compiling
+// or if it failed, so call again whenever the palette changes
+bool metal_rt_renderer_set_spin(MetalRTRenderer *renderer, float spin, int colorMode);
+
+// Foveated tracing: trace one ray per 4x4 tile, then trace full resolution only
+// in tiles near the disk, horizon edge and photon ring and upsample the rest.
+// Returns false if the mode is unavailable
+bool metal_rt_renderer_set_foveation(MetalRTRenderer *renderer, bool enabled);
+
+// Log every 60th frame, palette changes and screenshot details (off by default;
+// setup and failures are always logged)
+void metal_rt_renderer_set_verbose(MetalRTRenderer *renderer, bool enabled);
+
+// Replace the procedural starfield with a sky image: an equirectangular image
+// (PNG/JPEG, or Radiance .hdr / OpenEXR for HDR values) or a cubemap .ktx. It is
+// resampled once into a mipmapped float cubemap (faces up to 2048). Blocks
+// until done; returns false (keeping the current sky) if the file can't be used
+bool metal_rt_renderer_load_skybox(MetalRTRenderer *renderer, const char *path);
+
+// Enable/disable the per-pixel geodesic cache (on by default). With a crossing-based
+// trace mode and an unchanged camera, frames are re-shaded from the cache instead of traced
+void metal_rt_renderer_set_geodesic_cache(MetalRTRenderer *renderer, bool enabled);
+
+// Post chain: frames are traced into a half-float radiance target and turned
+// into the BGRA8 output by separate passes (bloom pyramid, exposure, filmic
+// tone curve, sRGB encoding). When nothing else changed since the last frame,
+// exposure and bloom changes only re-run these passes.
+// Linear exposure multiplier before tone mapping (default 1, clamped to [1/64, 64]);
+// also applied by render_tile
+void metal_rt_renderer_set_exposure(MetalRTRenderer *renderer, float exposure);
+
+// Bloom strength: share of the light above the threshold spread into the glow
+// (default 0.2, 0 disables the bloom passes, clamped to [0, 1]). Live frames only
+void metal_rt_renderer_set_bloom(MetalRTRenderer *renderer, float strength);
+
+// Progressive refinement (on by default): while the camera, time and every
+// other input repeat the previous frame's (e.g. a paused scene), each frame
+// adds one jittered sample per pixel to a float accumulation buffer and shows
+// the running mean, converging to an anti-aliased image (up to 1024 samples,
+// then the mean is only re-resolved). Any change starts over. Not used with
+// foveation or the diagnostics view
+void metal_rt_renderer_set_progressive(MetalRTRenderer *renderer, bool enabled);
+
+// Repeated-frame detection (on by default). Off, no frame counts as a repeat of
+// the previous one: nothing accumulates and nothing skips to the post chain,
+// so every frame traces every pixel afresh (benchmarks render one pose many times)
+void metal_rt_renderer_set_repeat_detection(MetalRTRenderer *renderer, bool enabled);
+
+// Samples per pixel in the image being shown by progressive refinement (0 while the scene moves)
+int metal_rt_renderer_get_accumulated_samples(MetalRTRenderer *renderer);
+
+// Diagnostics view: frames show a false-colour heatmap of integration steps
+// per pixel (blue = few, red = many; dimmed = horizon, whitened = opacity
+// cutoff, magenta = ran out of distance or steps) instead of the image, and
+// record per-pixel steps, termination and transmittance. Disables the geodesic
+// cache and foveation while enabled
+void metal_rt_renderer_set_diagnostics(MetalRTRenderer *renderer, bool enabled);
+
+// Totals of the latest completed diagnostics frame; false if there is none yet
+bool metal_rt_renderer_get_diagnostics(MetalRTRenderer *renderer, RayDiagnostics *diagnostics);
+
+// Write the displayed frame's raw diagnostics as a PFM float image (R = steps,
+// G = termination, B = transmittance); false if that frame has none
+bool metal_rt_renderer_save_diagnostics(MetalRTRenderer *renderer, const char *path);
+
 // Get pixel data size in bytes
 size_t metal_rt_renderer_get_pixel_data_size(MetalRTRenderer *renderer);
 
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "../camera/Camera.hpp"
+#include "MetalRTRenderer.h"
+
+/**
+ * Offline settings for a tiled still render
+ */
+struct OfflineRenderSettings {
+  int width = 15360;
+  int height = 8640;
+  int tileSize = 512;      // Tile edge in pixels (bounds GPU memory and command buffer length)
+  int samples = 16;        // Jittered samples per pixel
+  float time = 0.0f;       // Animation time of the still
+  int colorMode = 0;       // 0=blue, 1=orange, 2=red, 3=white, 4=blackbody
+  float colorIntensity = 1.0f;
+  int traceMode = METAL_RT_TRACE_GEODESIC_LUT;
+  int gpuCount = 0;        // GPUs sharing the tiles of each strip (0 = all)
+  std::string skyboxPath;  // Equirectangular image or cubemap .ktx; empty = procedural starfield
+  std::string outputPath = "blackhole_still.png";
+};
+
+/**
+ * Tiled offline renderer for stills past the maximum texture size (16K and up)
+ *
+ * The image is traced one tile at a time with progressive supersampling on the
+ * GPU; each strip of tiles is streamed to a PNG as soon as it is finished, so
+ * memory stays at one strip regardless of the output resolution. With several
+ * GPUs the tiles of a strip are split across them, one renderer and thread per device.
+ */
+class OfflineRenderer {
+public:
+  explicit OfflineRenderer(const OfflineRenderSettings &settings);
+  ~OfflineRenderer();
+
+  // Render the still seen from `camera` and write it to settings.outputPath
+  bool render(const Camera &camera);
+
+  // Camera -> GPU camera layout (normalized basis)
+  static void toCameraData(const Camera &camera, CameraData &data);
+
+  // One renderer per Metal device, up to gpuCount (0 = all); logged under `tag`.
+  // Falls back to the system default device; empty if none could be created
+  static std::vector<MetalRTRenderer *> createRenderers(int gpuCount, int width, int height, const std::string &tag);
+
+private:
+  OfflineRenderSettings settings;
+  std::vector<MetalRTRenderer *> renderers;
+};
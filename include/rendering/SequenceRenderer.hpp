@@ -0,0 +1,71 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "../camera/CinematicCamera.hpp"
+#include "MetalRTRenderer.h"
+
+/**
+ * Offline settings for a fixed-timestep frame sequence
+ */
+struct SequenceRenderSettings {
+  int width = 1920;
+  int height = 1080;
+  int fps = 60;
+  int firstFrame = 0;      // Global index of the first frame (time firstFrame / fps)
+  int frameCount = 600;
+  int gpuCount = 0;        // GPUs to spread frames across (0 = all)
+  CinematicMode cameraMode = CinematicMode::SmoothOrbit;
+  std::string cameraPath;  // Keyframe timeline (.json or .campath) instead of cameraMode; empty = cameraMode
+  int colorMode = 0;       // 0=blue, 1=orange, 2=red, 3=white, 4=blackbody
+  float colorIntensity = 1.0f;
+  int traceMode = METAL_RT_TRACE_VOLUMETRIC;
+  std::string skyboxPath;  // Equirectangular image or cubemap .ktx; empty = procedural starfield
+  // .mp4/.mov/.m4v writes a video; anything else is a printf pattern for PNG
+  // frames numbered by global frame index, e.g. frames/blackhole_%05d.png
+  std::string outputPath = "blackhole_sequence.mp4";
+};
+
+/**
+ * Headless renderer for cinematic clips decoupled from wall-clock time
+ *
+ * Frame i is rendered at exactly i / fps seconds: the cinematic camera and the
+ * shader time advance by a fixed 1 / fps step, so the output is perfectly timed
+ * no matter how long each frame takes. The GPU traces frame N+1 while frame N
+ * is converted and handed to the encoder thread (or written as a PNG), so the
+ * sequence renders as fast as the GPU allows instead of in real time.
+ *
+ * Frames are dealt round-robin to one renderer per GPU and emitted in order.
+ * A render farm shard renders frames [firstFrame, firstFrame + frameCount), and
+ * every camera of the shard is computed before the first frame is traced. A
+ * camera timeline is evaluated at each frame's time directly; the incremental
+ * cinematic modes are stepped from frame 0 without rendering. Either way every
+ * shard follows the exact same path and the segments concatenate seamlessly
+ * (each video segment starts on a keyframe with identical encoder settings).
+ */
+class SequenceRenderer {
+public:
+  explicit SequenceRenderer(const SequenceRenderSettings &settings);
+  ~SequenceRenderer();
+
+  // Render the sequence starting from `camera` and write it to settings.outputPath
+  bool render(const Camera &camera);
+
+  // Narrow frames [first, last] to contiguous shard `index` (1-based) of `count`.
+  // Returns false if the range or shard spec is invalid
+  static bool applyShard(SequenceRenderSettings &settings, int first, int last, int index, int count);
+
+private:
+  SequenceRenderSettings settings;
+  std::vector<MetalRTRenderer *> renderers;
+
+  // Cameras of frames [firstFrame, firstFrame + frameCount) in frame order
+  bool cameraPoses(const Camera &camera, std::vector<Camera> &poses) const;
+
+  static bool isVideoPath(const std::string &path);
+
+  // The image sequence path is used as a printf format: true only if it holds
+  // exactly one integer conversion (%d or %i with flags and width, e.g. %05d)
+  // and every other '%' is escaped as %%
+  static bool isFramePattern(const std::string &path);
+};
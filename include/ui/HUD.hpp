@@ -4,6 +4,7 @@
 #include <SDL2/SDL_ttf.h>
 #include "../camera/CinematicCamera.hpp"
 #include "../camera/Camera.hpp"
+#include "../rendering/MetalRTRenderer.h"
 
 /**
  * Heads-Up Display for rendering on-screen information
@@ -18,9 +19,17 @@ public:
   // Render music credits
   void renderMusicCredits(bool isMusicMuted, int windowWidth, int windowHeight);
   
+  // Render the rolling per-stage frame time graph with stage averages (top right),
+  // plus the step totals of the diagnostics view when given
+  void renderProfiler(const class FrameProfiler &profiler, int windowWidth, int windowHeight,
+                      const RayDiagnostics *diagnostics = nullptr);
+  
   // Render camera axis indicators
   void renderCameraAxes(const Camera *camera, int windowWidth, int windowHeight);
   
+  // Font for all text (loaded after startup; nothing is drawn while null)
+  void setFont(TTF_Font *newFont) { font = newFont; }
+  
   // Toggle hints visibility
   void toggleHints() { hintsVisible = !hintsVisible; }
   
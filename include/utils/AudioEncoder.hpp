@@ -0,0 +1,67 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+struct AVFormatContext;
+struct AVCodecContext;
+struct AVStream;
+struct AVFrame;
+struct AVPacket;
+struct AVAudioFifo;
+struct SwrContext;
+
+/**
+ * Live AAC track for VideoRecorder
+ *
+ * Decodes the background music file (looping, like the in-app playback),
+ * resamples it to the AAC encoder's format and writes the packets into the
+ * recorder's output alongside the video. The recorder's encoder thread calls
+ * writeUntil with the time of each video frame it has written, so audio is
+ * always interleaved just ahead of the video and nothing has to be remuxed
+ * afterwards.
+ */
+class AudioEncoder {
+public:
+  AudioEncoder();
+  ~AudioEncoder();
+
+  AudioEncoder(const AudioEncoder&) = delete;
+  AudioEncoder& operator=(const AudioEncoder&) = delete;
+
+  // Open the source file and add an AAC stream to output (before avformat_write_header)
+  bool open(const std::string& audioFile, AVFormatContext* output);
+
+  // Encode and write audio up to `seconds` of output time
+  bool writeUntil(double seconds);
+
+  // Write audio up to `seconds`, then flush the encoder (before av_write_trailer)
+  void finish(double seconds);
+
+  // Release everything (also done by the destructor)
+  void close();
+
+private:
+  AVFormatContext* inputContext;
+  AVCodecContext* decoderContext;
+  AVCodecContext* encoderContext;
+  AVFormatContext* outputContext; // Owned by the recorder
+  AVStream* stream;
+  SwrContext* resampler;
+  AVAudioFifo* fifo;        // Resampled samples waiting for a full encoder frame
+  AVFrame* decodedFrame;
+  AVFrame* encoderFrame;
+  AVPacket* packet;
+  int inputStreamIndex;
+  int64_t nextPts;          // Samples written, in 1/sample_rate
+  bool sourceEnded;         // Source can't be read even after looping
+
+  // Decode until the fifo holds at least `samples` samples; false at the end of the source
+  bool fill(int samples);
+
+  // Resample and queue one decoded frame (nullptr drains the resampler)
+  bool queueSamples(const AVFrame* frame);
+
+  // Send a frame (nullptr flushes) and write every packet the encoder returns
+  bool encode(AVFrame* frame);
+};
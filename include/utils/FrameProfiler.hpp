@@ -0,0 +1,97 @@
+#pragma once
+
+#include <chrono>
+#include <fstream>
+#include <string>
+
+/**
+ * Per-stage frame timing for the interactive renderer
+ *
+ * CPU stages are timed with begin/end pairs (a ScopedStage), the GPU stage is
+ * fed with the command buffer time of the frame that completed during this
+ * loop iteration. The last HISTORY frames are kept for the HUD graph. An
+ * optional export streams every frame to disk while the session runs: CSV
+ * (one row per frame, one column per stage) or Chrome trace JSON (one event
+ * per stage, open in chrome://tracing or Perfetto).
+ */
+class FrameProfiler {
+public:
+  enum Stage {
+    STAGE_GPU,       // Ray tracing on the GPU, or the CPU tracer
+    STAGE_SUBMIT,    // Encoding the frame and waiting for a free in-flight slot
+    STAGE_READBACK,  // Copying the finished frame to system memory
+    STAGE_UPLOAD,    // SDL_UpdateTexture, or the zero-copy draw into SDL's drawable
+    STAGE_HUD,       // Text and overlay drawing
+    STAGE_ENCODE,    // Handing the frame to the video recorder
+    STAGE_PRESENT,   // SDL_RenderPresent
+    STAGE_COUNT
+  };
+
+  static constexpr int HISTORY = 240;
+
+  FrameProfiler();
+  ~FrameProfiler();
+
+  FrameProfiler(const FrameProfiler &) = delete;
+  FrameProfiler &operator=(const FrameProfiler &) = delete;
+
+  void beginFrame();
+  void endFrame();
+
+  // CPU stage timing; a stage may run several times per frame (times add up)
+  void beginStage(Stage stage);
+  void endStage(Stage stage);
+
+  // Stage time measured elsewhere (the GPU stage)
+  void addStageTime(Stage stage, double ms);
+
+  // Times of a recorded frame; age 0 is the last finished frame
+  double getStageTime(int age, Stage stage) const;
+  double getFrameTime(int age) const;  // Wall-clock time of the whole frame
+  int getFrameCount() const { return frameCount < HISTORY ? frameCount : HISTORY; }
+
+  // Mean stage time over the recorded history
+  double getAverageStageTime(Stage stage) const;
+
+  static const char *stageName(Stage stage);
+
+  // Stream frames to path until stopExport; .json writes a Chrome trace, anything else CSV
+  bool startExport(const std::string &path);
+  void stopExport();
+  bool isExporting() const { return exportFile.is_open(); }
+
+  // RAII begin/end of a CPU stage
+  class ScopedStage {
+  public:
+    ScopedStage(FrameProfiler &profiler, Stage stage) : profiler(profiler), stage(stage) {
+      profiler.beginStage(stage);
+    }
+    ~ScopedStage() { profiler.endStage(stage); }
+
+  private:
+    FrameProfiler &profiler;
+    Stage stage;
+  };
+
+private:
+  using Clock = std::chrono::high_resolution_clock;
+
+  struct FrameRecord {
+    double stageMs[STAGE_COUNT];
+    double frameMs;
+  };
+
+  FrameRecord history[HISTORY];  // Ring buffer indexed by frame number
+  FrameRecord current;
+  long frameCount;  // Finished frames
+  Clock::time_point sessionStart;
+  Clock::time_point frameStart;
+  Clock::time_point stageStart[STAGE_COUNT];
+
+  std::ofstream exportFile;
+  bool chromeTrace;
+  bool firstTraceEvent;
+
+  double microsecondsSinceStart(Clock::time_point time) const;
+  void writeTraceEvent(const char *name, int thread, double startUs, double durationUs);
+};
@@ -0,0 +1,54 @@
+#pragma once
+
+/**
+ * Automatic render-scale controller targeting a GPU frame-time budget
+ *
+ * Fed with the measured GPU time of each completed frame, it adjusts a render
+ * scale in [MIN_SCALE, 1] (fraction of the render resolution per axis). Cost is
+ * roughly proportional to pixel count, so the scale moves by sqrt(target / time).
+ * A dead band around the target plus a cooldown between changes keeps it from
+ * oscillating.
+ */
+class QualityController {
+public:
+  static constexpr double MIN_SCALE = 0.25;
+  static constexpr double MAX_SCALE = 1.0;
+  static constexpr double DEFAULT_TARGET_MS = 16.6;
+
+  QualityController(double targetFrameMs = DEFAULT_TARGET_MS);
+
+  // Enable/disable automatic mode (disabling returns to full scale)
+  void setEnabled(bool enabled);
+  bool isEnabled() const { return enabled; }
+
+  // Target GPU frame time in milliseconds
+  void setTargetFrameTime(double ms);
+  double getTargetFrameTime() const { return targetMs; }
+
+  // Feed the GPU time of the latest completed frame
+  // Returns true if the scale changed
+  bool update(double gpuFrameMs);
+
+  // Current render scale per axis
+  double getScale() const { return scale; }
+
+  // Smoothed GPU frame time in milliseconds
+  double getSmoothedFrameTime() const { return smoothedMs; }
+
+  // Forget timing history (e.g. after a resolution change)
+  void reset();
+
+private:
+  double targetMs;
+  double scale;
+  double smoothedMs;
+  bool enabled;
+  int framesSinceChange;
+
+  static constexpr double SMOOTHING = 0.15;       // Exponential moving average weight
+  static constexpr double UPPER_BAND = 1.05;      // Scale down above target * UPPER_BAND
+  static constexpr double LOWER_BAND = 0.80;      // Scale up below target * LOWER_BAND
+  static constexpr int COOLDOWN_FRAMES = 12;      // Frames to wait after each change
+  static constexpr double MAX_STEP_DOWN = 0.75;   // Largest single decrease (factor)
+  static constexpr double MAX_STEP_UP = 1.10;     // Largest single increase (factor)
+};
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Bounded lock-free single-producer / single-consumer ring of reusable slots
+ *
+ * Slots are constructed once and recycled, so whatever they own (pixel buffers,
+ * frame references) doubles as a pool: the producer fills producerSlot() and
+ * publishes it with push(), the consumer reads front() and recycles it with pop().
+ * Either side can sleep until the other makes progress (C++20 atomic wait/notify).
+ */
+template <typename T>
+class SPSCQueue {
+public:
+  explicit SPSCQueue(size_t capacity)
+      : slots(capacity > 0 ? capacity : 1), head(0), tail(0), dataSignal(0), spaceSignal(0) {}
+
+  size_t capacity() const { return slots.size(); }
+  size_t size() const { return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire); }
+  bool empty() const { return size() == 0; }
+  bool full() const { return size() >= slots.size(); }
+
+  // Producer: slot to fill next, or nullptr if the ring is full
+  T *producerSlot() {
+    if (full()) return nullptr;
+    return &slots[tail.load(std::memory_order_relaxed) % slots.size()];
+  }
+
+  // Producer: publish the filled slot
+  void push() {
+    tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    signal(dataSignal);
+  }
+
+  // Producer: sleep until the consumer frees a slot
+  void waitForSpace() {
+    while (full()) {
+      uint32_t seen = spaceSignal.load(std::memory_order_acquire);
+      if (!full()) break;
+      spaceSignal.wait(seen, std::memory_order_acquire);
+    }
+  }
+
+  // Consumer: oldest published slot, or nullptr if the ring is empty
+  T *front() {
+    if (empty()) return nullptr;
+    return &slots[head.load(std::memory_order_relaxed) % slots.size()];
+  }
+
+  // Consumer: recycle the slot returned by front()
+  void pop() {
+    head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    signal(spaceSignal);
+  }
+
+  // Consumer: sleep until data is pushed or wakeConsumer() is called.
+  // stop() is checked after arming the wait, so a wake that follows setting
+  // the consumer's stop flag is never missed
+  template <typename StopPredicate>
+  void waitForData(StopPredicate stop) {
+    uint32_t seen = dataSignal.load(std::memory_order_acquire);
+    if (empty() && !stop()) {
+      dataSignal.wait(seen, std::memory_order_acquire);
+    }
+  }
+
+  // Wake a consumer sleeping in waitForData (set its stop flag first)
+  void wakeConsumer() { signal(dataSignal); }
+
+private:
+  std::vector<T> slots;
+  std::atomic<size_t> head;  // Next slot to consume (written by the consumer only)
+  std::atomic<size_t> tail;  // Next slot to fill (written by the producer only)
+  std::atomic<uint32_t> dataSignal;   // Bumped on push / wake
+  std::atomic<uint32_t> spaceSignal;  // Bumped on pop
+
+  static void signal(std::atomic<uint32_t> &counter) {
+    counter.fetch_add(1, std::memory_order_release);
+    counter.notify_all();
+  }
+};
@@ -2,10 +2,44 @@
 
 #include <string>
 
-// Save ARGB8888 pixel data as PNG file
-// pixels: ARGB8888 format (4 bytes per pixel: A, R, G, B)
+class WorkStealingPool;
+
+// Deflate levels for savePNG
+constexpr int PNG_STORED = 0;   // No compression: fastest, largest file
+constexpr int PNG_FAST = 1;
+constexpr int PNG_DEFAULT = 6;  // libpng's default
+
+// Save BGRA8 pixel data (Metal renderer / SDL_PIXELFORMAT_ARGB8888) as an 8-bit RGB PNG file
+// pixels: 4 bytes per pixel (B, G, R, A), strideBytes apart (0 = width * 4)
 // width, height: image dimensions
 // filename: output file path
+// With a pool, bands of rows are filtered and deflated in parallel into a
+// single zlib stream (each band primed with the previous band's last 32 KB)
 // Returns true on success, false on error
-bool savePNG(const void* pixels, int width, int height, const std::string& filename);
+bool savePNG(const void* pixels, int width, int height, const std::string& filename,
+             int compressionLevel = PNG_DEFAULT, WorkStealingPool* pool = nullptr, int strideBytes = 0);
+
+// Save linear RGBA32F pixels (before tone mapping) as an uncompressed 32-bit float RGB TIFF
+// strideBytes = 0 means width * 16
+bool saveFloatTIFF(const float* rgba, int width, int height, const std::string& filename, int strideBytes = 0);
+
+// Incremental PNG writer for images too large to hold in memory
+// Rows are appended top to bottom as they become available
+class PNGStreamWriter {
+public:
+    PNGStreamWriter();
+    ~PNGStreamWriter();
+
+    // Create the file and write the header (8-bit RGB)
+    bool open(const std::string& filename, int width, int height);
+
+    // Append `rows` rows of BGRA8 pixels (strideBytes apart)
+    bool writeRows(const void* bgraPixels, int rows, int strideBytes);
+
+    // Finish the image; fails if fewer rows than the height were written
+    bool close();
 
+private:
+    struct State;
+    State* state;
+};
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../rendering/MetalRTRenderer.h"
+#include "Screenshot.h"
+#include "WorkStealingPool.hpp"
+
+/**
+ * Background encoder for screenshots
+ *
+ * The main thread only queues a job: either pixels it already has (CPU
+ * renderer) or a GPU capture (metal_rt_renderer_begin_capture) that may still
+ * be tracing and copying into its staging buffer. The worker waits for the
+ * GPU, writes the PNG with the row-parallel encoder (plus a float TIFF for HDR
+ * captures) and releases the staging buffer, so the render loop never stalls
+ * on large frames.
+ */
+class ScreenshotWriter {
+public:
+  struct Job {
+    std::string path;                     // PNG path
+    std::string hdrPath;                  // Float TIFF path (HDR captures only, empty = none)
+    MetalRTRenderer *renderer = nullptr;  // GPU capture to wait for...
+    long capture = -1;
+    std::vector<uint8_t> pixels;          // ...or BGRA8 pixels already on the CPU
+    int width = 0;
+    int height = 0;
+    int compressionLevel = PNG_DEFAULT;
+  };
+
+  ScreenshotWriter();
+  ~ScreenshotWriter();  // Writes every queued job first
+
+  ScreenshotWriter(const ScreenshotWriter &) = delete;
+  ScreenshotWriter &operator=(const ScreenshotWriter &) = delete;
+
+  void submit(Job job);
+
+  // Block until every queued screenshot is written (before destroying the renderer)
+  void flush();
+
+  // Jobs queued or being written
+  int getPendingCount();
+
+  // Deflate level for a frame: fast compression above 4K, where the default level takes seconds
+  static int compressionLevelFor(int width, int height);
+
+private:
+  WorkStealingPool pool;  // Row bands of the PNG encoder
+  std::thread worker;
+  std::mutex mutex;
+  std::condition_variable jobReady;
+  std::condition_variable jobsDone;
+  std::deque<Job> jobs;
+  int active;  // Jobs taken by the worker and not finished yet
+  bool stopping;
+
+  void workerLoop();
+  void write(Job &job);
+};
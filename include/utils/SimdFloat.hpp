@@ -0,0 +1,244 @@
+#pragma once
+
+#include <cmath>
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define SIMD_FLOAT_NEON 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SIMD_FLOAT_AVX2 1
+#endif
+
+/**
+ * Minimal SIMD float vector for packet ray tracing
+ *
+ * NEON on Apple Silicon (4 lanes), plain arrays elsewhere (left to the
+ * auto-vectorizer; 8 lanes on x86, 4 otherwise). On x86, simd_avx2 adds an
+ * 8-lane AVX2 version: only its own functions are compiled for AVX2/FMA, so
+ * the binary still runs on older CPUs. Use it from SIMD_AVX2_TARGET functions
+ * after checking simdHasAVX2(). Only the operations the packet tracer needs:
+ * arithmetic, sqrt, min/max, compares and blends.
+ */
+#if SIMD_FLOAT_NEON
+
+struct SimdMask {
+  uint32x4_t m;
+
+  static SimdMask all() { return {vdupq_n_u32(0xFFFFFFFFu)}; }
+  static SimdMask none() { return {vdupq_n_u32(0)}; }
+
+  bool any() const { return vmaxvq_u32(m) != 0; }
+  // Bit i set if lane i is set
+  int bits() const {
+    static const uint32_t weights[4] = {1, 2, 4, 8};
+    return static_cast<int>(vaddvq_u32(vandq_u32(m, vld1q_u32(weights))));
+  }
+
+  SimdMask operator&(SimdMask o) const { return {vandq_u32(m, o.m)}; }
+  SimdMask operator|(SimdMask o) const { return {vorrq_u32(m, o.m)}; }
+  // this & ~o
+  SimdMask andNot(SimdMask o) const { return {vbicq_u32(m, o.m)}; }
+};
+
+struct SimdFloat {
+  static constexpr int LANES = 4;
+  float32x4_t v;
+
+  SimdFloat() : v(vdupq_n_f32(0.0f)) {}
+  SimdFloat(float x) : v(vdupq_n_f32(x)) {}
+  SimdFloat(float32x4_t x) : v(x) {}
+
+  static SimdFloat load(const float *p) { return vld1q_f32(p); }
+  void store(float *p) const { vst1q_f32(p, v); }
+
+  SimdFloat operator+(SimdFloat o) const { return vaddq_f32(v, o.v); }
+  SimdFloat operator-(SimdFloat o) const { return vsubq_f32(v, o.v); }
+  SimdFloat operator*(SimdFloat o) const { return vmulq_f32(v, o.v); }
+  SimdFloat operator/(SimdFloat o) const { return vdivq_f32(v, o.v); }
+
+  SimdMask operator<(SimdFloat o) const { return {vcltq_f32(v, o.v)}; }
+  SimdMask operator>(SimdFloat o) const { return {vcgtq_f32(v, o.v)}; }
+  SimdMask operator<=(SimdFloat o) const { return {vcleq_f32(v, o.v)}; }
+  SimdMask operator>=(SimdFloat o) const { return {vcgeq_f32(v, o.v)}; }
+
+  friend SimdFloat sqrt(SimdFloat a) { return vsqrtq_f32(a.v); }
+  friend SimdFloat abs(SimdFloat a) { return vabsq_f32(a.v); }
+  friend SimdFloat min(SimdFloat a, SimdFloat b) { return vminq_f32(a.v, b.v); }
+  friend SimdFloat max(SimdFloat a, SimdFloat b) { return vmaxq_f32(a.v, b.v); }
+  // mask ? a : b per lane
+  friend SimdFloat select(SimdMask mask, SimdFloat a, SimdFloat b) { return vbslq_f32(mask.m, a.v, b.v); }
+};
+
+#endif
+
+#if SIMD_FLOAT_AVX2
+
+// Marks functions that may use AVX2/FMA instructions
+#define SIMD_AVX2_TARGET __attribute__((target("avx2,fma")))
+
+namespace simd_avx2 {
+
+struct SimdMask {
+  __m256 m;
+
+  SIMD_AVX2_TARGET static SimdMask all() { return {_mm256_castsi256_ps(_mm256_set1_epi32(-1))}; }
+  SIMD_AVX2_TARGET static SimdMask none() { return {_mm256_setzero_ps()}; }
+
+  SIMD_AVX2_TARGET bool any() const { return _mm256_movemask_ps(m) != 0; }
+  // Bit i set if lane i is set
+  SIMD_AVX2_TARGET int bits() const { return _mm256_movemask_ps(m); }
+
+  SIMD_AVX2_TARGET SimdMask operator&(SimdMask o) const { return {_mm256_and_ps(m, o.m)}; }
+  SIMD_AVX2_TARGET SimdMask operator|(SimdMask o) const { return {_mm256_or_ps(m, o.m)}; }
+  // this & ~o
+  SIMD_AVX2_TARGET SimdMask andNot(SimdMask o) const { return {_mm256_andnot_ps(o.m, m)}; }
+};
+
+struct SimdFloat {
+  static constexpr int LANES = 8;
+  __m256 v;
+
+  SIMD_AVX2_TARGET SimdFloat() : v(_mm256_setzero_ps()) {}
+  SIMD_AVX2_TARGET SimdFloat(float x) : v(_mm256_set1_ps(x)) {}
+  SIMD_AVX2_TARGET SimdFloat(__m256 x) : v(x) {}
+
+  SIMD_AVX2_TARGET static SimdFloat load(const float *p) { return _mm256_loadu_ps(p); }
+  SIMD_AVX2_TARGET void store(float *p) const { _mm256_storeu_ps(p, v); }
+
+  SIMD_AVX2_TARGET SimdFloat operator+(SimdFloat o) const { return _mm256_add_ps(v, o.v); }
+  SIMD_AVX2_TARGET SimdFloat operator-(SimdFloat o) const { return _mm256_sub_ps(v, o.v); }
+  SIMD_AVX2_TARGET SimdFloat operator*(SimdFloat o) const { return _mm256_mul_ps(v, o.v); }
+  SIMD_AVX2_TARGET SimdFloat operator/(SimdFloat o) const { return _mm256_div_ps(v, o.v); }
+
+  SIMD_AVX2_TARGET SimdMask operator<(SimdFloat o) const { return {_mm256_cmp_ps(v, o.v, _CMP_LT_OQ)}; }
+  SIMD_AVX2_TARGET SimdMask operator>(SimdFloat o) const { return {_mm256_cmp_ps(v, o.v, _CMP_GT_OQ)}; }
+  SIMD_AVX2_TARGET SimdMask operator<=(SimdFloat o) const { return {_mm256_cmp_ps(v, o.v, _CMP_LE_OQ)}; }
+  SIMD_AVX2_TARGET SimdMask operator>=(SimdFloat o) const { return {_mm256_cmp_ps(v, o.v, _CMP_GE_OQ)}; }
+
+  SIMD_AVX2_TARGET friend SimdFloat sqrt(SimdFloat a) { return _mm256_sqrt_ps(a.v); }
+  SIMD_AVX2_TARGET friend SimdFloat abs(SimdFloat a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v); }
+  SIMD_AVX2_TARGET friend SimdFloat min(SimdFloat a, SimdFloat b) { return _mm256_min_ps(a.v, b.v); }
+  SIMD_AVX2_TARGET friend SimdFloat max(SimdFloat a, SimdFloat b) { return _mm256_max_ps(a.v, b.v); }
+  // mask ? a : b per lane
+  SIMD_AVX2_TARGET friend SimdFloat select(SimdMask mask, SimdFloat a, SimdFloat b) {
+    return _mm256_blendv_ps(b.v, a.v, mask.m);
+  }
+};
+} // namespace simd_avx2
+
+// Runtime check before calling into simd_avx2 code
+inline bool simdHasAVX2() {
+  static const bool supported = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+  return supported;
+}
+
+#endif
+
+#if !SIMD_FLOAT_NEON
+
+namespace simd_portable {
+
+// Same width as simd_avx2 on x86, so packets have one size whichever path runs
+#if SIMD_FLOAT_AVX2
+constexpr int LANES = 8;
+#else
+constexpr int LANES = 4;
+#endif
+
+struct SimdMask {
+  bool m[LANES];
+
+  static SimdMask all() { return fill(true); }
+  static SimdMask none() { return fill(false); }
+
+  bool any() const {
+    bool r = false;
+    for (int i = 0; i < LANES; i++) r = r || m[i];
+    return r;
+  }
+  // Bit i set if lane i is set
+  int bits() const {
+    int r = 0;
+    for (int i = 0; i < LANES; i++) r |= m[i] ? 1 << i : 0;
+    return r;
+  }
+
+  SimdMask operator&(SimdMask o) const {
+    SimdMask r;
+    for (int i = 0; i < LANES; i++) r.m[i] = m[i] && o.m[i];
+    return r;
+  }
+  SimdMask operator|(SimdMask o) const {
+    SimdMask r;
+    for (int i = 0; i < LANES; i++) r.m[i] = m[i] || o.m[i];
+    return r;
+  }
+  // this & ~o
+  SimdMask andNot(SimdMask o) const {
+    SimdMask r;
+    for (int i = 0; i < LANES; i++) r.m[i] = m[i] && !o.m[i];
+    return r;
+  }
+
+private:
+  static SimdMask fill(bool value) {
+    SimdMask r;
+    for (int i = 0; i < LANES; i++) r.m[i] = value;
+    return r;
+  }
+};
+
+struct SimdFloat {
+  static constexpr int LANES = simd_portable::LANES;
+  float v[LANES];
+
+  SimdFloat() : SimdFloat(0.0f) {}
+  SimdFloat(float x) {
+    for (int i = 0; i < LANES; i++) v[i] = x;
+  }
+
+  static SimdFloat load(const float *p) {
+    SimdFloat r;
+    for (int i = 0; i < LANES; i++) r.v[i] = p[i];
+    return r;
+  }
+  void store(float *p) const {
+    for (int i = 0; i < LANES; i++) p[i] = v[i];
+  }
+
+#define SIMD_FLOAT_LANEWISE(expr) \
+  SimdFloat r;                    \
+  for (int i = 0; i < LANES; i++) r.v[i] = (expr); \
+  return r
+#define SIMD_MASK_LANEWISE(expr) \
+  SimdMask r;                    \
+  for (int i = 0; i < LANES; i++) r.m[i] = (expr); \
+  return r
+
+  SimdFloat operator+(SimdFloat o) const { SIMD_FLOAT_LANEWISE(v[i] + o.v[i]); }
+  SimdFloat operator-(SimdFloat o) const { SIMD_FLOAT_LANEWISE(v[i] - o.v[i]); }
+  SimdFloat operator*(SimdFloat o) const { SIMD_FLOAT_LANEWISE(v[i] * o.v[i]); }
+  SimdFloat operator/(SimdFloat o) const { SIMD_FLOAT_LANEWISE(v[i] / o.v[i]); }
+
+  SimdMask operator<(SimdFloat o) const { SIMD_MASK_LANEWISE(v[i] < o.v[i]); }
+  SimdMask operator>(SimdFloat o) const { SIMD_MASK_LANEWISE(v[i] > o.v[i]); }
+  SimdMask operator<=(SimdFloat o) const { SIMD_MASK_LANEWISE(v[i] <= o.v[i]); }
+  SimdMask operator>=(SimdFloat o) const { SIMD_MASK_LANEWISE(v[i] >= o.v[i]); }
+
+  friend SimdFloat sqrt(SimdFloat a) { SIMD_FLOAT_LANEWISE(std::sqrt(a.v[i])); }
+  friend SimdFloat abs(SimdFloat a) { SIMD_FLOAT_LANEWISE(std::fabs(a.v[i])); }
+  friend SimdFloat min(SimdFloat a, SimdFloat b) { SIMD_FLOAT_LANEWISE(a.v[i] < b.v[i] ? a.v[i] : b.v[i]); }
+  friend SimdFloat max(SimdFloat a, SimdFloat b) { SIMD_FLOAT_LANEWISE(a.v[i] > b.v[i] ? a.v[i] : b.v[i]); }
+  // mask ? a : b per lane
+  friend SimdFloat select(SimdMask mask, SimdFloat a, SimdFloat b) { SIMD_FLOAT_LANEWISE(mask.m[i] ? a.v[i] : b.v[i]); }
+
+#undef SIMD_FLOAT_LANEWISE
+#undef SIMD_MASK_LANEWISE
+};
+} // namespace simd_portable
+
+using SimdFloat = simd_portable::SimdFloat;
+using SimdMask = simd_portable::SimdMask;
+
+#endif
@@ -1,28 +1,101 @@
 #pragma once
 
 #include <string>
+#include <cstddef>
 #include <cstdint>
+#include <chrono>
+
+struct AVFrame;
 
 /**
  * Video recorder for capturing frames and encoding to video file with audio
+ *
+ * Frames are queued in a bounded SPSC ring of pooled buffers and encoded/muxed
+ * on a dedicated thread, so encoder stalls and disk hiccups never block the
+ * render loop (unless the Block queue policy asks for it).
+ *
+ * The audio file is encoded as a live AAC track interleaved with the video,
+ * and MP4/MOV files are fragmented, so stopping is immediate and a crash keeps
+ * everything up to the last fragment.
+ *
+ * The output can also be a live stream instead of a file: an rtmp:// (FLV),
+ * srt:// or udp:// (MPEG-TS) URL, or an .m3u8 playlist (HLS with fMP4
+ * segments). Streams use a zero-latency encoder configuration.
  */
 class VideoRecorder {
 public:
+  // Where frames come from and which encoder consumes them
+  enum class Backend {
+    Software,   // CPU BGRA frames (addFrame), swscale to YUV420P, libx264 preferred
+    Hardware    // NV12 CVPixelBuffers filled on the GPU, encoded by VideoToolbox (hw_frames_ctx)
+  };
+  
+  // What the render thread does when the encoder queue is full
+  enum class QueuePolicy {
+    Block,    // Wait for the encoder (never loses frames, can stall rendering)
+    Drop,     // Discard the new frame
+    Degrade   // Keep every other frame once the queue is half full, drop when full
+  };
+  
+  // Encoder queue statistics (safe to read while recording)
+  struct Stats {
+    size_t queueDepth;        // Frames waiting for the encoder
+    size_t maxQueueDepth;     // Highest depth reached this recording
+    size_t queueCapacity;
+    uint64_t framesQueued;
+    uint64_t framesEncoded;
+    uint64_t framesDropped;   // Frames rejected by the queue policy
+    double averageEncodeMs;   // Conversion + encode + mux time per frame
+    double maxEncodeMs;
+    double averageLatencyMs;  // Queued -> written to the file
+  };
+
   VideoRecorder();
   ~VideoRecorder();
   
-  // Start recording to a file
-  bool startRecording(const std::string& filename, int width, int height, int fps = 60, const std::string& audioFile = "");
+  // Start recording to a file or stream URL. Fails if the requested backend is unavailable
+  bool startRecording(const std::string& filename, int width, int height, int fps = 60, const std::string& audioFile = "",
+                      Backend backend = Backend::Software);
   
-  // Stop recording and finalize video file (mixes audio if provided)
+  // Stop recording and finalize video file
   void stopRecording();
   
-  // Add a frame to the video (ARGB8888 format, 4 bytes per pixel)
+  // Add a frame to the video (ARGB8888 format, 4 bytes per pixel) - software backend
   bool addFrame(const void* pixels, int width, int height);
   
+  // Hardware backend: IOSurface-backed NV12 CVPixelBufferRef from the encoder's pool
+  // for the next frame. Fill it on the GPU, then call submitHardwareFrame
+  void* acquireHardwareFrame();
+  
+  // Hardware backend: encode the frame returned by acquireHardwareFrame
+  bool submitHardwareFrame();
+  
+  // Hardware backend: give back a frame from acquireHardwareFrame that could
+  // not be filled (its pixel buffer returns to the pool, its pts to the timeline)
+  void cancelHardwareFrame();
+  
+  // Backend of the current recording
+  Backend getBackend() const { return backend; }
+  
+  // Frame size of the current recording (addFrame expects exactly this)
+  int getFrameWidth() const { return frameWidth; }
+  int getFrameHeight() const { return frameHeight; }
+  
   // Check if currently recording
   bool isRecording() const { return recording; }
   
+  // Output is a live stream rather than a file (see isStreamURL)
+  bool isStreaming() const { return streaming; }
+  static bool isStreamURL(const std::string& output);
+  
+  // Queue configuration, applied by the next startRecording
+  void setQueuePolicy(QueuePolicy policy) { queuePolicy = policy; }
+  QueuePolicy getQueuePolicy() const { return queuePolicy; }
+  void setQueueCapacity(size_t frames) { queueCapacity = frames > 0 ? frames : 1; }
+  
+  // Statistics of the current (or last) recording
+  Stats getStats() const;
+  
   // Get current output filename
   const std::string& getFilename() const { return filename; }
   
@@ -31,20 +104,35 @@ public:
 
 private:
   bool recording;
+  bool streaming;
   std::string filename;
   std::string audioFilePath;
   int frameWidth;
   int frameHeight;
   int frameRate;
+  Backend backend;
+  QueuePolicy queuePolicy;
+  size_t queueCapacity;
+  int64_t nextPts; // Pts of the next frame: counts offered frames (files) or wall-clock ticks (streams), so drops leave gaps
+  std::chrono::steady_clock::time_point streamStart; // Live streams: wall-clock origin of the pts
   void* ffmpegContext; // Opaque pointer to FFmpeg context
+  Stats finalStats; // Snapshot taken when the last recording stopped
   
   // Initialize FFmpeg encoder
   bool initializeEncoder();
   
+  // Set up the VideoToolbox device/frames contexts for the hardware backend
+  bool initializeHardwareFrames();
+  
+  // Send a frame (nullptr flushes) and write every packet the encoder returns
+  bool encodeFrame(AVFrame* frame);
+  
+  // Apply the queue policy to the next frame; false if it must be dropped
+  bool admitFrame();
+  
+  // Encoder thread: drain the queue until recording stops
+  void encoderLoop();
+  
   // Cleanup FFmpeg resources
   void cleanupEncoder();
-  
-  // Mux audio with video after recording
-  bool muxAudioWithVideo();
 };
-
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Fixed thread pool running index ranges with work stealing
+ *
+ * parallelFor splits [0, count) into one contiguous range per thread (the
+ * calling thread takes part). Each thread pops indices from the front of its
+ * own range; once it runs dry it steals the back half of another thread's
+ * range. Ranges are packed into a single atomic word, so owner and thieves
+ * only ever compare-and-swap - no locks on the hot path. Uneven work (rows
+ * through the disk cost far more than empty sky) is rebalanced automatically.
+ */
+class WorkStealingPool {
+public:
+  // threadCount = 0 uses every hardware thread
+  explicit WorkStealingPool(unsigned threadCount = 0);
+  ~WorkStealingPool();
+
+  WorkStealingPool(const WorkStealingPool &) = delete;
+  WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+  // Run body(i) for every i in [0, count) and return once all have finished
+  void parallelFor(int count, const std::function<void(int)> &body);
+
+  // Threads taking part in parallelFor, including the caller
+  unsigned getThreadCount() const { return static_cast<unsigned>(ranges.size()); }
+
+private:
+  // Remaining [begin, end) of one thread: begin in the low, end in the high 32 bits
+  struct alignas(64) WorkRange {
+    std::atomic<uint64_t> packed{0};
+  };
+
+  std::vector<WorkRange> ranges;  // Index 0 belongs to the caller of parallelFor
+  std::vector<std::thread> workers;
+  std::mutex mutex;
+  std::condition_variable startSignal;
+  std::condition_variable doneSignal;
+  const std::function<void(int)> *task;  // Body of the running parallelFor
+  uint64_t generation;  // Bumped for every parallelFor
+  unsigned busyWorkers;
+  bool stopping;
+
+  void workerLoop(unsigned index);
+
+  // Drain own range, then steal until every range is empty
+  void runTasks(unsigned index);
+  bool popFront(unsigned index, int &item);
+  bool stealHalf(unsigned thief);
+};
@@ -0,0 +1,62 @@
+#include <metal_stdlib>
+using namespace metal;
+
+// GPU colour conversion for the hardware video encoder.
+// Converts the displayed BGRA8 frame into the two planes of an NV12
+// (420YpCbCr8BiPlanarVideoRange) CVPixelBuffer: BT.709, video range.
+// One thread per 2x2 luma block writes four Y samples and one CbCr pair.
+// uvScale selects the rendered sub-rect when the frame was traced below full size.
+
+constant float3 BT709_LUMA = float3(0.2126, 0.7152, 0.0722);
+
+kernel void bgra_to_nv12(
+    texture2d<float, access::sample> frame [[texture(0)]],
+    texture2d<float, access::write> lumaPlane [[texture(1)]],
+    texture2d<float, access::write> chromaPlane [[texture(2)]],
+    constant float2& uvScale [[buffer(0)]],
+    uint2 gid [[thread_position_in_grid]])
+{
+    if (gid.x >= chromaPlane.get_width() || gid.y >= chromaPlane.get_height()) {
+        return;
+    }
+
+    constexpr sampler frameSampler(filter::linear, address::clamp_to_edge);
+    float2 lumaSize = float2(lumaPlane.get_width(), lumaPlane.get_height());
+    float3 rgbSum = float3(0.0);
+
+    for (uint i = 0; i < 4; i++) {
+        uint2 pixel = gid * 2 + uint2(i & 1, i >> 1);
+        // Odd sizes: the last block repeats its edge pixel
+        pixel = min(pixel, uint2(lumaSize) - 1);
+        float2 uv = (float2(pixel) + 0.5) / lumaSize * uvScale;
+        float3 rgb = frame.sample(frameSampler, uv).rgb;
+        rgbSum += rgb;
+        lumaPlane.write(float4((16.0 + 219.0 * dot(rgb, BT709_LUMA)) / 255.0), pixel);
+    }
+
+    float3 rgb = rgbSum * 0.25;
+    float y = dot(rgb, BT709_LUMA);
+    float cb = (rgb.b - y) / 1.8556;
+    float cr = (rgb.r - y) / 1.5748;
+    chromaPlane.write(float4((128.0 + 224.0 * float2(cb, cr)) / 255.0, 0.0, 0.0), gid);
+}
+
+// Software recording readback: the displayed BGRA8 frame scaled (bilinear) to
+// the recording size, written as packed BGRA8 straight into a staging buffer.
+// At the same size every sample lands on a texel center, an exact copy.
+kernel void bgra_resample(
+    texture2d<float, access::sample> frame [[texture(0)]],
+    device uchar4* pixels [[buffer(0)]],
+    constant float2& uvScale [[buffer(1)]],
+    constant uint2& size [[buffer(2)]],
+    uint2 gid [[thread_position_in_grid]])
+{
+    if (gid.x >= size.x || gid.y >= size.y) {
+        return;
+    }
+
+    constexpr sampler frameSampler(filter::linear, address::clamp_to_edge);
+    float2 uv = (float2(gid) + 0.5) / float2(size) * uvScale;
+    float3 rgb = frame.sample(frameSampler, uv).rgb;
+    pixels[gid.y * size.x + gid.x] = uchar4(uchar3(round(saturate(rgb.bgr) * 255.0)), 255);
+}
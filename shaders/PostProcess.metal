@@ -0,0 +1,135 @@
+#include <metal_stdlib>
+using namespace metal;
+#include "ToneMapping.h"
+
+// Post chain of a live frame: the trace kernels write linear radiance into an
+// RGBA16Float target, these passes turn it into the BGRA8 output. Exposure and
+// bloom changes only re-run them, not the trace.
+//   post_bloom_prefilter:  exposed radiance above the threshold -> bloom level 0 (half size)
+//   post_bloom_downsample: level i -> i + 1
+//   post_bloom_upsample:   level i + 1 (blurred) + level i (down chain) -> level i (up chain)
+//   post_composite:        radiance * exposure + bloom -> filmic tone curve -> sRGB BGRA8
+// Targets are allocated at the renderer size; only the top-left sourceSize /
+// targetSize region (the viewport at that level) is valid, so every sample is
+// clamped to it.
+
+constant float BLOOM_KNEE = 0.5; // Soft threshold width (exposed radiance)
+
+constexpr sampler bloom_sampler(filter::linear, address::clamp_to_edge);
+
+// Must match PostParams in MetalRTRenderer.mm
+struct PostParams {
+    uint2 sourceSize;     // Valid region of the texture being read
+    uint2 targetSize;     // Valid region of the texture being written (the grid)
+    float exposure;       // Linear exposure multiplier
+    float bloomStrength;  // Bloom added per unit of radiance (0 = no bloom texture bound)
+    float bloomThreshold; // Exposed radiance where bloom starts
+    uint raw;             // Diagnostics heatmap: write the values unchanged
+};
+
+// Bilinear sample at a position in texels, kept inside the valid region
+float3 sample_region(texture2d<float> source, float2 position, uint2 validSize) {
+    float2 clamped = clamp(position, float2(0.5), float2(validSize) - 0.5);
+    return source.sample(bloom_sampler, clamped / float2(source.get_width(), source.get_height())).rgb;
+}
+
+// Four bilinear taps around a 2x2 block center: a 4x4 box footprint
+float3 downsample_box(texture2d<float> source, uint2 tid, uint2 validSize) {
+    float2 center = float2(tid) * 2.0 + 1.0;
+    return 0.25 * (sample_region(source, center + float2(-1.0, -1.0), validSize) +
+                   sample_region(source, center + float2(1.0, -1.0), validSize) +
+                   sample_region(source, center + float2(-1.0, 1.0), validSize) +
+                   sample_region(source, center + float2(1.0, 1.0), validSize));
+}
+
+// Soft-knee threshold on the brightest channel
+float3 bloom_threshold(float3 color, float threshold) {
+    float brightness = max(color.r, max(color.g, color.b));
+    float soft = clamp(brightness - threshold + BLOOM_KNEE, 0.0, 2.0 * BLOOM_KNEE);
+    soft = soft * soft / (4.0 * BLOOM_KNEE + 1e-5);
+    return color * (max(soft, brightness - threshold) / max(brightness, 1e-5));
+}
+
+kernel void post_bloom_prefilter(
+    texture2d<float> radiance [[texture(0)]],
+    texture2d<float, access::write> bloom [[texture(1)]],
+    constant PostParams& params [[buffer(0)]],
+    uint2 tid [[thread_position_in_grid]])
+{
+    if (tid.x >= params.targetSize.x || tid.y >= params.targetSize.y) {
+        return;
+    }
+
+    // Karis average of the four 2x2 blocks: single very bright pixels (stars,
+    // the photon ring) can't flicker the whole bloom as they move
+    float2 center = float2(tid) * 2.0 + 1.0;
+    float3 sum = float3(0.0);
+    float weightSum = 0.0;
+    for (int i = 0; i < 4; i++) {
+        float2 offset = float2(i & 1 ? 1.0 : -1.0, i & 2 ? 1.0 : -1.0);
+        float3 color = sample_region(radiance, center + offset, params.sourceSize) * params.exposure;
+        color = all(isfinite(color)) ? color : float3(0.0); // Flagged pixels don't bloom
+        float weight = 1.0 / (1.0 + dot(color, float3(0.2126, 0.7152, 0.0722)));
+        sum += color * weight;
+        weightSum += weight;
+    }
+    bloom.write(float4(bloom_threshold(sum / weightSum, params.bloomThreshold), 1.0), tid);
+}
+
+kernel void post_bloom_downsample(
+    texture2d<float> source [[texture(0)]],
+    texture2d<float, access::write> target [[texture(1)]],
+    constant PostParams& params [[buffer(0)]],
+    uint2 tid [[thread_position_in_grid]])
+{
+    if (tid.x >= params.targetSize.x || tid.y >= params.targetSize.y) {
+        return;
+    }
+    target.write(float4(downsample_box(source, tid, params.sourceSize), 1.0), tid);
+}
+
+// 3x3 tent over the smaller level, added to the same-size level of the down chain
+kernel void post_bloom_upsample(
+    texture2d<float> coarse [[texture(0)]],
+    texture2d<float, access::write> target [[texture(1)]],
+    texture2d<float, access::read> detail [[texture(2)]],
+    constant PostParams& params [[buffer(0)]],
+    uint2 tid [[thread_position_in_grid]])
+{
+    if (tid.x >= params.targetSize.x || tid.y >= params.targetSize.y) {
+        return;
+    }
+
+    float2 position = (float2(tid) + 0.5) * 0.5;
+    float3 blurred = float3(0.0);
+    for (int y = -1; y <= 1; y++) {
+        for (int x = -1; x <= 1; x++) {
+            float weight = (x == 0 ? 2.0 : 1.0) * (y == 0 ? 2.0 : 1.0) / 16.0;
+            blurred += sample_region(coarse, position + float2(x, y), params.sourceSize) * weight;
+        }
+    }
+    target.write(float4(detail.read(tid).rgb + blurred, 1.0), tid);
+}
+
+kernel void post_composite(
+    texture2d<float, access::read> radiance [[texture(0)]],
+    texture2d<float> bloom [[texture(1)]],
+    texture2d<float, access::write> output_texture [[texture(2)]],
+    constant PostParams& params [[buffer(0)]],
+    uint2 tid [[thread_position_in_grid]])
+{
+    if (tid.x >= params.targetSize.x || tid.y >= params.targetSize.y) {
+        return;
+    }
+
+    float3 color = radiance.read(tid).rgb;
+    if (params.raw) {
+        output_texture.write(float4(saturate(color), 1.0), tid);
+        return;
+    }
+    color *= params.exposure;
+    if (params.bloomStrength > 0.0 && all(isfinite(color))) {
+        color += sample_region(bloom, (float2(tid) + 0.5) * 0.5, params.sourceSize) * params.bloomStrength;
+    }
+    output_texture.write(display_color(color), tid);
+}
@@ -0,0 +1,27 @@
+#include <metal_stdlib>
+using namespace metal;
+
+// Zero-copy presentation of the ray tracing output texture.
+// Draws a single fullscreen triangle into the current viewport. uvScale selects
+// the rendered sub-rect when the frame was traced below full size.
+
+struct PresentVertexOut {
+    float4 position [[position]];
+    float2 uv;
+};
+
+vertex PresentVertexOut present_vertex(uint vid [[vertex_id]]) {
+    // Fullscreen triangle: (-1,-1), (3,-1), (-1,3)
+    float2 pos = float2((vid << 1) & 2, vid & 2);
+    PresentVertexOut out;
+    out.position = float4(pos * 2.0 - 1.0, 0.0, 1.0);
+    out.uv = float2(pos.x, 1.0 - pos.y); // Texture origin is top-left
+    return out;
+}
+
+fragment float4 present_fragment(PresentVertexOut in [[stage_in]],
+                                 texture2d<float> frame [[texture(0)]],
+                                 sampler frameSampler [[sampler(0)]],
+                                 constant float2& uvScale [[buffer(0)]]) {
+    return float4(frame.sample(frameSampler, in.uv * uvScale).rgb, 1.0);
+}
@@ -1,5 +1,6 @@
 #include <metal_stdlib>
 using namespace metal;
+#include "ToneMapping.h"
 
 // Constants
 constant float RS = 2.0; // Schwarzschild radius (mass = 1.0)
@@ -9,6 +10,85 @@ constant float MAX_DIST = 100.0;
 constant float MIN_STEP = 0.02;
 constant float MAX_STEP = 0.5;
 
+// Accretion disk geometry
+constant float DISK_INNER = RS * 2.5;
+constant float DISK_OUTER = RS * 12.0;
+constant float DISK_HALF_THICKNESS = 0.2; // Volumetric slab bound (|y|)
+constant float DISK_FALLOFF = 10.0;       // Vertical density falloff exp(-|y| * k)
+
+// Disk-crossing trace mode
+constant float FAR_FIELD_STEP = 0.25;     // Step as a fraction of r once outbound past the disk
+constant float FAR_MAX_STEP = 8.0;
+constant int CROSSING_REFINE_STEPS = 6;   // Bisection iterations on the Hermite segment
+constant float MIN_SLAB_COSINE = 0.05;    // Limits the slab path length for grazing rays
+
+// Adaptive Binet trace mode
+constant float BINET_INITIAL_STEP = 0.05;  // First angular step (radians), the error control takes over
+constant float BINET_MAX_STEP = 0.5;       // Largest angular step (radians)
+constant int BINET_MAX_STEPS = 512;        // Accepted and rejected steps before a ray counts as trapped
+constant float BINET_MAX_SWEEP = 8.0 * PI; // Orbits winding further than this stay on the photon sphere
+constant int BINET_ROOT_ITERATIONS = 3;    // Newton iterations on the Hermite for the escape sub-step
+
+// Kerr geodesics (KERR_GEODESICS variant, spin != 0)
+constant float KERR_STEP = 0.04;             // Largest change of ln(r - r+), theta or phi per Mino-time step
+constant int KERR_MAX_STEPS = 1024;          // Steps before a ray counts as trapped
+constant float KERR_ESCAPE_RADIUS = 1000.0;  // Outbound rays past this are escaped (remaining bending is negligible)
+constant float KERR_HORIZON_MARGIN = 1e-3;   // Absorbed within this fraction of r+
+
+// Trace modes
+constant int TRACE_VOLUMETRIC = 0;        // Sample disk density at every step
+constant int TRACE_DISK_CROSSING = 1;     // Shade only where the ray crosses the disk plane
+constant int TRACE_GEODESIC_LUT = 2;      // Precomputed Schwarzschild orbits, no integration
+constant int TRACE_ADAPTIVE_BINET = 3;    // Error-controlled integration of the orbit u(phi)
+
+// Geodesic lookup tables (layout must match GeodesicLUT.hpp)
+constant int LUT_IMPACT_SAMPLES = 512;
+constant int LUT_CAPTURED_ROWS = 256;
+constant int LUT_BRANCH_SAMPLES = 256;
+constant float LUT_MAX_IMPACT = 64.0;
+constant float LUT_CRITICAL_EPSILON = 1e-3;
+constant float LUT_CRITICAL_IMPACT = 1.5 * 1.7320508 * RS; // 3 * sqrt(3) * M
+constant float LUT_MIN_RADIUS = RS * 2.0;  // Closer cameras fall back to integration
+
+// Blackbody palette (colour mode 4) tables (layout must match DiskShadingLUT.hpp)
+constant int COLOR_MODE_BLACKBODY = 4;
+constant int DISK_PROFILE_SAMPLES = 256;       // {T / peak, sqrt(1 - RS/r), beta, gamma} over DISK_INNER..DISK_OUTER
+constant int BLACKBODY_SAMPLES = 256;          // Linear sRGB, log-spaced temperatures
+constant float BLACKBODY_MIN_TEMPERATURE = 500.0;
+constant float BLACKBODY_MAX_TEMPERATURE = 50000.0;
+constant float DISK_PEAK_TEMPERATURE = 9000.0; // Kelvin, hottest ring
+constexpr sampler shading_lut_sampler(coord::normalized, address::clamp_to_edge, filter::linear);
+
+// Sky cubemap (baked by Skybox.metal), trilinear with the mip picked by the pixel footprint
+constant float SKY_MAX_LENSING_STRETCH = 64.0; // Caps the footprint growth toward the shadow edge
+constexpr sampler sky_sampler(filter::linear, mip_filter::linear);
+
+// Foveated rendering: one coarse ray per FOVEA_TILE x FOVEA_TILE tile
+constant int FOVEA_TILE = 4;
+constant float FOVEA_DIRECTION_TOLERANCE = 3.0; // Escape-direction spread (in coarse spacings) that forces refinement
+
+// Progressive refinement (Uniforms.accumulationIndex): samples per pixel after
+// which a still frame is only re-resolved (must match kMaxAccumulationSamples)
+constant int ACCUMULATION_MAX_SAMPLES = 1024;
+
+// How a ray ended (coarse pass classification)
+constant uint FATE_ESCAPED = 0;
+constant uint FATE_HORIZON = 1;
+constant uint FATE_DISK = 2;
+
+// Disk crossings recorded per ray by the crossing-based trace modes (and the geodesic cache)
+constant int GEO_MAX_CROSSINGS = 3;
+
+// Diagnostics view (Uniforms.diagnostics): why each trace stopped
+// (must match METAL_RT_TERMINATION_* in MetalRTRenderer.h)
+constant uint TERMINATION_ESCAPED = 0;   // Outbound past the disk, or reached u = 0
+constant uint TERMINATION_HORIZON = 1;
+constant uint TERMINATION_OPAQUE = 2;    // Volumetric transmittance fell to the 0.01 cutoff
+constant uint TERMINATION_EXHAUSTED = 3; // MAX_DIST (or the Binet step/sweep budget) ran out first
+constant uint TERMINATION_COUNT = 4;
+constant uint DIAGNOSTIC_STEP_BINS = 4096;       // Step histogram bins (must match kDiagnosticStepBins)
+constant float DIAGNOSTIC_HEATMAP_STEPS = 1024.0; // Step count at the top of the false-colour scale
+
 // Structures matching C++ layout
 // Note: Metal float3 is 16-byte aligned, but C++ uses float[3] which is 12 bytes
 // So we use packed_float3 or match the exact C++ layout
@@ -27,8 +107,74 @@ struct Uniforms {
     Camera camera;
     uint2 resolution;
     float time;
-    int colorMode; // 0=blue, 1=orange, 2=red, 3=white
+    int colorMode; // 0=blue, 1=orange, 2=red, 3=white, 4=blackbody
     float colorIntensity; // Brightness multiplier for accretion disk
+    int traceMode; // 0=volumetric, 1=disk-plane crossing, 2=geodesic LUT, 3=adaptive Binet
+    int writeCache; // Store crossing-based traces in the geodesic cache
+    float integratorTolerance; // Adaptive Binet: local error bound per step (relative to 1/RS)
+    int diagnostics; // Output the step count heatmap and record per-pixel trace statistics
+    int captureHDR; // Also store the linear color before tone mapping (HDR screenshots)
+    float spin; // Kerr a / M (the renderer clamps it to the Thorne limit); 0 = Schwarzschild
+    int accumulationIndex; // Still scene: sample added to the accumulation buffer (0 restarts), -1 = off
+};
+
+// Pipeline specialization (MTLFunctionConstantValues, see MetalRTRenderer.mm):
+// variants bake the palette and trace mode in so the compiler folds away the
+// other branches; the generic pipelines leave them undefined and read Uniforms
+constant int SPECIALIZED_COLOR_MODE [[function_constant(0)]];
+constant int SPECIALIZED_TRACE_MODE [[function_constant(1)]];
+constant bool HAS_SPECIALIZED_COLOR_MODE = is_function_constant_defined(SPECIALIZED_COLOR_MODE);
+constant bool HAS_SPECIALIZED_TRACE_MODE = is_function_constant_defined(SPECIALIZED_TRACE_MODE);
+
+// Kerr variant of ray_generation: only it contains the Kerr integrator, so
+// Schwarzschild pipelines (the default, spin = 0) keep their fast path
+constant bool KERR_GEODESICS [[function_constant(2)]];
+constant bool USE_KERR_GEODESICS = is_function_constant_defined(KERR_GEODESICS) && KERR_GEODESICS;
+
+int active_color_mode(constant Uniforms& uniforms) {
+    return HAS_SPECIALIZED_COLOR_MODE ? SPECIALIZED_COLOR_MODE : uniforms.colorMode;
+}
+
+int active_trace_mode(constant Uniforms& uniforms) {
+    return HAS_SPECIALIZED_TRACE_MODE ? SPECIALIZED_TRACE_MODE : uniforms.traceMode;
+}
+
+// Spinning hole: every trace mode becomes the Kerr crossing trace
+bool kerr_active(constant Uniforms& uniforms) {
+    return USE_KERR_GEODESICS && uniforms.spin != 0.0;
+}
+
+// Offline tiled rendering: one tile of a (possibly huge) image, accumulated
+// over several jittered passes (must match TileParams in MetalRTRenderer.mm)
+struct TileParams {
+    uint2 origin;     // Tile position in the full image
+    uint2 size;       // Tile size in pixels
+    uint sampleIndex; // Pass being accumulated (0 clears the accumulator)
+    float exposure;   // Linear exposure of the resolve
+};
+
+// Per-pixel geodesic cache entry (must match GeodesicCacheEntry in MetalRTRenderer.mm)
+// Everything the crossing-based modes need to re-shade a pixel when only time changes
+struct GeodesicCacheEntry {
+    half4 crossings[GEO_MAX_CROSSINGS]; // r, disk angle, Doppler delta, slab path scale
+    packed_float3 escapeDir;
+    ushort crossingCount;
+    ushort absorbed;
+};
+
+// Cost and termination of one trace (diagnostics view); unused fields fold away otherwise
+struct TraceStats {
+    uint steps;          // Integration steps, rejected adaptive steps included
+    uint termination;    // TERMINATION_*
+    float transmittance; // Remaining transmittance after the disk
+};
+
+// Disk crossings and fate of one ray, before shading
+struct GeodesicRecord {
+    float4 crossings[GEO_MAX_CROSSINGS]; // r, disk angle, Doppler delta, slab path scale
+    int crossingCount;
+    bool absorbed;
+    float3 escapeDir;
 };
 
 // Vector math utilities
@@ -74,17 +220,10 @@ void rk4_step(thread float3& pos, thread float3& vel, float dt) {
     vel = normalize(vel);
 }
 
-// Accretion disk density
-float disk_density(float3 pos, float time) {
-    float r = length(pos);
-    
-    // Disk bounds
-    if (r < RS * 2.5 || r > RS * 12.0) return 0.0;
-    if (abs(pos.y) > 0.2) return 0.0;
-    
+// Disk surface pattern (in-plane part of the density, no vertical falloff)
+float disk_pattern(float angle, float r, float time) {
     // Procedural pattern with time-based rotation
     // Rotate the disk pattern over time to create animation
-    float angle = atan2(pos.z, pos.x);
     float rotationSpeed = 1.0; // Rotation speed (increased for more visible animation)
     float rotatedAngle = angle + time * rotationSpeed;
     float spiral = sin(rotatedAngle * 3.0 + r * 0.5);
@@ -96,7 +235,18 @@ float disk_density(float3 pos, float time) {
     if (r < RS * 3.0) fade = (r - RS * 2.5) / (RS * 0.5);
     if (r > RS * 10.0) fade = (RS * 12.0 - r) / (RS * 2.0);
     
-    return noise * fade * exp(-abs(pos.y) * 10.0);
+    return noise * fade;
+}
+
+// Accretion disk density
+float disk_density(float3 pos, float time) {
+    float r = length(pos);
+    
+    // Disk bounds
+    if (r < DISK_INNER || r > DISK_OUTER) return 0.0;
+    if (abs(pos.y) > DISK_HALF_THICKNESS) return 0.0;
+    
+    return disk_pattern(atan2(pos.z, pos.x), r, time) * exp(-abs(pos.y) * DISK_FALLOFF);
 }
 
 // Calculate Doppler beaming factor
@@ -127,8 +277,33 @@ float doppler_factor(float3 pos, float3 ray_dir) {
     return delta;
 }
 
-// Disk color based on temperature with multiple color palettes and Doppler effects
-float3 disk_color(float density, float r, float3 pos, float3 ray_dir, int colorMode, float colorIntensity) {
+// Per-radius disk quantities {T / peak, sqrt(1 - RS/r), beta, gamma} (linearly interpolated)
+float4 disk_profile_at(texture1d<float> diskProfile, float r) {
+    float x = saturate((r - DISK_INNER) / (DISK_OUTER - DISK_INNER));
+    return diskProfile.sample(shading_lut_sampler,
+                              (x * float(DISK_PROFILE_SAMPLES - 1) + 0.5) / float(DISK_PROFILE_SAMPLES));
+}
+
+// Same as doppler_factor, with beta and gamma taken from the profile
+float doppler_factor_lut(float4 profile, float3 pos, float3 ray_dir) {
+    float3 tangent = float3(pos.z, 0.0, -pos.x) * rsqrt(max(pos.x * pos.x + pos.z * pos.z, 1e-6));
+    return 1.0 / (profile.w * (1.0 + profile.z * dot(tangent, ray_dir)));
+}
+
+// Blackbody disk: the profile temperature shifted by g = delta * sqrt(1 - RS/r)
+// is still a blackbody, so the observed colour (and brightness) is one fetch
+float3 disk_color_blackbody(float density, float4 profile, float delta, float colorIntensity,
+                            texture1d<float> blackbody) {
+    float kelvin = profile.x * DISK_PEAK_TEMPERATURE * delta * profile.y;
+    float x = saturate(log2(kelvin / BLACKBODY_MIN_TEMPERATURE) /
+                       log2(BLACKBODY_MAX_TEMPERATURE / BLACKBODY_MIN_TEMPERATURE));
+    float3 radiance = blackbody.sample(shading_lut_sampler,
+                                       (x * float(BLACKBODY_SAMPLES - 1) + 0.5) / float(BLACKBODY_SAMPLES)).rgb;
+    return radiance * density * 4.0 * colorIntensity;
+}
+
+// Disk color based on temperature with multiple color palettes and a given Doppler factor
+float3 disk_color_palette(float density, float r, float delta, int colorMode, float colorIntensity) {
     float t = (r - RS * 2.5) / (RS * 9.5);
     t = clamp(t, 0.0, 1.0);
     
@@ -174,11 +349,8 @@ float3 disk_color(float density, float r, float3 pos, float3 ray_dir, int colorM
         base_color = mix(mid, cold, (t - 0.5) * 2.0);
     }
     
-    // Apply Doppler beaming
-    float delta = doppler_factor(pos, ray_dir);
-    
     // Intensity boost: I_observed = I_emitted * δ^3 (for emission)
-    float intensity_boost = pow(delta, 3.0);
+    float intensity_boost = delta * delta * delta;
     
     // Frequency shift affects color
     float3 doppler_color = base_color;
@@ -195,8 +367,39 @@ float3 disk_color(float density, float r, float3 pos, float3 ray_dir, int colorM
     return doppler_color * density * 4.0 * intensity_boost * colorIntensity;
 }
 
-// Background starfield with time-based rotation
-float3 sample_background(float3 dir, float time) {
+// Disk color for a given Doppler factor (crossing-based modes store it per crossing)
+float3 disk_color_shifted(float density, float r, float delta, int colorMode, float colorIntensity,
+                          texture1d<float> diskProfile, texture1d<float> blackbody) {
+    if (colorMode == COLOR_MODE_BLACKBODY) {
+        return disk_color_blackbody(density, disk_profile_at(diskProfile, r), delta, colorIntensity, blackbody);
+    }
+    return disk_color_palette(density, r, delta, colorMode, colorIntensity);
+}
+
+// Disk color with Doppler effects at a volumetric sample: one profile fetch
+// replaces the per-step sqrt and normalize of doppler_factor
+float3 disk_color(float density, float r, float3 pos, float3 ray_dir, int colorMode, float colorIntensity,
+                  texture1d<float> diskProfile, texture1d<float> blackbody) {
+    float4 profile = disk_profile_at(diskProfile, r);
+    float delta = doppler_factor_lut(profile, pos, ray_dir);
+    if (colorMode == COLOR_MODE_BLACKBODY) {
+        return disk_color_blackbody(density, profile, delta, colorIntensity, blackbody);
+    }
+    return disk_color_palette(density, r, delta, colorMode, colorIntensity);
+}
+
+// Angular footprint of a camera ray on the sky: the pixel's angle, stretched
+// by lensing (weak-field magnification 1 + 2 RS D / b^2, b = impact parameter)
+float sky_footprint(constant Uniforms& uniforms, float3 dir) {
+    float3 origin = float3(uniforms.camera.position);
+    float pixelAngle = 2.0 * tan(uniforms.camera.fov * PI / 360.0) / float(uniforms.resolution.y);
+    float3 h = cross_product(origin, dir);
+    float b2 = max(dot(h, h), RS * RS);
+    return pixelAngle * min(1.0 + 2.0 * RS * length(origin) / b2, SKY_MAX_LENSING_STRETCH);
+}
+
+// Background sky with time-based rotation, filtered over the ray's footprint
+float3 sample_background(float3 dir, float time, texturecube<float> sky, float footprint) {
     // Rotate background over time for continuous animation
     float rotationAngle = time * 0.1; // Slow rotation speed
     float cosRot = cos(rotationAngle);
@@ -208,42 +411,50 @@ float3 sample_background(float3 dir, float time) {
     rotatedDir.y = dir.y;
     rotatedDir.z = dir.x * sinRot + dir.z * cosRot;
     
-    float u = 0.5 + atan2(rotatedDir.z, rotatedDir.x) / (2.0 * PI);
-    float v = 0.5 - asin(rotatedDir.y) / PI;
-    
-    float3 color = float3(0.0);  // Pure black background
-    
-    // Stars only (no galaxy band)
-    uint hash = uint(u * 4000.0) * 19349663u + uint(v * 4000.0) * 83492791u;
-    if ((hash % 1000u) < 2u) {
-        color += float3(1.0) * (0.5 + float(hash % 100u) / 200.0);
-    }
-    
-    return color;
+    // A face texel spans about (pi / 2) / size radians
+    float texelAngle = 0.5 * PI / float(sky.get_width());
+    float lod = max(log2(footprint / texelAngle), 0.0);
+    return sky.sample(sky_sampler, rotatedDir, level(lod)).rgb;
+}
+
+// Termination of a ray that ran out of distance: escaped when it is already
+// outbound past the disk (nothing left to hit), exhausted otherwise
+uint unbound_termination(float3 pos, float3 vel) {
+    return dot(pos, pos) > DISK_OUTER * DISK_OUTER && dot(pos, vel) > 0.0 ? TERMINATION_ESCAPED
+                                                                           : TERMINATION_EXHAUSTED;
 }
 
 // Full volumetric ray tracing
-float3 trace_ray(float3 origin, float3 direction, float time, int colorMode, float colorIntensity) {
+float3 trace_ray(float3 origin, float3 direction, float time, int colorMode, float colorIntensity,
+                 texture1d<float> diskProfile, texture1d<float> blackbody, texturecube<float> sky, float skyFootprint,
+                 thread uint& fate, thread float3& escapeDir, thread TraceStats& stats) {
     float3 pos = origin;
     float3 vel = direction;
     
     float3 accumulatedColor = float3(0.0);
     float transmittance = 1.0;
     float totalDist = 0.0;
+    fate = FATE_ESCAPED;
+    stats.steps = 0;
     
     while (totalDist < MAX_DIST && transmittance > 0.01) {
         float r2 = dot(pos, pos);
         
         // Event Horizon
         if (r2 < RS * RS) {
+            fate = FATE_HORIZON;
+            escapeDir = vel;
+            stats.termination = TERMINATION_HORIZON;
+            stats.transmittance = transmittance;
             return accumulatedColor; // Black (absorbed)
         }
         
         // Volumetric Accretion Disk Integration
         float density = disk_density(pos, time);
         if (density > 0.001) {
+            fate = FATE_DISK;
             float r = sqrt(r2);
-            float3 emission = disk_color(density, r, pos, vel, colorMode, colorIntensity);
+            float3 emission = disk_color(density, r, pos, vel, colorMode, colorIntensity, diskProfile, blackbody);
             float absorption = density * 0.5;
             
             // Beer's Law integration for this step
@@ -262,26 +473,780 @@ float3 trace_ray(float3 origin, float3 direction, float time, int colorMode, flo
         
         // RK4 integration
         rk4_step(pos, vel, dt);
+        stats.steps++;
         
         totalDist += dt;
     }
     
         // Add background if ray escapes - pass time for rotation
-        accumulatedColor += sample_background(vel, time) * transmittance;
+        accumulatedColor += sample_background(vel, time, sky, skyFootprint) * transmittance;
     
+    escapeDir = vel;
+    stats.termination = transmittance <= 0.01 ? TERMINATION_OPAQUE : unbound_termination(pos, vel);
+    stats.transmittance = transmittance;
     return accumulatedColor;
 }
 
+// Cubic Hermite interpolation of an RK4 step (position and direction at s in [0,1])
+float3 hermite_position(float3 p0, float3 v0, float3 p1, float3 v1, float dt, float s) {
+    float s2 = s * s;
+    float s3 = s2 * s;
+    return p0 * (2.0 * s3 - 3.0 * s2 + 1.0) + v0 * (dt * (s3 - 2.0 * s2 + s)) +
+           p1 * (3.0 * s2 - 2.0 * s3) + v1 * (dt * (s3 - s2));
+}
+
+float3 hermite_direction(float3 p0, float3 v0, float3 p1, float3 v1, float dt, float s) {
+    float s2 = s * s;
+    float3 d = (p0 - p1) * (6.0 * s2 - 6.0 * s) + v0 * (dt * (3.0 * s2 - 4.0 * s + 1.0)) +
+               v1 * (dt * (3.0 * s2 - 2.0 * s));
+    return normalize(d);
+}
+
+// Record a disk-plane hit: everything shading needs that does not depend on time
+void record_disk_crossing(thread GeodesicRecord& record, float3 hit, float hitR, float3 hitDir) {
+    if (record.crossingCount >= GEO_MAX_CROSSINGS) {
+        return;
+    }
+    float pathScale = 1.0 / max(abs(hitDir.y), MIN_SLAB_COSINE);
+    record.crossings[record.crossingCount++] =
+        float4(hitR, atan2(hit.z, hit.x), doppler_factor(hit, hitDir), pathScale);
+}
+
+// Shade the recorded slab crossings front to back, then the background
+float3 shade_geodesic_record(thread const GeodesicRecord& record, float time, int colorMode, float colorIntensity,
+                             texture1d<float> diskProfile, texture1d<float> blackbody,
+                             texturecube<float> sky, float skyFootprint, thread float& transmittance) {
+    // Vertical column density of the slab: integral of exp(-|y| * k) over |y| < h
+    float slabColumn = 2.0 * (1.0 - exp(-DISK_HALF_THICKNESS * DISK_FALLOFF)) / DISK_FALLOFF;
+    
+    float3 accumulatedColor = float3(0.0);
+    transmittance = 1.0;
+    
+    for (int i = 0; i < record.crossingCount && transmittance > 0.01; i++) {
+        float4 crossing = record.crossings[i];
+        float pattern = disk_pattern(crossing.y, crossing.x, time);
+        if (pattern <= 0.0) {
+            continue;
+        }
+        
+        // Optical depth of the slab along the ray (same absorption as volumetric mode)
+        float opticalDepth = pattern * 0.5 * slabColumn * crossing.w;
+        float slabTransmittance = exp(-opticalDepth);
+        
+        float3 emission = disk_color_shifted(pattern, crossing.x, crossing.z, colorMode, colorIntensity,
+                                             diskProfile, blackbody);
+        accumulatedColor += emission * transmittance * (1.0 - slabTransmittance);
+        transmittance *= slabTransmittance;
+    }
+    
+    if (record.absorbed) {
+        return accumulatedColor; // Black (absorbed)
+    }
+    
+    // Add background if ray escapes - pass time for rotation
+    return accumulatedColor + sample_background(record.escapeDir, time, sky, skyFootprint) * transmittance;
+}
+
+float3 shade_geodesic_record(thread const GeodesicRecord& record, float time, int colorMode, float colorIntensity,
+                             texture1d<float> diskProfile, texture1d<float> blackbody,
+                             texturecube<float> sky, float skyFootprint) {
+    float transmittance;
+    return shade_geodesic_record(record, time, colorMode, colorIntensity, diskProfile, blackbody, sky, skyFootprint,
+                                 transmittance);
+}
+
+// Disk-plane crossing ray tracing
+// Instead of sampling density at every step, detect the sign change of pos.y
+// between two RK4 steps, locate the crossing on the step's Hermite curve and
+// shade the slab once with its real optical depth. Far-field steps grow with r
+// once the ray has left the disk and is moving outward.
+GeodesicRecord trace_ray_disk_crossing(float3 origin, float3 direction, thread TraceStats& stats) {
+    float3 pos = origin;
+    float3 vel = direction;
+    
+    GeodesicRecord record;
+    record.crossingCount = 0;
+    record.absorbed = false;
+    float totalDist = 0.0;
+    stats.steps = 0;
+    stats.transmittance = 1.0; // Known only once the record is shaded
+    
+    while (totalDist < MAX_DIST) {
+        float r2 = dot(pos, pos);
+        
+        // Event Horizon
+        if (r2 < RS * RS) {
+            record.absorbed = true; // Black (absorbed)
+            record.escapeDir = vel;
+            stats.termination = TERMINATION_HORIZON;
+            return record;
+        }
+        
+        // Adaptive Step
+        float r = sqrt(r2);
+        float dt = STEP_SIZE * (r / (RS * 2.0 + 0.1));
+        if (dt < MIN_STEP) dt = MIN_STEP;
+        if (dt > MAX_STEP) dt = MAX_STEP;
+        
+        // Past the disk and outbound: Schwarzschild rays have no turning point
+        // while r grows, so only the (weak) residual bending is left to integrate
+        if (r > DISK_OUTER && dot(pos, vel) > 0.0) {
+            dt = min(max(dt, r * FAR_FIELD_STEP), FAR_MAX_STEP);
+        }
+        
+        float3 p0 = pos;
+        float3 v0 = vel;
+        rk4_step(pos, vel, dt);
+        stats.steps++;
+        totalDist += dt;
+        
+        // Disk plane crossing between p0 and pos
+        if ((p0.y > 0.0) == (pos.y > 0.0)) {
+            continue;
+        }
+        
+        float lo = 0.0;
+        float hi = 1.0;
+        for (int i = 0; i < CROSSING_REFINE_STEPS; i++) {
+            float mid = 0.5 * (lo + hi);
+            float y = hermite_position(p0, v0, pos, vel, dt, mid).y;
+            if ((y > 0.0) == (p0.y > 0.0)) lo = mid; else hi = mid;
+        }
+        float s = 0.5 * (lo + hi);
+        float3 hit = hermite_position(p0, v0, pos, vel, dt, s);
+        hit.y = 0.0;
+        float hitR = length(hit);
+        if (hitR < DISK_INNER || hitR > DISK_OUTER) {
+            continue;
+        }
+        
+        float3 hitDir = hermite_direction(p0, v0, pos, vel, dt, s);
+        record_disk_crossing(record, hit, hitR, hitDir);
+        
+        // The record is full, so later crossings would be dropped anyway. A
+        // slab pass only dims the light behind it, so the ray is not opaque:
+        // stop integrating and shade the background along the current
+        // direction with whatever transmittance the crossings leave
+        if (record.crossingCount == GEO_MAX_CROSSINGS) {
+            record.escapeDir = vel;
+            stats.termination = unbound_termination(pos, vel);
+            return record;
+        }
+    }
+    
+    record.escapeDir = vel;
+    stats.termination = unbound_termination(pos, vel);
+    return record;
+}
+
+// Record the point at angle phi of an orbit u(phi) in the plane spanned by e1
+// and e2 (phi measured from e1) if it lies on the disk
+void record_orbit_crossing(thread GeodesicRecord& record, float3 e1, float3 e2, float phi, float u, float dudphi) {
+    float r = 1.0 / u;
+    float c = cos(phi);
+    float s = sin(phi);
+    float3 radial = e1 * c + e2 * s;
+    float3 hit = radial * r;
+    hit.y = 0.0;
+    float hitR = length(hit);
+    if (hitR < DISK_INNER || hitR > DISK_OUTER) {
+        return;
+    }
+    
+    // dr/dphi = -u'/u^2 along the radial direction, r along the tangential one
+    float3 hitDir = normalize(radial * (-dudphi / (u * u)) + (e2 * c - e1 * s) * r);
+    record_disk_crossing(record, hit, hitR, hitDir);
+}
+
+// First angle > 0 where the orbital plane meets the disk plane:
+// cos(phi) e1.y + sin(phi) e2.y = 0, repeating every PI
+float first_disk_plane_angle(float3 e1, float3 e2) {
+    float phi = atan2(-e1.y, e2.y);
+    while (phi <= 1e-4) phi += PI;
+    return phi;
+}
+
+// Bilinear fetch from a LUT texture; the row range keeps captured and
+// scattered impact parameters from blending across b_crit
+float2 lut_fetch(texture2d<float, access::read> table, float row, float col, float rowLo, float rowHi) {
+    row = clamp(row, rowLo, rowHi);
+    col = clamp(col, 0.0, float(table.get_width() - 1));
+    float r0 = floor(row);
+    float c0 = floor(col);
+    float fr = row - r0;
+    float fc = col - c0;
+    uint r1 = uint(min(r0 + 1.0, rowHi));
+    uint c1 = uint(min(c0 + 1.0, float(table.get_width() - 1)));
+    float2 a = mix(table.read(uint2(uint(c0), uint(r0))).xy, table.read(uint2(c1, uint(r0))).xy, fc);
+    float2 b = mix(table.read(uint2(uint(c0), r1)).xy, table.read(uint2(c1, r1)).xy, fc);
+    return mix(a, b, fr);
+}
+
+// Inverse of GeodesicLUT::impactForRow
+float lut_row(float b, thread float& rowLo, thread float& rowHi) {
+    if (b < LUT_CRITICAL_IMPACT) {
+        float bLo = LUT_CRITICAL_IMPACT * (1.0 - LUT_CRITICAL_EPSILON);
+        float x = 1.0 - sqrt(max(1.0 - b / bLo, 0.0));
+        rowLo = 0.0;
+        rowHi = float(LUT_CAPTURED_ROWS - 1);
+        return x * rowHi;
+    }
+    float bHi = LUT_CRITICAL_IMPACT * (1.0 + LUT_CRITICAL_EPSILON);
+    float x = sqrt(clamp((b - bHi) / (LUT_MAX_IMPACT - bHi), 0.0, 1.0));
+    rowLo = float(LUT_CAPTURED_ROWS);
+    rowHi = float(LUT_IMPACT_SAMPLES - 1);
+    return rowLo + x * float(LUT_IMPACT_SAMPLES - LUT_CAPTURED_ROWS - 1);
+}
+
+// Geodesic LUT ray tracing
+// A Schwarzschild ray stays in the plane spanned by the camera position and
+// the ray direction. Its orbit u(phi) comes from the tables, so the disk
+// crossings (where the orbit meets y = 0) and the escape direction are found
+// with a few fetches and a rotation back into 3D instead of integrating.
+GeodesicRecord trace_ray_lut(float3 origin, float3 direction,
+                             texture2d<float, access::read> lutRadius,
+                             texture2d<float, access::read> lutAngle,
+                             texture2d<float, access::read> lutBranch,
+                             thread TraceStats& stats) {
+    float r0 = length(origin);
+    if (r0 < LUT_MIN_RADIUS || r0 > LUT_MAX_IMPACT) {
+        return trace_ray_disk_crossing(origin, direction, stats);
+    }
+    
+    // Orbital plane basis: e1 towards the camera, e2 along the initial tangential motion
+    float3 e1 = origin / r0;
+    float cosA = dot(direction, e1);
+    float3 tangential = direction - e1 * cosA;
+    float sinA = length(tangential);
+    float3 e2;
+    if (sinA > 1e-6) {
+        e2 = tangential / sinA;
+    } else {
+        // Radial ray: any perpendicular works, the orbit sweeps no angle
+        float3 helper = abs(e1.y) < 0.9 ? float3(0.0, 1.0, 0.0) : float3(1.0, 0.0, 0.0);
+        e2 = normalize(cross_product(helper, e1));
+    }
+    
+    // Impact parameter at infinity: the geodesic_acceleration model conserves
+    // h = |pos x vel| and v^2 - RS h^2 u^3, so 1/b^2 = 1/(r0 sinA)^2 - RS u0^3
+    float u0 = 1.0 / r0;
+    float hCam = max(r0 * sinA, 1e-6);
+    float b = rsqrt(max(1.0 / (hCam * hCam) - RS * u0 * u0 * u0, 1e-12));
+    bool captured = b < LUT_CRITICAL_IMPACT;
+    bool inbound = cosA < 0.0;
+    
+    float rowLo, rowHi;
+    float row = lut_row(b, rowLo, rowHi);
+    float2 branch = lut_fetch(lutBranch, row, 0.0, rowLo, rowHi);
+    float phiEnd = branch.x;
+    float uEnd = branch.y;
+    
+    // Camera position along the inbound branch
+    float w = 1.0 - sqrt(clamp(1.0 - u0 / uEnd, 0.0, 1.0));
+    float psi0 = lut_fetch(lutAngle, row, w * float(LUT_BRANCH_SAMPLES - 1), rowLo, rowHi).x;
+    
+    // Sweep: inbound rays run to periapsis (or the horizon), then back out to infinity
+    float inSweep = inbound ? max(phiEnd - psi0, 0.0) : 0.0;
+    float outStart = inbound ? phiEnd : psi0;
+    bool absorbed = inbound && captured;
+    float totalSweep = inSweep + (absorbed ? 0.0 : outStart);
+    
+    GeodesicRecord record;
+    record.crossingCount = 0;
+    record.absorbed = absorbed;
+    
+    // Disk plane crossings
+    if (abs(e1.y) + abs(e2.y) > 1e-6) {
+        for (float phi = first_disk_plane_angle(e1, e2);
+             record.crossingCount < GEO_MAX_CROSSINGS && phi < totalSweep; phi += PI) {
+            bool onInbound = phi < inSweep;
+            float psi = onInbound ? psi0 + phi : outStart - (phi - inSweep);
+            float t = phiEnd > 0.0 ? clamp(psi / phiEnd, 0.0, 1.0) : 0.0;
+            float u = lut_fetch(lutRadius, row, t * float(LUT_BRANCH_SAMPLES - 1), rowLo, rowHi).x;
+            if (u <= 0.0) continue;
+            
+            // Photon direction from the Binet first integral (u')^2 = 1/b^2 - u^2 + RS u^3
+            float dudphi = sqrt(max(1.0 / (b * b) - u * u + RS * u * u * u, 0.0));
+            if (!onInbound) dudphi = -dudphi;
+            record_orbit_crossing(record, e1, e2, phi, u, dudphi);
+        }
+    }
+    
+    // Escape direction is radial at the asymptotic angle
+    record.escapeDir = e1 * cos(totalSweep) + e2 * sin(totalSweep);
+    stats.steps = 0; // Table lookups only
+    stats.termination = absorbed ? TERMINATION_HORIZON : TERMINATION_ESCAPED;
+    stats.transmittance = 1.0;
+    return record;
+}
+
+// Binet equation u'' = -u + 1.5 RS u^2 (u = 1/r, ' = d/dphi) for the state (u, u').
+// Same orbits as geodesic_acceleration, but a single scalar ODE per ray
+float2 binet_derivative(float2 y) {
+    return float2(y.y, -y.x + 1.5 * RS * y.x * y.x);
+}
+
+// Dormand-Prince 5(4) step of the Binet equation. k1 is the derivative at y,
+// kNext receives the derivative at the result (first same as last, so an
+// accepted step costs 6 evaluations) and error the difference to the
+// embedded 4th order solution
+float2 dopri_step(float2 y, float h, float2 k1, thread float2& kNext, thread float2& error) {
+    float2 k2 = binet_derivative(y + h * (k1 * (1.0 / 5.0)));
+    float2 k3 = binet_derivative(y + h * (k1 * (3.0 / 40.0) + k2 * (9.0 / 40.0)));
+    float2 k4 = binet_derivative(y + h * (k1 * (44.0 / 45.0) - k2 * (56.0 / 15.0) + k3 * (32.0 / 9.0)));
+    float2 k5 = binet_derivative(y + h * (k1 * (19372.0 / 6561.0) - k2 * (25360.0 / 2187.0) +
+                                          k3 * (64448.0 / 6561.0) - k4 * (212.0 / 729.0)));
+    float2 k6 = binet_derivative(y + h * (k1 * (9017.0 / 3168.0) - k2 * (355.0 / 33.0) +
+                                          k3 * (46732.0 / 5247.0) + k4 * (49.0 / 176.0) -
+                                          k5 * (5103.0 / 18656.0)));
+    float2 next = y + h * (k1 * (35.0 / 384.0) + k3 * (500.0 / 1113.0) + k4 * (125.0 / 192.0) -
+                           k5 * (2187.0 / 6784.0) + k6 * (11.0 / 84.0));
+    kNext = binet_derivative(next);
+    error = h * (k1 * (71.0 / 57600.0) - k3 * (71.0 / 16695.0) + k4 * (71.0 / 1920.0) -
+                 k5 * (17253.0 / 339200.0) + k6 * (22.0 / 525.0) - kNext * (1.0 / 40.0));
+    return next;
+}
+
+// Cubic Hermite interpolation of (u, u') across a step of length h at s in [0,1]
+float2 hermite_binet(float2 y0, float2 y1, float h, float s) {
+    float s2 = s * s;
+    float s3 = s2 * s;
+    float u = y0.x * (2.0 * s3 - 3.0 * s2 + 1.0) + y0.y * (h * (s3 - 2.0 * s2 + s)) +
+              y1.x * (3.0 * s2 - 2.0 * s3) + y1.y * (h * (s3 - s2));
+    float dudphi = (y0.x - y1.x) * ((6.0 * s2 - 6.0 * s) / h) + y0.y * (3.0 * s2 - 4.0 * s + 1.0) +
+                   y1.y * (3.0 * s2 - 2.0 * s);
+    return float2(u, dudphi);
+}
+
+// Adaptive Binet ray tracing
+// Reduces the ray to its orbital plane like the geodesic LUT, but integrates
+// u(phi) per ray with Dormand-Prince steps sized by the embedded error
+// estimate (per-step bound: tolerance * (1/RS + |y|)). Steps grow to
+// BINET_MAX_STEP where the orbit is nearly straight and shrink only where it
+// bends hard, around the photon sphere; the ray is followed all the way to
+// u = 0 instead of MAX_DIST, so the escape direction has no truncation error.
+GeodesicRecord trace_ray_binet(float3 origin, float3 direction, float tolerance, thread TraceStats& stats) {
+    float r0 = length(origin);
+    float3 e1 = origin / r0;
+    float cosA = dot(direction, e1);
+    float3 tangential = direction - e1 * cosA;
+    float sinA = length(tangential);
+    
+    GeodesicRecord record;
+    record.crossingCount = 0;
+    record.absorbed = true; // Until the orbit reaches u = 0
+    record.escapeDir = direction;
+    stats.steps = 0;
+    stats.transmittance = 1.0; // Known only once the record is shaded
+    if (sinA < 1e-4 || r0 <= RS) {
+        // (Nearly) radial: u' diverges, but the ray only meets the disk plane
+        // inside the horizon and is not bent, so it is absorbed unless outbound
+        record.absorbed = r0 <= RS || cosA < 0.0;
+        stats.termination = record.absorbed ? TERMINATION_HORIZON : TERMINATION_ESCAPED;
+        return record;
+    }
+    float3 e2 = tangential / sinA;
+    
+    // dr/dphi = r cot(A) at the camera
+    float2 y = float2(1.0 / r0, -cosA / (r0 * sinA));
+    float2 k1 = binet_derivative(y);
+    float phi = 0.0;
+    float h = BINET_INITIAL_STEP;
+    bool inPlane = abs(e1.y) + abs(e2.y) <= 1e-6;
+    float phiCross = inPlane ? 2.0 * BINET_MAX_SWEEP : first_disk_plane_angle(e1, e2);
+    
+    for (int i = 0; i < BINET_MAX_STEPS && phi < BINET_MAX_SWEEP; i++) {
+        stats.steps++;
+        h = min(h, BINET_MAX_STEP);
+        float2 kNext, error;
+        float2 next = dopri_step(y, h, k1, kNext, error);
+        float2 bound = tolerance * (1.0 / RS + abs(next));
+        float err = max(abs(error.x) / bound.x, abs(error.y) / bound.y);
+        if (err > 1.0) {
+            h *= max(0.9 * pow(err, -0.2), 0.2);
+            continue;
+        }
+        
+        // Disk crossings inside the step, each reached with its own sub-step
+        // (none behind the horizon or past infinity)
+        while (phiCross <= phi + h && record.crossingCount < GEO_MAX_CROSSINGS) {
+            float2 kCross, errorCross;
+            float2 c = dopri_step(y, phiCross - phi, k1, kCross, errorCross);
+            if (c.x > 0.0 && c.x < 1.0 / RS) {
+                record_orbit_crossing(record, e1, e2, phiCross, c.x, c.y);
+            }
+            phiCross += PI;
+        }
+        
+        if (next.x >= 1.0 / RS) {
+            record.escapeDir = e1 * cos(phi + h) + e2 * sin(phi + h);
+            stats.termination = TERMINATION_HORIZON;
+            return record; // Black (absorbed)
+        }
+        
+        if (next.x <= 0.0) {
+            // Escaped: the asymptotic direction is radial where u reaches zero.
+            // Step to the Hermite estimate of the root, then finish the
+            // remaining (harmonic for u -> 0) sweep analytically
+            float s = y.x / (y.x - next.x);
+            for (int j = 0; j < BINET_ROOT_ITERATIONS; j++) {
+                float2 c = hermite_binet(y, next, h, s);
+                s = clamp(s - c.x / min(c.y * h, -1e-12), 0.0, 1.0); // u' < 0 on the way out
+            }
+            float2 kEnd, errorEnd;
+            float2 end = dopri_step(y, h * s, k1, kEnd, errorEnd);
+            float phiEscape = phi + h * s + atan2(end.x, -end.y);
+            record.absorbed = false;
+            record.escapeDir = e1 * cos(phiEscape) + e2 * sin(phiEscape);
+            stats.termination = TERMINATION_ESCAPED;
+            return record;
+        }
+        
+        y = next;
+        k1 = kNext;
+        phi += h;
+        h *= min(0.9 * pow(max(err, 1e-6), -0.2), 5.0);
+    }
+    
+    // Still winding around the photon sphere: dark, like the LUT's captured rays
+    record.escapeDir = e1 * cos(phi) + e2 * sin(phi);
+    stats.termination = TERMINATION_EXHAUSTED;
+    return record;
+}
+
+// Kerr geodesics in Boyer-Lindquist coordinates (M = RS / 2, spin a along +y,
+// so the disk - which orbits about +y - is prograde for a > 0). Cartesian
+// position: (R sin(theta) cos(phi), r cos(theta), -R sin(theta) sin(phi)),
+// R = sqrt(r^2 + a^2). With E = 1 the photon's L = p_phi and Carter constant Q
+// are fixed per ray at generation, and in Mino time (d lambda = Sigma d tau)
+// r and theta decouple:
+//   r'' = R'(r) / 2,  theta'' = Theta'(theta) / 2,
+//   phi' = L / sin^2(theta) - a + a (r^2 + a^2 - a L) / Delta
+// The second-order form passes through turning points without tracking signs.
+// Rays are traced backwards from the camera: the r and theta equations are even
+// in tau, only phi' flips sign.
+
+// d/dtau of (r, theta, dr/dtau, dtheta/dtau) along the backward trace; K = (L - a)^2 + Q
+float4 kerr_derivative(float4 y, float a, float L, float K, thread float& dphi) {
+    float r = y.x;
+    float sinT = sin(y.y);
+    float cosT = cos(y.y);
+    sinT = abs(sinT) < 1e-4 ? (sinT < 0.0 ? -1e-4 : 1e-4) : sinT; // Rays through the axis
+    float sin2 = sinT * sinT;
+    float a2 = a * a;
+    float delta = r * r - RS * r + a2;
+    float P = r * r + a2 - a * L;
+    dphi = -(L / sin2 - a + a * P / delta);
+    float ddr = 2.0 * r * P - (r - 0.5 * RS) * K;
+    float ddtheta = L * L * cosT / (sinT * sin2) - a2 * sinT * cosT;
+    return float4(y.z, y.w, ddr, ddtheta);
+}
+
+float3 kerr_position(float r, float theta, float phi, float a) {
+    float R = sqrt(r * r + a * a);
+    return float3(R * sin(theta) * cos(phi), r * cos(theta), -R * sin(theta) * sin(phi));
+}
+
+// d/dtau of kerr_position (direction of travel)
+float3 kerr_velocity(float4 y, float phi, float dphi, float a) {
+    float r = y.x;
+    float R = sqrt(r * r + a * a);
+    float sinT = sin(y.y);
+    float cosT = cos(y.y);
+    float sinP = sin(phi);
+    float cosP = cos(phi);
+    float dRho = r * y.z / R * sinT + R * cosT * y.w; // d(R sin(theta))
+    return float3(dRho * cosP - R * sinT * sinP * dphi,
+                  y.z * cosT - r * sinT * y.w,
+                  -(dRho * sinP + R * sinT * cosP * dphi));
+}
+
+// Redshift g = 1 / (u^t (1 - Omega L)) of a prograde circular equatorial
+// emitter, stored as g / sqrt(1 - RS/r): shading applies the Schwarzschild
+// gravitational factor itself (blackbody palette), so it ends up with g
+float kerr_disk_delta(float r, float a, float L) {
+    float sqrtM = sqrt(0.5 * RS);
+    float omega = sqrtM / (r * sqrt(r) + a * sqrtM);
+    float gtt = -(1.0 - RS / r);
+    float gtphi = -RS * a / r;
+    float gphiphi = r * r + a * a + RS * a * a / r;
+    float norm = -(gtt + 2.0 * gtphi * omega + gphiphi * omega * omega);
+    if (norm <= 0.0) {
+        return 0.0; // No timelike circular orbit this close
+    }
+    return sqrt(norm) / (1.0 - omega * L) / sqrt(max(1.0 - RS / r, 1e-4));
+}
+
+// Disk crossings and fate of one ray around a spinning hole, RK4 in Mino time.
+// Steps are sized so ln(r - r+), theta and phi change by at most KERR_STEP:
+// they shrink near the horizon and in the ergosphere, where frame dragging
+// winds phi up, and grow geometrically on the way out
+GeodesicRecord trace_ray_kerr(float3 origin, float3 direction, float a, thread TraceStats& stats) {
+    GeodesicRecord record;
+    record.crossingCount = 0;
+    record.absorbed = true; // Until the ray escapes
+    record.escapeDir = direction;
+    stats.steps = 0;
+    stats.transmittance = 1.0; // Known only once the record is shaded
+    
+    float a2 = a * a;
+    float M = 0.5 * RS;
+    float horizon = M + sqrt(max(M * M - a2, 0.0));
+    
+    // Boyer-Lindquist coordinates of the camera (oblate spheroidal inversion)
+    float w = dot(origin, origin) - a2;
+    float r = sqrt(0.5 * (w + sqrt(w * w + 4.0 * a2 * origin.y * origin.y)));
+    if (r <= horizon) {
+        stats.termination = TERMINATION_HORIZON;
+        return record;
+    }
+    float theta = acos(clamp(origin.y / r, -1.0, 1.0));
+    float phi = atan2(-origin.z, origin.x);
+    
+    // Direction in the local (r, theta, phi) frame; the mild oblateness and the
+    // camera's motion relative to the zero angular momentum frame are neglected
+    float sinT = max(sin(theta), 1e-4);
+    float cosT = cos(theta);
+    float sinP = sin(phi);
+    float cosP = cos(phi);
+    float nR = dot(direction, float3(sinT * cosP, cosT, -sinT * sinP));
+    float nTheta = dot(direction, float3(cosT * cosP, -sinT, -cosT * sinP));
+    float nPhi = dot(direction, float3(-sinP, 0.0, -cosP));
+    
+    // Conserved quantities of the photon arriving along -direction, via the ZAMO tetrad (Bardeen 1973)
+    float sigma = r * r + a2 * cosT * cosT;
+    float delta = r * r - RS * r + a2;
+    float A = (r * r + a2) * (r * r + a2) - a2 * delta * sinT * sinT;
+    float omegaFrame = RS * a * r / A;
+    float eNu = sqrt(sigma * delta / A);
+    float ePsi = sqrt(A / sigma) * sinT;
+    float energy = 1.0 / (eNu - omegaFrame * ePsi * nPhi); // Local energy for E = 1
+    float L = -ePsi * energy * nPhi;
+    float pTheta = -sqrt(sigma) * energy * nTheta;
+    float Q = pTheta * pTheta + cosT * cosT * (L * L / (sinT * sinT) - a2);
+    float K = (L - a) * (L - a) + Q;
+    
+    float4 y = float4(r, theta, sqrt(delta * sigma) * energy * nR, sqrt(sigma) * energy * nTheta);
+    float dphi;
+    float4 k1 = kerr_derivative(y, a, L, K, dphi);
+    
+    for (int i = 0; i < KERR_MAX_STEPS; i++) {
+        stats.steps++;
+        float rate = max(max(abs(y.z) / (y.x - horizon), abs(y.w)), max(abs(dphi), 1e-6));
+        float h = KERR_STEP / rate;
+        
+        float dphi2, dphi3, dphi4;
+        float4 k2 = kerr_derivative(y + k1 * (h * 0.5), a, L, K, dphi2);
+        float4 k3 = kerr_derivative(y + k2 * (h * 0.5), a, L, K, dphi3);
+        float4 k4 = kerr_derivative(y + k3 * h, a, L, K, dphi4);
+        float4 next = y + (k1 + k2 * 2.0 + k3 * 2.0 + k4) * (h / 6.0);
+        float phiNext = phi + (dphi + dphi2 * 2.0 + dphi3 * 2.0 + dphi4) * (h / 6.0);
+        
+        if (next.x <= horizon * (1.0 + KERR_HORIZON_MARGIN)) {
+            stats.termination = TERMINATION_HORIZON;
+            return record; // Black (absorbed)
+        }
+        
+        float dphiNext;
+        float4 kNext = kerr_derivative(next, a, L, K, dphiNext);
+        
+        // Disk plane (cos(theta) = 0) crossed inside the step
+        float c0 = cos(y.y);
+        float c1 = cos(next.y);
+        if (c0 * c1 < 0.0 && record.crossingCount < GEO_MAX_CROSSINGS) {
+            float t = c0 / (c0 - c1);
+            float4 c = mix(y, next, t);
+            float phiCross = mix(phi, phiNext, t);
+            float3 hit = kerr_position(c.x, c.y, phiCross, a);
+            float3 hitDir = normalize(kerr_velocity(c, phiCross, mix(dphi, dphiNext, t), a));
+            float pathScale = 1.0 / max(abs(hitDir.y), MIN_SLAB_COSINE);
+            record.crossings[record.crossingCount++] =
+                float4(c.x, atan2(hit.z, hit.x), kerr_disk_delta(c.x, a, L), pathScale);
+        }
+        
+        y = next;
+        k1 = kNext;
+        phi = phiNext;
+        dphi = dphiNext;
+        if (y.x > KERR_ESCAPE_RADIUS && y.z > 0.0) {
+            record.absorbed = false;
+            record.escapeDir = normalize(kerr_velocity(y, phi, dphi, a));
+            stats.termination = TERMINATION_ESCAPED;
+            return record;
+        }
+    }
+    
+    // Still winding around the photon orbit: dark, like the other crossing modes
+    record.escapeDir = normalize(kerr_velocity(y, phi, dphi, a));
+    stats.termination = TERMINATION_EXHAUSTED;
+    return record;
+}
+
+// Geodesic cache packing (half precision is plenty for r, angle, delta and path scale)
+GeodesicCacheEntry pack_geodesic_record(thread const GeodesicRecord& record) {
+    GeodesicCacheEntry entry;
+    for (int i = 0; i < GEO_MAX_CROSSINGS; i++) {
+        entry.crossings[i] = half4(i < record.crossingCount ? record.crossings[i] : float4(0.0));
+    }
+    entry.escapeDir = packed_float3(record.escapeDir);
+    entry.crossingCount = ushort(record.crossingCount);
+    entry.absorbed = record.absorbed ? 1 : 0;
+    return entry;
+}
+
+GeodesicRecord unpack_geodesic_record(GeodesicCacheEntry entry) {
+    GeodesicRecord record;
+    for (int i = 0; i < GEO_MAX_CROSSINGS; i++) {
+        record.crossings[i] = float4(entry.crossings[i]);
+    }
+    record.crossingCount = int(entry.crossingCount);
+    record.absorbed = entry.absorbed != 0;
+    record.escapeDir = float3(entry.escapeDir);
+    return record;
+}
+
+// Linear radiance for the RGBA16Float frame target the post chain reads.
+// Values beyond half range are clamped so they don't turn into Inf; NaN/Inf
+// stay non-finite so the composite flags them green
+float4 frame_radiance(float3 color) {
+    return all(isfinite(color)) ? float4(min(color, float(HALF_MAX)), 1.0) : float4(NAN);
+}
+
+// Sub-pixel offset of a supersampling pass: R2 low-discrepancy sequence,
+// rotated per pixel so neighbouring pixels don't share a pattern
+float2 sample_jitter(uint2 pixel, uint sampleIndex) {
+    uint hash = pixel.x * 73856093u ^ pixel.y * 19349663u;
+    hash = (hash ^ (hash >> 13)) * 1274126177u;
+    float2 rotation = float2(float(hash & 0xffffu), float(hash >> 16)) / 65536.0;
+    float2 r2 = float(sampleIndex) * float2(0.7548776662, 0.5698402910);
+    return fract(r2 + rotation);
+}
+
+// Primary ray direction through a (sub)pixel position of the current viewport
+float3 camera_ray_direction(constant Uniforms& uniforms, float2 pixel) {
+    // Calculate aspect ratio and FOV
+    float aspectRatio = float(uniforms.resolution.x) / float(uniforms.resolution.y);
+    float fovRad = uniforms.camera.fov * PI / 180.0;
+    float scale = tan(fovRad * 0.5);
+    
+    // Calculate pixel coordinates in normalized space
+    float px = (2.0 * pixel.x / float(uniforms.resolution.x) - 1.0) * aspectRatio * scale;
+    float py = (1.0 - 2.0 * pixel.y / float(uniforms.resolution.y)) * scale;
+    
+    // Calculate ray direction
+    float3 forward = float3(uniforms.camera.forward);
+    float3 right = float3(uniforms.camera.right);
+    float3 up = float3(uniforms.camera.up);
+    return normalize(forward + right * px + up * py);
+}
+
+// Disk crossings and fate of one ray with the active crossing-based trace mode
+GeodesicRecord trace_geodesic_record(constant Uniforms& uniforms, float3 dir,
+                                     texture2d<float, access::read> lutRadius,
+                                     texture2d<float, access::read> lutAngle,
+                                     texture2d<float, access::read> lutBranch,
+                                     thread TraceStats& stats) {
+    float3 origin = float3(uniforms.camera.position);
+    if (kerr_active(uniforms)) {
+        return trace_ray_kerr(origin, dir, uniforms.spin, stats);
+    }
+    int traceMode = active_trace_mode(uniforms);
+    if (traceMode == TRACE_GEODESIC_LUT) {
+        return trace_ray_lut(origin, dir, lutRadius, lutAngle, lutBranch, stats);
+    }
+    if (traceMode == TRACE_ADAPTIVE_BINET) {
+        return trace_ray_binet(origin, dir, uniforms.integratorTolerance, stats);
+    }
+    return trace_ray_disk_crossing(origin, dir, stats);
+}
+
+// Trace and shade one ray with the active trace mode (no geodesic cache),
+// reporting its fate and escape direction for the foveated passes
+float3 trace_with_fate(constant Uniforms& uniforms, float3 dir,
+                       texture2d<float, access::read> lutRadius,
+                       texture2d<float, access::read> lutAngle,
+                       texture2d<float, access::read> lutBranch,
+                       texture1d<float> diskProfile, texture1d<float> blackbody, texturecube<float> sky,
+                       thread uint& fate, thread float3& escapeDir) {
+    float3 origin = float3(uniforms.camera.position);
+    int colorMode = active_color_mode(uniforms);
+    TraceStats stats;
+    if (active_trace_mode(uniforms) == TRACE_VOLUMETRIC && !kerr_active(uniforms)) {
+        return trace_ray(origin, dir, uniforms.time, colorMode, uniforms.colorIntensity, diskProfile, blackbody,
+                         sky, sky_footprint(uniforms, dir), fate, escapeDir, stats);
+    }
+    GeodesicRecord record = trace_geodesic_record(uniforms, dir, lutRadius, lutAngle, lutBranch, stats);
+    fate = record.absorbed ? FATE_HORIZON : (record.crossingCount > 0 ? FATE_DISK : FATE_ESCAPED);
+    escapeDir = record.escapeDir;
+    return shade_geodesic_record(record, uniforms.time, colorMode, uniforms.colorIntensity, diskProfile, blackbody,
+                                 sky, sky_footprint(uniforms, dir));
+}
+
+// False colour for the diagnostics view: step count on a log scale from blue
+// (cheap) through green and yellow to red, tinted by why the trace stopped
+float3 diagnostic_heatmap(TraceStats stats) {
+    float t = saturate(log2(1.0 + float(stats.steps)) / log2(1.0 + DIAGNOSTIC_HEATMAP_STEPS));
+    float3 heat = saturate(float3(1.5 - abs(4.0 * t - 3.0),
+                                  1.5 - abs(4.0 * t - 2.0),
+                                  1.5 - abs(4.0 * t - 1.0)));
+    if (stats.termination == TERMINATION_HORIZON) {
+        heat *= 0.35;                                  // Dimmed: ended in the black hole
+    } else if (stats.termination == TERMINATION_OPAQUE) {
+        heat = mix(heat, float3(1.0), 0.45);           // Whitened: stopped by the opacity cutoff
+    } else if (stats.termination == TERMINATION_EXHAUSTED) {
+        heat = mix(heat, float3(1.0, 0.0, 1.0), 0.6);  // Magenta: ran out of distance or steps
+    }
+    return heat;
+}
+
+// Store one pixel's trace statistics: raw values for dumps, plus the step
+// histogram and termination counts the renderer reduces to mean/p99
+void record_diagnostics(TraceStats stats, uint2 tid,
+                        texture2d<float, access::write> diagnostics,
+                        device atomic_uint* counters) {
+    diagnostics.write(float4(float(stats.steps), float(stats.termination), stats.transmittance, 1.0), tid);
+    atomic_fetch_add_explicit(&counters[min(stats.steps, DIAGNOSTIC_STEP_BINS - 1)], 1u, memory_order_relaxed);
+    atomic_fetch_add_explicit(&counters[DIAGNOSTIC_STEP_BINS + min(stats.termination, TERMINATION_COUNT - 1)], 1u,
+                              memory_order_relaxed);
+}
+
 // Ray generation kernel
 kernel void ray_generation(
-    texture2d<float, access::write> output_texture [[texture(0)]],
+    texture2d<float, access::write> radiance [[texture(0)]],
+    texture2d<float, access::read> lut_radius [[texture(1)]],
+    texture2d<float, access::read> lut_angle [[texture(2)]],
+    texture2d<float, access::read> lut_branch [[texture(3)]],
+    texture2d<float, access::write> diagnostics [[texture(4)]],
+    texture2d<float, access::write> hdr_output [[texture(5)]],
+    texture1d<float> disk_profile [[texture(6)]],
+    texture1d<float> blackbody [[texture(7)]],
+    texturecube<float> sky [[texture(8)]],
     constant Uniforms& uniforms [[buffer(0)]],
+    device GeodesicCacheEntry* geodesic_cache [[buffer(1)]],
+    device atomic_uint* diagnostic_counters [[buffer(2)]],
+    device float4* accumulation [[buffer(3)]],
     uint2 tid [[thread_position_in_grid]])
 {
     if (tid.x >= uniforms.resolution.x || tid.y >= uniforms.resolution.y) {
         return;
     }
     
+    // Progressive refinement: the first sample is the pixel center (as a
+    // moving frame), the following ones are jittered; the mean is displayed
+    bool accumulating = uniforms.accumulationIndex >= 0;
+    uint accumulationSlot = tid.y * uniforms.resolution.x + tid.x;
+    if (accumulating && uniforms.accumulationIndex >= ACCUMULATION_MAX_SAMPLES) {
+        float4 sum = accumulation[accumulationSlot];
+        float3 mean = sum.w > 0.0 ? sum.rgb / sum.w : float3(NAN);
+        if (uniforms.captureHDR) {
+            hdr_output.write(float4(mean, 1.0), tid);
+        }
+        radiance.write(frame_radiance(mean), tid);
+        return;
+    }
+    float2 offset = uniforms.accumulationIndex > 0 ? sample_jitter(tid, uint(uniforms.accumulationIndex))
+                                                   : float2(0.5);
+    
     // Debug: Check if camera data is valid
     // packed_float3 can be implicitly converted to float3
     float3 camPos = float3(uniforms.camera.position);
@@ -290,44 +1255,250 @@ kernel void ray_generation(
     // Check for invalid camera data (all zeros)
     if (length(camPos) < 0.001 && length(camForward) < 0.001) {
         // Invalid camera - output red to indicate error
-        output_texture.write(float4(1.0, 0.0, 0.0, 1.0), tid);
+        radiance.write(float4(1.0, 0.0, 0.0, 1.0), tid);
         return;
     }
     
-    // Calculate aspect ratio and FOV
-    float aspectRatio = float(uniforms.resolution.x) / float(uniforms.resolution.y);
-    float fovRad = uniforms.camera.fov * PI / 180.0;
-    float scale = tan(fovRad * 0.5);
-    
-    // Calculate pixel coordinates in normalized space
-    float px = (2.0 * (float(tid.x) + 0.5) / float(uniforms.resolution.x) - 1.0) * aspectRatio * scale;
-    float py = (1.0 - 2.0 * (float(tid.y) + 0.5) / float(uniforms.resolution.y)) * scale;
-    
     // Calculate ray direction
-    float3 forward = float3(uniforms.camera.forward);
-    float3 right = float3(uniforms.camera.right);
-    float3 up = float3(uniforms.camera.up);
-    float3 dir = normalize(forward + right * px + up * py);
+    float3 dir = camera_ray_direction(uniforms, float2(tid) + offset);
     
     // Trace ray - pass time for animation, color mode, and intensity
     float3 origin = float3(uniforms.camera.position);
-    float3 color = trace_ray(origin, dir, uniforms.time, uniforms.colorMode, uniforms.colorIntensity);
+    int colorMode = active_color_mode(uniforms);
+    float3 color;
+    TraceStats stats;
+    if (active_trace_mode(uniforms) == TRACE_VOLUMETRIC && !kerr_active(uniforms)) {
+        uint fate;
+        float3 escapeDir;
+        color = trace_ray(origin, dir, uniforms.time, colorMode, uniforms.colorIntensity, disk_profile, blackbody,
+                          sky, sky_footprint(uniforms, dir), fate, escapeDir, stats);
+    } else {
+        GeodesicRecord record = trace_geodesic_record(uniforms, dir, lut_radius, lut_angle, lut_branch, stats);
+        if (uniforms.writeCache) {
+            // Shade from the stored (half precision) values so cached frames match exactly
+            GeodesicCacheEntry entry = pack_geodesic_record(record);
+            geodesic_cache[tid.y * uniforms.resolution.x + tid.x] = entry;
+            record = unpack_geodesic_record(entry);
+        }
+        color = shade_geodesic_record(record, uniforms.time, colorMode, uniforms.colorIntensity,
+                                      disk_profile, blackbody, sky, sky_footprint(uniforms, dir),
+                                      stats.transmittance);
+    }
+    
+    if (uniforms.diagnostics) {
+        record_diagnostics(stats, tid, diagnostics, diagnostic_counters);
+        radiance.write(float4(diagnostic_heatmap(stats), 1.0), tid); // Shown as is (PostParams.raw)
+        return;
+    }
+    if (accumulating) {
+        // Same running sum as ray_generation_tile (w counts the finite samples)
+        float4 sum = uniforms.accumulationIndex == 0 ? float4(0.0) : accumulation[accumulationSlot];
+        if (all(isfinite(color))) {
+            sum += float4(color, 1.0);
+        }
+        accumulation[accumulationSlot] = sum;
+        color = sum.w > 0.0 ? sum.rgb / sum.w : float3(NAN);
+    }
+    if (uniforms.captureHDR) {
+        hdr_output.write(float4(color, 1.0), tid);
+    }
+    radiance.write(frame_radiance(color), tid);
+}
+
+// Shading-only kernel for a static camera: re-shades the disk and background
+// for the current time/palette from the geodesic cache, no ray tracing at all
+kernel void shade_cached(
+    texture2d<float, access::write> radiance [[texture(0)]],
+    texture2d<float, access::write> hdr_output [[texture(5)]],
+    texture1d<float> disk_profile [[texture(6)]],
+    texture1d<float> blackbody [[texture(7)]],
+    texturecube<float> sky [[texture(8)]],
+    constant Uniforms& uniforms [[buffer(0)]],
+    device const GeodesicCacheEntry* geodesic_cache [[buffer(1)]],
+    uint2 tid [[thread_position_in_grid]])
+{
+    if (tid.x >= uniforms.resolution.x || tid.y >= uniforms.resolution.y) {
+        return;
+    }
+    
+    GeodesicRecord record = unpack_geodesic_record(geodesic_cache[tid.y * uniforms.resolution.x + tid.x]);
+    float skyFootprint = sky_footprint(uniforms, camera_ray_direction(uniforms, float2(tid) + 0.5));
+    float3 color = shade_geodesic_record(record, uniforms.time, active_color_mode(uniforms), uniforms.colorIntensity,
+                                         disk_profile, blackbody, sky, skyFootprint);
+    if (uniforms.captureHDR) {
+        hdr_output.write(float4(color, 1.0), tid);
+    }
+    radiance.write(frame_radiance(color), tid);
+}
+
+// Foveated pass 1: trace one ray through the center of every tile and store
+// its escape direction (xyz) and fate (w)
+kernel void trace_coarse(
+    texture2d<float, access::read> lut_radius [[texture(1)]],
+    texture2d<float, access::read> lut_angle [[texture(2)]],
+    texture2d<float, access::read> lut_branch [[texture(3)]],
+    texture2d<float, access::write> coarse_rays [[texture(4)]],
+    texture1d<float> disk_profile [[texture(6)]],
+    texture1d<float> blackbody [[texture(7)]],
+    texturecube<float> sky [[texture(8)]],
+    constant Uniforms& uniforms [[buffer(0)]],
+    uint2 tid [[thread_position_in_grid]])
+{
+    uint2 tiles = (uniforms.resolution + uint(FOVEA_TILE - 1)) / uint(FOVEA_TILE);
+    if (tid.x >= tiles.x || tid.y >= tiles.y) {
+        return;
+    }
+    
+    float2 center = float2(tid * uint(FOVEA_TILE)) + float(FOVEA_TILE) * 0.5;
+    uint fate;
+    float3 escapeDir;
+    trace_with_fate(uniforms, camera_ray_direction(uniforms, center),
+                    lut_radius, lut_angle, lut_branch, disk_profile, blackbody, sky, fate, escapeDir);
+    coarse_rays.write(float4(escapeDir, float(fate)), tid);
+}
+
+// Foveated pass 1b: flag tiles that need full-resolution tracing - anything
+// touching the disk, a change of fate (horizon edge, photon ring) or strongly
+// lensed sky where the escape direction changes faster than the coarse grid
+kernel void classify_tiles(
+    texture2d<float, access::read> coarse_rays [[texture(4)]],
+    texture2d<uint, access::write> tile_flags [[texture(5)]],
+    constant Uniforms& uniforms [[buffer(0)]],
+    uint2 tid [[thread_position_in_grid]])
+{
+    int2 tiles = int2((uniforms.resolution + uint(FOVEA_TILE - 1)) / uint(FOVEA_TILE));
+    if (int(tid.x) >= tiles.x || int(tid.y) >= tiles.y) {
+        return;
+    }
+    
+    // Angle between neighbouring coarse rays before lensing
+    float fovRad = uniforms.camera.fov * PI / 180.0;
+    float spacing = 2.0 * tan(fovRad * 0.5) / float(uniforms.resolution.y) * float(FOVEA_TILE);
+    float minCos = cos(min(spacing * FOVEA_DIRECTION_TOLERANCE, PI));
+    
+    float4 center = coarse_rays.read(tid);
+    bool refine = uint(center.w) == FATE_DISK;
+    for (int dy = -1; dy <= 1 && !refine; dy++) {
+        for (int dx = -1; dx <= 1 && !refine; dx++) {
+            int2 n = clamp(int2(tid) + int2(dx, dy), int2(0), tiles - 1);
+            float4 neighbour = coarse_rays.read(uint2(n));
+            if (uint(neighbour.w) != uint(center.w) || uint(neighbour.w) == FATE_DISK) {
+                refine = true;
+            } else if (uint(center.w) == FATE_ESCAPED &&
+                       dot(normalize(neighbour.xyz), normalize(center.xyz)) < minCos) {
+                refine = true;
+            }
+        }
+    }
+    tile_flags.write(uint4(refine ? 1u : 0u), tid);
+}
+
+// Foveated pass 2: trace flagged tiles at full resolution; elsewhere every
+// coarse neighbour shares one fate, so the escape direction is interpolated
+// only between same-fate samples and the sky is still sampled per pixel
+kernel void ray_generation_foveated(
+    texture2d<float, access::write> radiance [[texture(0)]],
+    texture2d<float, access::read> lut_radius [[texture(1)]],
+    texture2d<float, access::read> lut_angle [[texture(2)]],
+    texture2d<float, access::read> lut_branch [[texture(3)]],
+    texture2d<float, access::read> coarse_rays [[texture(4)]],
+    texture2d<uint, access::read> tile_flags [[texture(5)]],
+    texture1d<float> disk_profile [[texture(6)]],
+    texture1d<float> blackbody [[texture(7)]],
+    texturecube<float> sky [[texture(8)]],
+    constant Uniforms& uniforms [[buffer(0)]],
+    uint2 tid [[thread_position_in_grid]])
+{
+    if (tid.x >= uniforms.resolution.x || tid.y >= uniforms.resolution.y) {
+        return;
+    }
     
-    // Check if color is valid (not NaN or Inf)
-    if (isnan(color.x) || isnan(color.y) || isnan(color.z) ||
-        isinf(color.x) || isinf(color.y) || isinf(color.z)) {
-        color = float3(0.0, 1.0, 0.0); // Green for NaN/Inf
+    uint2 tile = tid / uint(FOVEA_TILE);
+    if (tile_flags.read(tile).x != 0) {
+        uint fate;
+        float3 escapeDir;
+        float3 color = trace_with_fate(uniforms, camera_ray_direction(uniforms, float2(tid) + 0.5),
+                                       lut_radius, lut_angle, lut_branch, disk_profile, blackbody, sky,
+                                       fate, escapeDir);
+        radiance.write(frame_radiance(color), tid);
+        return;
     }
     
-    // Tone mapping (simple reinhard)
-    color = color / (color + float3(1.0));
+    // Edge-aware upsample: bilinear over the 4 nearest coarse rays of the same fate
+    int2 tiles = int2((uniforms.resolution + uint(FOVEA_TILE - 1)) / uint(FOVEA_TILE));
+    float2 g = (float2(tid) + 0.5) / float(FOVEA_TILE) - 0.5;
+    int2 c0 = int2(floor(g));
+    float2 f = g - float2(c0);
+    uint ownFate = uint(coarse_rays.read(tile).w);
     
-    // Gamma correction
-    color.x = pow(max(color.x, 0.0), 1.0 / 2.2);
-    color.y = pow(max(color.y, 0.0), 1.0 / 2.2);
-    color.z = pow(max(color.z, 0.0), 1.0 / 2.2);
+    float3 dirSum = float3(0.0);
+    float weightSum = 0.0;
+    for (int j = 0; j < 4; j++) {
+        int2 offset = int2(j & 1, j >> 1);
+        int2 c = clamp(c0 + offset, int2(0), tiles - 1);
+        float4 coarse = coarse_rays.read(uint2(c));
+        float w = (offset.x ? f.x : 1.0 - f.x) * (offset.y ? f.y : 1.0 - f.y);
+        if (uint(coarse.w) == ownFate) {
+            dirSum += normalize(coarse.xyz) * w;
+            weightSum += w;
+        }
+    }
     
-    // Clamp
-    color = clamp(color, float3(0.0), float3(1.0));
-    output_texture.write(float4(color, 1.0), tid);
+    float3 color = float3(0.0); // Horizon: black
+    if (ownFate == FATE_ESCAPED && weightSum > 0.0) {
+        float skyFootprint = sky_footprint(uniforms, camera_ray_direction(uniforms, float2(tid) + 0.5));
+        color = sample_background(normalize(dirSum), uniforms.time, sky, skyFootprint);
+    }
+    radiance.write(frame_radiance(color), tid);
+}
+
+// Offline pass: trace one jittered sample per tile pixel and add the linear
+// radiance to the accumulator (w counts the finite samples)
+kernel void ray_generation_tile(
+    texture2d<float, access::read> lut_radius [[texture(1)]],
+    texture2d<float, access::read> lut_angle [[texture(2)]],
+    texture2d<float, access::read> lut_branch [[texture(3)]],
+    texture1d<float> disk_profile [[texture(6)]],
+    texture1d<float> blackbody [[texture(7)]],
+    texturecube<float> sky [[texture(8)]],
+    constant Uniforms& uniforms [[buffer(0)]],
+    constant TileParams& tile [[buffer(1)]],
+    device float4* accumulation [[buffer(2)]],
+    uint2 tid [[thread_position_in_grid]])
+{
+    uint2 pixel = tile.origin + tid;
+    if (tid.x >= tile.size.x || tid.y >= tile.size.y ||
+        pixel.x >= uniforms.resolution.x || pixel.y >= uniforms.resolution.y) {
+        return;
+    }
+
+    uint fate;
+    float3 escapeDir;
+    float2 position = float2(pixel) + sample_jitter(pixel, tile.sampleIndex);
+    float3 color = trace_with_fate(uniforms, camera_ray_direction(uniforms, position),
+                                   lut_radius, lut_angle, lut_branch, disk_profile, blackbody, sky, fate, escapeDir);
+
+    uint index = tid.y * tile.size.x + tid.x;
+    float4 sum = tile.sampleIndex == 0 ? float4(0.0) : accumulation[index];
+    if (all(isfinite(color))) {
+        sum += float4(color, 1.0);
+    }
+    accumulation[index] = sum;
+}
+
+// Offline resolve: average the accumulated samples and tone map into the tile
+// output (the post chain's exposure and tone curve; bloom needs the whole image)
+kernel void resolve_tile(
+    texture2d<float, access::write> output_texture [[texture(0)]],
+    constant TileParams& tile [[buffer(1)]],
+    device const float4* accumulation [[buffer(2)]],
+    uint2 tid [[thread_position_in_grid]])
+{
+    if (tid.x >= tile.size.x || tid.y >= tile.size.y) {
+        return;
+    }
+    float4 sum = accumulation[tid.y * tile.size.x + tid.x];
+    // No finite sample at all: let display_color flag the pixel
+    float3 color = sum.w > 0.0 ? sum.rgb / sum.w : float3(NAN);
+    output_texture.write(display_color(color * tile.exposure), tid);
 }
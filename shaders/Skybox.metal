@@ -0,0 +1,92 @@
+#include <metal_stdlib>
+using namespace metal;
+
+// Sky cubemap baking, run once when the renderer is created or a skybox is loaded.
+// sample_background in RayTracing.metal reads the result with trilinear filtering,
+// so stars no longer alias or shimmer as the sky rotates.
+// One thread per texel of mip 0; the grid's z is the cube face.
+
+constant uint STAR_CELLS = 96;         // Star grid cells per face edge, at most one star per cell
+constant float STAR_PROBABILITY = 0.5; // Fraction of cells holding a star (~28k stars)
+constant float STAR_MARGIN = 0.2;      // Stars stay this far (in cells) from the cell edge, so no seams
+constant float STAR_SIGMA = 0.75;      // Gaussian star radius in texels (band-limits the bake)
+
+// Direction through the center of a texel (Metal / D3D cube face convention)
+float3 cube_texel_direction(uint3 tid, uint size) {
+    float2 uv = (float2(tid.xy) + 0.5) / float(size) * 2.0 - 1.0;
+    switch (tid.z) {
+        case 0: return normalize(float3(1.0, -uv.y, -uv.x));
+        case 1: return normalize(float3(-1.0, -uv.y, uv.x));
+        case 2: return normalize(float3(uv.x, 1.0, uv.y));
+        case 3: return normalize(float3(uv.x, -1.0, -uv.y));
+        case 4: return normalize(float3(uv.x, -uv.y, 1.0));
+        default: return normalize(float3(-uv.x, -uv.y, -1.0));
+    }
+}
+
+uint star_hash(uint3 cell) {
+    uint hash = cell.x * 73856093u ^ cell.y * 19349663u ^ cell.z * 83492791u;
+    hash = (hash ^ (hash >> 13)) * 1274126177u;
+    return hash ^ (hash >> 16);
+}
+
+// Procedural fallback: white stars of brightness 0.5-1.0, as the old per-pixel hash
+kernel void bake_starfield(
+    texturecube<float, access::write> sky [[texture(0)]],
+    uint3 tid [[thread_position_in_grid]])
+{
+    uint size = sky.get_width();
+    if (tid.x >= size || tid.y >= size) {
+        return;
+    }
+
+    float cellSize = float(size) / float(STAR_CELLS);
+    uint2 cell = min(uint2(float2(tid.xy) / cellSize), uint2(STAR_CELLS - 1));
+    uint hash = star_hash(uint3(cell, tid.z));
+
+    float3 color = float3(0.0);
+    if (float(hash & 0xffffu) / 65536.0 < STAR_PROBABILITY) {
+        float2 jitter = float2(float((hash >> 16) & 0xffu), float(hash >> 24)) / 255.0;
+        float2 star = (float2(cell) + STAR_MARGIN + jitter * (1.0 - 2.0 * STAR_MARGIN)) * cellSize;
+        float2 d = float2(tid.xy) + 0.5 - star;
+        float brightness = 0.5 + float(star_hash(uint3(cell, tid.z + 6u)) % 100u) / 200.0;
+        color = float3(brightness * exp(-dot(d, d) / (2.0 * STAR_SIGMA * STAR_SIGMA)));
+    }
+    sky.write(float4(color, 1.0), tid.xy, tid.z);
+}
+
+// Equirectangular image (same longitude/latitude mapping as the old procedural sky)
+kernel void skybox_from_equirect(
+    texture2d<float> source [[texture(0)]],
+    texturecube<float, access::write> sky [[texture(1)]],
+    constant float& sourceLod [[buffer(0)]],
+    uint3 tid [[thread_position_in_grid]])
+{
+    uint size = sky.get_width();
+    if (tid.x >= size || tid.y >= size) {
+        return;
+    }
+
+    constexpr sampler equirectSampler(filter::linear, mip_filter::linear,
+                                      s_address::repeat, t_address::clamp_to_edge);
+    float3 dir = cube_texel_direction(tid, size);
+    float2 uv = float2(0.5 + atan2(dir.z, dir.x) / (2.0 * M_PI_F), 0.5 - asin(dir.y) / M_PI_F);
+    sky.write(float4(source.sample(equirectSampler, uv, level(sourceLod)).rgb, 1.0), tid.xy, tid.z);
+}
+
+// Cubemap file (KTX etc.): resampled into the renderer's mipmapped float format
+kernel void skybox_from_cube(
+    texturecube<float> source [[texture(0)]],
+    texturecube<float, access::write> sky [[texture(1)]],
+    constant float& sourceLod [[buffer(0)]],
+    uint3 tid [[thread_position_in_grid]])
+{
+    uint size = sky.get_width();
+    if (tid.x >= size || tid.y >= size) {
+        return;
+    }
+
+    constexpr sampler cubeSampler(filter::linear, mip_filter::linear);
+    float3 dir = cube_texel_direction(tid, size);
+    sky.write(float4(source.sample(cubeSampler, dir, level(sourceLod)).rgb, 1.0), tid.xy, tid.z);
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <metal_stdlib>
+
+// Display transform shared by the post chain (PostProcess.metal) and the
+// offline tile resolve (RayTracing.metal); CPURenderer mirrors it.
+// Linear radiance -> filmic tone curve -> sRGB encoded [0, 1].
+
+// With the fit's 0.6 pre-scale the shadows stay close to a Reinhard curve,
+// while highlights keep more contrast before rolling off
+inline float3 filmic_tonemap(float3 color) {
+    constexpr float exposureBias = 0.6;
+    float3 x = metal::max(color, 0.0) * exposureBias;
+    // ACES filmic curve fit (Narkowicz 2015)
+    return metal::saturate((x * (2.51 * x + 0.03)) / (x * (2.43 * x + 0.59) + 0.14));
+}
+
+inline float3 srgb_encode(float3 color) {
+    float3 low = color * 12.92;
+    float3 high = 1.055 * metal::pow(color, 1.0 / 2.4) - 0.055;
+    return metal::select(high, low, color <= 0.0031308);
+}
+
+// Tone mapped, encoded output color; NaN/Inf radiance shows up green
+inline float4 display_color(float3 color) {
+    if (!metal::all(metal::isfinite(color))) {
+        return float4(0.0, 1.0, 0.0, 1.0);
+    }
+    return float4(srgb_encode(filmic_tonemap(color)), 1.0);
+}
@@ -0,0 +1,63 @@
+#include "../include/rendering/BenchmarkRunner.hpp"
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+// Headless benchmark entry point: logs go to the console only
+void appLog(const std::string& message, bool isError = false);
+
+void appLog(const std::string& message, bool isError) {
+  (isError ? std::cerr : std::cout) << message << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+  BenchmarkSettings settings;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--output" && i + 1 < argc) {
+      settings.outputPath = argv[++i];
+    } else if (arg == "--baseline" && i + 1 < argc) {
+      settings.baselinePath = argv[++i];
+    } else if (arg == "--threshold" && i + 1 < argc) {
+      settings.threshold = std::atof(argv[++i]);
+    } else if (arg == "--frames" && i + 1 < argc) {
+      settings.frames = std::atoi(argv[++i]);
+    } else if (arg == "--warmup" && i + 1 < argc) {
+      settings.warmupFrames = std::atoi(argv[++i]);
+    } else if (arg == "--trace-mode" && i + 1 < argc) {
+      settings.traceMode = std::atoi(argv[++i]);
+      if (settings.traceMode < 0 || settings.traceMode >= METAL_RT_TRACE_MODE_COUNT) {
+        std::cerr << "Invalid --trace-mode (expected 0-" << METAL_RT_TRACE_MODE_COUNT - 1 << "): " << argv[i] << std::endl;
+        return 1;
+      }
+    } else if (arg == "--presets" && i + 1 < argc) {
+      std::stringstream list(argv[++i]);
+      std::string item;
+      while (std::getline(list, item, ',')) {
+        settings.presets.push_back(std::atoi(item.c_str()));
+      }
+    } else if (arg == "--help" || arg == "-h") {
+      std::cout << "Black Hole Simulation benchmark\n";
+      std::cout << "Usage: " << argv[0] << " [--output FILE] [--baseline FILE [--threshold PERCENT]] [options]\n";
+      std::cout << "\nOptions:\n";
+      std::cout << "  --output FILE          JSON results (default bench.json)\n";
+      std::cout << "  --baseline FILE        Compare GPU times against an earlier --output file;\n";
+      std::cout << "                         exits with status 1 if any case regressed\n";
+      std::cout << "  --threshold PERCENT    Allowed GPU time increase over the baseline (default 5)\n";
+      std::cout << "  --frames N             Timed frames per case (default 10)\n";
+      std::cout << "  --warmup N             Untimed frames per case before timing (default 3)\n";
+      std::cout << "  --trace-mode N         Trace mode 0-" << METAL_RT_TRACE_MODE_COUNT - 1 << " (default 0, volumetric)\n";
+      std::cout << "  --presets LIST         Comma-separated resolution preset indices (default all, 0 = 144p)\n";
+      std::cout << "  --help, -h             Show this help message\n";
+      return 0;
+    } else {
+      std::cerr << "Unknown option: " << arg << " (see --help)" << std::endl;
+      return 1;
+    }
+  }
+
+  BenchmarkRunner runner(settings);
+  return runner.run() ? 0 : 1;
+}
@@ -0,0 +1,401 @@
+#include "../../include/camera/CameraPath.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace {
+// Binary timeline: magic, version, key count, then 9 doubles per key
+// (time, position xyz, target xyz, fov, roll) in native byte order
+const char kBinaryMagic[4] = {'B', 'H', 'C', 'P'};
+constexpr uint32_t kBinaryVersion = 1;
+constexpr int kBinaryKeyValues = 9;
+
+// Cubic Hermite on a segment of length h at s in [0, 1]
+template <typename T>
+T hermite(const T &p0, const T &m0, const T &p1, const T &m1, double h, double s) {
+  double s2 = s * s;
+  double s3 = s2 * s;
+  return p0 * (2.0 * s3 - 3.0 * s2 + 1.0) + m0 * ((s3 - 2.0 * s2 + s) * h) + p1 * (-2.0 * s3 + 3.0 * s2) +
+         m1 * ((s3 - s2) * h);
+}
+
+// Camera looking from position to target, rolled about the view direction
+Camera makePose(const Vector3 &position, const Vector3 &target, double fov, double roll) {
+  Camera camera(position, target, std::clamp(fov, 1.0, 179.0));
+  if (camera.forward.length() < 0.001) {
+    camera.lookAt(position + Vector3(0, 0, 1));
+  }
+  if (camera.right.length() < 0.001) {
+    // Looking straight up or down: take the horizontal axis from world x instead
+    camera.right = camera.forward.cross(Vector3(1, 0, 0)).normalized();
+    camera.up = camera.right.cross(camera.forward).normalized();
+  }
+  if (roll != 0.0) {
+    double angle = roll * M_PI / 180.0;
+    Vector3 right = camera.right * std::cos(angle) + camera.up * std::sin(angle);
+    camera.up = camera.up * std::cos(angle) - camera.right * std::sin(angle);
+    camera.right = right;
+  }
+  return camera;
+}
+
+size_t skipSpace(const std::string &text, size_t pos) {
+  while (pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos]))) {
+    pos++;
+  }
+  return pos;
+}
+
+// Position of the value of "key" in a flat JSON object, or npos
+size_t findValue(const std::string &object, const char *key) {
+  std::string quoted = std::string("\"") + key + "\"";
+  size_t pos = object.find(quoted);
+  if (pos == std::string::npos) {
+    return std::string::npos;
+  }
+  pos = skipSpace(object, pos + quoted.size());
+  if (pos >= object.size() || object[pos] != ':') {
+    return std::string::npos;
+  }
+  return skipSpace(object, pos + 1);
+}
+
+// Number at pos; advances pos past it
+bool parseNumber(const std::string &text, size_t &pos, double &value) {
+  const char *start = text.c_str() + pos;
+  char *end = nullptr;
+  value = std::strtod(start, &end);
+  if (end == start || !std::isfinite(value)) {
+    return false;
+  }
+  pos += end - start;
+  return true;
+}
+
+// Optional number field: true if absent (value unchanged) or valid
+bool readNumber(const std::string &object, const char *key, double &value, bool &present) {
+  size_t pos = findValue(object, key);
+  present = pos != std::string::npos;
+  return !present || parseNumber(object, pos, value);
+}
+
+// Optional [x, y, z] field: true if absent (value unchanged) or valid
+bool readVector(const std::string &object, const char *key, Vector3 &value, bool &present) {
+  size_t pos = findValue(object, key);
+  present = pos != std::string::npos;
+  if (!present) {
+    return true;
+  }
+  double components[3];
+  if (pos >= object.size() || object[pos] != '[') {
+    return false;
+  }
+  pos++;
+  for (int c = 0; c < 3; c++) {
+    pos = skipSpace(object, pos);
+    if (!parseNumber(object, pos, components[c])) {
+      return false;
+    }
+    pos = skipSpace(object, pos);
+    char expected = c < 2 ? ',' : ']';
+    if (pos >= object.size() || object[pos] != expected) {
+      return false;
+    }
+    pos++;
+  }
+  value = Vector3(components[0], components[1], components[2]);
+  return true;
+}
+} // namespace
+
+bool CameraPath::isBinaryPath(const std::string &path) {
+  const std::string ext = ".campath";
+  return path.size() >= ext.size() && path.compare(path.size() - ext.size(), ext.size(), ext) == 0;
+}
+
+void CameraPath::setKeyframes(std::vector<CameraKeyframe> keys) {
+  std::stable_sort(keys.begin(), keys.end(),
+                   [](const CameraKeyframe &a, const CameraKeyframe &b) { return a.time < b.time; });
+  keyframes.clear();
+  for (const CameraKeyframe &key : keys) {
+    if (!keyframes.empty() && keyframes.back().time == key.time) {
+      keyframes.back() = key;
+    } else {
+      keyframes.push_back(key);
+    }
+  }
+  times.clear();
+  for (const CameraKeyframe &key : keyframes) {
+    times.push_back(key.time);
+  }
+  computeTangents();
+}
+
+void CameraPath::computeTangents() {
+  size_t n = keyframes.size();
+  tangents.assign(n, Tangent());
+  if (n < 2) {
+    return;
+  }
+  // Catmull-Rom over the key times; one-sided differences at the ends
+  for (size_t i = 0; i < n; i++) {
+    const CameraKeyframe &prev = keyframes[i > 0 ? i - 1 : 0];
+    const CameraKeyframe &next = keyframes[i + 1 < n ? i + 1 : n - 1];
+    double dt = next.time - prev.time;
+    tangents[i].position = (next.position - prev.position) / dt;
+    tangents[i].target = (next.target - prev.target) / dt;
+    tangents[i].fov = (next.fov - prev.fov) / dt;
+    tangents[i].roll = (next.roll - prev.roll) / dt;
+  }
+}
+
+size_t CameraPath::segmentAt(double time) const {
+  // Segment i spans [times[i], times[i + 1]); times before or after the path clamp to the ends
+  size_t upper = std::upper_bound(times.begin(), times.end(), time) - times.begin();
+  return std::min(upper > 0 ? upper - 1 : 0, times.size() - 2);
+}
+
+Camera CameraPath::evaluateSegment(size_t segment, double time) const {
+  const CameraKeyframe &a = keyframes[segment];
+  const CameraKeyframe &b = keyframes[segment + 1];
+  const Tangent &ma = tangents[segment];
+  const Tangent &mb = tangents[segment + 1];
+  double h = b.time - a.time;
+  double s = std::clamp((time - a.time) / h, 0.0, 1.0);
+
+  return makePose(hermite(a.position, ma.position, b.position, mb.position, h, s),
+                  hermite(a.target, ma.target, b.target, mb.target, h, s),
+                  hermite(a.fov, ma.fov, b.fov, mb.fov, h, s), hermite(a.roll, ma.roll, b.roll, mb.roll, h, s));
+}
+
+Camera CameraPath::evaluate(double time) const {
+  if (keyframes.empty()) {
+    return Camera(Vector3(0, 3, -20), Vector3(0, 0, 0), 60.0);
+  }
+  if (keyframes.size() == 1) {
+    // A single key holds still
+    const CameraKeyframe &key = keyframes.front();
+    return makePose(key.position, key.target, key.fov, key.roll);
+  }
+  return evaluateSegment(segmentAt(time), time);
+}
+
+void CameraPath::evaluateFrames(int firstFrame, int count, int fps, std::vector<Camera> &poses) const {
+  poses.clear();
+  if (count <= 0 || fps <= 0) {
+    return;
+  }
+  poses.reserve(count);
+  if (keyframes.size() < 2) {
+    poses.assign(count, evaluate(0.0));
+    return;
+  }
+  size_t segment = segmentAt(static_cast<double>(firstFrame) / fps);
+  for (int i = 0; i < count; i++) {
+    double time = static_cast<double>(firstFrame + i) / fps;
+    while (segment + 2 < times.size() && time >= times[segment + 1]) {
+      segment++;
+    }
+    poses.push_back(evaluateSegment(segment, time));
+  }
+}
+
+CameraPath CameraPath::fromCinematic(CinematicMode mode, const Camera &start, double duration, double keyInterval) {
+  Camera cam = start;
+  CinematicCamera cinematic(cam, start.position);
+  cinematic.setMode(mode);
+  cinematic.update(0.0, nullptr);
+
+  // The modes advance linearly with the step, so stepping a whole key
+  // interval at a time follows the same path as per-frame updates
+  int steps = std::max(1, static_cast<int>(std::ceil(duration / keyInterval - 1e-9)));
+  std::vector<CameraKeyframe> keys;
+  keys.reserve(steps + 1);
+  for (int i = 0; i <= steps; i++) {
+    if (i > 0) {
+      cinematic.update(keyInterval, nullptr);
+    }
+    CameraKeyframe key;
+    key.time = i * keyInterval;
+    key.position = cam.position;
+    // Cinematic modes look at the hole: this puts the target at the origin
+    key.target = cam.position + cam.forward * cam.position.length();
+    key.fov = cam.fov;
+    keys.push_back(key);
+  }
+  CameraPath path;
+  path.setKeyframes(std::move(keys));
+  return path;
+}
+
+bool CameraPath::load(const std::string &path, std::string &error) {
+  std::vector<CameraKeyframe> keys;
+  if (isBinaryPath(path)) {
+    if (!loadBinary(path, keys, error)) {
+      return false;
+    }
+  } else {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+      error = "cannot open " + path;
+      return false;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    if (!parseJSON(buffer.str(), keys, error)) {
+      return false;
+    }
+  }
+  if (keys.empty()) {
+    error = "no keyframes in " + path;
+    return false;
+  }
+  setKeyframes(std::move(keys));
+  return true;
+}
+
+bool CameraPath::parseJSON(const std::string &text, std::vector<CameraKeyframe> &keys, std::string &error) const {
+  // Reads the documented timeline layout: an array of flat keyframe objects
+  size_t pos = findValue(text, "keyframes");
+  if (pos == std::string::npos || pos >= text.size() || text[pos] != '[') {
+    error = "expected a \"keyframes\" array";
+    return false;
+  }
+  pos++;
+  while (true) {
+    pos = skipSpace(text, pos);
+    if (pos < text.size() && text[pos] == ']') {
+      return true;
+    }
+    if (pos >= text.size() || text[pos] != '{') {
+      error = "expected a keyframe object at offset " + std::to_string(pos);
+      return false;
+    }
+    size_t end = text.find('}', pos);
+    if (end == std::string::npos) {
+      error = "unterminated keyframe object";
+      return false;
+    }
+    std::string object = text.substr(pos, end - pos + 1);
+    std::string index = "keyframe " + std::to_string(keys.size());
+
+    CameraKeyframe key;
+    bool hasTime = false;
+    bool hasPosition = false;
+    bool present = false;
+    if (!readNumber(object, "time", key.time, hasTime) || !hasTime) {
+      error = index + ": missing or invalid \"time\"";
+      return false;
+    }
+    if (!readVector(object, "position", key.position, hasPosition) || !hasPosition) {
+      error = index + ": missing or invalid \"position\" (expected [x, y, z])";
+      return false;
+    }
+    if (!readVector(object, "target", key.target, present) || !readNumber(object, "fov", key.fov, present) ||
+        !readNumber(object, "roll", key.roll, present)) {
+      error = index + ": invalid \"target\", \"fov\" or \"roll\"";
+      return false;
+    }
+    keys.push_back(key);
+
+    pos = skipSpace(text, end + 1);
+    if (pos < text.size() && text[pos] == ',') {
+      pos++;
+    }
+  }
+}
+
+bool CameraPath::loadBinary(const std::string &path, std::vector<CameraKeyframe> &keys, std::string &error) const {
+  std::ifstream file(path, std::ios::binary);
+  if (!file.is_open()) {
+    error = "cannot open " + path;
+    return false;
+  }
+  char magic[4];
+  uint32_t version = 0;
+  uint32_t count = 0;
+  file.read(magic, sizeof(magic));
+  file.read(reinterpret_cast<char *>(&version), sizeof(version));
+  file.read(reinterpret_cast<char *>(&count), sizeof(count));
+  if (!file || std::memcmp(magic, kBinaryMagic, sizeof(magic)) != 0 || version != kBinaryVersion) {
+    error = path + " is not a version " + std::to_string(kBinaryVersion) + " .campath file";
+    return false;
+  }
+  // The count is checked against what the file holds before anything is
+  // sized by it, so a corrupt header can't ask for an enormous allocation
+  const std::streamoff header = file.tellg();
+  file.seekg(0, std::ios::end);
+  const std::streamoff available = file.tellg() - header;
+  file.seekg(header);
+  constexpr std::streamoff keyBytes = kBinaryKeyValues * sizeof(double);
+  if (!file || available < 0 || static_cast<uint64_t>(count) > static_cast<uint64_t>(available / keyBytes)) {
+    error = path + " is truncated";
+    return false;
+  }
+  std::vector<double> values(static_cast<size_t>(count) * kBinaryKeyValues);
+  file.read(reinterpret_cast<char *>(values.data()), values.size() * sizeof(double));
+  if (!file) {
+    error = path + " is truncated";
+    return false;
+  }
+  // Same rule as the JSON reader: a NaN time would break the sort and the search
+  for (size_t i = 0; i < values.size(); i++) {
+    if (!std::isfinite(values[i])) {
+      error = path + ": keyframe " + std::to_string(i / kBinaryKeyValues) + " has a non-finite value";
+      return false;
+    }
+  }
+  keys.resize(count);
+  for (uint32_t i = 0; i < count; i++) {
+    const double *v = &values[i * kBinaryKeyValues];
+    keys[i].time = v[0];
+    keys[i].position = Vector3(v[1], v[2], v[3]);
+    keys[i].target = Vector3(v[4], v[5], v[6]);
+    keys[i].fov = v[7];
+    keys[i].roll = v[8];
+  }
+  return true;
+}
+
+bool CameraPath::save(const std::string &path) const {
+  return isBinaryPath(path) ? saveBinary(path) : saveJSON(path);
+}
+
+bool CameraPath::saveJSON(const std::string &path) const {
+  std::ofstream file(path, std::ios::out | std::ios::trunc);
+  if (!file.is_open()) {
+    return false;
+  }
+  file << std::setprecision(9) << "{\n  \"keyframes\": [";
+  for (size_t i = 0; i < keyframes.size(); i++) {
+    const CameraKeyframe &k = keyframes[i];
+    file << (i ? ",\n" : "\n") << "    {\"time\": " << k.time << ", \"position\": [" << k.position.x << ", "
+         << k.position.y << ", " << k.position.z << "], \"target\": [" << k.target.x << ", " << k.target.y << ", "
+         << k.target.z << "], \"fov\": " << k.fov << ", \"roll\": " << k.roll << "}";
+  }
+  file << "\n  ]\n}\n";
+  return file.good();
+}
+
+bool CameraPath::saveBinary(const std::string &path) const {
+  std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!file.is_open()) {
+    return false;
+  }
+  uint32_t count = static_cast<uint32_t>(keyframes.size());
+  file.write(kBinaryMagic, sizeof(kBinaryMagic));
+  file.write(reinterpret_cast<const char *>(&kBinaryVersion), sizeof(kBinaryVersion));
+  file.write(reinterpret_cast<const char *>(&count), sizeof(count));
+  for (const CameraKeyframe &k : keyframes) {
+    const double values[kBinaryKeyValues] = {k.time,     k.position.x, k.position.y, k.position.z, k.target.x,
+                                             k.target.y, k.target.z,   k.fov,        k.roll};
+    file.write(reinterpret_cast<const char *>(values), sizeof(values));
+  }
+  return file.good();
+}
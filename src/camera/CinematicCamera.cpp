@@ -2,12 +2,19 @@
 #include <SDL2/SDL.h>
 #include <cmath>
 
+// Key state of a headless caller: nothing pressed
+static const uint8_t kNoKeys[SDL_NUM_SCANCODES] = {};
+
 CinematicCamera::CinematicCamera(Camera &camera, const Vector3 &initialPosition)
     : cam(camera), initialPos(initialPosition), mode(CinematicMode::Manual),
       orbitAngle(0.0), orbitRadius(15.0), cinematicTime(0.0),
       rotationSpeed(0.3) {} // Start in Manual mode by default - slower rotation
 
 void CinematicCamera::update(double deltaTime, const uint8_t *keyStates) {
+  if (!keyStates) {
+    keyStates = kNoKeys;
+  }
+  
   // Always advance time, even if deltaTime is small
   cinematicTime += deltaTime;
   
@@ -37,7 +44,7 @@ void CinematicCamera::update(double deltaTime, const uint8_t *keyStates) {
   // Always update camera look direction after position change
   // This handles rotations incrementally based on current key states
   // Rotations only happen when keys are pressed, stop when released
-  updateCameraLookDirection(deltaTime);
+  updateCameraLookDirection(deltaTime, keyStates);
 }
 
 void CinematicCamera::updateManualMode(double deltaTime, const uint8_t *keyStates) {
@@ -132,13 +139,17 @@ void CinematicCamera::updateCloseFlyby(double deltaTime) {
 
 void CinematicCamera::cycleMode() {
   int nextMode = (static_cast<int>(mode) + 1) % 5;
-  mode = static_cast<CinematicMode>(nextMode);
+  setMode(static_cast<CinematicMode>(nextMode));
+}
+
+void CinematicCamera::setMode(CinematicMode newMode) {
+  mode = newMode;
   cinematicTime = 0.0;
   orbitAngle = 0.0;
   
   // Ensure camera is in valid state when switching modes
   // Force update of camera look direction to prevent invalid state
-  updateCameraLookDirection(0.016); // Use typical frame time
+  updateCameraLookDirection(0.016, kNoKeys); // Use typical frame time
 }
 
 const char* CinematicCamera::getModeName() const {
@@ -163,9 +174,9 @@ Vector3 rotateAroundAxis(const Vector3& vec, const Vector3& axis, double angle)
   return vec * cosAngle + crossProduct * sinAngle + normalizedAxis * dotProduct * (1.0 - cosAngle);
 }
 
-void CinematicCamera::updateCameraLookDirection(double deltaTime) {
-  // Get keyboard state for rotation (applied incrementally each frame)
-  const Uint8 *keyStates = SDL_GetKeyboardState(nullptr);
+void CinematicCamera::updateCameraLookDirection(double deltaTime, const uint8_t *keyStates) {
+  // keyStates drives rotation (applied incrementally each frame); passed in by
+  // update() so headless renders don't depend on SDL's keyboard state
   
   // Easing factor for smooth rotation acceleration/deceleration
   const double rotationEasingFactor = 15.0; // Increased for smoother, slower rotation response
@@ -7,30 +7,39 @@
 #include <string>
 #include <ctime>
 #include <algorithm>
+#include <cmath>
 #include <sstream>
 #include <iomanip>
 #include <vector>
 #include <cstring>
+#include <future>
+#include <limits>
 
 // External logging function from main.cpp
 extern void appLog(const std::string& message, bool isError = false);
 
 Application::Application()
     : window(nullptr), sdlRenderer(nullptr), font(nullptr), backgroundMusic(nullptr),
-      gpuRenderer(nullptr), gpuTexture(nullptr),
+      gpuRenderer(nullptr), gpuTexture(nullptr), metalLayer(nullptr), gpuPresentation(false),
+      cpuRenderer(nullptr), forceCPURendering(false), verboseLogging(false),
       blackHole(nullptr), camera(nullptr), cinematicCamera(nullptr), hud(nullptr),
-      resolutionManager(nullptr), videoRecorder(nullptr),
+      resolutionManager(nullptr), qualityController(nullptr), videoRecorder(nullptr), screenshotWriter(nullptr),
+      screenshotCompression(-1), frameProfiler(nullptr), streamStarted(false),
       windowWidth(1920), windowHeight(1080), renderWidth(1920), renderHeight(1080),
       isFullscreen(false), isResizing(false),
-      running(false), currentFPS(0), isRecording(false), colorMode(0), colorIntensity(1.0f), 
+      running(false), currentFPS(0), isRecording(false), colorMode(0), colorIntensity(1.0f), traceMode(0),
+      integratorTolerance(METAL_RT_DEFAULT_INTEGRATOR_TOLERANCE), spin(0.0f), exposure(1.0f), paused(false),
+      pausedDuration(0.0), foveatedRendering(false),
       isMusicMuted(false), currentMusicVolume(1.0f), targetMusicVolume(1.0f), isMusicFading(false),
-      currentElapsedTime(0.0) {}
+      showProfiler(false), diagnosticsView(false), currentElapsedTime(0.0), lastDisplayedFrame(-1), firstFrameShown(false) {}
 
 Application::~Application() {
   cleanup();
 }
 
 bool Application::initialize() {
+  launchTime = std::chrono::high_resolution_clock::now();
+
   // Initialize SDL
   std::cerr << "[INIT] Initializing SDL..." << std::endl;
   if (SDL_Init(SDL_INIT_VIDEO) < 0) {
@@ -48,6 +57,9 @@ bool Application::initialize() {
   renderWidth = res.width;
   renderHeight = res.height;
   std::cerr << "[OK] Resolution manager initialized: " << renderWidth << "x" << renderHeight << std::endl;
+
+  // Dynamic quality starts disabled (full render resolution)
+  qualityController = new QualityController();
   
   // Window size - use a reasonable default that matches common screen sizes
   // This will be the display size, rendering resolution is separate
@@ -62,15 +74,34 @@ bool Application::initialize() {
   }
   std::cerr << "[OK] SDL_ttf initialized successfully" << std::endl;
 
-  // Initialize SDL_mixer for audio
+  // Open the audio device here (SDL audio init isn't thread-safe against the
+  // video init below) and decode the background music off the main thread;
+  // pollStartupAssets starts playback once it is ready
   std::cerr << "[INIT] Initializing SDL_mixer..." << std::endl;
   if (Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 2048) < 0) {
     std::cerr << "[WARNING] SDL_mixer could not initialize! Mix_Error: " << Mix_GetError() << std::endl;
     std::cerr << "[WARNING] Continuing without audio..." << std::endl;
   } else {
-    std::cerr << "[OK] SDL_mixer initialized successfully" << std::endl;
+    std::cerr << "[OK] SDL_mixer initialized successfully, loading music in the background..." << std::endl;
+    musicLoad = std::async(std::launch::async, []() -> Mix_Music * {
+      Mix_Music *music = Mix_LoadMUS("assets/interstellar-ambient-music_background-music.wav");
+      if (!music) {
+        std::cerr << "[WARNING] Failed to load background music: " << Mix_GetError() << std::endl;
+        std::cerr << "[WARNING] Continuing without music..." << std::endl;
+      }
+      return music;
+    });
   }
 
+  // The HUD font is only needed for overlays; frames are shown without it until it has loaded
+  fontLoad = std::async(std::launch::async, []() -> TTF_Font * {
+    TTF_Font *loaded = TTF_OpenFont("/System/Library/Fonts/Helvetica.ttc", 24);
+    if (!loaded) {
+      std::cerr << "Failed to load font! TTF_Error: " << TTF_GetError() << std::endl;
+    }
+    return loaded;
+  });
+
   // Create window (resizable)
   std::cerr << "[INIT] Creating window (" << windowWidth << "x" << windowHeight << ")..." << std::endl;
   window = SDL_CreateWindow("Black Hole Simulation | Smooth Orbit",
@@ -93,6 +124,8 @@ bool Application::initialize() {
   windowHeight = actualHeight;
 
   // Create SDL renderer (without VSYNC to prevent pausing when idle)
+  // Prefer the Metal backend so ray traced frames can be drawn straight into its drawable
+  SDL_SetHint(SDL_HINT_RENDER_DRIVER, "metal");
   std::cerr << "[INIT] Creating SDL renderer..." << std::endl;
   sdlRenderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
   if (!sdlRenderer) {
@@ -101,6 +134,12 @@ bool Application::initialize() {
   }
   std::cerr << "[OK] SDL renderer created successfully" << std::endl;
   
+  // Zero-copy presentation is only possible on the Metal backend
+  metalLayer = SDL_RenderGetMetalLayer(sdlRenderer);
+  gpuPresentation = (metalLayer != nullptr);
+  std::cerr << "[OK] Frame presentation: "
+            << (gpuPresentation ? "GPU (zero-copy)" : "CPU readback") << std::endl;
+  
   // Set default render draw color to black
   SDL_SetRenderDrawColor(sdlRenderer, 0, 0, 0, 255);
   
@@ -117,24 +156,46 @@ bool Application::initialize() {
   SDL_Rect fullViewport = {0, 0, rendererOutputW, rendererOutputH};
   SDL_RenderSetViewport(sdlRenderer, &fullViewport);
 
-  // Load font with larger size for better readability
-  font = TTF_OpenFont("/System/Library/Fonts/Helvetica.ttc", 24);
-  if (!font) {
-    std::cerr << "Failed to load font! TTF_Error: " << TTF_GetError() << std::endl;
-  }
-
   // Initialize GPU renderer (Metal) with rendering resolution
   std::cerr << "[INIT] Initializing Metal renderer at " << renderWidth << "x" << renderHeight << "..." << std::endl;
-  gpuRenderer = metal_rt_renderer_create(renderWidth, renderHeight);
-  if (!gpuRenderer) {
-    std::cerr << "[ERROR] GPU renderer failed to initialize!" << std::endl;
-    std::cerr << "[ERROR] Metal GPU acceleration is required for this simulation." << std::endl;
-    return false;
+  if (!forceCPURendering) {
+    gpuRenderer = metal_rt_renderer_create(renderWidth, renderHeight);
+  }
+  if (gpuRenderer) {
+    std::cerr << "[OK] Metal renderer initialized successfully" << std::endl;
+    metal_rt_renderer_set_trace_mode(gpuRenderer, traceMode);
+    metal_rt_renderer_set_integrator_tolerance(gpuRenderer, integratorTolerance);
+    metal_rt_renderer_set_foveation(gpuRenderer, foveatedRendering);
+    metal_rt_renderer_set_exposure(gpuRenderer, exposure);
+    metal_rt_renderer_set_verbose(gpuRenderer, verboseLogging);
+    if (!skyboxPath.empty()) {
+      if (metal_rt_renderer_load_skybox(gpuRenderer, skyboxPath.c_str())) {
+        appLog("[SKY] Loaded skybox " + skyboxPath);
+      } else {
+        appLog("[SKY] Failed to load skybox " + skyboxPath + ", using the starfield", true);
+      }
+    }
+  } else {
+    // CPU reference tracer: volumetric or adaptive Binet, frames always go through readback
+    if (!forceCPURendering) {
+      std::cerr << "[ERROR] GPU renderer failed to initialize! Falling back to the CPU renderer" << std::endl;
+    }
+    cpuRenderer = new CPURenderer(renderWidth, renderHeight);
+    gpuPresentation = false;
+    traceMode = METAL_RT_TRACE_VOLUMETRIC;
+    cpuRenderer->setIntegratorTolerance(integratorTolerance);
+    cpuRenderer->setExposure(exposure);
+    std::ostringstream logMsg;
+    logMsg << "[CPU] CPU renderer initialized (" << cpuRenderer->getThreadCount() << " threads, "
+           << BlackHole::PACKET_SIZE << " rays per packet)";
+    appLog(logMsg.str());
   }
-  std::cerr << "[OK] Metal renderer initialized successfully" << std::endl;
 
-  gpuTexture = SDL_CreateTexture(sdlRenderer, SDL_PIXELFORMAT_ARGB8888,
-                                  SDL_TEXTUREACCESS_STREAMING, renderWidth, renderHeight);
+  // Streaming texture is only needed when frames go through CPU readback
+  if (!gpuPresentation) {
+    gpuTexture = SDL_CreateTexture(sdlRenderer, SDL_PIXELFORMAT_ARGB8888,
+                                    SDL_TEXTUREACCESS_STREAMING, renderWidth, renderHeight);
+  }
   
   // Startup messages removed - use HUD instead
 
@@ -150,20 +211,13 @@ bool Application::initialize() {
   camera->lookAt(Vector3(0, 0, 0));
   hud = new HUD(sdlRenderer, font);
   videoRecorder = new VideoRecorder();
-
-  // Load and play background music
-  std::cerr << "[INIT] Loading background music..." << std::endl;
-  backgroundMusic = Mix_LoadMUS("assets/interstellar-ambient-music_background-music.wav");
-  if (!backgroundMusic) {
-    std::cerr << "[WARNING] Failed to load background music: " << Mix_GetError() << std::endl;
-    std::cerr << "[WARNING] Continuing without music..." << std::endl;
-  } else {
-    std::cerr << "[OK] Background music loaded successfully" << std::endl;
-    // Play music on infinite loop (-1 = loop forever)
-    if (Mix_PlayMusic(backgroundMusic, -1) < 0) {
-      std::cerr << "[WARNING] Failed to play background music: " << Mix_GetError() << std::endl;
+  screenshotWriter = new ScreenshotWriter();
+  frameProfiler = new FrameProfiler();
+  if (!profileExportPath.empty()) {
+    if (frameProfiler->startExport(profileExportPath)) {
+      appLog("[PROFILE] Exporting frame timings to " + profileExportPath);
     } else {
-      std::cerr << "[OK] Background music playing" << std::endl;
+      appLog("[PROFILE] Failed to open " + profileExportPath, true);
     }
   }
 
@@ -183,6 +237,11 @@ void Application::run() {
     auto currentTime = std::chrono::high_resolution_clock::now();
     double deltaTime = std::chrono::duration<double>(currentTime - lastTime).count();
     
+    // Paused: the scene clock stands still so the time passed is skipped on resume
+    if (paused) {
+      pausedDuration += deltaTime;
+    }
+    
     // Clamp deltaTime to reasonable bounds (1ms to 100ms)
     if (deltaTime < 0.001) {
       deltaTime = 0.001; // Minimum 1ms
@@ -191,11 +250,13 @@ void Application::run() {
     }
     
     lastTime = currentTime;
-    double elapsedTime = std::chrono::duration<double>(currentTime - startTime).count();
+    double elapsedTime = std::chrono::duration<double>(currentTime - startTime).count() - pausedDuration;
     
     // Ensure elapsedTime always advances (debug check)
     static double lastElapsedTime = -1.0;
-    if (elapsedTime <= lastElapsedTime) {
+    if (paused && lastElapsedTime >= 0.0) {
+      elapsedTime = lastElapsedTime;
+    } else if (elapsedTime <= lastElapsedTime) {
         // Time didn't advance - this shouldn't happen
         elapsedTime = lastElapsedTime + deltaTime;
     }
@@ -204,12 +265,16 @@ void Application::run() {
     // Store elapsed time for screenshot capture
     currentElapsedTime = elapsedTime;
 
+    frameProfiler->beginFrame();
+
     // Always process events (non-blocking)
     handleEvents();
+    pollStartupAssets();
     
     // Always update and render, regardless of input
     update(deltaTime);
     render(elapsedTime);
+    frameProfiler->endFrame();
 
         // FPS calculation - measure actual rendering performance
         // Use a timer that measures the actual render time, not just frame count
@@ -236,6 +301,36 @@ void Application::run() {
   }
 }
 
+void Application::pollStartupAssets() {
+  auto ready = [](const auto &load) {
+    return load.valid() && load.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+  };
+
+  if (ready(fontLoad)) {
+    font = fontLoad.get();
+    hud->setFont(font);
+  }
+
+  if (ready(musicLoad)) {
+    backgroundMusic = musicLoad.get();
+    if (backgroundMusic) {
+      std::cerr << "[OK] Background music loaded successfully" << std::endl;
+      // Play music on infinite loop (-1 = loop forever)
+      if (Mix_PlayMusic(backgroundMusic, -1) < 0) {
+        std::cerr << "[WARNING] Failed to play background music: " << Mix_GetError() << std::endl;
+      } else {
+        std::cerr << "[OK] Background music playing" << std::endl;
+      }
+    }
+  }
+
+  // The stream carries the music, so it starts once the music load has finished either way
+  if (!streamOutput.empty() && !streamStarted && !musicLoad.valid()) {
+    streamStarted = true;
+    startRecording();
+  }
+}
+
 void Application::handleEvents() {
   SDL_Event e;
   while (SDL_PollEvent(&e) != 0) {
@@ -263,7 +358,7 @@ void Application::handleEvents() {
       }
       
       if (e.key.keysym.sym == SDLK_s && isCommandPressed) {
-        takeScreenshot();
+        takeScreenshot((SDL_GetModState() & KMOD_SHIFT) != 0);
         break;
       }
       
@@ -307,15 +402,162 @@ void Application::handleEvents() {
           // Hints toggle logging removed
           break;
         case SDLK_c:
-          // Cycle color palette: Blue -> Orange -> Red -> White -> Blue
-          colorMode = (colorMode + 1) % 4;
+          // Cycle color palette: Blue -> Orange -> Red -> White -> Blackbody -> Blue
+          colorMode = (colorMode + 1) % 5;
           {
-            const char* colorNames[] = {"Blue", "Orange", "Red", "White"};
+            const char* colorNames[] = {"Blue", "Orange", "Red", "White", "Blackbody"};
             std::ostringstream logMsg;
             logMsg << "[COLOR] Switched to " << colorNames[colorMode] << " palette";
             appLog(logMsg.str());
             std::cout << "Color mode: " << colorNames[colorMode] << std::endl;
           }
+          // Every palette has its own Kerr pipeline: without one, drop back to
+          // Schwarzschild rather than trace the new palette with the wrong metric
+          if (gpuRenderer && spin != 0.0f && !metal_rt_renderer_set_spin(gpuRenderer, spin, colorMode)) {
+            metal_rt_renderer_set_spin(gpuRenderer, 0.0f, colorMode);
+            spin = 0.0f;
+            appLog("[SPIN] No Kerr pipeline for this palette, back to Schwarzschild (a/M = 0)", true);
+          }
+          updateWindowTitle();
+          break;
+        
+        case SDLK_v:
+          // Cycle ray tracing strategy: Volumetric -> Disk Crossing -> Geodesic LUT -> Adaptive Binet
+          if (cpuRenderer) {
+            // The CPU tracer only has the volumetric and adaptive Binet modes
+            traceMode = traceMode == METAL_RT_TRACE_VOLUMETRIC ? METAL_RT_TRACE_ADAPTIVE_BINET
+                                                               : METAL_RT_TRACE_VOLUMETRIC;
+            cpuRenderer->setTraceMode(traceMode);
+          } else {
+            traceMode = (traceMode + 1) % METAL_RT_TRACE_MODE_COUNT;
+            metal_rt_renderer_set_trace_mode(gpuRenderer, traceMode);
+          }
+          {
+            const char* traceNames[] = {"Volumetric", "Disk Crossing", "Geodesic LUT", "Adaptive Binet"};
+            std::ostringstream logMsg;
+            logMsg << "[TRACE] Switched to " << traceNames[traceMode] << " tracing";
+            appLog(logMsg.str());
+            std::cout << "Trace mode: " << traceNames[traceMode] << std::endl;
+          }
+          break;
+        
+        case SDLK_b:
+          // Cycle the adaptive Binet integrator tolerance: 1e-6 -> 1e-7 -> 1e-5 -> 1e-6
+          integratorTolerance = integratorTolerance > 5e-6f ? 1e-6f : (integratorTolerance > 5e-7f ? 1e-7f : 1e-5f);
+          if (cpuRenderer) {
+            cpuRenderer->setIntegratorTolerance(integratorTolerance);
+          } else {
+            metal_rt_renderer_set_integrator_tolerance(gpuRenderer, integratorTolerance);
+          }
+          {
+            std::ostringstream logMsg;
+            logMsg << "[TRACE] Adaptive Binet tolerance " << std::scientific << std::setprecision(0)
+                   << integratorTolerance;
+            appLog(logMsg.str());
+            std::cout << logMsg.str() << std::endl;
+          }
+          break;
+        
+        case SDLK_SPACE:
+          // Pause: freeze the scene; the Metal renderer then accumulates jittered
+          // samples into an anti-aliased still
+          paused = !paused;
+          {
+            std::ostringstream logMsg;
+            logMsg << "[PAUSE] Scene " << (paused ? "paused" : "resumed");
+            if (!paused && gpuRenderer) {
+              logMsg << " (" << metal_rt_renderer_get_accumulated_samples(gpuRenderer) << " samples per pixel)";
+            }
+            appLog(logMsg.str());
+            std::cout << logMsg.str() << std::endl;
+          }
+          updateWindowTitle();
+          break;
+        
+        case SDLK_LEFTBRACKET:
+        case SDLK_RIGHTBRACKET:
+          // Exposure in half stops between -6 and +6 EV; only the post chain re-runs on a paused scene
+          {
+            double ev = std::round(std::log2(exposure) * 2.0) / 2.0 +
+                        (e.key.keysym.sym == SDLK_RIGHTBRACKET ? 0.5 : -0.5);
+            ev = std::clamp(ev, -6.0, 6.0);
+            exposure = static_cast<float>(std::exp2(ev));
+            if (cpuRenderer) {
+              cpuRenderer->setExposure(exposure);
+            } else {
+              metal_rt_renderer_set_exposure(gpuRenderer, exposure);
+            }
+            std::ostringstream logMsg;
+            logMsg << "[EXPOSURE] " << std::showpos << std::fixed << std::setprecision(1) << ev << " EV";
+            appLog(logMsg.str());
+            std::cout << logMsg.str() << std::endl;
+          }
+          break;
+        
+        case SDLK_COMMA:
+        case SDLK_PERIOD:
+          // Kerr spin in steps of 0.1 (negative = counter-rotating to the disk), clamped at +-0.998
+          if (!gpuRenderer) {
+            appLog("[SPIN] Kerr spin needs the Metal renderer");
+          } else {
+            float step = e.key.keysym.sym == SDLK_PERIOD ? 0.1f : -0.1f;
+            float next = std::clamp(std::round((spin + step) * 10.0f) / 10.0f, -0.998f, 0.998f);
+            std::ostringstream logMsg;
+            if (metal_rt_renderer_set_spin(gpuRenderer, next, colorMode)) {
+              spin = next;
+              logMsg << "[SPIN] Black hole spin a/M = " << std::fixed << std::setprecision(3) << spin
+                     << (spin == 0.0f ? " (Schwarzschild)" : " (Kerr)");
+            } else {
+              logMsg << "[SPIN] Kerr pipeline not ready for this palette, spin stays " << std::fixed << std::setprecision(3)
+                     << spin;
+            }
+            appLog(logMsg.str());
+            std::cout << logMsg.str() << std::endl;
+          }
+          break;
+        
+        case SDLK_e:
+          // Toggle foveated tracing (coarse pass + full resolution only where needed)
+          if (metal_rt_renderer_set_foveation(gpuRenderer, !foveatedRendering)) {
+            foveatedRendering = !foveatedRendering;
+            std::ostringstream logMsg;
+            logMsg << "[FOVEATION] Foveated tracing " << (foveatedRendering ? "enabled" : "disabled");
+            appLog(logMsg.str());
+            std::cout << logMsg.str() << std::endl;
+          } else {
+            appLog("[FOVEATION] Foveated tracing unavailable");
+            std::cout << "Foveated tracing unavailable" << std::endl;
+          }
+          break;
+        
+        case SDLK_h:
+          if (!gpuRenderer) {
+            appLog("[DIAGNOSTICS] Heatmap view needs the Metal renderer");
+          } else if (SDL_GetModState() & KMOD_SHIFT) {
+            // Shift+H: dump the heatmap and the raw per-pixel statistics
+            saveDiagnostics();
+          } else {
+            // Step count heatmap (totals appear in the P overlay)
+            diagnosticsView = !diagnosticsView;
+            metal_rt_renderer_set_diagnostics(gpuRenderer, diagnosticsView);
+            std::ostringstream logMsg;
+            logMsg << "[DIAGNOSTICS] Step heatmap " << (diagnosticsView ? "enabled" : "disabled");
+            appLog(logMsg.str());
+            std::cout << logMsg.str() << std::endl;
+          }
+          break;
+        
+        case SDLK_x:
+          // Toggle automatic quality (render scale driven by GPU frame time)
+          qualityController->setEnabled(!qualityController->isEnabled());
+          applyQualityScale();
+          {
+            std::ostringstream logMsg;
+            logMsg << "[QUALITY] Automatic quality " << (qualityController->isEnabled() ? "enabled" : "disabled")
+                   << " (target " << std::fixed << std::setprecision(1) << qualityController->getTargetFrameTime() << " ms)";
+            appLog(logMsg.str());
+            std::cout << logMsg.str() << std::endl;
+          }
           updateWindowTitle();
           break;
         
@@ -336,6 +578,12 @@ void Application::handleEvents() {
           }
           break;
         
+        case SDLK_p:
+          // Frame timing graph
+          showProfiler = !showProfiler;
+          appLog(std::string("[PROFILE] Frame timing graph ") + (showProfiler ? "shown" : "hidden"));
+          break;
+        
         case SDLK_t:
           // Changed cinematic camera to 't' key (was 'b')
           cinematicCamera->cycleMode();
@@ -387,7 +635,9 @@ void Application::update(double deltaTime) {
   
   // Update camera - this must happen every frame
   // Even in manual mode with no input, camera look direction needs updating
-  cinematicCamera->update(deltaTime, keyStates);
+  if (!paused) {
+    cinematicCamera->update(deltaTime, keyStates);
+  }
   
   // Update music volume fade
   if (isMusicFading && backgroundMusic) {
@@ -435,71 +685,76 @@ void Application::render(double elapsedTime) {
   
   // Debug logging removed for performance
   
-  // Render with current color mode
-  metal_rt_renderer_render(gpuRenderer, &gpuCam, renderTime, colorMode, colorIntensity);
-  const void *pixels = metal_rt_renderer_get_pixels(gpuRenderer);
-  
-  if (pixels && gpuTexture) {
-    // Always update texture - force update even if pixels appear unchanged
-    // This ensures animation continues even when camera is stationary
-    // Explicitly update the entire texture region (at rendering resolution)
-    SDL_Rect updateRect = {0, 0, renderWidth, renderHeight};
-    int result = SDL_UpdateTexture(gpuTexture, &updateRect, pixels, renderWidth * 4);
-    if (result != 0) {
-      static int updateErrorCount = 0;
-      if (updateErrorCount++ < 3) {
-        std::cerr << "SDL_UpdateTexture error: " << SDL_GetError() << std::endl;
-      }
-    }
-    
-    // Clear renderer with black before copying to ensure fresh frame
-    SDL_SetRenderDrawColor(sdlRenderer, 0, 0, 0, 255); // Black background
-    SDL_RenderClear(sdlRenderer);
-    
-    // Reset all renderer state to defaults
-    SDL_RenderSetViewport(sdlRenderer, nullptr); // Reset viewport to full renderer output
-    SDL_RenderSetScale(sdlRenderer, 1.0f, 1.0f); // Ensure 1:1 scale
-    
-    // Get current renderer output size (accounts for high DPI scaling)
-    int currentOutputW, currentOutputH;
-    SDL_GetRendererOutputSize(sdlRenderer, &currentOutputW, &currentOutputH);
-    
-    // Calculate aspect ratios to maintain proper aspect ratio (letterbox/pillarbox)
-    float renderAspect = static_cast<float>(renderWidth) / static_cast<float>(renderHeight);
-    float outputAspect = static_cast<float>(currentOutputW) / static_cast<float>(currentOutputH);
-    
-    SDL_Rect srcRect = {0, 0, renderWidth, renderHeight}; // Full source texture
-    SDL_Rect dstRect;
-    
-    if (renderAspect > outputAspect) {
-      // Source is wider - letterbox (black bars top/bottom)
-      int scaledHeight = static_cast<int>(currentOutputW / renderAspect);
-      int offsetY = (currentOutputH - scaledHeight) / 2;
-      dstRect = {0, offsetY, currentOutputW, scaledHeight};
-    } else {
-      // Source is taller - pillarbox (black bars left/right)
-      int scaledWidth = static_cast<int>(currentOutputH * renderAspect);
-      int offsetX = (currentOutputW - scaledWidth) / 2;
-      dstRect = {offsetX, 0, scaledWidth, currentOutputH};
+  // Submit this frame with the current color mode without waiting for the GPU,
+  // then pick up the newest frame that has finished (usually the previous one).
+  // The CPU only blocks when two frames are already in flight.
+  bool haveFrame;
+  if (cpuRenderer) {
+    // CPU fallback traces synchronously at the full render size
+    cpuRenderer->render(gpuCam, renderTime, colorMode, colorIntensity);
+    frameProfiler->addStageTime(FrameProfiler::STAGE_GPU, cpuRenderer->getLastFrameTimeMs());
+    haveFrame = true;
+  } else {
+    long displayedFrame;
+    {
+      FrameProfiler::ScopedStage stage(*frameProfiler, FrameProfiler::STAGE_SUBMIT);
+      metal_rt_renderer_begin_frame(gpuRenderer, &gpuCam, renderTime, colorMode, colorIntensity);
+      displayedFrame = metal_rt_renderer_acquire_completed(gpuRenderer);
     }
+    haveFrame = displayedFrame >= 0;
     
-    // Copy texture maintaining aspect ratio
-    int copyResult = SDL_RenderCopy(sdlRenderer, gpuTexture, &srcRect, &dstRect);
-    if (copyResult != 0) {
-      static int errorCount = 0;
-      if (errorCount++ < 3) {
-        std::cerr << "SDL_RenderCopy error: " << SDL_GetError() << std::endl;
+    // Dynamic quality: one GPU timing sample per newly completed frame
+    if (haveFrame && displayedFrame != lastDisplayedFrame) {
+      lastDisplayedFrame = displayedFrame;
+      double gpuMs = metal_rt_renderer_get_gpu_time_ms(gpuRenderer);
+      frameProfiler->addStageTime(FrameProfiler::STAGE_GPU, gpuMs);
+      // Paused: hold the render scale, a viewport change would restart the refinement
+      if (!paused && qualityController->update(gpuMs)) {
+        applyQualityScale();
       }
     }
-    
-    // Force renderer to flush commands
-    SDL_RenderFlush(sdlRenderer);
+  }
+  
+  // Clear renderer with black before drawing to ensure fresh frame
+  SDL_SetRenderDrawColor(sdlRenderer, 0, 0, 0, 255); // Black background
+  SDL_RenderClear(sdlRenderer);
+  
+  // Reset all renderer state to defaults
+  SDL_RenderSetViewport(sdlRenderer, nullptr); // Reset viewport to full renderer output
+  SDL_RenderSetScale(sdlRenderer, 1.0f, 1.0f); // Ensure 1:1 scale
+  
+  // Get current renderer output size (accounts for high DPI scaling)
+  int currentOutputW, currentOutputH;
+  SDL_GetRendererOutputSize(sdlRenderer, &currentOutputW, &currentOutputH);
+  
+  // Calculate aspect ratios to maintain proper aspect ratio (letterbox/pillarbox)
+  float renderAspect = static_cast<float>(renderWidth) / static_cast<float>(renderHeight);
+  float outputAspect = static_cast<float>(currentOutputW) / static_cast<float>(currentOutputH);
+  
+  SDL_Rect dstRect;
+  if (renderAspect > outputAspect) {
+    // Source is wider - letterbox (black bars top/bottom)
+    int scaledHeight = static_cast<int>(currentOutputW / renderAspect);
+    int offsetY = (currentOutputH - scaledHeight) / 2;
+    dstRect = {0, offsetY, currentOutputW, scaledHeight};
   } else {
-    // If rendering fails, log error but continue loop
-    static int errorCount = 0;
-    if (errorCount++ < 5) {
-      std::cerr << "Warning: Render failed - pixels: " << (pixels ? "OK" : "NULL") 
-                << ", texture: " << (gpuTexture ? "OK" : "NULL") << std::endl;
+    // Source is taller - pillarbox (black bars left/right)
+    int scaledWidth = static_cast<int>(currentOutputH * renderAspect);
+    int offsetX = (currentOutputW - scaledWidth) / 2;
+    dstRect = {offsetX, 0, scaledWidth, currentOutputH};
+  }
+  
+  // Prefer drawing the Metal output texture directly into SDL's drawable;
+  // fall back to readback + SDL_UpdateTexture if that isn't available.
+  // Nothing to draw until the first frame has come back from the GPU.
+  if (haveFrame) {
+    bool presented;
+    {
+      FrameProfiler::ScopedStage stage(*frameProfiler, FrameProfiler::STAGE_UPLOAD);
+      presented = gpuPresentation && presentFrame(dstRect);
+    }
+    if (!presented) {
+      presentFrameWithReadback(dstRect);
     }
   }
 
@@ -508,37 +763,79 @@ void Application::render(double elapsedTime) {
   SDL_RenderSetScale(sdlRenderer, 1.0f, 1.0f); // Ensure 1:1 scale for HUD
   
   // Render HUD (hide hints if recording)
+  frameProfiler->beginStage(FrameProfiler::STAGE_HUD);
   bool showHints = hud->areHintsVisible() && !isRecording;
   hud->renderHints(showHints, cinematicCamera->getMode(), currentFPS, windowWidth, windowHeight, resolutionManager, colorMode, colorIntensity, isMusicMuted);
   
   // Render music credits (always visible when music is playing, even during recording)
   hud->renderMusicCredits(isMusicMuted, windowWidth, windowHeight);
+  
+  if (showProfiler) {
+    RayDiagnostics diagnostics;
+    bool haveDiagnostics = diagnosticsView && metal_rt_renderer_get_diagnostics(gpuRenderer, &diagnostics);
+    hud->renderProfiler(*frameProfiler, windowWidth, windowHeight, haveDiagnostics ? &diagnostics : nullptr);
+  }
+  frameProfiler->endStage(FrameProfiler::STAGE_HUD);
 
-  // Capture frame for video recording AFTER HUD is rendered (to include overlays)
-  if (isRecording && videoRecorder) {
-    // Get actual renderer output size (may differ from render resolution due to high DPI)
-    int outputW, outputH;
-    SDL_GetRendererOutputSize(sdlRenderer, &outputW, &outputH);
-    
-    // Allocate buffer for pixel data
-    std::vector<uint8_t> pixelBuffer(outputW * outputH * 4);
-    
-    // Read pixels from renderer (includes HUD overlay)
-    if (SDL_RenderReadPixels(sdlRenderer, nullptr, SDL_PIXELFORMAT_ARGB8888, 
-                             pixelBuffer.data(), outputW * 4) == 0) {
-      // Pass the actual captured size to the video recorder
-      videoRecorder->addFrame(pixelBuffer.data(), outputW, outputH);
-    } else {
-      static int readErrorCount = 0;
-      if (readErrorCount++ < 3) {
-        std::cerr << "Warning: Failed to read pixels for recording: " << SDL_GetError() << std::endl;
+  frameProfiler->beginStage(FrameProfiler::STAGE_ENCODE);
+  if (isRecording && videoRecorder && videoRecorder->getBackend() == VideoRecorder::Backend::Hardware) {
+    // Hardware recording: the displayed ray traced frame goes GPU -> NV12 ->
+    // VideoToolbox without a CPU readback (clean feed, no HUD)
+    void *pixelBuffer = haveFrame ? videoRecorder->acquireHardwareFrame() : nullptr;
+    if (pixelBuffer) {
+      if (metal_rt_renderer_convert_to_nv12(gpuRenderer, pixelBuffer)) {
+        videoRecorder->submitHardwareFrame();
+      } else {
+        videoRecorder->cancelHardwareFrame();
       }
     }
+  } else if (isRecording && videoRecorder) {
+    // Software recording: same clean feed at the render size. The GPU scales
+    // the displayed frame into a pooled staging buffer and it's encoded once a
+    // later frame sees the copy finished, so the render loop only waits on a
+    // readback when every staging buffer is still queued
+    if (cpuRenderer) {
+      if (cpuRenderer->getWidth() == videoRecorder->getFrameWidth() &&
+          cpuRenderer->getHeight() == videoRecorder->getFrameHeight()) {
+        videoRecorder->addFrame(cpuRenderer->getPixels(), cpuRenderer->getWidth(), cpuRenderer->getHeight());
+      }
+    } else if (haveFrame) {
+      long readback = metal_rt_renderer_begin_readback(gpuRenderer, videoRecorder->getFrameWidth(),
+                                                       videoRecorder->getFrameHeight());
+      if (readback < 0 && !recordingReadbacks.empty()) {
+        // Every staging buffer is still queued: wait for the oldest rather than drop the frame
+        drainRecordingReadbacks(recordingReadbacks.size() - 1);
+        readback = metal_rt_renderer_begin_readback(gpuRenderer, videoRecorder->getFrameWidth(),
+                                                    videoRecorder->getFrameHeight());
+      }
+      if (readback >= 0) {
+        recordingReadbacks.push_back(readback);
+      } else {
+        static int readErrorCount = 0;
+        if (readErrorCount++ < 3) {
+          appLog("[RECORDING] No free readback buffer, frame skipped", true);
+        }
+      }
+      drainRecordingReadbacks(std::numeric_limits<size_t>::max());
+    }
   }
 
+  frameProfiler->endStage(FrameProfiler::STAGE_ENCODE);
+
   // Always present - this must happen every frame
   // Force presentation even if SDL thinks nothing changed
+  frameProfiler->beginStage(FrameProfiler::STAGE_PRESENT);
   SDL_RenderPresent(sdlRenderer);
+  frameProfiler->endStage(FrameProfiler::STAGE_PRESENT);
+
+  if (haveFrame && !firstFrameShown) {
+    firstFrameShown = true;
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - launchTime).count();
+    std::ostringstream logMsg;
+    logMsg << "[STARTUP] First frame after " << std::fixed << std::setprecision(1) << ms << " ms";
+    appLog(logMsg.str());
+    std::cout << logMsg.str() << std::endl;
+  }
   
   // Force window update on macOS - prevent throttling
   #ifdef __APPLE__
@@ -547,6 +844,71 @@ void Application::render(double elapsedTime) {
   #endif
 }
 
+bool Application::presentFrame(const SDL_Rect &dstRect) {
+  // Execute the queued clear so SDL's render pass is open on the current drawable
+  SDL_RenderFlush(sdlRenderer);
+  
+  // Encoder is null if Metal refuses to hand out a drawable (e.g. minimized window)
+  void *encoder = SDL_RenderGetMetalCommandEncoder(sdlRenderer);
+  if (!encoder) {
+    return false;
+  }
+  
+  // The frame is sampled by SDL's own command buffer: no readback, no swizzle, no upload.
+  // HUD draws queued after this point land on top of it.
+  return metal_rt_renderer_present(gpuRenderer, encoder, metalLayer,
+                                   dstRect.x, dstRect.y, dstRect.w, dstRect.h);
+}
+
+void Application::presentFrameWithReadback(const SDL_Rect &dstRect) {
+  // Created lazily: only needed if GPU presentation is unavailable
+  if (!gpuTexture) {
+    gpuTexture = SDL_CreateTexture(sdlRenderer, SDL_PIXELFORMAT_ARGB8888,
+                                    SDL_TEXTUREACCESS_STREAMING, renderWidth, renderHeight);
+  }
+  
+  frameProfiler->beginStage(FrameProfiler::STAGE_READBACK);
+  const void *pixels = cpuRenderer ? cpuRenderer->getPixels() : metal_rt_renderer_get_pixels(gpuRenderer);
+  frameProfiler->endStage(FrameProfiler::STAGE_READBACK);
+  
+  if (pixels && gpuTexture) {
+    FrameProfiler::ScopedStage stage(*frameProfiler, FrameProfiler::STAGE_UPLOAD);
+    // Always update texture - force update even if pixels appear unchanged
+    // This ensures animation continues even when camera is stationary
+    // Explicitly update the entire texture region (at rendering resolution)
+    SDL_Rect updateRect = {0, 0, renderWidth, renderHeight};
+    int result = SDL_UpdateTexture(gpuTexture, &updateRect, pixels, renderWidth * 4);
+    if (result != 0) {
+      static int updateErrorCount = 0;
+      if (updateErrorCount++ < 3) {
+        std::cerr << "SDL_UpdateTexture error: " << SDL_GetError() << std::endl;
+      }
+    }
+    
+    // Copy texture maintaining aspect ratio (only the traced sub-rect under dynamic quality)
+    int displayedW = renderWidth, displayedH = renderHeight;
+    metal_rt_renderer_get_displayed_size(gpuRenderer, &displayedW, &displayedH);
+    SDL_Rect srcRect = {0, 0, displayedW, displayedH};
+    int copyResult = SDL_RenderCopy(sdlRenderer, gpuTexture, &srcRect, &dstRect);
+    if (copyResult != 0) {
+      static int errorCount = 0;
+      if (errorCount++ < 3) {
+        std::cerr << "SDL_RenderCopy error: " << SDL_GetError() << std::endl;
+      }
+    }
+    
+    // Force renderer to flush commands
+    SDL_RenderFlush(sdlRenderer);
+  } else {
+    // If rendering fails, log error but continue loop
+    static int errorCount = 0;
+    if (errorCount++ < 5) {
+      std::cerr << "Warning: Render failed - pixels: " << (pixels ? "OK" : "NULL") 
+                << ", texture: " << (gpuTexture ? "OK" : "NULL") << std::endl;
+    }
+  }
+}
+
 void Application::prepareCameraData(CameraData &data) {
   // Always ensure camera data is valid, even when switching modes
   data.position[0] = camera->position.x;
@@ -645,7 +1007,15 @@ void Application::recreateRenderTargets() {
   windowHeight = actualHeight;
   
   // Resize Metal renderer to rendering resolution (not window size)
-  metal_rt_renderer_resize(gpuRenderer, renderWidth, renderHeight);
+  if (cpuRenderer) {
+    cpuRenderer->resize(renderWidth, renderHeight);
+  } else {
+    metal_rt_renderer_resize(gpuRenderer, renderWidth, renderHeight);
+  }
+  
+  // New maximum size: keep the current quality scale, but re-measure timing
+  qualityController->reset();
+  applyQualityScale();
   
   // Recreate SDL texture with rendering resolution
   if (gpuTexture) {
@@ -653,11 +1023,13 @@ void Application::recreateRenderTargets() {
     gpuTexture = nullptr;
   }
   
-  gpuTexture = SDL_CreateTexture(sdlRenderer, SDL_PIXELFORMAT_ARGB8888,
-                                  SDL_TEXTUREACCESS_STREAMING, renderWidth, renderHeight);
-  
-  if (!gpuTexture) {
-    std::cerr << "Failed to recreate texture at " << renderWidth << "×" << renderHeight << std::endl;
+  if (!gpuPresentation) {
+    gpuTexture = SDL_CreateTexture(sdlRenderer, SDL_PIXELFORMAT_ARGB8888,
+                                    SDL_TEXTUREACCESS_STREAMING, renderWidth, renderHeight);
+    
+    if (!gpuTexture) {
+      std::cerr << "Failed to recreate texture at " << renderWidth << "×" << renderHeight << std::endl;
+    }
   }
   
   updateWindowTitle();
@@ -667,10 +1039,25 @@ void Application::updateWindowTitle() {
   std::string title = "Black Hole Simulation - " +
                       std::string(cinematicCamera->getModeName()) +
                       " - FPS: " + std::to_string(currentFPS);
+  if (qualityController && qualityController->isEnabled()) {
+    title += " - Auto Quality: " + std::to_string(static_cast<int>(qualityController->getScale() * 100.0 + 0.5)) + "%";
+  }
+  if (paused) {
+    title += " - Paused";
+    if (gpuRenderer) {
+      title += " (" + std::to_string(metal_rt_renderer_get_accumulated_samples(gpuRenderer)) + " spp)";
+    }
+  }
   if (isRecording) {
     // Use both emoji and text indicator for maximum compatibility
     // macOS window titles may not always display emoji correctly
     title = "🔴 [REC] " + title;
+    if (videoRecorder) {
+      // Encoder queue health (frames waiting / capacity, frames lost to the queue policy)
+      VideoRecorder::Stats stats = videoRecorder->getStats();
+      title += " - Queue: " + std::to_string(stats.queueDepth) + "/" + std::to_string(stats.queueCapacity) +
+               " - Dropped: " + std::to_string(stats.framesDropped);
+    }
   }
   SDL_SetWindowTitle(window, title.c_str());
   
@@ -683,6 +1070,14 @@ void Application::updateWindowTitle() {
 }
 
 
+void Application::applyQualityScale() {
+  // Trace into a sub-rect of the (max size) render targets - no reallocation
+  double scale = qualityController->getScale();
+  int w = std::max(8, static_cast<int>(renderWidth * scale + 0.5));
+  int h = std::max(8, static_cast<int>(renderHeight * scale + 0.5));
+  metal_rt_renderer_set_viewport(gpuRenderer, w, h);
+}
+
 void Application::changeResolution(bool increase) {
   // Don't allow resolution change during recording
   if (isRecording) {
@@ -773,12 +1168,12 @@ void Application::startRecording() {
   
   // Use /tmp directory for temporary recording file (writable location)
   // The file will be moved to user's chosen location after recording stops
-  std::string filename = std::string("/tmp/") + filenameBase;
+  std::string filename = streamOutput.empty() ? std::string("/tmp/") + filenameBase : streamOutput;
   
   int fps = currentFPS > 0 ? currentFPS : 60;
-  // Get actual renderer output size for recording (includes high DPI scaling)
-  int recordWidth, recordHeight;
-  SDL_GetRendererOutputSize(sdlRenderer, &recordWidth, &recordHeight);
+  // Both backends record the render target at the render size (clean feed, no HUD)
+  int recordWidth = renderWidth;
+  int recordHeight = renderHeight;
   
   std::ostringstream logMsg;
   logMsg << "[RECORDING] Attempting to start recording: " << filename 
@@ -803,7 +1198,14 @@ void Application::startRecording() {
     }
   }
   
-  if (videoRecorder->startRecording(filename, recordWidth, recordHeight, fps, audioFile)) {
+  bool started = gpuRenderer && videoRecorder->startRecording(filename, recordWidth, recordHeight, fps, audioFile,
+                                                              VideoRecorder::Backend::Hardware);
+  if (!started) {
+    appLog("[RECORDING] Hardware encoding unavailable, falling back to software encoding");
+    started = videoRecorder->startRecording(filename, recordWidth, recordHeight, fps, audioFile);
+  }
+  
+  if (started) {
     isRecording = true;
     updateWindowTitle();
     logMsg.str("");
@@ -822,6 +1224,23 @@ void Application::startRecording() {
   }
 }
 
+void Application::drainRecordingReadbacks(size_t keep) {
+  // Copies finish in queue order, so stop at the first one still on the GPU
+  // unless more than `keep` are pending
+  while (!recordingReadbacks.empty()) {
+    long readback = recordingReadbacks.front();
+    if (recordingReadbacks.size() <= keep && !metal_rt_renderer_capture_ready(gpuRenderer, readback)) {
+      break;
+    }
+    recordingReadbacks.pop_front();
+    MetalRTCapture capture;
+    if (metal_rt_renderer_finish_capture(gpuRenderer, readback, &capture)) {
+      videoRecorder->addFrame(capture.pixels, capture.width, capture.height);
+    }
+    metal_rt_renderer_release_capture(gpuRenderer, readback);
+  }
+}
+
 void Application::stopRecording() {
   if (!isRecording || !videoRecorder) {
     appLog("[RECORDING] stopRecording() called but not recording or videoRecorder is null");
@@ -830,12 +1249,18 @@ void Application::stopRecording() {
   
   appLog("[RECORDING] Stopping recording...");
   
-  // Stop recording first
+  // Stop recording first (after the readbacks still on the GPU)
+  drainRecordingReadbacks(0);
   videoRecorder->stopRecording();
   std::string tempFilename = videoRecorder->getFilename();
   isRecording = false;
   updateWindowTitle();
   
+  if (videoRecorder->isStreaming()) {
+    appLog("[RECORDING] Stream to " + tempFilename + " stopped");
+    return;
+  }
+  
   std::ostringstream logMsg;
   logMsg << "[RECORDING] Recording stopped. Temp file: " << tempFilename;
   appLog(logMsg.str());
@@ -873,8 +1298,8 @@ void Application::stopRecording() {
   }
 }
 
-void Application::takeScreenshot() {
-  if (!gpuRenderer || !camera) {
+void Application::takeScreenshot(bool hdr) {
+  if ((!gpuRenderer && !cpuRenderer) || !camera || !screenshotWriter) {
     appLog("[SCREENSHOT] Cannot take screenshot: renderer or camera not initialized", true);
     return;
   }
@@ -887,85 +1312,120 @@ void Application::takeScreenshot() {
   // This ensures consistency with what's being displayed
   float renderTime = static_cast<float>(currentElapsedTime);
   
-  // Use render resolution (the actual rendered scene resolution)
-  // This is the native resolution of the GPU renderer, without any scaling
-  int screenshotWidth = renderWidth;
-  int screenshotHeight = renderHeight;
-  
-  // CRITICAL DEBUG: Verify colorMode value
-  std::cout << "========== SCREENSHOT START ==========" << std::endl;
-  std::cout << "Application::colorMode = " << colorMode << std::endl;
-  
   // Log the color mode being used for debugging
   {
-    const char* colorNames[] = {"Blue", "Orange", "Red", "White"};
+    const char* colorNames[] = {"Blue", "Orange", "Red", "White", "Blackbody"};
     std::ostringstream logMsg;
-    logMsg << "[SCREENSHOT] Capturing with color mode: " << colorMode << " (" << colorNames[colorMode % 4] << ")";
+    logMsg << "[SCREENSHOT] Capturing with color mode: " << colorMode << " (" << colorNames[colorMode % 5] << ")"
+           << (hdr ? ", HDR" : "");
     appLog(logMsg.str());
-    std::cout << "[SCREENSHOT] colorMode=" << colorMode << ", colorIntensity=" << colorIntensity << std::endl;
   }
   
-  // Store in local variable to ensure it doesn't get modified
-  int screenshotColorMode = colorMode;
-  std::cout << "[SCREENSHOT] Passing screenshotColorMode=" << screenshotColorMode << " to render_and_get_pixels" << std::endl;
+  // Capture the frame at the render resolution before the save dialog opens:
+  // the GPU traces and copies it while the user picks a file
+  ScreenshotWriter::Job job;
+  job.width = renderWidth;
+  job.height = renderHeight;
+  if (cpuRenderer) {
+    if (hdr) {
+      appLog("[SCREENSHOT] HDR output needs the Metal renderer, saving PNG only");
+      hdr = false;
+    }
+    cpuRenderer->render(gpuCam, renderTime, colorMode, colorIntensity);
+    const uint8_t *pixels = static_cast<const uint8_t *>(cpuRenderer->getPixels());
+    job.width = cpuRenderer->getWidth();
+    job.height = cpuRenderer->getHeight();
+    job.pixels.assign(pixels, pixels + static_cast<size_t>(job.width) * job.height * 4);
+  } else {
+    job.renderer = gpuRenderer;
+    job.capture = metal_rt_renderer_begin_capture(gpuRenderer, &gpuCam, renderTime, colorMode, colorIntensity, hdr);
+    if (job.capture < 0) {
+      appLog("[SCREENSHOT] Previous screenshots are still being written, try again shortly", true);
+      return;
+    }
+  }
   
-  // Use the atomic render-and-get function which reads directly from texture
-  const void *gpuPixels = metal_rt_renderer_render_and_get_pixels(gpuRenderer, &gpuCam, renderTime, screenshotColorMode, colorIntensity);
-  std::cout << "[SCREENSHOT] Got pixels back from render_and_get_pixels" << std::endl;
-  std::cout << "========== SCREENSHOT END ==========" << std::endl;
+  // Generate default filename with timestamp
+  std::time_t now = std::time(nullptr);
+  std::tm* tm = std::localtime(&now);
+  char filenameBase[256];
+  std::snprintf(filenameBase, sizeof(filenameBase), "blackhole_screenshot_%04d%02d%02d_%02d%02d%02d.png",
+                tm->tm_year + 1900, tm->tm_mon + 1, tm->tm_mday,
+                tm->tm_hour, tm->tm_min, tm->tm_sec);
   
-  if (!gpuPixels) {
-    appLog("[SCREENSHOT] render_and_get_pixels returned nullptr!", true);
-    std::cerr << "Failed to get pixels from render_and_get_pixels" << std::endl;
+  // Show save dialog
+  std::string savePath = showSaveDialogPNG(filenameBase);
+  if (savePath.empty()) {
+    if (job.renderer) {
+      metal_rt_renderer_release_capture(gpuRenderer, job.capture);
+    }
+    appLog("[SCREENSHOT] User cancelled save dialog");
     return;
   }
   
-  // Debug: Sample a few pixels to verify color (check top-left corner for debug square)
-  if (screenshotWidth > 0 && screenshotHeight > 0) {
-    // Check top-left corner (should be colored square)
-    // gpuPixels is in BGRA format: [B, G, R, A]
-    const uint8_t* cornerPixel = static_cast<const uint8_t*>(gpuPixels);
-    std::cout << "[SCREENSHOT] Top-left corner pixel BGRA format: B=" << (int)cornerPixel[0] << " G=" << (int)cornerPixel[1] << " R=" << (int)cornerPixel[2] << " A=" << (int)cornerPixel[3] << std::endl;
-    
-    // Check center pixel
-    int centerX = screenshotWidth / 2;
-    int centerY = screenshotHeight / 2;
-    int centerIdx = (centerY * screenshotWidth + centerX) * 4;
-    const uint8_t* centerPixel = static_cast<const uint8_t*>(gpuPixels) + centerIdx;
-    std::cout << "[SCREENSHOT] Center pixel BGRA format: B=" << (int)centerPixel[0] << " G=" << (int)centerPixel[1] << " R=" << (int)centerPixel[2] << " A=" << (int)centerPixel[3] << std::endl;
+  // Linear color next to the PNG
+  job.path = savePath;
+  if (hdr) {
+    size_t extension = savePath.rfind(".png");
+    job.hdrPath = (extension != std::string::npos ? savePath.substr(0, extension) : savePath) + ".tiff";
+  }
+  job.compressionLevel = screenshotCompression >= 0 ? screenshotCompression
+                                                    : ScreenshotWriter::compressionLevelFor(job.width, job.height);
+  screenshotWriter->submit(std::move(job));
+  std::cout << "Saving screenshot to: " << savePath << std::endl;
+}
+
+void Application::saveDiagnostics() {
+  if (!diagnosticsView) {
+    appLog("[DIAGNOSTICS] Enable the heatmap with H before saving it");
+    return;
   }
   
-  // Copy GPU pixels to buffer (GPU pixels are already in ARGB8888 format)
-  std::vector<uint8_t> pixelBuffer(screenshotWidth * screenshotHeight * 4);
-  std::memcpy(pixelBuffer.data(), gpuPixels, screenshotWidth * screenshotHeight * 4);
+  // Full-resolution diagnostics frame; it becomes the displayed frame for the raw dump
+  CameraData gpuCam;
+  prepareCameraData(gpuCam);
+  const void *pixels = metal_rt_renderer_render_and_get_pixels(gpuRenderer, &gpuCam,
+                                                               static_cast<float>(currentElapsedTime),
+                                                               colorMode, colorIntensity);
+  if (!pixels) {
+    appLog("[DIAGNOSTICS] Failed to render the diagnostics frame", true);
+    return;
+  }
   
-  // Generate default filename with timestamp
   std::time_t now = std::time(nullptr);
   std::tm* tm = std::localtime(&now);
   char filenameBase[256];
-  std::snprintf(filenameBase, sizeof(filenameBase), "blackhole_screenshot_%04d%02d%02d_%02d%02d%02d.png",
+  std::snprintf(filenameBase, sizeof(filenameBase), "blackhole_diagnostics_%04d%02d%02d_%02d%02d%02d.png",
                 tm->tm_year + 1900, tm->tm_mon + 1, tm->tm_mday,
                 tm->tm_hour, tm->tm_min, tm->tm_sec);
+  std::string pngPath = showSaveDialogPNG(filenameBase);
+  if (pngPath.empty()) {
+    appLog("[DIAGNOSTICS] User cancelled save dialog");
+    return;
+  }
   
-  // Show save dialog
-  std::string savePath = showSaveDialogPNG(filenameBase);
+  // Raw statistics next to the heatmap: R = steps, G = termination, B = transmittance
+  std::string pfmPath = pngPath;
+  size_t extension = pfmPath.rfind(".png");
+  pfmPath = (extension != std::string::npos ? pfmPath.substr(0, extension) : pfmPath) + ".pfm";
   
-  if (!savePath.empty()) {
-    // Save PNG file
-    if (savePNG(pixelBuffer.data(), screenshotWidth, screenshotHeight, savePath)) {
-      std::ostringstream logMsg;
-      logMsg << "[SCREENSHOT] Screenshot saved to: " << savePath << " (" << screenshotWidth << "×" << screenshotHeight << ")";
-      appLog(logMsg.str());
-      std::cout << "Screenshot saved to: " << savePath << std::endl;
-    } else {
-      std::ostringstream errMsg;
-      errMsg << "[SCREENSHOT] Failed to save screenshot to: " << savePath;
-      appLog(errMsg.str(), true);
-      std::cerr << "Failed to save screenshot!" << std::endl;
+  bool saved = savePNG(pixels, renderWidth, renderHeight, pngPath);
+  saved = metal_rt_renderer_save_diagnostics(gpuRenderer, pfmPath.c_str()) && saved;
+  
+  std::ostringstream logMsg;
+  RayDiagnostics diagnostics;
+  if (saved) {
+    logMsg << "[DIAGNOSTICS] Saved " << pngPath << " and " << pfmPath;
+    if (metal_rt_renderer_get_diagnostics(gpuRenderer, &diagnostics)) {
+      logMsg << std::fixed << std::setprecision(1) << " (mean " << diagnostics.meanSteps << " steps/px, p99 "
+             << diagnostics.p99Steps << ", max " << diagnostics.maxSteps << ")";
     }
+    appLog(logMsg.str());
   } else {
-    appLog("[SCREENSHOT] User cancelled save dialog");
+    logMsg << "[DIAGNOSTICS] Failed to save " << pngPath << " / " << pfmPath;
+    appLog(logMsg.str(), true);
   }
+  std::cout << logMsg.str() << std::endl;
 }
 
 void Application::cleanup() {
@@ -974,10 +1434,21 @@ void Application::cleanup() {
     stopRecording();
   }
   
+  // Pending screenshots still read the renderer's staging buffers
+  delete screenshotWriter;
+  screenshotWriter = nullptr;
+  
   if (gpuRenderer)
     metal_rt_renderer_destroy(gpuRenderer);
+  delete cpuRenderer;
   if (gpuTexture)
     SDL_DestroyTexture(gpuTexture);
+
+  // Background loads that never got picked up still own their results
+  if (fontLoad.valid())
+    font = fontLoad.get();
+  if (musicLoad.valid())
+    backgroundMusic = musicLoad.get();
   if (font)
     TTF_CloseFont(font);
   if (sdlRenderer)
@@ -986,7 +1457,9 @@ void Application::cleanup() {
     SDL_DestroyWindow(window);
   
   delete videoRecorder;
+  delete frameProfiler;
   delete resolutionManager;
+  delete qualityController;
   delete hud;
   delete cinematicCamera;
   delete camera;
@@ -1,4 +1,7 @@
 #include "../include/core/Application.hpp"
+#include "../include/rendering/OfflineRenderer.hpp"
+#include "../include/rendering/SequenceRenderer.hpp"
+#include "../include/camera/CameraPath.hpp"
 #include <iostream>
 #include <fstream>
 #include <string>
@@ -6,6 +9,9 @@
 #include <sstream>
 #include <ctime>
 #include <cstring>
+#include <cstdio>
+#include <cmath>
+#include <algorithm>
 
 // Global log file stream (for Application to use)
 std::ofstream* g_logFile = nullptr;
@@ -60,6 +66,19 @@ void appLog(const std::string& message, bool isError) {
 int main(int argc, char* argv[]) {
   std::string xrayId;
   bool xrayMode = false;
+  bool renderStill = false;
+  bool cpuRendering = false;
+  std::string profilePath;
+  std::string streamOutput;
+  std::string skyboxPath;
+  int screenshotCompression = -1;
+  OfflineRenderSettings stillSettings;
+  bool renderSequence = false;
+  SequenceRenderSettings sequenceSettings;
+  double sequenceDuration = 0.0; // Seconds; overrides --frame-count when set
+  int rangeFirst = -1, rangeLast = -1; // --frames A-B (inclusive)
+  int shardIndex = 1, shardCount = 1;  // --shard K/N (1-based)
+  std::string bakePath;                // --bake-camera-path: timeline written from --camera-mode
   
   // Parse command line arguments
   for (int i = 1; i < argc; i++) {
@@ -67,11 +86,116 @@ int main(int argc, char* argv[]) {
     if (arg == "--xray" && i + 1 < argc) {
       xrayId = argv[++i];
       xrayMode = true;
+    } else if (arg == "--cpu") {
+      cpuRendering = true;
+    } else if (arg == "--profile" && i + 1 < argc) {
+      profilePath = argv[++i];
+    } else if (arg == "--stream" && i + 1 < argc) {
+      streamOutput = argv[++i];
+      if (!VideoRecorder::isStreamURL(streamOutput)) {
+        std::cerr << "Invalid --stream target (expected rtmp://, srt://, udp:// or an .m3u8 playlist): "
+                  << argv[i] << std::endl;
+        return 1;
+      }
+    } else if (arg == "--skybox" && i + 1 < argc) {
+      skyboxPath = argv[++i];
+      stillSettings.skyboxPath = skyboxPath;
+      sequenceSettings.skyboxPath = skyboxPath;
+    } else if (arg == "--png-compression" && i + 1 < argc) {
+      std::string level = argv[++i];
+      if (level == "stored") {
+        screenshotCompression = PNG_STORED;
+      } else if (level == "fast") {
+        screenshotCompression = PNG_FAST;
+      } else if (level == "default") {
+        screenshotCompression = PNG_DEFAULT;
+      } else if (level != "auto") {
+        std::cerr << "Invalid --png-compression (expected auto, stored, fast or default): " << level << std::endl;
+        return 1;
+      }
+    } else if (arg == "--render-still" && i + 1 < argc) {
+      if (std::sscanf(argv[++i], "%dx%d", &stillSettings.width, &stillSettings.height) != 2) {
+        std::cerr << "Invalid --render-still size (expected WIDTHxHEIGHT): " << argv[i] << std::endl;
+        return 1;
+      }
+      renderStill = true;
+    } else if (arg == "--samples" && i + 1 < argc) {
+      stillSettings.samples = std::atoi(argv[++i]);
+    } else if (arg == "--tile-size" && i + 1 < argc) {
+      stillSettings.tileSize = std::atoi(argv[++i]);
+    } else if (arg == "--output" && i + 1 < argc) {
+      stillSettings.outputPath = argv[++i];
+    } else if (arg == "--render-sequence" && i + 1 < argc) {
+      sequenceSettings.outputPath = argv[++i];
+      renderSequence = true;
+    } else if (arg == "--size" && i + 1 < argc) {
+      if (std::sscanf(argv[++i], "%dx%d", &sequenceSettings.width, &sequenceSettings.height) != 2) {
+        std::cerr << "Invalid --size (expected WIDTHxHEIGHT): " << argv[i] << std::endl;
+        return 1;
+      }
+    } else if (arg == "--fps" && i + 1 < argc) {
+      sequenceSettings.fps = std::atoi(argv[++i]);
+    } else if (arg == "--duration" && i + 1 < argc) {
+      sequenceDuration = std::atof(argv[++i]);
+    } else if (arg == "--frame-count" && i + 1 < argc) {
+      sequenceSettings.frameCount = std::atoi(argv[++i]);
+    } else if (arg == "--camera-mode" && i + 1 < argc) {
+      int cameraMode = std::atoi(argv[++i]);
+      if (cameraMode < 0 || cameraMode > 4) {
+        std::cerr << "Invalid --camera-mode (expected 0-4): " << argv[i] << std::endl;
+        return 1;
+      }
+      sequenceSettings.cameraMode = static_cast<CinematicMode>(cameraMode);
+    } else if (arg == "--camera-path" && i + 1 < argc) {
+      sequenceSettings.cameraPath = argv[++i];
+    } else if (arg == "--bake-camera-path" && i + 1 < argc) {
+      bakePath = argv[++i];
+    } else if (arg == "--frames" && i + 1 < argc) {
+      if (std::sscanf(argv[++i], "%d-%d", &rangeFirst, &rangeLast) != 2) {
+        std::cerr << "Invalid --frames (expected FIRST-LAST): " << argv[i] << std::endl;
+        return 1;
+      }
+    } else if (arg == "--shard" && i + 1 < argc) {
+      if (std::sscanf(argv[++i], "%d/%d", &shardIndex, &shardCount) != 2) {
+        std::cerr << "Invalid --shard (expected K/N): " << argv[i] << std::endl;
+        return 1;
+      }
+    } else if (arg == "--gpus" && i + 1 < argc) {
+      sequenceSettings.gpuCount = std::atoi(argv[++i]);
+      stillSettings.gpuCount = sequenceSettings.gpuCount;
     } else if (arg == "--help" || arg == "-h") {
       std::cout << "Black Hole Simulation\n";
-      std::cout << "Usage: " << argv[0] << " [--xray REFERENCE_ID]\n";
+      std::cout << "Usage: " << argv[0] << " [--xray REFERENCE_ID] [--cpu] [--render-still WIDTHxHEIGHT [options]]"
+                << " [--render-sequence OUTPUT [options]]\n";
       std::cout << "\nOptions:\n";
       std::cout << "  --xray REFERENCE_ID    Enable detailed logging to /tmp/blackhole_sim_xray_REFERENCE_ID.log\n";
+      std::cout << "                         (including per-frame Metal renderer logs)\n";
+      std::cout << "  --cpu                  Use the multithreaded CPU reference tracer instead of Metal\n";
+      std::cout << "  --profile FILE         Write per-stage frame timings to FILE (.csv, or .json for a Chrome trace)\n";
+      std::cout << "  --stream URL           Stream the render live with the music to rtmp://, srt:// or udp://,\n";
+      std::cout << "                         or write an HLS playlist (.m3u8) for an HTTP server to share\n";
+      std::cout << "  --skybox FILE          Sky image instead of the procedural stars: equirectangular PNG/JPEG/\n";
+      std::cout << "                         .hdr/.exr or a cubemap .ktx (Metal only)\n";
+      std::cout << "  --png-compression L    Screenshot deflate level: auto (fast above 4K), stored (uncompressed),\n";
+      std::cout << "                         fast or default\n";
+      std::cout << "  --render-still WxH     Render one still offline in tiles (e.g. 15360x8640) and exit\n";
+      std::cout << "  --samples N            Jittered samples per pixel for --render-still (default 16)\n";
+      std::cout << "  --tile-size N          Tile edge in pixels for --render-still (default 512)\n";
+      std::cout << "  --output FILE          PNG path for --render-still (default blackhole_still.png)\n";
+      std::cout << "  --render-sequence OUT  Render a fixed-timestep clip headless and exit; OUT is an .mp4/.mov\n";
+      std::cout << "                         file or a PNG pattern such as frames/blackhole_%05d.png\n";
+      std::cout << "  --size WxH             Frame size for --render-sequence (default 1920x1080)\n";
+      std::cout << "  --fps N                Frame rate for --render-sequence (default 60)\n";
+      std::cout << "  --duration SECONDS     Clip length for --render-sequence (sets the frame count)\n";
+      std::cout << "  --frame-count N        Number of frames for --render-sequence (default 600)\n";
+      std::cout << "  --camera-mode N        Cinematic camera path 0-4 for --render-sequence (default 1, smooth orbit)\n";
+      std::cout << "  --camera-path FILE     Keyframe timeline (.json or .campath) for --render-sequence instead of\n";
+      std::cout << "                         --camera-mode; frames are evaluated at their time, so shards seek directly\n";
+      std::cout << "  --bake-camera-path OUT Write --camera-mode over --duration/--frame-count as an editable timeline\n";
+      std::cout << "                         (.json, or binary .campath) and exit\n";
+      std::cout << "  --frames A-B           Render only frames A to B (inclusive) of the sequence\n";
+      std::cout << "  --shard K/N            Render contiguous part K (1-based) of N of the frame range\n";
+      std::cout << "  --gpus N               GPUs used by --render-still/--render-sequence (default all)\n";
       std::cout << "  --help, -h             Show this help message\n";
       return 0;
     }
@@ -104,7 +228,66 @@ int main(int argc, char* argv[]) {
     std::cerr << "[WARNING] Could not open log file: " << logPath << std::endl;
   }
   
+  if (renderStill) {
+    // Headless: same view as the interactive startup camera
+    Camera stillCamera(Vector3(0, 3, -20), Vector3(0, 0, 0), 60.0);
+    OfflineRenderer offline(stillSettings);
+    bool ok = offline.render(stillCamera);
+    if (logFile.is_open()) {
+      logFile.close();
+    }
+    g_logFile = nullptr;
+    return ok ? 0 : 1;
+  }
+  
+  if (sequenceDuration > 0.0 && sequenceSettings.fps > 0) {
+    sequenceSettings.frameCount = static_cast<int>(std::lround(sequenceDuration * sequenceSettings.fps));
+  }
+  
+  if (!bakePath.empty()) {
+    // Keys every quarter second follow the cinematic modes' slow sinusoids closely
+    const double keyInterval = 0.25;
+    double duration = static_cast<double>(sequenceSettings.frameCount) / std::max(sequenceSettings.fps, 1);
+    Camera bakeCamera(Vector3(0, 3, -20), Vector3(0, 0, 0), 60.0);
+    CameraPath path = CameraPath::fromCinematic(sequenceSettings.cameraMode, bakeCamera, duration, keyInterval);
+    bool ok = path.save(bakePath);
+    std::ostringstream logMsg;
+    logMsg << "[CAMERA] " << (ok ? "Wrote " : "Failed to write ") << path.getKeyframes().size() << " keyframes of "
+           << getCinematicModeName(sequenceSettings.cameraMode) << " to " << bakePath;
+    logMessage(logMsg.str(), !ok);
+    if (logFile.is_open()) {
+      logFile.close();
+    }
+    g_logFile = nullptr;
+    return ok ? 0 : 1;
+  }
+  
+  if (renderSequence) {
+    if (rangeFirst < 0) {
+      rangeFirst = 0;
+      rangeLast = sequenceSettings.frameCount - 1;
+    }
+    if (!SequenceRenderer::applyShard(sequenceSettings, rangeFirst, rangeLast, shardIndex, shardCount)) {
+      logMessage("[SEQUENCE] Invalid --frames/--shard range", true);
+      return 1;
+    }
+    Camera sequenceCamera(Vector3(0, 3, -20), Vector3(0, 0, 0), 60.0);
+    SequenceRenderer sequence(sequenceSettings);
+    bool ok = sequence.render(sequenceCamera);
+    if (logFile.is_open()) {
+      logFile.close();
+    }
+    g_logFile = nullptr;
+    return ok ? 0 : 1;
+  }
+  
   Application app;
+  app.setCPURendering(cpuRendering);
+  app.setProfileExport(profilePath);
+  app.setStreamOutput(streamOutput);
+  app.setSkybox(skyboxPath);
+  app.setVerboseLogging(xrayMode);
+  app.setScreenshotCompression(screenshotCompression);
   
   if (!app.initialize()) {
     logMessage("[FATAL] Failed to initialize application!", true);
@@ -3,7 +3,10 @@
 #include <cmath>
 #include <numbers>
 
-BlackHole::BlackHole(double mass) : mass(mass), rs(2.0 * mass) {}
+BlackHole::BlackHole(double mass) : mass(mass), rs(2.0 * mass), diskShading(mass, rs * 2.5, rs * 12.0)
+{
+  diskShading.build();
+}
 
 Vector3 BlackHole::acceleration(const Vector3 &pos, const Vector3 &vel) const
 {
@@ -15,8 +18,8 @@ Vector3 BlackHole::acceleration(const Vector3 &pos, const Vector3 &vel) const
   return pos * factor;
 }
 
-// Simple procedural noise for disk
-double BlackHole::diskDensity(const Vector3 &pos) const
+// Simple procedural noise for disk (rotates with time like disk_pattern in the shader)
+double BlackHole::diskDensity(const Vector3 &pos, double time) const
 {
   double r = pos.length();
 
@@ -27,7 +30,7 @@ double BlackHole::diskDensity(const Vector3 &pos) const
     return 0.0; // Thin disk
 
   // Noise-like pattern based on angle and radius
-  double angle = std::atan2(pos.z, pos.x);
+  double angle = std::atan2(pos.z, pos.x) + time;
   double spiral = std::sin(angle * 3.0 + r * 0.5);
   double rings = std::sin(r * 2.0);
 
@@ -72,8 +75,22 @@ double BlackHole::dopplerFactor(const Vector3 &pos, const Vector3 &rayDir) const
   return delta;
 }
 
-Vector3 BlackHole::diskColor(double density, double r, const Vector3 &pos, const Vector3 &rayDir, int colorMode) const
+Vector3 BlackHole::diskColor(double density, double r, const Vector3 &pos, const Vector3 &rayDir, int colorMode,
+                             double colorIntensity) const
 {
+  // Apply Doppler beaming
+  double delta = dopplerFactor(pos, rayDir);
+
+  if (colorMode == 4)
+  {
+    // Blackbody mode - profile temperature shifted by Doppler and gravitational redshift
+    float profile[4], radiance[3];
+    diskShading.profileAt(r, profile);
+    diskShading.blackbodyAt(profile[0] * DiskShadingLUT::PEAK_TEMPERATURE * delta * profile[1], radiance);
+    double scale = density * 4.0 * colorIntensity;
+    return Vector3(radiance[0] * scale, radiance[1] * scale, radiance[2] * scale);
+  }
+
   double t = (r - rs * 2.5) / (rs * 9.5);
   t = std::min(std::max(t, 0.0), 1.0);
 
@@ -99,7 +116,7 @@ Vector3 BlackHole::diskColor(double density, double r, const Vector3 &pos, const
     doppler_bright = Vector3(1.0, 0.95, 0.85);
     doppler_dim = Vector3(0.8, 0.5, 0.3);
   }
-  else
+  else if (colorMode == 2)
   {
     // Red mode - Hot red plasma
     hot = Vector3(1.0, 0.85, 0.75); // Inner: Bright red-white
@@ -108,6 +125,15 @@ Vector3 BlackHole::diskColor(double density, double r, const Vector3 &pos, const
     doppler_bright = Vector3(1.0, 0.9, 0.85);
     doppler_dim = Vector3(0.7, 0.3, 0.2);
   }
+  else
+  {
+    // White mode - Pure white/grayscale
+    hot = Vector3(1.0, 1.0, 1.0);   // Inner: Pure white
+    mid = Vector3(0.9, 0.9, 0.9);   // Mid: Light gray-white
+    cold = Vector3(0.7, 0.7, 0.7);  // Outer: Medium gray
+    doppler_bright = Vector3(1.0, 1.0, 1.0);
+    doppler_dim = Vector3(0.6, 0.6, 0.6);
+  }
 
   // Blend between hot, mid, and cold
   Vector3 baseColor;
@@ -120,11 +146,8 @@ Vector3 BlackHole::diskColor(double density, double r, const Vector3 &pos, const
     baseColor = mid * (1.0 - (t - 0.5) * 2.0) + cold * ((t - 0.5) * 2.0);
   }
 
-  // Apply Doppler beaming
-  double delta = dopplerFactor(pos, rayDir);
-
   // Intensity boost: I_observed = I_emitted * δ^3 (for emission)
-  double intensity_boost = std::pow(delta, 3.0);
+  double intensity_boost = delta * delta * delta;
 
   // Frequency shift affects color
   Vector3 doppler_color = baseColor;
@@ -141,14 +164,21 @@ Vector3 BlackHole::diskColor(double density, double r, const Vector3 &pos, const
     doppler_color = baseColor * (1.0 - shift) + doppler_dim * shift;
   }
 
-  return doppler_color * density * 4.0 * intensity_boost;
+  return doppler_color * density * 4.0 * intensity_boost * colorIntensity;
 }
 
-Vector3 BlackHole::sampleBackground(const Vector3 &dir) const
+Vector3 BlackHole::sampleBackground(const Vector3 &dir, double time) const
 {
   constexpr double pi = 3.14159265358979323846;
-  double u = 0.5 + std::atan2(dir.z, dir.x) / (2 * pi);
-  double v = 0.5 - std::asin(dir.y) / pi;
+
+  // Starfield rotates slowly around Y over time
+  double rotationAngle = time * 0.1;
+  double cosRot = std::cos(rotationAngle);
+  double sinRot = std::sin(rotationAngle);
+  Vector3 rotatedDir(dir.x * cosRot - dir.z * sinRot, dir.y, dir.x * sinRot + dir.z * cosRot);
+
+  double u = 0.5 + std::atan2(rotatedDir.z, rotatedDir.x) / (2 * pi);
+  double v = 0.5 - std::asin(std::clamp(rotatedDir.y, -1.0, 1.0)) / pi;
 
   Vector3 color(0, 0, 0); // Pure black background
 
@@ -163,8 +193,27 @@ Vector3 BlackHole::sampleBackground(const Vector3 &dir) const
   return color;
 }
 
-Vector3 BlackHole::trace(const Ray &ray, double stepSize,
-                         double maxDist) const
+void BlackHole::accumulateDisk(const Vector3 &pos, const Vector3 &dir, double time, int colorMode,
+                               double colorIntensity, double stepSize, Vector3 &color,
+                               double &transmittance) const
+{
+  double density = diskDensity(pos, time);
+  if (density <= 0.001)
+    return;
+
+  Vector3 emission = diskColor(density, pos.length(), pos, dir, colorMode, colorIntensity);
+  double absorption = density * 0.5;
+
+  // Beer's Law integration for this step
+  double dt = stepSize; // Approximation
+  double stepTransmittance = std::exp(-absorption * dt);
+
+  color += emission * transmittance * (1.0 - stepTransmittance);
+  transmittance *= stepTransmittance;
+}
+
+Vector3 BlackHole::trace(const Ray &ray, double time, int colorMode, double colorIntensity,
+                         double stepSize, double maxDist) const
 {
   Vector3 pos = ray.origin;
   Vector3 vel = ray.direction;
@@ -184,28 +233,15 @@ Vector3 BlackHole::trace(const Ray &ray, double stepSize,
     }
 
     // Volumetric Accretion Disk Integration
-    double density = diskDensity(pos);
-    if (density > 0.001)
-    {
-      double r = std::sqrt(r2);
-      Vector3 emission = diskColor(density, r, pos, vel, 0); // Default to blue mode
-      double absorption = density * 0.5;
-
-      // Beer's Law integration for this step
-      double dt = stepSize; // Approximation
-      double stepTransmittance = std::exp(-absorption * dt);
-
-      accumulatedColor += emission * transmittance * (1.0 - stepTransmittance);
-      transmittance *= stepTransmittance;
-    }
+    accumulateDisk(pos, vel, time, colorMode, colorIntensity, stepSize, accumulatedColor, transmittance);
 
     // Adaptive Step
     double r = std::sqrt(r2);
     double dt = stepSize * (r / (rs * 2 + 0.1));
-    if (dt < 0.02)
-      dt = 0.02; // Minimum step
-    if (dt > 0.5)
-      dt = 0.5; // Maximum step
+    if (dt < MIN_STEP)
+      dt = MIN_STEP; // Minimum step
+    if (dt > MAX_STEP)
+      dt = MAX_STEP; // Maximum step
 
     // RK4
     Vector3 k1_v = acceleration(pos, vel);
@@ -235,7 +271,343 @@ Vector3 BlackHole::trace(const Ray &ray, double stepSize,
   }
 
   // Add background if ray escapes
-  accumulatedColor += sampleBackground(vel) * transmittance;
+  accumulatedColor += sampleBackground(vel, time) * transmittance;
+
+  return accumulatedColor;
+}
+
+namespace
+{
+// SIMD counterpart of BlackHole::acceleration for a packet of rays
+template <typename Float>
+struct PacketVector
+{
+  Float x, y, z;
+
+  PacketVector operator+(const PacketVector &o) const { return {x + o.x, y + o.y, z + o.z}; }
+  PacketVector operator*(Float s) const { return {x * s, y * s, z * s}; }
+  Float lengthSquared() const { return x * x + y * y + z * z; }
+};
+
+template <typename Float>
+__attribute__((always_inline)) inline PacketVector<Float>
+packetAcceleration(const PacketVector<Float> &pos, const PacketVector<Float> &vel, Float factorScale)
+{
+  Float r2 = pos.lengthSquared();
+  Float r = sqrt(r2);
+  Float hx = pos.y * vel.z - pos.z * vel.y;
+  Float hy = pos.z * vel.x - pos.x * vel.z;
+  Float hz = pos.x * vel.y - pos.y * vel.x;
+  Float h2 = hx * hx + hy * hy + hz * hz;
+  return pos * (factorScale * h2 / (r2 * r2 * r));
+}
+} // namespace
+
+template <typename Float, typename Mask>
+__attribute__((always_inline)) inline void BlackHole::tracePacketLanes(RayPacket &packet, double time,
+                                                                       int colorMode, double colorIntensity) const
+{
+  using PacketVector = ::PacketVector<Float>;
+  constexpr int N = PACKET_SIZE;
+  const double stepSize = 0.1;
+  const Float maxDist(100.0f);
+  const Float minTransmittance(0.01f);
+  const Float horizon2(static_cast<float>(rs * rs));
+  const Float factorScale(static_cast<float>(-1.5 * rs));
+  const Float diskInner(static_cast<float>(rs * 2.5));
+  const Float diskOuter(static_cast<float>(rs * 12.0));
+  const Float diskHalfThickness(0.2f);
+  const Float stepScale(static_cast<float>(stepSize / (rs * 2 + 0.1)));
+  const Float minStep(static_cast<float>(MIN_STEP));
+  const Float maxStep(static_cast<float>(MAX_STEP));
+  const Float half(0.5f), two(2.0f), sixth(1.0f / 6.0f), one(1.0f);
+
+  PacketVector pos = {Float::load(packet.originX), Float::load(packet.originY),
+                      Float::load(packet.originZ)};
+  PacketVector vel = {Float::load(packet.dirX), Float::load(packet.dirY), Float::load(packet.dirZ)};
+  Float totalDist(0.0f);
+
+  // Color and transmittance only change inside the disk, which is shaded per lane
+  Vector3 color[N];
+  double transmittance[N];
+  float laneTransmittance[N];
+  for (int i = 0; i < N; i++)
+  {
+    transmittance[i] = 1.0;
+    laneTransmittance[i] = 1.0f;
+  }
+
+  Mask active = Mask::all();
+  Mask absorbed = Mask::none();
+
+  while (true)
+  {
+    active = active & (totalDist < maxDist) & (Float::load(laneTransmittance) > minTransmittance);
+
+    // Event Horizon
+    Float r2 = pos.lengthSquared();
+    Mask captured = active & (r2 < horizon2);
+    absorbed = absorbed | captured;
+    active = active.andNot(captured);
+    if (!active.any())
+      break;
+
+    // Volumetric Accretion Disk Integration (only lanes inside the slab can have density)
+    Float r = sqrt(r2);
+    Mask slab = active & (r >= diskInner) & (r <= diskOuter) & (abs(pos.y) <= diskHalfThickness);
+    if (slab.any())
+    {
+      float px[N], py[N], pz[N], dx[N], dy[N], dz[N];
+      pos.x.store(px);
+      pos.y.store(py);
+      pos.z.store(pz);
+      vel.x.store(dx);
+      vel.y.store(dy);
+      vel.z.store(dz);
+      int lanes = slab.bits();
+      for (int i = 0; i < N; i++)
+      {
+        if (!(lanes & (1 << i)))
+          continue;
+        accumulateDisk(Vector3(px[i], py[i], pz[i]), Vector3(dx[i], dy[i], dz[i]), time, colorMode,
+                       colorIntensity, stepSize, color[i], transmittance[i]);
+        laneTransmittance[i] = static_cast<float>(transmittance[i]);
+      }
+    }
+
+    // Adaptive Step
+    Float dt = min(max(r * stepScale, minStep), maxStep);
+    Float halfDt = dt * half;
+
+    // RK4
+    PacketVector k1_v = packetAcceleration(pos, vel, factorScale);
+    PacketVector k1_p = vel;
+    PacketVector k2_v = packetAcceleration(pos + k1_p * halfDt, vel + k1_v * halfDt, factorScale);
+    PacketVector k2_p = vel + k1_v * halfDt;
+    PacketVector k3_v = packetAcceleration(pos + k2_p * halfDt, vel + k2_v * halfDt, factorScale);
+    PacketVector k3_p = vel + k2_v * halfDt;
+    PacketVector k4_v = packetAcceleration(pos + k3_p * dt, vel + k3_v * dt, factorScale);
+    PacketVector k4_p = vel + k3_v * dt;
+
+    Float weight = dt * sixth;
+    PacketVector nextVel = vel + (k1_v + k2_v * two + k3_v * two + k4_v) * weight;
+    PacketVector nextPos = pos + (k1_p + k2_p * two + k3_p * two + k4_p) * weight;
+    nextVel = nextVel * (one / sqrt(nextVel.lengthSquared()));
+
+    // Finished lanes keep their final state
+    pos = {select(active, nextPos.x, pos.x), select(active, nextPos.y, pos.y), select(active, nextPos.z, pos.z)};
+    vel = {select(active, nextVel.x, vel.x), select(active, nextVel.y, vel.y), select(active, nextVel.z, vel.z)};
+    totalDist = select(active, totalDist + dt, totalDist);
+  }
+
+  // Add background if ray escapes
+  float dx[N], dy[N], dz[N];
+  vel.x.store(dx);
+  vel.y.store(dy);
+  vel.z.store(dz);
+  int absorbedLanes = absorbed.bits();
+  for (int i = 0; i < N; i++)
+  {
+    if (!(absorbedLanes & (1 << i)))
+      color[i] += sampleBackground(Vector3(dx[i], dy[i], dz[i]), time) * transmittance[i];
+    packet.red[i] = static_cast<float>(color[i].x);
+    packet.green[i] = static_cast<float>(color[i].y);
+    packet.blue[i] = static_cast<float>(color[i].z);
+  }
+}
+
+void BlackHole::tracePacket(RayPacket &packet, double time, int colorMode, double colorIntensity) const
+{
+#if SIMD_FLOAT_AVX2
+  if (simdHasAVX2())
+  {
+    tracePacketAVX2(packet, time, colorMode, colorIntensity);
+    return;
+  }
+#endif
+  tracePacketLanes<SimdFloat, SimdMask>(packet, time, colorMode, colorIntensity);
+}
+
+#if SIMD_FLOAT_AVX2
+static_assert(simd_avx2::SimdFloat::LANES == BlackHole::PACKET_SIZE, "AVX2 and portable packets must match");
+
+// Everything the kernel calls is flattened in here, so its SIMD code is compiled
+// with AVX2/FMA while the rest of the binary stays baseline x86_64
+SIMD_AVX2_TARGET __attribute__((flatten)) void BlackHole::tracePacketAVX2(RayPacket &packet, double time,
+                                                                          int colorMode, double colorIntensity) const
+{
+  tracePacketLanes<simd_avx2::SimdFloat, simd_avx2::SimdMask>(packet, time, colorMode, colorIntensity);
+}
+#endif
+
+namespace
+{
+// Binet state (u, u') with u = 1/r and ' = d/dphi
+struct BinetState
+{
+  double u, du;
+
+  BinetState operator+(const BinetState &o) const { return {u + o.u, du + o.du}; }
+  BinetState operator-(const BinetState &o) const { return {u - o.u, du - o.du}; }
+  BinetState operator*(double s) const { return {u * s, du * s}; }
+};
+
+// u'' = -u + 1.5 rs u^2 (binet_derivative in RayTracing.metal)
+BinetState binetDerivative(const BinetState &y, double rs) { return {y.du, -y.u + 1.5 * rs * y.u * y.u}; }
+
+// Dormand-Prince 5(4) step with first-same-as-last derivative and embedded error (dopri_step)
+BinetState dopriStep(const BinetState &y, double h, const BinetState &k1, double rs, BinetState &kNext,
+                     BinetState &error)
+{
+  BinetState k2 = binetDerivative(y + k1 * (h / 5.0), rs);
+  BinetState k3 = binetDerivative(y + (k1 * (3.0 / 40.0) + k2 * (9.0 / 40.0)) * h, rs);
+  BinetState k4 = binetDerivative(y + (k1 * (44.0 / 45.0) - k2 * (56.0 / 15.0) + k3 * (32.0 / 9.0)) * h, rs);
+  BinetState k5 = binetDerivative(y + (k1 * (19372.0 / 6561.0) - k2 * (25360.0 / 2187.0) +
+                                       k3 * (64448.0 / 6561.0) - k4 * (212.0 / 729.0)) * h,
+                                  rs);
+  BinetState k6 = binetDerivative(y + (k1 * (9017.0 / 3168.0) - k2 * (355.0 / 33.0) + k3 * (46732.0 / 5247.0) +
+                                       k4 * (49.0 / 176.0) - k5 * (5103.0 / 18656.0)) * h,
+                                  rs);
+  BinetState next = y + (k1 * (35.0 / 384.0) + k3 * (500.0 / 1113.0) + k4 * (125.0 / 192.0) -
+                         k5 * (2187.0 / 6784.0) + k6 * (11.0 / 84.0)) * h;
+  kNext = binetDerivative(next, rs);
+  error = (k1 * (71.0 / 57600.0) - k3 * (71.0 / 16695.0) + k4 * (71.0 / 1920.0) - k5 * (17253.0 / 339200.0) +
+           k6 * (22.0 / 525.0) - kNext * (1.0 / 40.0)) * h;
+  return next;
+}
+
+// Cubic Hermite interpolation of (u, u') across a step (hermite_binet)
+BinetState hermiteBinet(const BinetState &y0, const BinetState &y1, double h, double s)
+{
+  double s2 = s * s;
+  double s3 = s2 * s;
+  double u = y0.u * (2.0 * s3 - 3.0 * s2 + 1.0) + y0.du * (h * (s3 - 2.0 * s2 + s)) +
+             y1.u * (3.0 * s2 - 2.0 * s3) + y1.du * (h * (s3 - s2));
+  double du = (y0.u - y1.u) * ((6.0 * s2 - 6.0 * s) / h) + y0.du * (3.0 * s2 - 4.0 * s + 1.0) +
+              y1.du * (3.0 * s2 - 2.0 * s);
+  return {u, du};
+}
+} // namespace
+
+Vector3 BlackHole::traceBinet(const Ray &ray, double time, int colorMode, double colorIntensity,
+                              double tolerance) const
+{
+  constexpr double pi = 3.14159265358979323846;
+  constexpr double initialStep = 0.05;
+  constexpr double maxStep = 0.5;
+  constexpr int maxSteps = 512;
+  constexpr double maxSweep = 8.0 * pi;
+  constexpr int maxCrossings = 3;
+
+  // Orbital plane: e1 towards the camera, e2 along the initial tangential motion
+  double r0 = ray.origin.length();
+  Vector3 e1 = ray.origin * (1.0 / r0);
+  double cosA = ray.direction.dot(e1);
+  Vector3 tangential = ray.direction - e1 * cosA;
+  double sinA = tangential.length();
+  if (sinA < 1e-4 || r0 <= rs)
+  {
+    // Radial rays are not bent and meet the disk plane only inside the horizon
+    if (r0 <= rs || cosA < 0.0)
+      return Vector3(0, 0, 0);
+    return sampleBackground(ray.direction, time);
+  }
+  Vector3 e2 = tangential * (1.0 / sinA);
+
+  // Vertical column density of the slab (shade_geodesic_record)
+  double slabColumn = 2.0 * (1.0 - std::exp(-0.2 * 10.0)) / 10.0;
+  Vector3 accumulatedColor(0, 0, 0);
+  double transmittance = 1.0;
+  int crossings = 0;
+
+  // Shade the slab where the orbit crosses the disk plane at angle phi
+  auto shadeCrossing = [&](double phi, const BinetState &y) {
+    double r = 1.0 / y.u;
+    Vector3 radial = e1 * std::cos(phi) + e2 * std::sin(phi);
+    Vector3 hit = radial * r;
+    hit.y = 0.0;
+    double hitR = hit.length();
+    if (hitR < rs * 2.5 || hitR > rs * 12.0)
+      return;
+    crossings++;
+
+    Vector3 tangent = e2 * std::cos(phi) - e1 * std::sin(phi);
+    Vector3 hitDir = (radial * (-y.du / (y.u * y.u)) + tangent * r).normalized();
+    double pattern = diskDensity(hit, time);
+    if (pattern <= 0.0)
+      return;
+
+    double pathScale = 1.0 / std::max(std::abs(hitDir.y), 0.05);
+    double slabTransmittance = std::exp(-pattern * 0.5 * slabColumn * pathScale);
+    Vector3 emission = diskColor(pattern, hitR, hit, hitDir, colorMode, colorIntensity);
+    accumulatedColor += emission * transmittance * (1.0 - slabTransmittance);
+    transmittance *= slabTransmittance;
+  };
+
+  // First angle where cos(phi) e1.y + sin(phi) e2.y = 0, then every pi
+  double phiCross = 2.0 * maxSweep;
+  if (std::abs(e1.y) + std::abs(e2.y) > 1e-6)
+  {
+    phiCross = std::atan2(-e1.y, e2.y);
+    while (phiCross <= 1e-4)
+      phiCross += pi;
+  }
+
+  BinetState y = {1.0 / r0, -cosA / (r0 * sinA)};
+  BinetState k1 = binetDerivative(y, rs);
+  double phi = 0.0;
+  double h = initialStep;
+
+  for (int i = 0; i < maxSteps && phi < maxSweep; i++)
+  {
+    h = std::min(h, maxStep);
+    BinetState kNext, error;
+    BinetState next = dopriStep(y, h, k1, rs, kNext, error);
+    double err = std::max(std::abs(error.u) / (tolerance * (1.0 / rs + std::abs(next.u))),
+                          std::abs(error.du) / (tolerance * (1.0 / rs + std::abs(next.du))));
+    if (err > 1.0)
+    {
+      h *= std::max(0.9 * std::pow(err, -0.2), 0.2);
+      continue;
+    }
+
+    // Disk crossings inside the step, each reached with its own sub-step
+    while (phiCross <= phi + h && crossings < maxCrossings && transmittance > 0.01)
+    {
+      BinetState kCross, errorCross;
+      BinetState c = dopriStep(y, phiCross - phi, k1, rs, kCross, errorCross);
+      if (c.u > 0.0 && c.u < 1.0 / rs)
+        shadeCrossing(phiCross, c);
+      phiCross += pi;
+    }
+
+    // Event Horizon
+    if (next.u >= 1.0 / rs)
+      return accumulatedColor; // Black (absorbed)
+
+    if (next.u <= 0.0)
+    {
+      // Escaped: radial direction where u reaches zero (sub-step to the
+      // Hermite estimate of the root, harmonic remainder)
+      double s = y.u / (y.u - next.u);
+      for (int j = 0; j < 3; j++)
+      {
+        BinetState c = hermiteBinet(y, next, h, s);
+        s = std::clamp(s - c.u / std::min(c.du * h, -1e-12), 0.0, 1.0);
+      }
+      BinetState kEnd, errorEnd;
+      BinetState end = dopriStep(y, h * s, k1, rs, kEnd, errorEnd);
+      double phiEscape = phi + h * s + std::atan2(end.u, -end.du);
+      Vector3 escapeDir = e1 * std::cos(phiEscape) + e2 * std::sin(phiEscape);
+      return accumulatedColor + sampleBackground(escapeDir, time) * transmittance;
+    }
+
+    y = next;
+    k1 = kNext;
+    phi += h;
+    h *= std::min(0.9 * std::pow(std::max(err, 1e-6), -0.2), 5.0);
+  }
 
+  // Still winding around the photon sphere
   return accumulatedColor;
 }
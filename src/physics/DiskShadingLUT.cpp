@@ -0,0 +1,112 @@
+#include "../../include/physics/DiskShadingLUT.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+// Second radiation constant hc / k in nm * K
+constexpr double PLANCK_C2 = 1.4387769e7;
+
+// Piecewise Gaussian lobe of the CIE matching function fit (Wyman, Sloan, Shirley 2013)
+double lobe(double lambda, double mu, double sigmaLow, double sigmaHigh)
+{
+  double t = (lambda - mu) / (lambda < mu ? sigmaLow : sigmaHigh);
+  return std::exp(-0.5 * t * t);
+}
+
+// Interpolate a table of 4-float samples at a fractional index
+void interpolate(const std::vector<float> &table, int samples, double x, float *out, int components)
+{
+  x = std::clamp(x, 0.0, static_cast<double>(samples - 1));
+  int i0 = std::min(static_cast<int>(x), samples - 2);
+  float f = static_cast<float>(x - i0);
+  for (int c = 0; c < components; c++)
+  {
+    out[c] = table[i0 * 4 + c] * (1.0f - f) + table[(i0 + 1) * 4 + c] * f;
+  }
+}
+} // namespace
+
+DiskShadingLUT::DiskShadingLUT(double mass, double innerRadius, double outerRadius)
+    : mass(mass), innerRadius(innerRadius), outerRadius(outerRadius) {}
+
+double DiskShadingLUT::radiusForSample(int i) const
+{
+  return innerRadius + (outerRadius - innerRadius) * i / (PROFILE_SAMPLES - 1);
+}
+
+double DiskShadingLUT::temperatureForSample(int i)
+{
+  double t = static_cast<double>(i) / (BLACKBODY_SAMPLES - 1);
+  return MIN_TEMPERATURE * std::pow(MAX_TEMPERATURE / MIN_TEMPERATURE, t);
+}
+
+void DiskShadingLUT::planckRGB(double kelvin, double rgb[3])
+{
+  double X = 0.0, Y = 0.0, Z = 0.0;
+  for (double lambda = 380.0; lambda <= 780.0; lambda += 5.0)
+  {
+    double radiance = 1.0 / (std::pow(lambda * 1e-3, 5.0) * (std::exp(PLANCK_C2 / (lambda * kelvin)) - 1.0));
+    X += radiance * (1.056 * lobe(lambda, 599.8, 37.9, 31.0) + 0.362 * lobe(lambda, 442.0, 16.0, 26.7) -
+                     0.065 * lobe(lambda, 501.1, 20.4, 26.2));
+    Y += radiance * (0.821 * lobe(lambda, 568.8, 46.9, 40.5) + 0.286 * lobe(lambda, 530.9, 16.3, 31.1));
+    Z += radiance * (1.217 * lobe(lambda, 437.0, 11.8, 36.0) + 0.681 * lobe(lambda, 459.0, 26.0, 13.8));
+  }
+
+  // XYZ -> linear sRGB; the reddest and bluest blackbodies fall slightly outside the gamut
+  rgb[0] = std::max(3.2406 * X - 1.5372 * Y - 0.4986 * Z, 0.0);
+  rgb[1] = std::max(-0.9689 * X + 1.8758 * Y + 0.0415 * Z, 0.0);
+  rgb[2] = std::max(0.0557 * X - 0.2040 * Y + 1.0570 * Z, 0.0);
+}
+
+void DiskShadingLUT::build()
+{
+  double rs = 2.0 * mass;
+
+  // Novikov-Thorne flux profile F ~ r^-3 (1 - sqrt(r_in / r)) peaks at r = 49/36 r_in
+  auto flux = [this](double r) {
+    return std::max(1.0 - std::sqrt(innerRadius / r), 0.0) / (r * r * r);
+  };
+  double peakRadius = std::clamp(innerRadius * 49.0 / 36.0, innerRadius, outerRadius);
+  double peakFlux = flux(peakRadius);
+
+  profileTable.assign(PROFILE_SAMPLES * 4, 0.0f);
+  for (int i = 0; i < PROFILE_SAMPLES; i++)
+  {
+    double r = radiusForSample(i);
+    double beta = std::min(std::sqrt(rs / (2.0 * r)), MAX_ORBITAL_BETA);
+    profileTable[i * 4 + 0] = static_cast<float>(std::pow(flux(r) / peakFlux, 0.25));
+    profileTable[i * 4 + 1] = static_cast<float>(std::sqrt(std::max(1.0 - rs / r, 0.0)));
+    profileTable[i * 4 + 2] = static_cast<float>(beta);
+    profileTable[i * 4 + 3] = static_cast<float>(1.0 / std::sqrt(1.0 - beta * beta));
+  }
+
+  // Luminance 1 at the peak temperature, so the disk's brightness matches the palettes
+  double reference[3];
+  planckRGB(PEAK_TEMPERATURE, reference);
+  double scale = 1.0 / (0.2126 * reference[0] + 0.7152 * reference[1] + 0.0722 * reference[2]);
+
+  blackbodyTable.assign(BLACKBODY_SAMPLES * 4, 1.0f);
+  for (int i = 0; i < BLACKBODY_SAMPLES; i++)
+  {
+    double rgb[3];
+    planckRGB(temperatureForSample(i), rgb);
+    for (int c = 0; c < 3; c++)
+    {
+      blackbodyTable[i * 4 + c] = static_cast<float>(rgb[c] * scale);
+    }
+  }
+}
+
+void DiskShadingLUT::profileAt(double r, float out[4]) const
+{
+  double x = (r - innerRadius) / (outerRadius - innerRadius) * (PROFILE_SAMPLES - 1);
+  interpolate(profileTable, PROFILE_SAMPLES, x, out, 4);
+}
+
+void DiskShadingLUT::blackbodyAt(double kelvin, float out[3]) const
+{
+  double x = std::log(std::max(kelvin, MIN_TEMPERATURE) / MIN_TEMPERATURE) /
+             std::log(MAX_TEMPERATURE / MIN_TEMPERATURE) * (BLACKBODY_SAMPLES - 1);
+  interpolate(blackbodyTable, BLACKBODY_SAMPLES, x, out, 3);
+}
@@ -0,0 +1,133 @@
+#include "../../include/physics/GeodesicLUT.hpp"
+#include <algorithm>
+#include <cmath>
+
+GeodesicLUT::GeodesicLUT(double mass) : mass(mass) {}
+
+double GeodesicLUT::criticalImpact() const
+{
+  return 3.0 * std::sqrt(3.0) * mass;
+}
+
+double GeodesicLUT::impactForRow(int row) const
+{
+  double bc = criticalImpact();
+  if (row < CAPTURED_ROWS)
+  {
+    // b in [0, bc): denser towards bc
+    double x = static_cast<double>(row) / (CAPTURED_ROWS - 1);
+    double bLo = bc * (1.0 - CRITICAL_EPSILON);
+    return bLo * (1.0 - (1.0 - x) * (1.0 - x));
+  }
+  // b in (bc, MAX_IMPACT]: denser towards bc
+  double x = static_cast<double>(row - CAPTURED_ROWS) / (IMPACT_SAMPLES - CAPTURED_ROWS - 1);
+  double bHi = bc * (1.0 + CRITICAL_EPSILON);
+  return bHi + (MAX_IMPACT - bHi) * x * x;
+}
+
+void GeodesicLUT::build()
+{
+  radiusTable.assign(IMPACT_SAMPLES * BRANCH_SAMPLES, 0.0f);
+  angleTable.assign(IMPACT_SAMPLES * BRANCH_SAMPLES, 0.0f);
+  branchTable.assign(IMPACT_SAMPLES * 2, 0.0f);
+
+  for (int row = 0; row < IMPACT_SAMPLES; row++)
+  {
+    buildRow(row);
+  }
+}
+
+void GeodesicLUT::buildRow(int row)
+{
+  double b = impactForRow(row);
+  double uHorizon = 1.0 / (2.0 * mass);
+  float *radiusRow = &radiusTable[row * BRANCH_SAMPLES];
+  float *angleRow = &angleTable[row * BRANCH_SAMPLES];
+
+  // Radial ray: falls straight in without sweeping any angle
+  if (b < 1e-6)
+  {
+    for (int i = 0; i < BRANCH_SAMPLES; i++)
+    {
+      radiusRow[i] = static_cast<float>(uHorizon * i / (BRANCH_SAMPLES - 1));
+      angleRow[i] = 0.0f;
+    }
+    branchTable[row * 2 + 0] = 0.0f;
+    branchTable[row * 2 + 1] = static_cast<float>(uHorizon);
+    return;
+  }
+
+  // Integrate u'' = -u + 3 M u^2 from infinity (u = 0, u' = 1/b) with RK4
+  auto accel = [this](double u) { return -u + 3.0 * mass * u * u; };
+  double h = 1e-3 * std::min(1.0, b);
+  std::vector<double> phis = {0.0};
+  std::vector<double> us = {0.0};
+  double phi = 0.0;
+  double u = 0.0;
+  double w = 1.0 / b;
+  const int maxSteps = 200000;
+
+  for (int step = 0; step < maxSteps; step++)
+  {
+    double k1u = w, k1w = accel(u);
+    double k2u = w + 0.5 * h * k1w, k2w = accel(u + 0.5 * h * k1u);
+    double k3u = w + 0.5 * h * k2w, k3w = accel(u + 0.5 * h * k2u);
+    double k4u = w + h * k3w, k4w = accel(u + h * k3u);
+    double uNext = u + h / 6.0 * (k1u + 2.0 * k2u + 2.0 * k3u + k4u);
+    double wNext = w + h / 6.0 * (k1w + 2.0 * k2w + 2.0 * k3w + k4w);
+
+    if (wNext <= 0.0)
+    {
+      // Periapsis inside this step (u' = 0)
+      double f = w / (w - wNext);
+      phis.push_back(phi + h * f);
+      us.push_back(u + (uNext - u) * f);
+      break;
+    }
+    if (uNext >= uHorizon)
+    {
+      // Captured: crossed the horizon inside this step
+      double f = (uHorizon - u) / (uNext - u);
+      phis.push_back(phi + h * f);
+      us.push_back(uHorizon);
+      break;
+    }
+
+    phi += h;
+    u = uNext;
+    w = wNext;
+    phis.push_back(phi);
+    us.push_back(u);
+  }
+
+  double phiEnd = phis.back();
+  double uEnd = us.back();
+  branchTable[row * 2 + 0] = static_cast<float>(phiEnd);
+  branchTable[row * 2 + 1] = static_cast<float>(uEnd);
+
+  // Resample u(phi) uniformly in phi / Phi
+  size_t j = 0;
+  for (int i = 0; i < BRANCH_SAMPLES; i++)
+  {
+    double target = phiEnd * i / (BRANCH_SAMPLES - 1);
+    while (j + 2 < phis.size() && phis[j + 1] < target)
+      j++;
+    double span = phis[j + 1] - phis[j];
+    double f = span > 0.0 ? std::clamp((target - phis[j]) / span, 0.0, 1.0) : 0.0;
+    radiusRow[i] = static_cast<float>(us[j] + (us[j + 1] - us[j]) * f);
+  }
+
+  // Resample phi(u); u increases monotonically along the inbound branch.
+  // The warp keeps phi(w) close to linear near periapsis where dphi/du diverges.
+  j = 0;
+  for (int i = 0; i < BRANCH_SAMPLES; i++)
+  {
+    double x = static_cast<double>(i) / (BRANCH_SAMPLES - 1);
+    double target = uEnd * (1.0 - (1.0 - x) * (1.0 - x));
+    while (j + 2 < us.size() && us[j + 1] < target)
+      j++;
+    double span = us[j + 1] - us[j];
+    double f = span > 0.0 ? std::clamp((target - us[j]) / span, 0.0, 1.0) : 0.0;
+    angleRow[i] = static_cast<float>(phis[j] + (phis[j + 1] - phis[j]) * f);
+  }
+}
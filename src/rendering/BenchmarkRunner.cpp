@@ -0,0 +1,305 @@
+#include "../../include/rendering/BenchmarkRunner.hpp"
+#include "../../include/rendering/OfflineRenderer.hpp"
+#include "../../include/utils/ResolutionManager.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+// External logging function
+extern void appLog(const std::string& message, bool isError = false);
+
+namespace {
+// Cinematic path timestep used to reach each pose (same as a 60 fps sequence)
+constexpr double POSE_STEP = 1.0 / 60.0;
+// Seconds along each cinematic path
+constexpr double POSE_TIMES[] = {0.0, 5.0, 10.0};
+
+double median(std::vector<double> values) {
+  if (values.empty()) return 0.0;
+  std::sort(values.begin(), values.end());
+  size_t mid = values.size() / 2;
+  return values.size() % 2 ? values[mid] : 0.5 * (values[mid - 1] + values[mid]);
+}
+
+// Value of the first "key": "..." string after `from`; npos if there is none
+size_t findString(const std::string &text, const std::string &key, size_t from, std::string &value) {
+  std::string pattern = "\"" + key + "\": \"";
+  size_t start = text.find(pattern, from);
+  if (start == std::string::npos) return std::string::npos;
+  start += pattern.size();
+  size_t end = text.find('"', start);
+  if (end == std::string::npos) return std::string::npos;
+  value = text.substr(start, end - start);
+  return end;
+}
+
+// Number of `key` between from and limit; false if it isn't there
+bool findNumber(const std::string &text, const std::string &key, size_t from, size_t limit, double &value) {
+  std::string pattern = "\"" + key + "\": ";
+  size_t start = text.find(pattern, from);
+  if (start == std::string::npos || start > limit) return false;
+  value = std::strtod(text.c_str() + start + pattern.size(), nullptr);
+  return true;
+}
+
+// Baseline key of a case: the same pose is only comparable at the same size
+std::string caseKey(const std::string &name, int width, int height) {
+  return name + " " + std::to_string(width) + "x" + std::to_string(height);
+}
+} // namespace
+
+BenchmarkRunner::BenchmarkRunner(const BenchmarkSettings &settings)
+    : settings(settings), renderer(nullptr) {}
+
+BenchmarkRunner::~BenchmarkRunner() {
+  if (renderer) {
+    metal_rt_renderer_destroy(renderer);
+  }
+}
+
+std::vector<BenchmarkRunner::Pose> BenchmarkRunner::poses() {
+  // The manual camera never moves without input: one pose
+  std::vector<Pose> result = {{CinematicMode::Manual, 0.0}};
+  for (int mode = static_cast<int>(CinematicMode::SmoothOrbit); mode <= static_cast<int>(CinematicMode::CloseFlyby);
+       mode++) {
+    for (double time : POSE_TIMES) {
+      result.push_back({static_cast<CinematicMode>(mode), time});
+    }
+  }
+  return result;
+}
+
+bool BenchmarkRunner::run() {
+  if (settings.frames <= 0 || settings.warmupFrames < 0) {
+    appLog("[BENCH] Invalid frame counts", true);
+    return false;
+  }
+  std::vector<int> presets = settings.presets;
+  if (presets.empty()) {
+    for (int i = 0; i < ResolutionManager::NUM_PRESETS; i++) {
+      presets.push_back(i);
+    }
+  }
+  for (int preset : presets) {
+    if (preset < 0 || preset >= ResolutionManager::NUM_PRESETS) {
+      appLog("[BENCH] Invalid resolution preset " + std::to_string(preset), true);
+      return false;
+    }
+  }
+
+  const Resolution &first = ResolutionManager::PRESETS[presets.front()];
+  renderer = metal_rt_renderer_create(first.width, first.height);
+  if (!renderer) {
+    appLog("[BENCH] Failed to create Metal renderer", true);
+    return false;
+  }
+  char name[256];
+  deviceName = metal_rt_renderer_get_device_name(-1, name, sizeof(name)) ? name : "unknown";
+  metal_rt_renderer_set_trace_mode(renderer, settings.traceMode);
+  // Every timed frame must trace every pixel: no cached crossings, no coarse
+  // tiles, and no progressive samples or post-only frames although every
+  // frame of a case repeats the same pose and time
+  metal_rt_renderer_set_geodesic_cache(renderer, false);
+  metal_rt_renderer_set_foveation(renderer, false);
+  metal_rt_renderer_set_repeat_detection(renderer, false);
+
+  std::vector<Pose> cases = poses();
+  {
+    std::ostringstream logMsg;
+    logMsg << "[BENCH] " << cases.size() << " poses x " << presets.size() << " resolutions, "
+           << settings.warmupFrames << " warmup + " << settings.frames << " timed frames each, trace mode "
+           << settings.traceMode << " on " << deviceName;
+    appLog(logMsg.str());
+  }
+
+  results.clear();
+  for (int preset : presets) {
+    const Resolution &resolution = ResolutionManager::PRESETS[preset];
+    metal_rt_renderer_resize(renderer, resolution.width, resolution.height);
+    for (const Pose &pose : cases) {
+      BenchmarkResult result;
+      if (!runCase(pose, resolution.width, resolution.height, resolution.name, result)) {
+        appLog("[BENCH] Failed to render " + result.name, true);
+        return false;
+      }
+      std::ostringstream logMsg;
+      logMsg << "[BENCH] " << result.name << ": " << std::fixed << std::setprecision(3) << result.gpuMs
+             << " ms GPU, " << result.readbackMs << " ms readback, " << std::setprecision(1)
+             << result.raysPerSecond / 1e6 << " Mrays/s, " << result.stepsPerSecond / 1e9 << " Gsteps/s";
+      appLog(logMsg.str());
+      results.push_back(result);
+    }
+  }
+
+  if (!writeJSON(settings.outputPath)) {
+    appLog("[BENCH] Failed to write " + settings.outputPath, true);
+    return false;
+  }
+  appLog("[BENCH] Wrote " + settings.outputPath);
+  return settings.baselinePath.empty() || compareBaseline();
+}
+
+bool BenchmarkRunner::runCase(const Pose &pose, int width, int height, const char *presetName,
+                              BenchmarkResult &result) {
+  std::ostringstream caseName;
+  caseName << presetName << "/" << getCinematicModeName(pose.mode) << "@" << std::fixed << std::setprecision(1)
+           << pose.time << "s";
+  result.name = caseName.str();
+  result.width = width;
+  result.height = height;
+
+  // Step the path from its start at a fixed timestep, like SequenceRenderer
+  Camera cam(Vector3(0, 3, -20), Vector3(0, 0, 0), 60.0);
+  CinematicCamera cinematic(cam, cam.position);
+  cinematic.setMode(pose.mode);
+  cinematic.update(0.0, nullptr);
+  long steps = std::lround(pose.time / POSE_STEP);
+  for (long i = 0; i < steps; i++) {
+    cinematic.update(POSE_STEP, nullptr);
+  }
+  CameraData camera;
+  OfflineRenderer::toCameraData(cam, camera);
+  float time = static_cast<float>(pose.time);
+
+  std::vector<double> gpuTimes, readbackTimes;
+  for (int frame = 0; frame < settings.warmupFrames + settings.frames; frame++) {
+    metal_rt_renderer_render(renderer, &camera, time, settings.colorMode, settings.colorIntensity);
+    // The GPU time is stored by the completion handler, which has run once the slot is free
+    metal_rt_renderer_wait_idle(renderer);
+    auto start = std::chrono::high_resolution_clock::now();
+    const void *pixels = metal_rt_renderer_get_pixels(renderer);
+    double readbackMs =
+        std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    if (!pixels) {
+      return false;
+    }
+    if (frame >= settings.warmupFrames) {
+      gpuTimes.push_back(metal_rt_renderer_get_gpu_time_ms(renderer));
+      readbackTimes.push_back(readbackMs);
+    }
+  }
+
+  result.gpuMs = median(gpuTimes);
+  result.gpuMsMin = *std::min_element(gpuTimes.begin(), gpuTimes.end());
+  result.gpuMsMax = *std::max_element(gpuTimes.begin(), gpuTimes.end());
+  result.readbackMs = median(readbackTimes);
+  double pixelCount = static_cast<double>(width) * height;
+  if (result.gpuMs > 0.0) {
+    result.raysPerSecond = pixelCount / (result.gpuMs / 1000.0);
+  }
+
+  // Step counts from one untimed diagnostics frame
+  metal_rt_renderer_set_diagnostics(renderer, true);
+  metal_rt_renderer_render(renderer, &camera, time, settings.colorMode, settings.colorIntensity);
+  metal_rt_renderer_wait_idle(renderer);
+  RayDiagnostics diagnostics;
+  if (metal_rt_renderer_get_diagnostics(renderer, &diagnostics)) {
+    result.meanSteps = diagnostics.meanSteps;
+    result.stepsPerSecond = result.raysPerSecond * diagnostics.meanSteps;
+  }
+  metal_rt_renderer_set_diagnostics(renderer, false);
+  return true;
+}
+
+bool BenchmarkRunner::writeJSON(const std::string &path) const {
+  std::ofstream file(path, std::ios::out | std::ios::trunc);
+  if (!file.is_open()) {
+    return false;
+  }
+  file << std::fixed << std::setprecision(3);
+  file << "{\n  \"device\": \"" << deviceName << "\",\n  \"trace_mode\": " << settings.traceMode
+       << ",\n  \"warmup_frames\": " << settings.warmupFrames << ",\n  \"frames\": " << settings.frames
+       << ",\n  \"cases\": [";
+  for (size_t i = 0; i < results.size(); i++) {
+    const BenchmarkResult &r = results[i];
+    file << (i ? ",\n" : "\n") << "    {\"name\": \"" << r.name << "\", \"width\": " << r.width
+         << ", \"height\": " << r.height << ", \"gpu_ms\": " << r.gpuMs << ", \"gpu_ms_min\": " << r.gpuMsMin
+         << ", \"gpu_ms_max\": " << r.gpuMsMax << ", \"readback_ms\": " << r.readbackMs
+         << ", \"rays_per_s\": " << r.raysPerSecond << ", \"mean_steps\": " << r.meanSteps
+         << ", \"steps_per_s\": " << r.stepsPerSecond << "}";
+  }
+  file << "\n  ]\n}\n";
+  return file.good();
+}
+
+bool BenchmarkRunner::readBaseline(const std::string &path, std::map<std::string, double> &gpuMs,
+                                   std::string &device, int &traceMode) {
+  std::ifstream file(path);
+  if (!file.is_open()) {
+    return false;
+  }
+  std::stringstream buffer;
+  buffer << file.rdbuf();
+  std::string text = buffer.str();
+
+  // Only needs to read what writeJSON writes: one case object per line
+  if (findString(text, "device", 0, device) == std::string::npos) {
+    device.clear();
+  }
+  double mode = -1.0;
+  findNumber(text, "trace_mode", 0, text.size(), mode);
+  traceMode = static_cast<int>(mode);
+  std::string name;
+  size_t pos = 0;
+  while ((pos = findString(text, "name", pos, name)) != std::string::npos) {
+    size_t lineEnd = text.find('\n', pos);
+    double width = 0.0, height = 0.0, ms = 0.0;
+    if (!findNumber(text, "width", pos, lineEnd, width) || !findNumber(text, "height", pos, lineEnd, height) ||
+        !findNumber(text, "gpu_ms", pos, lineEnd, ms)) {
+      continue;
+    }
+    gpuMs[caseKey(name, static_cast<int>(width), static_cast<int>(height))] = ms;
+  }
+  return true;
+}
+
+bool BenchmarkRunner::compareBaseline() const {
+  std::map<std::string, double> baseline;
+  std::string baselineDevice;
+  int baselineTraceMode = -1;
+  if (!readBaseline(settings.baselinePath, baseline, baselineDevice, baselineTraceMode)) {
+    appLog("[BENCH] Failed to read baseline " + settings.baselinePath, true);
+    return false;
+  }
+  // Trace modes run different kernels: their timings can't be compared
+  if (baselineTraceMode != settings.traceMode) {
+    appLog("[BENCH] Baseline " + settings.baselinePath + " was recorded in trace mode " +
+               std::to_string(baselineTraceMode) + ", this run uses " + std::to_string(settings.traceMode),
+           true);
+    return false;
+  }
+  if (baselineDevice != deviceName) {
+    appLog("[BENCH] Baseline was recorded on " + baselineDevice + ", comparing anyway", true);
+  }
+
+  int regressions = 0;
+  int compared = 0;
+  for (const BenchmarkResult &result : results) {
+    auto it = baseline.find(caseKey(result.name, result.width, result.height));
+    if (it == baseline.end() || it->second <= 0.0) {
+      appLog("[BENCH] " + result.name + ": not in baseline");
+      continue;
+    }
+    compared++;
+    double change = (result.gpuMs - it->second) / it->second * 100.0;
+    bool regressed = change > settings.threshold;
+    regressions += regressed ? 1 : 0;
+    std::ostringstream logMsg;
+    logMsg << "[BENCH] " << result.name << ": " << std::fixed << std::setprecision(3) << it->second << " -> "
+           << result.gpuMs << " ms (" << std::showpos << std::setprecision(1) << change << std::noshowpos << "%)"
+           << (regressed ? " REGRESSION" : "");
+    appLog(logMsg.str(), regressed);
+  }
+
+  std::ostringstream logMsg;
+  logMsg << "[BENCH] " << regressions << " of " << compared << " cases slower than the baseline by more than "
+         << std::fixed << std::setprecision(1) << settings.threshold << "%";
+  appLog(logMsg.str(), regressions > 0);
+  return regressions == 0;
+}
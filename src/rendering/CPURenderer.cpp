@@ -0,0 +1,115 @@
+#include "../../include/rendering/CPURenderer.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace {
+constexpr double PI = 3.14159265359;
+
+// display_color in ToneMapping.h: ACES filmic fit, sRGB encoding (the GPU
+// post chain's bloom is not mirrored)
+uint8_t finalizeChannel(float value) {
+  double x = std::max(static_cast<double>(value), 0.0) * 0.6;
+  double c = std::clamp((x * (2.51 * x + 0.03)) / (x * (2.43 * x + 0.59) + 0.14), 0.0, 1.0);
+  c = c <= 0.0031308 ? c * 12.92 : 1.055 * std::pow(c, 1.0 / 2.4) - 0.055;
+  return static_cast<uint8_t>(c * 255.0 + 0.5);
+}
+} // namespace
+
+CPURenderer::CPURenderer(int width, int height, unsigned threadCount)
+    : blackHole(1.0), pool(threadCount), width(0), height(0), lastFrameMs(0.0),
+      traceMode(METAL_RT_TRACE_VOLUMETRIC), integratorTolerance(BlackHole::DEFAULT_INTEGRATOR_TOLERANCE),
+      exposure(1.0f) {
+  resize(width, height);
+}
+
+void CPURenderer::resize(int newWidth, int newHeight) {
+  width = std::max(newWidth, 1);
+  height = std::max(newHeight, 1);
+  pixels.assign(static_cast<size_t>(width) * height * 4, 0);
+}
+
+bool CPURenderer::setTraceMode(int mode) {
+  if (mode != METAL_RT_TRACE_VOLUMETRIC && mode != METAL_RT_TRACE_ADAPTIVE_BINET) {
+    return false;
+  }
+  traceMode = mode;
+  return true;
+}
+
+void CPURenderer::setIntegratorTolerance(float tolerance) {
+  if (std::isfinite(tolerance)) {
+    integratorTolerance = std::clamp(static_cast<double>(tolerance), 1e-7, 1e-3);
+  }
+}
+
+void CPURenderer::setExposure(float value) {
+  if (std::isfinite(value)) {
+    exposure = std::clamp(value, 1.0f / 64.0f, 64.0f);
+  }
+}
+
+void CPURenderer::render(const CameraData &camera, float time, int colorMode, float colorIntensity) {
+  auto start = std::chrono::high_resolution_clock::now();
+  pool.parallelFor(height, [&](int y) { renderRow(y, camera, time, colorMode, colorIntensity); });
+  lastFrameMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void CPURenderer::renderRow(int y, const CameraData &camera, float time, int colorMode, float colorIntensity) {
+  constexpr int N = BlackHole::PACKET_SIZE;
+
+  // camera_ray_direction in RayTracing.metal (pixel centers)
+  float aspectRatio = static_cast<float>(width) / static_cast<float>(height);
+  float scale = std::tan(static_cast<float>(camera.fov * PI / 180.0) * 0.5f);
+  float py = (1.0f - 2.0f * (y + 0.5f) / static_cast<float>(height)) * scale;
+
+  BlackHole::RayPacket packet;
+  uint8_t *row = &pixels[static_cast<size_t>(y) * width * 4];
+
+  for (int x0 = 0; x0 < width; x0 += N) {
+    for (int lane = 0; lane < N; lane++) {
+      // The last packet of a row repeats its final pixel in the unused lanes
+      int x = std::min(x0 + lane, width - 1);
+      float px = (2.0f * (x + 0.5f) / static_cast<float>(width) - 1.0f) * aspectRatio * scale;
+      float dx = camera.forward[0] + camera.right[0] * px + camera.up[0] * py;
+      float dy = camera.forward[1] + camera.right[1] * px + camera.up[1] * py;
+      float dz = camera.forward[2] + camera.right[2] * px + camera.up[2] * py;
+      float invLength = 1.0f / std::sqrt(dx * dx + dy * dy + dz * dz);
+      packet.originX[lane] = camera.position[0];
+      packet.originY[lane] = camera.position[1];
+      packet.originZ[lane] = camera.position[2];
+      packet.dirX[lane] = dx * invLength;
+      packet.dirY[lane] = dy * invLength;
+      packet.dirZ[lane] = dz * invLength;
+    }
+
+    int lanes = std::min(N, width - x0);
+    if (traceMode == METAL_RT_TRACE_ADAPTIVE_BINET) {
+      // Step counts differ too much between rays to share a packet
+      for (int lane = 0; lane < lanes; lane++) {
+        Ray ray(Vector3(packet.originX[lane], packet.originY[lane], packet.originZ[lane]),
+                Vector3(packet.dirX[lane], packet.dirY[lane], packet.dirZ[lane]));
+        Vector3 color = blackHole.traceBinet(ray, time, colorMode, colorIntensity, integratorTolerance);
+        packet.red[lane] = static_cast<float>(color.x);
+        packet.green[lane] = static_cast<float>(color.y);
+        packet.blue[lane] = static_cast<float>(color.z);
+      }
+    } else {
+      blackHole.tracePacket(packet, time, colorMode, colorIntensity);
+    }
+
+    for (int lane = 0; lane < lanes; lane++) {
+      float r = packet.red[lane] * exposure, g = packet.green[lane] * exposure, b = packet.blue[lane] * exposure;
+      if (!std::isfinite(r) || !std::isfinite(g) || !std::isfinite(b)) {
+        r = 0.0f; // Green for NaN/Inf, like the shader
+        g = 1.0f;
+        b = 0.0f;
+      }
+      uint8_t *pixel = row + static_cast<size_t>(x0 + lane) * 4;
+      pixel[0] = finalizeChannel(b);
+      pixel[1] = finalizeChannel(g);
+      pixel[2] = finalizeChannel(r);
+      pixel[3] = 255;
+    }
+  }
+}
@@ -1,19 +1,249 @@
 #include "../../include/rendering/MetalRTRenderer.h"
+#include "../../include/physics/GeodesicLUT.hpp"
+#include "../../include/physics/DiskShadingLUT.hpp"
 #import <Foundation/Foundation.h>
 #import <Metal/Metal.h>
 #import <MetalKit/MetalKit.h>
+#import <QuartzCore/CAMetalLayer.h>
+#import <CoreVideo/CoreVideo.h>
+#import <ImageIO/ImageIO.h>
 #include <vector>
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <algorithm>
+#include <cstdio>
+#include <cmath>
+
+// Frame ring: each slot owns its own output texture so the CPU can encode
+// frame N+1 while the GPU is still tracing frame N; uniforms are copied into
+// each command buffer with setBytes and need no per-slot storage. One slot is
+// always reserved for the frame being displayed/read back, the rest may be in flight.
+static constexpr int kFrameSlots = 3;
+static constexpr int kMaxFramesInFlight = kFrameSlots - 1;
+
+// Foveated tracing tile size (must match FOVEA_TILE in RayTracing.metal)
+static constexpr int kFoveaTile = 4;
+
+// Pipeline specialization: palettes baked into variants and the function
+// constant indices (must match SPECIALIZED_* in RayTracing.metal)
+static constexpr int kColorModes = 5;
+static constexpr NSUInteger kColorModeConstant = 0;
+static constexpr NSUInteger kTraceModeConstant = 1;
+static constexpr NSUInteger kKerrConstant = 2;
+
+// Largest |a / M| of the Kerr trace (Thorne's limit for an accreting hole)
+static constexpr float kMaxSpin = 0.998f;
+// Longest set_spin waits for startup variant compiles (it runs on the UI thread)
+static constexpr int64_t kSpinVariantWaitMs = 50;
+
+// Diagnostics counters: step histogram followed by one count per termination
+// cause (must match DIAGNOSTIC_STEP_BINS in RayTracing.metal)
+static constexpr int kDiagnosticStepBins = 4096;
+static constexpr int kDiagnosticCounters = kDiagnosticStepBins + METAL_RT_TERMINATION_COUNT;
+
+// Progressive refinement: samples per pixel after which a still frame is only
+// re-resolved (must match ACCUMULATION_MAX_SAMPLES in RayTracing.metal)
+static constexpr int kMaxAccumulationSamples = 1024;
+
+// Post chain: bloom pyramid levels below the half-size one, where bloom
+// starts (exposed radiance) and its default strength
+static constexpr int kBloomLevels = 6;
+static constexpr float kBloomThreshold = 1.0f;
+static constexpr float kDefaultBloomStrength = 0.2f;
+
+// Sky cubemap face sizes: the procedural starfield, and the cap for loaded skyboxes
+static constexpr int kSkyFaceSize = 1024;
+static constexpr int kSkyMaxFaceSize = 2048;
+
+// Staging buffers shared by screenshots being encoded and recording readbacks in flight
+static constexpr int kCaptureSlots = 4;
+
+struct FrameSlot {
+  id<MTLTexture> outputTexture;  // BGRA8, written by the post chain
+  id<MTLCommandBuffer> commandBuffer;  // Last submission that wrote this slot
+  long frameIndex;  // -1 until the slot has been rendered once
+  bool inFlight;
+  int viewportWidth;  // Sub-rect of outputTexture written by this frame
+  int viewportHeight;
+  bool diagnostics;  // This frame was traced in the diagnostics view
+  id<MTLTexture> diagnosticsTexture;  // RGBA32Float: steps, termination, transmittance (allocated on first use)
+  id<MTLBuffer> diagnosticsCounters;  // kDiagnosticCounters uint32, cleared every diagnostics frame
+};
+
+// Staging buffers of one asynchronous capture, reused across captures
+struct CaptureSlot {
+  id<MTLBuffer> pixels;     // BGRA8 copy of the output texture
+  id<MTLBuffer> hdrPixels;  // RGBA32Float copy of the HDR target (allocated on first HDR capture)
+  id<MTLCommandBuffer> copyCommandBuffer;
+  long captureId;
+  bool inUse;  // Held until metal_rt_renderer_release_capture
+  bool hdr;
+  int width;
+  int height;
+};
+
+// Everything a frame's image depends on (progressive refinement resets when any of it changes)
+struct AccumulationKey {
+  CameraData camera;
+  float time;
+  int colorMode;
+  float colorIntensity;
+  int traceMode;
+  float integratorTolerance;
+  float spin;
+  int viewportWidth;
+  int viewportHeight;
+  bool diagnostics;
+  bool foveated;
+};
 
 struct MetalRTRenderer {
   id<MTLDevice> device;
   id<MTLCommandQueue> commandQueue;
+  id<MTLLibrary> library;
   id<MTLComputePipelineState> pipelineState;
-  id<MTLBuffer> uniformBuffer;
-  id<MTLTexture> outputTexture;
-  std::vector<uint8_t> pixelData;  // Main render loop buffer
+
+  // Specialized ray_generation (palette x trace mode) and shade_cached (palette)
+  // variants without runtime mode branches. Compiled in the background at
+  // startup; until a variant is ready the generic pipeline is used
+  id<MTLComputePipelineState> traceVariants[kColorModes][METAL_RT_TRACE_MODE_COUNT];
+  id<MTLComputePipelineState> shadeVariants[kColorModes];
+  id<MTLComputePipelineState> kerrVariants[kColorModes];  // ray_generation with the Kerr integrator (spin != 0)
+  std::mutex variantMutex;  // Variants (and archiveMisses) are stored from Metal's compiler threads
+  dispatch_group_t variantGroup;  // Outstanding variant compilations
+  int pendingVariants;
+  NSMutableArray<MTLComputePipelineDescriptor *> *archiveMisses;  // Compiled, not yet in the archive
+  id<MTLBinaryArchive> pipelineArchive;  // Compiled pipelines kept across launches (nil if unsupported)
+  NSURL *pipelineArchiveURL;
+  bool pipelineArchiveLoaded;  // Read from disk: pipelines are looked up before compiling
+  std::chrono::high_resolution_clock::time_point variantStart;
+
+  FrameSlot slots[kFrameSlots];
+  dispatch_semaphore_t inFlightSemaphore;  // Counts free in-flight slots, signalled on completion
+  std::mutex slotMutex;  // Guards inFlight/frameIndex (completion handlers run on a Metal thread)
+  long nextFrameIndex;
+  int displayedSlot;  // Slot latched by acquire_completed, -1 if none
+
+  id<MTLTexture> outputTexture;  // Texture of displayedSlot (what present/get_pixels use)
+  std::vector<uint8_t> pixelData;  // Main render loop buffer (filled lazily on readback)
   std::vector<uint8_t> screenshotBuffer;  // Separate buffer for screenshots
-  int width;
+  bool pixelsDirty;  // outputTexture holds a frame that has not been read back yet
+  int width;   // Texture size (maximum render size)
   int height;
+  int viewportWidth;   // Sub-rect traced by new frames (dynamic quality)
+  int viewportHeight;
+  int displayedWidth;  // Sub-rect holding the displayed frame
+  int displayedHeight;
+  double lastGPUTimeMs;  // GPU time of the most recently completed frame
+  int traceMode;  // Applied to every frame submitted after it is set
+  float integratorTolerance;  // METAL_RT_TRACE_ADAPTIVE_BINET step error bound
+  float spin;  // Kerr a / M; nonzero frames use kerrVariants
+
+  // Precomputed Schwarzschild orbits for METAL_RT_TRACE_GEODESIC_LUT (R32Float / RG32Float)
+  id<MTLTexture> lutRadius;
+  id<MTLTexture> lutAngle;
+  id<MTLTexture> lutBranch;
+  std::unique_ptr<GeodesicLUT> pendingLUT;  // Built in the background, uploaded on first use
+  dispatch_group_t lutGroup;
+
+  // Blackbody disk tables (1D RGBA32Float, see DiskShadingLUT.hpp)
+  id<MTLTexture> diskProfile;
+  id<MTLTexture> blackbody;
+
+  // Mipmapped RGBA16Float sky cubemap (procedural starfield or a loaded skybox)
+  id<MTLTexture> sky;
+
+  // Geodesic cache (crossing-based trace modes): ray_generation records each
+  // pixel's disk crossings, shade_cached re-shades them while the camera is still
+  id<MTLComputePipelineState> shadePipelineState;
+  id<MTLBuffer> geodesicCache;  // Allocated on first use at the render size
+  id<MTLBuffer> placeholderCache;  // Bound while the cache is unused
+  bool geodesicCacheEnabled;
+  bool geodesicCacheValid;
+  CameraData cacheCamera;  // Camera the cache was traced with
+  int cacheTraceMode;
+  float cacheSpin;
+  int cacheWidth;  // Viewport the cache was traced at
+  int cacheHeight;
+
+  // Progressive refinement: while a frame's inputs repeat the previous frame's,
+  // ray_generation adds one jittered sample per pixel and displays the mean
+  bool accumulationEnabled;
+  bool repeatDetection;  // Off: every frame is a fresh full trace (benchmarks)
+  id<MTLBuffer> accumulation;  // float4 per pixel (linear radiance sum, sample count), allocated on first use
+  AccumulationKey accumulationKey;  // Inputs of the previous frame (zeroed padding, compared with memcmp)
+  bool accumulationKeyValid;
+  int accumulationSamples;  // Index of the last sample added (kMaxAccumulationSamples = converged), -1 = none
+
+  // Post chain (PostProcess.metal): live frames are traced into radiance and
+  // turned into the slot's BGRA8 output by exposure, bloom and tone mapping passes
+  id<MTLComputePipelineState> compositePipelineState;
+  id<MTLComputePipelineState> bloomPrefilterPipelineState;  // nil: bloom unavailable
+  id<MTLComputePipelineState> bloomDownsamplePipelineState;
+  id<MTLComputePipelineState> bloomUpsamplePipelineState;
+  id<MTLTexture> radiance;  // RGBA16Float linear radiance of the latest traced frame
+  id<MTLTexture> bloomDown[kBloomLevels];  // Half size and below (down chain)
+  id<MTLTexture> bloomUp[kBloomLevels - 1];  // Blurred sums of the levels below (up chain)
+  bool radianceValid;  // radiance holds the frame of accumulationKey: repeats only re-run the post chain
+  float exposure;  // Linear multiplier before tone mapping
+  float bloomStrength;
+
+  // Diagnostics view (step heatmap + per-pixel trace statistics)
+  bool diagnosticsEnabled;
+  id<MTLTexture> placeholderDiagnostics;  // Bound while the view is off
+  RayDiagnostics latestDiagnostics;  // Written by completion handlers under slotMutex
+  bool diagnosticsValid;
+
+  // Asynchronous screenshots: frames are copied into pooled staging buffers on the GPU
+  CaptureSlot captures[kCaptureSlots];
+  std::mutex captureMutex;  // Captures are finished and released from encoder threads
+  long nextCaptureId;
+  id<MTLTexture> hdrTexture;  // RGBA32Float linear color of HDR capture frames (allocated on first use)
+
+  // Foveated tracing: coarse pass + tile classification + selective full-res pass
+  id<MTLComputePipelineState> coarsePipelineState;
+  id<MTLComputePipelineState> classifyPipelineState;
+  id<MTLComputePipelineState> foveatedPipelineState;
+  id<MTLTexture> coarseRays;  // RGBA32Float per tile: escape direction + fate
+  id<MTLTexture> tileFlags;   // R8Uint per tile: 1 = trace at full resolution
+  bool foveationEnabled;
+
+  // Per-frame and per-screenshot logging (off by default, see set_verbose)
+  bool verbose;
+  int loggedColorMode;
+
+  // Offline tiled rendering: jittered passes accumulate into a float buffer,
+  // resolved into a BGRA8 tile that is read back per tile
+  id<MTLComputePipelineState> tilePipelineState;
+  id<MTLComputePipelineState> resolvePipelineState;
+  id<MTLBuffer> tileAccumulation;  // float4 per tile pixel (linear radiance sum, sample count)
+  id<MTLTexture> tileOutput;
+  int tileCapacityWidth;
+  int tileCapacityHeight;
+
+  // Hardware video encoding: outputTexture -> NV12 CVPixelBuffer planes (created on first use)
+  id<MTLComputePipelineState> nv12PipelineState;
+  CVMetalTextureCacheRef textureCache;
+  id<MTLCommandQueue> conversionQueue;  // Separate from commandQueue so frames in flight don't delay it
+
+  // Software recording: displayed frame -> recording size BGRA8 staging buffer (created on first use)
+  id<MTLComputePipelineState> resamplePipelineState;
+
+  // Zero-copy presentation (draws outputTexture straight into a CAMetalLayer drawable)
+  id<MTLRenderPipelineState> presentPipeline;
+  MTLPixelFormat presentPixelFormat;
+  id<MTLSamplerState> presentSampler;
+};
+
+// Post pass parameters (must match PostParams in PostProcess.metal)
+struct PostParams {
+  uint32_t sourceSize[2];
+  uint32_t targetSize[2];
+  float exposure;
+  float bloomStrength;
+  float bloomThreshold;
+  uint32_t raw;
 };
 
 // Uniforms structure matching Metal shader
@@ -30,21 +260,636 @@ struct Uniforms {
   } camera;
   uint32_t resolution[2];
   float time;
-  int colorMode; // 0=blue, 1=orange, 2=red, 3=white
+  int colorMode; // 0=blue, 1=orange, 2=red, 3=white, 4=blackbody
   float colorIntensity; // Brightness multiplier for accretion disk
+  int traceMode; // 0=volumetric, 1=disk-plane crossing, 2=geodesic LUT, 3=adaptive Binet
+  int writeCache; // Store crossing-based traces in the geodesic cache
+  float integratorTolerance; // Adaptive Binet: local error bound per step (relative to 1/RS)
+  int diagnostics; // Output the step count heatmap and record per-pixel trace statistics
+  int captureHDR; // Also store the linear color before tone mapping (HDR screenshots)
+  float spin; // Kerr a / M; 0 = Schwarzschild
+  int accumulationIndex; // Progressive refinement: sample added to the accumulation buffer (0 restarts), -1 = off
+};
+
+// Geodesic cache entry matching RayTracing.metal (3 x half4, packed_float3, 2 x ushort)
+struct GeodesicCacheEntry {
+  uint16_t crossings[3][4];
+  float escapeDir[3];
+  uint16_t crossingCount;
+  uint16_t absorbed;
 };
+static_assert(sizeof(GeodesicCacheEntry) == 40, "GeodesicCacheEntry must match the Metal layout");
+
+// Offline tile description (must match TileParams in RayTracing.metal)
+struct TileParams {
+  uint32_t origin[2];
+  uint32_t size[2];
+  uint32_t sampleIndex;
+  float exposure;
+};
+
+// Create the kernel output texture. BGRA8 matches SDL_PIXELFORMAT_ARGB8888 on
+// little-endian and the default CAMetalLayer format, so neither the readback
+// path nor the presentation path needs a CPU swizzle.
+static id<MTLTexture> createOutputTexture(id<MTLDevice> device, int width, int height) {
+  MTLTextureDescriptor *textureDesc = [MTLTextureDescriptor
+      texture2DDescriptorWithPixelFormat:MTLPixelFormatBGRA8Unorm
+                                   width:width
+                                  height:height
+                               mipmapped:NO];
+  textureDesc.usage = MTLTextureUsageShaderWrite | MTLTextureUsageShaderRead;
+  textureDesc.storageMode = MTLStorageModeShared;
+  return [device newTextureWithDescriptor:textureDesc];
+}
+
+// Half-float radiance target and bloom pyramid at the renderer size (shared by
+// all slots: frames execute in order on the one queue)
+static id<MTLTexture> createPostTexture(id<MTLDevice> device, int width, int height) {
+  MTLTextureDescriptor *desc = [MTLTextureDescriptor texture2DDescriptorWithPixelFormat:MTLPixelFormatRGBA16Float
+                                                                                   width:std::max(width, 1)
+                                                                                  height:std::max(height, 1)
+                                                                               mipmapped:NO];
+  desc.usage = MTLTextureUsageShaderWrite | MTLTextureUsageShaderRead;
+  desc.storageMode = MTLStorageModePrivate;
+  return [device newTextureWithDescriptor:desc];
+}
+
+static bool createPostTargets(MetalRTRenderer *renderer) {
+  renderer->radiance = createPostTexture(renderer->device, renderer->width, renderer->height);
+  renderer->radianceValid = false;
+  int levelWidth = renderer->width;
+  int levelHeight = renderer->height;
+  for (int i = 0; i < kBloomLevels; i++) {
+    levelWidth = std::max(levelWidth / 2, 1);
+    levelHeight = std::max(levelHeight / 2, 1);
+    renderer->bloomDown[i] = createPostTexture(renderer->device, levelWidth, levelHeight);
+    if (i < kBloomLevels - 1) {
+      renderer->bloomUp[i] = createPostTexture(renderer->device, levelWidth, levelHeight);
+    }
+  }
+  return renderer->radiance != nil;
+}
+
+// (Re)create every slot's output texture at the current size
+static bool createSlotTextures(MetalRTRenderer *renderer) {
+  if (!createPostTargets(renderer)) {
+    return false;
+  }
+  for (int i = 0; i < kFrameSlots; i++) {
+    FrameSlot &slot = renderer->slots[i];
+    slot.outputTexture = createOutputTexture(renderer->device, renderer->width, renderer->height);
+    slot.commandBuffer = nil;
+    slot.frameIndex = -1;
+    slot.inFlight = false;
+    slot.viewportWidth = renderer->width;
+    slot.viewportHeight = renderer->height;
+    slot.diagnostics = false;
+    slot.diagnosticsTexture = nil;  // Reallocated at the new size on next use
+    if (!slot.outputTexture) {
+      return false;
+    }
+  }
+  renderer->displayedSlot = -1;
+  renderer->outputTexture = nil;
+  renderer->pixelsDirty = false;
+  renderer->viewportWidth = renderer->width;
+  renderer->viewportHeight = renderer->height;
+  renderer->displayedWidth = renderer->width;
+  renderer->displayedHeight = renderer->height;
+  return true;
+}
+
+static MTLSize threadgroupsFor(int width, int height, MTLSize threadgroupSize) {
+  return MTLSizeMake((width + threadgroupSize.width - 1) / threadgroupSize.width,
+                     (height + threadgroupSize.height - 1) / threadgroupSize.height, 1);
+}
+
+// Upload a float table as a read-only texture
+static id<MTLTexture> createTableTexture(id<MTLDevice> device, MTLPixelFormat format,
+                                         int width, int height, const float *data, size_t bytesPerRow) {
+  MTLTextureDescriptor *desc = [MTLTextureDescriptor texture2DDescriptorWithPixelFormat:format
+                                                                                   width:width
+                                                                                  height:height
+                                                                               mipmapped:NO];
+  desc.usage = MTLTextureUsageShaderRead;
+  desc.storageMode = MTLStorageModeShared;
+  id<MTLTexture> texture = [device newTextureWithDescriptor:desc];
+  [texture replaceRegion:MTLRegionMake2D(0, 0, width, height)
+             mipmapLevel:0
+               withBytes:data
+             bytesPerRow:bytesPerRow];
+  return texture;
+}
+
+// Upload a 1D RGBA float table (linearly filtered by the shader)
+static id<MTLTexture> createTable1DTexture(id<MTLDevice> device, int width, const float *data) {
+  MTLTextureDescriptor *desc = [[MTLTextureDescriptor alloc] init];
+  desc.textureType = MTLTextureType1D;
+  desc.pixelFormat = MTLPixelFormatRGBA32Float;
+  desc.width = width;
+  desc.usage = MTLTextureUsageShaderRead;
+  desc.storageMode = MTLStorageModeShared;
+  id<MTLTexture> texture = [device newTextureWithDescriptor:desc];
+  [texture replaceRegion:MTLRegionMake1D(0, width)
+             mipmapLevel:0
+               withBytes:data
+             bytesPerRow:width * 4 * sizeof(float)];
+  return texture;
+}
+
+// Disk shading tables are tiny, so they are built synchronously: every
+// shading kernel samples them, whatever the colour mode
+static bool createDiskShadingLUT(MetalRTRenderer *renderer) {
+  DiskShadingLUT lut(1.0, 5.0, 24.0);  // Shader units: M = 1, DISK_INNER / DISK_OUTER
+  lut.build();
+  renderer->diskProfile = createTable1DTexture(renderer->device, DiskShadingLUT::PROFILE_SAMPLES,
+                                               lut.profileTable.data());
+  renderer->blackbody = createTable1DTexture(renderer->device, DiskShadingLUT::BLACKBODY_SAMPLES,
+                                             lut.blackbodyTable.data());
+  return renderer->diskProfile && renderer->blackbody;
+}
+
+// Resample a sky source into a new mipmapped float cubemap with one of the
+// Skybox.metal kernels (source may be nil for the procedural starfield).
+// Blocks until done: only runs at startup or when a skybox is loaded
+static id<MTLTexture> bakeSky(MetalRTRenderer *renderer, NSString *kernelName, id<MTLTexture> source,
+                              int faceSize) {
+  id<MTLFunction> function = [renderer->library newFunctionWithName:kernelName];
+  NSError *error = nil;
+  id<MTLComputePipelineState> pipeline =
+      function ? [renderer->device newComputePipelineStateWithFunction:function error:&error] : nil;
+  if (!pipeline) {
+    NSLog(@"Failed to create %@ pipeline: %@", kernelName, error);
+    return nil;
+  }
+
+  MTLTextureDescriptor *desc = [MTLTextureDescriptor textureCubeDescriptorWithPixelFormat:MTLPixelFormatRGBA16Float
+                                                                                      size:faceSize
+                                                                                 mipmapped:YES];
+  desc.usage = MTLTextureUsageShaderRead | MTLTextureUsageShaderWrite;
+  desc.storageMode = MTLStorageModePrivate;
+  id<MTLTexture> sky = [renderer->device newTextureWithDescriptor:desc];
+  if (!sky) return nil;
+
+  id<MTLCommandBuffer> commandBuffer = [renderer->commandQueue commandBuffer];
+  if (source && source.textureType == MTLTextureType2D && source.mipmapLevelCount > 1) {
+    // Decoded equirect images only have mip 0; large ones are read from a
+    // matching mip so the bake doesn't alias (cubemap files bring their own)
+    id<MTLBlitCommandEncoder> sourceMips = [commandBuffer blitCommandEncoder];
+    [sourceMips generateMipmapsForTexture:source];
+    [sourceMips endEncoding];
+  }
+  id<MTLComputeCommandEncoder> encoder = [commandBuffer computeCommandEncoder];
+  [encoder setComputePipelineState:pipeline];
+  if (source) {
+    int sourceFace = source.textureType == MTLTextureTypeCube ? static_cast<int>(source.width)
+                                                              : static_cast<int>(source.width) / 4;
+    float sourceLod = std::max(std::log2(static_cast<float>(sourceFace) / faceSize), 0.0f);
+    [encoder setTexture:source atIndex:0];
+    [encoder setTexture:sky atIndex:1];
+    [encoder setBytes:&sourceLod length:sizeof(sourceLod) atIndex:0];
+  } else {
+    [encoder setTexture:sky atIndex:0];
+  }
+  MTLSize threadgroupSize = MTLSizeMake(8, 8, 1);
+  MTLSize threadgroups = threadgroupsFor(faceSize, faceSize, threadgroupSize);
+  threadgroups.depth = 6;
+  [encoder dispatchThreadgroups:threadgroups threadsPerThreadgroup:threadgroupSize];
+  [encoder endEncoding];
+  id<MTLBlitCommandEncoder> mips = [commandBuffer blitCommandEncoder];
+  [mips generateMipmapsForTexture:sky];
+  [mips endEncoding];
+  [commandBuffer commit];
+  [commandBuffer waitUntilCompleted];
+  if (commandBuffer.status != MTLCommandBufferStatusCompleted) {
+    NSLog(@"Sky bake failed: %@", commandBuffer.error);
+    return nil;
+  }
+  return sky;
+}
+
+// Decode an equirectangular image (anything ImageIO reads, Radiance .hdr and
+// OpenEXR included) into a mipmapped linear RGBA32Float texture, keeping HDR values
+static id<MTLTexture> loadEquirectTexture(id<MTLDevice> device, NSURL *url) {
+  CGImageSourceRef imageSource = CGImageSourceCreateWithURL((__bridge CFURLRef)url, nullptr);
+  if (!imageSource) return nil;
+  NSDictionary *options = @{(__bridge NSString *)kCGImageSourceShouldAllowFloat: @YES};
+  CGImageRef image = CGImageSourceCreateImageAtIndex(imageSource, 0, (__bridge CFDictionaryRef)options);
+  CFRelease(imageSource);
+  if (!image) return nil;
+
+  // Wider than the largest face needs is downscaled while decoding
+  size_t width = std::min<size_t>(CGImageGetWidth(image), 4 * kSkyMaxFaceSize);
+  size_t height = std::max<size_t>(CGImageGetHeight(image) * width / CGImageGetWidth(image), 1);
+  std::vector<float> pixels(width * height * 4);
+  CGColorSpaceRef linear = CGColorSpaceCreateWithName(kCGColorSpaceExtendedLinearSRGB);
+  CGContextRef context = CGBitmapContextCreate(pixels.data(), width, height, 32, width * 4 * sizeof(float), linear,
+                                               kCGImageAlphaPremultipliedLast | kCGBitmapFloatComponents |
+                                                   kCGBitmapByteOrder32Little);
+  CGColorSpaceRelease(linear);
+  if (context) {
+    CGContextSetInterpolationQuality(context, kCGInterpolationHigh);
+    CGContextDrawImage(context, CGRectMake(0, 0, width, height), image);
+    CGContextRelease(context);
+  }
+  CGImageRelease(image);
+  if (!context) return nil;
+
+  MTLTextureDescriptor *desc = [MTLTextureDescriptor texture2DDescriptorWithPixelFormat:MTLPixelFormatRGBA32Float
+                                                                                  width:width
+                                                                                 height:height
+                                                                              mipmapped:YES];
+  desc.usage = MTLTextureUsageShaderRead;
+  desc.storageMode = MTLStorageModeShared;
+  id<MTLTexture> texture = [device newTextureWithDescriptor:desc];
+  if (!texture) {
+    NSLog(@"Could not allocate a %zux%zu skybox texture", width, height);
+    return nil;
+  }
+  [texture replaceRegion:MTLRegionMake2D(0, 0, width, height)
+             mipmapLevel:0
+               withBytes:pixels.data()
+             bytesPerRow:width * 4 * sizeof(float)];
+  return texture;
+}
+
+// Build the geodesic tables in the background; they don't depend on the
+// camera and only LUT trace mode needs them, so startup doesn't wait for them
+static void startGeodesicLUT(MetalRTRenderer *renderer) {
+  renderer->pendingLUT = std::make_unique<GeodesicLUT>();
+  GeodesicLUT *lut = renderer->pendingLUT.get();
+  dispatch_group_async(renderer->lutGroup, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+    auto start = std::chrono::high_resolution_clock::now();
+    lut->build();
+    double ms = std::chrono::duration<double, std::milli>(
+        std::chrono::high_resolution_clock::now() - start).count();
+    NSLog(@"Geodesic LUT built in %.1f ms (%d impact parameters x %d samples)", ms,
+          GeodesicLUT::IMPACT_SAMPLES, GeodesicLUT::BRANCH_SAMPLES);
+  });
+}
+
+// Upload the tables once the background build has finished, waiting for it
+// if wait is set. Returns whether the LUT textures are available
+static bool ensureGeodesicLUT(MetalRTRenderer *renderer, bool wait) {
+  if (!renderer->pendingLUT) return renderer->lutRadius != nil;
+  if (dispatch_group_wait(renderer->lutGroup, wait ? DISPATCH_TIME_FOREVER : DISPATCH_TIME_NOW) != 0) {
+    return false;
+  }
+
+  const GeodesicLUT &lut = *renderer->pendingLUT;
+  const int rows = GeodesicLUT::IMPACT_SAMPLES;
+  const int cols = GeodesicLUT::BRANCH_SAMPLES;
+  renderer->lutRadius = createTableTexture(renderer->device, MTLPixelFormatR32Float, cols, rows,
+                                           lut.radiusTable.data(), cols * sizeof(float));
+  renderer->lutAngle = createTableTexture(renderer->device, MTLPixelFormatR32Float, cols, rows,
+                                          lut.angleTable.data(), cols * sizeof(float));
+  renderer->lutBranch = createTableTexture(renderer->device, MTLPixelFormatRG32Float, 1, rows,
+                                           lut.branchTable.data(), 2 * sizeof(float));
+  renderer->pendingLUT.reset();
+  if (!renderer->lutRadius || !renderer->lutAngle || !renderer->lutBranch) {
+    NSLog(@"Failed to create geodesic LUT textures, LUT trace mode disabled");
+    renderer->lutRadius = nil;
+    return false;
+  }
+  return true;
+}
+
+// Pipeline archive file, one per device and shader library build so a
+// rebuilt metallib never looks up stale binaries
+static NSURL *pipelineArchiveURLFor(id<MTLDevice> device, NSString *libraryPath) {
+  NSFileManager *fileManager = [NSFileManager defaultManager];
+  NSURL *caches = [[fileManager URLsForDirectory:NSCachesDirectory inDomains:NSUserDomainMask] firstObject];
+  if (!caches) return nil;
+  NSURL *directory = [caches URLByAppendingPathComponent:@"blackhole_sim" isDirectory:YES];
+  if (![fileManager createDirectoryAtURL:directory withIntermediateDirectories:YES attributes:nil error:nil]) {
+    return nil;
+  }
+
+  unsigned long long librarySize = 0;
+  long long libraryTime = 0;
+  if (libraryPath) {
+    NSDictionary *attributes = [fileManager attributesOfItemAtPath:libraryPath error:nil];
+    librarySize = [attributes fileSize];
+    libraryTime = static_cast<long long>([[attributes fileModificationDate] timeIntervalSince1970]);
+  }
+  NSString *name = [NSString stringWithFormat:@"pipelines-%llx-%llx-%llx.metallib",
+                                              device.registryID, librarySize, libraryTime];
+  return [directory URLByAppendingPathComponent:name];
+}
+
+// Called once per variant (leaves variantGroup). The last one adds the freshly
+// compiled variants to the archive and writes it out, then logs the total time
+static void finishVariant(MetalRTRenderer *renderer) {
+  NSArray<MTLComputePipelineDescriptor *> *misses = nil;
+  {
+    std::lock_guard<std::mutex> lock(renderer->variantMutex);
+    if (--renderer->pendingVariants > 0) {
+      dispatch_group_leave(renderer->variantGroup);
+      return;
+    }
+    misses = [renderer->archiveMisses copy];
+    [renderer->archiveMisses removeAllObjects];
+  }
+
+  if (renderer->pipelineArchive && misses.count > 0) {
+    NSError *error = nil;
+    for (MTLComputePipelineDescriptor *descriptor in misses) {
+      if (![renderer->pipelineArchive addComputePipelineFunctionsWithDescriptor:descriptor error:&error]) {
+        NSLog(@"Failed to add %@ to the pipeline archive: %@", descriptor.label, error);
+      }
+    }
+    // The loaded archive may still be backed by the old file: write a new one and swap it in
+    NSURL *temporaryURL = [renderer->pipelineArchiveURL URLByAppendingPathExtension:@"tmp"];
+    [[NSFileManager defaultManager] removeItemAtURL:temporaryURL error:nil];
+    if (![renderer->pipelineArchive serializeToURL:temporaryURL error:&error] ||
+        ![[NSFileManager defaultManager] replaceItemAtURL:renderer->pipelineArchiveURL
+                                            withItemAtURL:temporaryURL
+                                           backupItemName:nil
+                                                  options:0
+                                         resultingItemURL:nil
+                                                    error:&error]) {
+      NSLog(@"Failed to write pipeline archive %@: %@", renderer->pipelineArchiveURL.path, error);
+    }
+  }
+
+  double ms = std::chrono::duration<double, std::milli>(
+      std::chrono::high_resolution_clock::now() - renderer->variantStart).count();
+  NSLog(@"Pipeline variants ready in %.0f ms (%lu pipelines compiled, the rest from the archive)", ms,
+        (unsigned long)misses.count);
+  dispatch_group_leave(renderer->variantGroup);
+}
+
+// Create a variant pipeline in the background. With requireArchiveHit the
+// pipeline is only taken from the archive; on a miss it is compiled instead
+static void createVariantPipeline(MetalRTRenderer *renderer, MTLComputePipelineDescriptor *descriptor,
+                                  __strong id<MTLComputePipelineState> *target, bool requireArchiveHit) {
+  MTLPipelineOption options = requireArchiveHit ? MTLPipelineOptionFailOnBinaryArchiveMiss : MTLPipelineOptionNone;
+  [renderer->device newComputePipelineStateWithDescriptor:descriptor
+                                                  options:options
+                                        completionHandler:^(id<MTLComputePipelineState> state,
+                                                            MTLComputePipelineReflection *, NSError *error) {
+    if (!state && requireArchiveHit) {
+      createVariantPipeline(renderer, descriptor, target, false);
+      return;
+    }
+    if (state) {
+      std::lock_guard<std::mutex> lock(renderer->variantMutex);
+      *target = state;
+      if (!requireArchiveHit) {
+        [renderer->archiveMisses addObject:descriptor];
+      }
+    } else {
+      NSLog(@"Pipeline variant %@ failed: %@", descriptor.label, error);
+    }
+    finishVariant(renderer);
+  }];
+}
+
+// Specialize a kernel (traceMode < 0 leaves the trace mode to the uniforms;
+// kerr compiles in the Kerr integrator) and create its pipeline in the background
+static void compileVariant(MetalRTRenderer *renderer, NSString *name, int colorMode, int traceMode,
+                           __strong id<MTLComputePipelineState> *target, bool kerr = false) {
+  MTLFunctionConstantValues *constants = [MTLFunctionConstantValues new];
+  [constants setConstantValue:&colorMode type:MTLDataTypeInt atIndex:kColorModeConstant];
+  if (traceMode >= 0) {
+    [constants setConstantValue:&traceMode type:MTLDataTypeInt atIndex:kTraceModeConstant];
+  }
+  if (kerr) {
+    [constants setConstantValue:&kerr type:MTLDataTypeBool atIndex:kKerrConstant];
+  }
+  NSString *label = [NSString stringWithFormat:@"%@ (color %d, trace %d%@)", name, colorMode, traceMode,
+                                               kerr ? @", Kerr" : @""];
+
+  [renderer->library newFunctionWithName:name
+                          constantValues:constants
+                       completionHandler:^(id<MTLFunction> function, NSError *error) {
+    if (!function) {
+      NSLog(@"Failed to specialize %@: %@", label, error);
+      finishVariant(renderer);
+      return;
+    }
+    MTLComputePipelineDescriptor *descriptor = [MTLComputePipelineDescriptor new];
+    descriptor.computeFunction = function;
+    descriptor.label = label;
+    if (renderer->pipelineArchive) {
+      descriptor.binaryArchives = @[renderer->pipelineArchive];
+    }
+    createVariantPipeline(renderer, descriptor, target, renderer->pipelineArchiveLoaded);
+  }];
+}
+
+// Open the pipeline archive of this device and library, or start an empty one
+static void openPipelineArchive(MetalRTRenderer *renderer, NSString *libraryPath) {
+  renderer->archiveMisses = [NSMutableArray array];
+  renderer->pipelineArchiveURL = pipelineArchiveURLFor(renderer->device, libraryPath);
+  if (renderer->pipelineArchiveURL) {
+    MTLBinaryArchiveDescriptor *archiveDescriptor = [MTLBinaryArchiveDescriptor new];
+    if ([[NSFileManager defaultManager] fileExistsAtPath:renderer->pipelineArchiveURL.path]) {
+      archiveDescriptor.url = renderer->pipelineArchiveURL;
+    }
+    NSError *error = nil;
+    renderer->pipelineArchive = [renderer->device newBinaryArchiveWithDescriptor:archiveDescriptor error:&error];
+    renderer->pipelineArchiveLoaded = renderer->pipelineArchive && archiveDescriptor.url;
+    if (!renderer->pipelineArchive && archiveDescriptor.url) {
+      // Unreadable (e.g. truncated) archive: start a fresh one
+      [[NSFileManager defaultManager] removeItemAtURL:renderer->pipelineArchiveURL error:nil];
+      renderer->pipelineArchive = [renderer->device newBinaryArchiveWithDescriptor:[MTLBinaryArchiveDescriptor new]
+                                                                              error:&error];
+    }
+    if (!renderer->pipelineArchive) {
+      NSLog(@"Pipeline archive unavailable, pipelines compile every launch: %@", error);
+    }
+  }
+}
+
+// Pipeline of a generic kernel, created synchronously at startup. Warm
+// launches take it from the archive; a miss is compiled and queued for the
+// archive, which is written once the variants have finished
+static id<MTLComputePipelineState> newArchivedPipeline(MetalRTRenderer *renderer, id<MTLFunction> function,
+                                                       NSError **error) {
+  MTLComputePipelineDescriptor *descriptor = [MTLComputePipelineDescriptor new];
+  descriptor.computeFunction = function;
+  descriptor.label = function.name;
+  if (renderer->pipelineArchive) {
+    descriptor.binaryArchives = @[renderer->pipelineArchive];
+    if (renderer->pipelineArchiveLoaded) {
+      id<MTLComputePipelineState> state =
+          [renderer->device newComputePipelineStateWithDescriptor:descriptor
+                                                          options:MTLPipelineOptionFailOnBinaryArchiveMiss
+                                                       reflection:nil
+                                                            error:nil];
+      if (state) return state;
+    }
+  }
+
+  id<MTLComputePipelineState> state = [renderer->device newComputePipelineStateWithDescriptor:descriptor
+                                                                                       options:MTLPipelineOptionNone
+                                                                                    reflection:nil
+                                                                                         error:error];
+  if (state && renderer->pipelineArchive) {
+    std::lock_guard<std::mutex> lock(renderer->variantMutex);
+    [renderer->archiveMisses addObject:descriptor];
+  }
+  return state;
+}
+
+// Start compiling every specialized variant; the generic pipelines cover frames until they land
+static void startPipelineVariants(MetalRTRenderer *renderer) {
+  renderer->variantStart = std::chrono::high_resolution_clock::now();
+
+  bool shadeAvailable = renderer->shadePipelineState != nil;
+  renderer->pendingVariants = kColorModes * (METAL_RT_TRACE_MODE_COUNT + 1 + (shadeAvailable ? 1 : 0));
+  for (int color = 0; color < kColorModes; color++) {
+    dispatch_group_enter(renderer->variantGroup);
+    compileVariant(renderer, @"ray_generation", color, -1, &renderer->kerrVariants[color], true);
+    for (int trace = 0; trace < METAL_RT_TRACE_MODE_COUNT; trace++) {
+      dispatch_group_enter(renderer->variantGroup);
+      compileVariant(renderer, @"ray_generation", color, trace, &renderer->traceVariants[color][trace]);
+    }
+    if (shadeAvailable) {
+      dispatch_group_enter(renderer->variantGroup);
+      compileVariant(renderer, @"shade_cached", color, -1, &renderer->shadeVariants[color]);
+    }
+  }
+}
+
+// Specialized pipeline for a frame, or the generic one while the variant compiles.
+// Tracing with spin needs a Kerr variant (the generic kernel has no Kerr
+// integrator); set_spin only accepts a spin for a palette whose variant exists
+static id<MTLComputePipelineState> framePipeline(MetalRTRenderer *renderer, int colorMode, bool shadeFromCache) {
+  if (colorMode >= 0 && colorMode < kColorModes) {
+    std::lock_guard<std::mutex> lock(renderer->variantMutex);
+    id<MTLComputePipelineState> variant =
+        shadeFromCache         ? renderer->shadeVariants[colorMode]
+        : renderer->spin != 0.0f ? renderer->kerrVariants[colorMode]
+                                 : renderer->traceVariants[colorMode][renderer->traceMode];
+    if (variant) return variant;
+  }
+  return shadeFromCache ? renderer->shadePipelineState : renderer->pipelineState;
+}
+
+// Copy the displayed sub-rect of the output texture into a CPU buffer
+// (BGRA8, full texture width per row so the layout doesn't change with the viewport)
+static void readBackPixels(MetalRTRenderer *renderer, std::vector<uint8_t> &dst) {
+  size_t bytesPerRow = static_cast<size_t>(renderer->width) * 4;
+  dst.resize(bytesPerRow * renderer->height);
+  [renderer->outputTexture
+         getBytes:dst.data()
+      bytesPerRow:bytesPerRow
+       fromRegion:MTLRegionMake2D(0, 0, renderer->displayedWidth, renderer->displayedHeight)
+      mipmapLevel:0];
+}
+
+// Metal device by MTLCopyAllDevices index, or the system default for -1
+static id<MTLDevice> deviceForIndex(int deviceIndex) {
+  if (deviceIndex < 0) {
+    return MTLCreateSystemDefaultDevice();
+  }
+  NSArray<id<MTLDevice>> *devices = MTLCopyAllDevices();
+  if (deviceIndex >= static_cast<int>(devices.count)) {
+    return nil;
+  }
+  return devices[deviceIndex];
+}
+
+int metal_rt_renderer_get_device_count(void) {
+  @autoreleasepool {
+    return static_cast<int>(MTLCopyAllDevices().count);
+  }
+}
+
+bool metal_rt_renderer_get_device_name(int deviceIndex, char *name, size_t size) {
+  if (!name || size == 0) return false;
+  @autoreleasepool {
+    id<MTLDevice> device = deviceForIndex(deviceIndex);
+    if (!device) return false;
+    std::snprintf(name, size, "%s%s", device.name.UTF8String,
+                  device.removable ? " (external)" : device.lowPower ? " (low power)" : "");
+    return true;
+  }
+}
 
 MetalRTRenderer *metal_rt_renderer_create(int width, int height) {
+  return metal_rt_renderer_create_on_device(-1, width, height);
+}
+
+MetalRTRenderer *metal_rt_renderer_create_on_device(int deviceIndex, int width, int height) {
   @autoreleasepool {
     MetalRTRenderer *renderer = new MetalRTRenderer();
     renderer->width = width;
     renderer->height = height;
     renderer->pixelData.resize(width * height * 4);
+    renderer->pixelsDirty = false;
+    renderer->presentPipeline = nil;
+    renderer->presentPixelFormat = MTLPixelFormatInvalid;
+    renderer->presentSampler = nil;
+    renderer->inFlightSemaphore = dispatch_semaphore_create(kMaxFramesInFlight);
+    renderer->nextFrameIndex = 0;
+    renderer->displayedSlot = -1;
+    renderer->traceMode = METAL_RT_TRACE_VOLUMETRIC;
+    renderer->variantGroup = dispatch_group_create();
+    renderer->lutGroup = dispatch_group_create();
+    renderer->pendingVariants = 0;
+    renderer->pipelineArchiveLoaded = false;
+    renderer->integratorTolerance = METAL_RT_DEFAULT_INTEGRATOR_TOLERANCE;
+    renderer->spin = 0.0f;
+    renderer->shadePipelineState = nil;
+    renderer->geodesicCache = nil;
+    renderer->geodesicCacheEnabled = true;
+    renderer->geodesicCacheValid = false;
+    renderer->cacheTraceMode = -1;
+    renderer->cacheSpin = 0.0f;
+    renderer->accumulationEnabled = true;
+    renderer->repeatDetection = true;
+    renderer->accumulation = nil;
+    renderer->accumulationKeyValid = false;
+    renderer->accumulationSamples = -1;
+    renderer->compositePipelineState = nil;
+    renderer->bloomPrefilterPipelineState = nil;
+    renderer->bloomDownsamplePipelineState = nil;
+    renderer->bloomUpsamplePipelineState = nil;
+    renderer->radianceValid = false;
+    renderer->exposure = 1.0f;
+    renderer->bloomStrength = kDefaultBloomStrength;
+    renderer->cacheWidth = 0;
+    renderer->cacheHeight = 0;
+    renderer->lastGPUTimeMs = 0.0;
+    renderer->coarsePipelineState = nil;
+    renderer->classifyPipelineState = nil;
+    renderer->foveatedPipelineState = nil;
+    renderer->coarseRays = nil;
+    renderer->tileFlags = nil;
+    renderer->foveationEnabled = false;
+    renderer->verbose = false;
+    renderer->loggedColorMode = -1;
+    renderer->diagnosticsEnabled = false;
+    renderer->diagnosticsValid = false;
+    renderer->latestDiagnostics = {};
+    renderer->nextCaptureId = 0;
+    renderer->hdrTexture = nil;
+    for (int i = 0; i < kCaptureSlots; i++) {
+      renderer->captures[i].inUse = false;
+      renderer->captures[i].captureId = -1;
+    }
+    renderer->tilePipelineState = nil;
+    renderer->resolvePipelineState = nil;
+    renderer->tileAccumulation = nil;
+    renderer->tileOutput = nil;
+    renderer->tileCapacityWidth = 0;
+    renderer->tileCapacityHeight = 0;
+    renderer->nv12PipelineState = nil;
+    renderer->textureCache = nullptr;
+    renderer->conversionQueue = nil;
+    renderer->resamplePipelineState = nil;
 
     // Get Metal device
-    renderer->device = MTLCreateSystemDefaultDevice();
+    renderer->device = deviceForIndex(deviceIndex);
     if (!renderer->device) {
-      NSLog(@"Metal is not supported on this device");
+      if (deviceIndex < 0) {
+        NSLog(@"Metal is not supported on this device");
+      } else {
+        NSLog(@"No Metal device at index %d", deviceIndex);
+      }
       delete renderer;
       return nullptr;
     }
@@ -55,6 +900,7 @@ MetalRTRenderer *metal_rt_renderer_create(int width, int height) {
     // Load Metal library
     NSError *error = nil;
     id<MTLLibrary> library = nil;
+    NSString *libraryPath = nil;  // File the library came from (keys the pipeline archive)
 
     // First, try to load from app bundle Resources directory
     NSBundle *bundle = [NSBundle mainBundle];
@@ -64,6 +910,7 @@ MetalRTRenderer *metal_rt_renderer_create(int width, int height) {
       NSURL *libraryURL = [NSURL fileURLWithPath:bundleLibraryPath];
       library = [renderer->device newLibraryWithURL:libraryURL error:&error];
       if (library) {
+        libraryPath = bundleLibraryPath;
         NSLog(@"Loaded Metal library from bundle: %@", bundleLibraryPath);
       } else {
         NSLog(@"Failed to load Metal library from bundle: %@", error);
@@ -77,6 +924,7 @@ MetalRTRenderer *metal_rt_renderer_create(int width, int height) {
         NSURL *libraryURL = [NSURL fileURLWithPath:devLibraryPath];
         library = [renderer->device newLibraryWithURL:libraryURL error:&error];
         if (library) {
+          libraryPath = devLibraryPath;
           NSLog(@"Loaded Metal library from development path: %@", devLibraryPath);
         }
       }
@@ -95,6 +943,10 @@ MetalRTRenderer *metal_rt_renderer_create(int width, int height) {
       delete renderer;
       return nullptr;
     }
+    renderer->library = library;
+
+    // Compiled pipelines from earlier launches; the generic ones below come from here when warm
+    openPipelineArchive(renderer, libraryPath);
 
     // Get kernel function
     id<MTLFunction> kernelFunction =
@@ -106,39 +958,101 @@ MetalRTRenderer *metal_rt_renderer_create(int width, int height) {
     }
 
     // Create compute pipeline
-    renderer->pipelineState =
-        [renderer->device newComputePipelineStateWithFunction:kernelFunction
-                                                        error:&error];
+    renderer->pipelineState = newArchivedPipeline(renderer, kernelFunction, &error);
     if (!renderer->pipelineState) {
       NSLog(@"Failed to create pipeline state: %@", error);
       delete renderer;
       return nullptr;
     }
 
-    // Create uniform buffer with managed storage mode for explicit synchronization
-    // This ensures CPU writes are properly synchronized to GPU
-    #if TARGET_OS_OSX
-    renderer->uniformBuffer =
-        [renderer->device newBufferWithLength:sizeof(Uniforms)
-                                      options:MTLResourceStorageModeManaged];
-    #else
-    renderer->uniformBuffer =
-        [renderer->device newBufferWithLength:sizeof(Uniforms)
-                                      options:MTLResourceStorageModeShared];
-    #endif
-
-    // Create output texture
-    MTLTextureDescriptor *textureDesc = [MTLTextureDescriptor
-        texture2DDescriptorWithPixelFormat:MTLPixelFormatRGBA8Unorm
-                                     width:width
-                                    height:height
-                                 mipmapped:NO];
-    textureDesc.usage = MTLTextureUsageShaderWrite | MTLTextureUsageShaderRead;
-    textureDesc.storageMode = MTLStorageModeShared;
-    renderer->outputTexture =
-        [renderer->device newTextureWithDescriptor:textureDesc];
+    // Shading-only pipeline for the geodesic cache (optional)
+    id<MTLFunction> shadeFunction = [library newFunctionWithName:@"shade_cached"];
+    if (shadeFunction) {
+      renderer->shadePipelineState =
+          newArchivedPipeline(renderer, shadeFunction, &error);
+    }
+    if (!renderer->shadePipelineState) {
+      NSLog(@"Geodesic cache disabled: failed to create shade_cached pipeline: %@", error);
+    }
 
-    if (!renderer->outputTexture) {
+    // Foveated tracing pipelines (optional)
+    id<MTLFunction> coarseFunction = [library newFunctionWithName:@"trace_coarse"];
+    id<MTLFunction> classifyFunction = [library newFunctionWithName:@"classify_tiles"];
+    id<MTLFunction> foveatedFunction = [library newFunctionWithName:@"ray_generation_foveated"];
+    if (coarseFunction && classifyFunction && foveatedFunction) {
+      renderer->coarsePipelineState =
+          newArchivedPipeline(renderer, coarseFunction, &error);
+      renderer->classifyPipelineState =
+          newArchivedPipeline(renderer, classifyFunction, &error);
+      renderer->foveatedPipelineState =
+          newArchivedPipeline(renderer, foveatedFunction, &error);
+    }
+    if (!renderer->coarsePipelineState || !renderer->classifyPipelineState || !renderer->foveatedPipelineState) {
+      NSLog(@"Foveated tracing unavailable: %@", error);
+      renderer->coarsePipelineState = nil;
+    }
+
+    // Post chain: the composite turns every live frame into its output, bloom is optional
+    id<MTLFunction> compositeFunction = [library newFunctionWithName:@"post_composite"];
+    if (compositeFunction) {
+      renderer->compositePipelineState = newArchivedPipeline(renderer, compositeFunction, &error);
+    }
+    if (!renderer->compositePipelineState) {
+      NSLog(@"Failed to create post_composite pipeline: %@", error);
+      delete renderer;
+      return nullptr;
+    }
+    id<MTLFunction> prefilterFunction = [library newFunctionWithName:@"post_bloom_prefilter"];
+    id<MTLFunction> downsampleFunction = [library newFunctionWithName:@"post_bloom_downsample"];
+    id<MTLFunction> upsampleFunction = [library newFunctionWithName:@"post_bloom_upsample"];
+    if (prefilterFunction && downsampleFunction && upsampleFunction) {
+      renderer->bloomPrefilterPipelineState = newArchivedPipeline(renderer, prefilterFunction, &error);
+      renderer->bloomDownsamplePipelineState = newArchivedPipeline(renderer, downsampleFunction, &error);
+      renderer->bloomUpsamplePipelineState = newArchivedPipeline(renderer, upsampleFunction, &error);
+    }
+    if (!renderer->bloomPrefilterPipelineState || !renderer->bloomDownsamplePipelineState ||
+        !renderer->bloomUpsamplePipelineState) {
+      NSLog(@"Bloom unavailable: %@", error);
+      renderer->bloomPrefilterPipelineState = nil;
+    }
+
+    // Offline tiled rendering pipelines (optional)
+    id<MTLFunction> tileFunction = [library newFunctionWithName:@"ray_generation_tile"];
+    id<MTLFunction> resolveFunction = [library newFunctionWithName:@"resolve_tile"];
+    if (tileFunction && resolveFunction) {
+      renderer->tilePipelineState =
+          newArchivedPipeline(renderer, tileFunction, &error);
+      renderer->resolvePipelineState =
+          newArchivedPipeline(renderer, resolveFunction, &error);
+    }
+    if (!renderer->tilePipelineState || !renderer->resolvePipelineState) {
+      NSLog(@"Tiled rendering unavailable: %@", error);
+      renderer->tilePipelineState = nil;
+    }
+
+    renderer->placeholderCache = [renderer->device newBufferWithLength:sizeof(GeodesicCacheEntry)
+                                                               options:MTLResourceStorageModePrivate];
+    MTLTextureDescriptor *placeholderDesc =
+        [MTLTextureDescriptor texture2DDescriptorWithPixelFormat:MTLPixelFormatRGBA32Float width:1 height:1 mipmapped:NO];
+    placeholderDesc.usage = MTLTextureUsageShaderWrite;
+    placeholderDesc.storageMode = MTLStorageModePrivate;
+    renderer->placeholderDiagnostics = [renderer->device newTextureWithDescriptor:placeholderDesc];
+
+    // Create per-slot output textures
+    bool texturesCreated = createSlotTextures(renderer);
+    if (!createDiskShadingLUT(renderer)) {
+      NSLog(@"Failed to create disk shading LUT textures");
+      delete renderer;
+      return nullptr;
+    }
+    renderer->sky = bakeSky(renderer, @"bake_starfield", nil, kSkyFaceSize);
+    if (!renderer->sky) {
+      NSLog(@"Failed to bake the starfield cubemap");
+      delete renderer;
+      return nullptr;
+    }
+
+    if (!texturesCreated) {
       NSUInteger maxSize = [renderer->device supportsFamily:MTLGPUFamilyApple1] ? 16384 : 8192;
       NSLog(@"Failed to create output texture at resolution %dx%d", width, height);
       NSLog(@"Maximum texture size supported: %lu x %lu", (unsigned long)maxSize, (unsigned long)maxSize);
@@ -148,6 +1062,11 @@ MetalRTRenderer *metal_rt_renderer_create(int width, int height) {
 
     // Initialization logging removed for performance
 
+    // Geodesic tables and branch-free palette/trace-mode variants finish in the
+    // background, so the first frame only waits for the generic pipelines
+    startGeodesicLUT(renderer);
+    startPipelineVariants(renderer);
+
     return renderer;
   }
 }
@@ -156,22 +1075,24 @@ void metal_rt_renderer_resize(MetalRTRenderer *renderer, int width, int height)
   if (!renderer) return;
   
   @autoreleasepool {
+    // Frames in flight still write the old textures
+    metal_rt_renderer_wait_idle(renderer);
+
     renderer->width = width;
     renderer->height = height;
     renderer->pixelData.resize(width * height * 4);
     
-    // Recreate output texture with new size
-    MTLTextureDescriptor *textureDesc = [MTLTextureDescriptor
-        texture2DDescriptorWithPixelFormat:MTLPixelFormatRGBA8Unorm
-                                     width:width
-                                    height:height
-                                 mipmapped:NO];
-    textureDesc.usage = MTLTextureUsageShaderWrite | MTLTextureUsageShaderRead;
-    textureDesc.storageMode = MTLStorageModeShared;
-    renderer->outputTexture =
-        [renderer->device newTextureWithDescriptor:textureDesc];
+    // Geodesic cache and foveation tiles are per pixel; reallocated on next use
+    renderer->geodesicCache = nil;
+    renderer->geodesicCacheValid = false;
+    renderer->accumulation = nil;
+    renderer->accumulationKeyValid = false;
+    renderer->coarseRays = nil;
+    renderer->tileFlags = nil;
+    renderer->hdrTexture = nil;
     
-    if (!renderer->outputTexture) {
+    // Recreate output textures with new size
+    if (!createSlotTextures(renderer)) {
       NSLog(@"Failed to resize Metal renderer texture to %dx%d", width, height);
       return;
     }
@@ -182,221 +1103,1307 @@ void metal_rt_renderer_resize(MetalRTRenderer *renderer, int width, int height)
 
 void metal_rt_renderer_destroy(MetalRTRenderer *renderer) {
   if (renderer) {
+    // Completion handlers reference the renderer
+    metal_rt_renderer_wait_idle(renderer);
+    for (int i = 0; i < kCaptureSlots; i++) {
+      [renderer->captures[i].copyCommandBuffer waitUntilCompleted];
+    }
+    dispatch_group_wait(renderer->variantGroup, DISPATCH_TIME_FOREVER);
+    dispatch_group_wait(renderer->lutGroup, DISPATCH_TIME_FOREVER);
+    if (renderer->textureCache) {
+      CFRelease(renderer->textureCache);
+    }
     delete renderer;
   }
 }
 
-void metal_rt_renderer_render(MetalRTRenderer *renderer,
-                              const CameraData *camera, float time, int colorMode, float colorIntensity) {
-  @autoreleasepool {
-    // Update uniforms
-    Uniforms *uniforms = (Uniforms *)[renderer->uniformBuffer contents];
-    memcpy(uniforms->camera.position, camera->position, sizeof(float) * 3);
-    memcpy(uniforms->camera.forward, camera->forward, sizeof(float) * 3);
-    memcpy(uniforms->camera.right, camera->right, sizeof(float) * 3);
-    memcpy(uniforms->camera.up, camera->up, sizeof(float) * 3);
-    uniforms->camera.fov = camera->fov;
-    uniforms->resolution[0] = renderer->width;
-    uniforms->resolution[1] = renderer->height;
-    // Always update time - this drives the black hole animation
-    // Even if camera doesn't move, time must advance for animation
-    uniforms->time = time;
-    uniforms->colorMode = colorMode;
-    uniforms->colorIntensity = colorIntensity;
-    
-    // Ensure time is valid (not NaN or Inf)
-    if (!isfinite(uniforms->time)) {
-      uniforms->time = 0.0f;
-    }
-    
-    // Debug: Always log colorMode for screenshots (check if called from screenshot context)
-    // We'll use a static counter to detect rapid successive calls (screenshot scenario)
-    static int lastColorMode = -1;
-    static int callCount = 0;
-    callCount++;
-    if (colorMode != lastColorMode || callCount % 60 == 0) {
-      NSLog(@"Metal render: colorMode=%d (was %d), colorIntensity=%.2f, time=%.2f", 
-            uniforms->colorMode, lastColorMode, uniforms->colorIntensity, uniforms->time);
-      lastColorMode = colorMode;
-    }
-    
-    // Explicitly mark the buffer as modified to ensure GPU sees the changes
-    // This is important for shared storage mode buffers
-    NSRange modifiedRange = NSMakeRange(0, sizeof(Uniforms));
-    [renderer->uniformBuffer didModifyRange:modifiedRange];
+void metal_rt_renderer_wait_idle(MetalRTRenderer *renderer) {
+  if (!renderer) return;
+  // Take every in-flight token, then hand them back
+  for (int i = 0; i < kMaxFramesInFlight; i++) {
+    dispatch_semaphore_wait(renderer->inFlightSemaphore, DISPATCH_TIME_FOREVER);
+  }
+  for (int i = 0; i < kMaxFramesInFlight; i++) {
+    dispatch_semaphore_signal(renderer->inFlightSemaphore);
+  }
+}
 
-    // Camera data logging removed for performance
+// Fill a slot's uniforms from the camera and frame parameters
+static void writeUniforms(MetalRTRenderer *renderer, Uniforms *uniforms,
+                          const CameraData *camera, float time, int colorMode, float colorIntensity) {
+  memcpy(uniforms->camera.position, camera->position, sizeof(float) * 3);
+  memcpy(uniforms->camera.forward, camera->forward, sizeof(float) * 3);
+  memcpy(uniforms->camera.right, camera->right, sizeof(float) * 3);
+  memcpy(uniforms->camera.up, camera->up, sizeof(float) * 3);
+  uniforms->camera.fov = camera->fov;
+  uniforms->resolution[0] = renderer->viewportWidth;
+  uniforms->resolution[1] = renderer->viewportHeight;
+  // Always update time - this drives the black hole animation
+  // Even if camera doesn't move, time must advance for animation
+  uniforms->time = time;
+  uniforms->colorMode = colorMode;
+  uniforms->colorIntensity = colorIntensity;
+  uniforms->traceMode = renderer->traceMode;
+  uniforms->integratorTolerance = renderer->integratorTolerance;
+  uniforms->spin = renderer->spin;
+  
+  // Ensure time is valid (not NaN or Inf)
+  if (!isfinite(uniforms->time)) {
+    uniforms->time = 0.0f;
+  }
+}
 
-    // Create command buffer
-    id<MTLCommandBuffer> commandBuffer = [renderer->commandQueue commandBuffer];
-    id<MTLComputeCommandEncoder> encoder =
-        [commandBuffer computeCommandEncoder];
+// Decide how this frame uses the geodesic cache. Returns true when the camera
+// (and trace mode and spin) match the cached trace so the frame can be re-shaded only;
+// otherwise writeCache tells ray_generation whether to refresh the cache.
+// Foveated and accumulating frames (bypass) don't use it.
+static bool prepareGeodesicCache(MetalRTRenderer *renderer, const CameraData *camera,
+                                 bool bypass, bool &writeCache) {
+  writeCache = false;
+  bool cacheable = renderer->geodesicCacheEnabled && renderer->shadePipelineState &&
+                   (renderer->traceMode != METAL_RT_TRACE_VOLUMETRIC || renderer->spin != 0.0f) && !bypass &&
+                   !renderer->diagnosticsEnabled;
+  if (!cacheable) {
+    renderer->geodesicCacheValid = false;
+    return false;
+  }
 
-    [encoder setComputePipelineState:renderer->pipelineState];
-    [encoder setTexture:renderer->outputTexture atIndex:0];
-    [encoder setBuffer:renderer->uniformBuffer offset:0 atIndex:0];
+  if (!renderer->geodesicCache) {
+    NSUInteger length = static_cast<NSUInteger>(renderer->width) * renderer->height * sizeof(GeodesicCacheEntry);
+    renderer->geodesicCache = [renderer->device newBufferWithLength:length
+                                                            options:MTLResourceStorageModePrivate];
+    renderer->geodesicCacheValid = false;
+    if (!renderer->geodesicCache) {
+      NSLog(@"Failed to allocate geodesic cache (%lu bytes), cache disabled", (unsigned long)length);
+      renderer->geodesicCacheEnabled = false;
+      return false;
+    }
+  }
 
-    // Dispatch threads
-    MTLSize threadgroupSize = MTLSizeMake(8, 8, 1);
-    MTLSize threadgroupCount = MTLSizeMake(
-        (renderer->width + threadgroupSize.width - 1) / threadgroupSize.width,
-        (renderer->height + threadgroupSize.height - 1) /
-            threadgroupSize.height,
-        1);
+  if (renderer->geodesicCacheValid && renderer->cacheTraceMode == renderer->traceMode &&
+      renderer->cacheSpin == renderer->spin && renderer->cacheWidth == renderer->viewportWidth && renderer->cacheHeight == renderer->viewportHeight &&
+      memcmp(&renderer->cacheCamera, camera, sizeof(CameraData)) == 0) {
+    return true;
+  }
 
-    [encoder dispatchThreadgroups:threadgroupCount
-            threadsPerThreadgroup:threadgroupSize];
-    [encoder endEncoding];
+  renderer->cacheCamera = *camera;
+  renderer->cacheTraceMode = renderer->traceMode;
+  renderer->cacheSpin = renderer->spin;
+  renderer->cacheWidth = renderer->viewportWidth;
+  renderer->cacheHeight = renderer->viewportHeight;
+  renderer->geodesicCacheValid = true;
+  writeCache = true;
+  return false;
+}
 
-    // Commit and wait - this ensures the frame is fully rendered
-    // Note: waitUntilCompleted ensures we have valid pixel data
-    [commandBuffer commit];
-    [commandBuffer waitUntilCompleted];
-    
-    // Time verification removed for performance
+// Progressive refinement for this frame: returns the sample ray_generation
+// adds to the accumulation buffer (0 restarts it), or -1 to trace normally.
+// A frame accumulates once its inputs repeat the previous frame's (repeated),
+// i.e. from the second frame of a paused scene; any change starts over.
+static int prepareAccumulation(MetalRTRenderer *renderer, const CameraData *camera, float time, int colorMode,
+                               float colorIntensity, bool diagnostics, bool foveated, bool &repeated) {
+  AccumulationKey key;
+  memset(&key, 0, sizeof(key));
+  key.camera = *camera;
+  key.time = time;
+  key.colorMode = colorMode;
+  key.colorIntensity = colorIntensity;
+  key.traceMode = renderer->traceMode;
+  key.integratorTolerance = renderer->integratorTolerance;
+  key.spin = renderer->spin;
+  key.viewportWidth = renderer->viewportWidth;
+  key.viewportHeight = renderer->viewportHeight;
+  key.diagnostics = diagnostics;
+  key.foveated = foveated;
 
-    // Check for errors
-    if (commandBuffer.error) {
-      NSLog(@"Command buffer error: %@", commandBuffer.error);
-    }
+  repeated = renderer->repeatDetection && renderer->accumulationKeyValid &&
+             memcmp(&key, &renderer->accumulationKey, sizeof(key)) == 0;
+  renderer->accumulationKey = key;
+  renderer->accumulationKeyValid = true;
+  if (!repeated) {
+    renderer->accumulationSamples = -1;
+  }
+  if (!repeated || diagnostics || foveated || !renderer->accumulationEnabled) {
+    return -1;
+  }
 
-    // Read back pixels
-    // Metal RGBA8Unorm stores as RGBA (R=byte0, G=byte1, B=byte2, A=byte3)
-    // SDL ARGB8888 expects ARGB (A=byte0, R=byte1, G=byte2, B=byte3) on little-endian
-    // So we need to convert: RGBA -> ARGB
-    size_t bytesPerRow = renderer->width * 4;
-    size_t totalBytes = bytesPerRow * renderer->height;
-    
-    // Temporary buffer for RGBA data
-    std::vector<uint8_t> tempBuffer(totalBytes);
-    [renderer->outputTexture
-           getBytes:tempBuffer.data()
-        bytesPerRow:bytesPerRow
-         fromRegion:MTLRegionMake2D(0, 0, renderer->width, renderer->height)
-        mipmapLevel:0];
-    
-    // Convert RGBA to BGRA (SDL_PIXELFORMAT_ARGB8888 on little-endian is BGRA in memory)
-    uint8_t *rgba = tempBuffer.data();
-    uint8_t *bgra = renderer->pixelData.data();
-    size_t pixelCount = static_cast<size_t>(renderer->width) * static_cast<size_t>(renderer->height);
-    for (size_t i = 0; i < pixelCount; i++) {
-      size_t idx = i * 4;
-      bgra[idx + 0] = rgba[idx + 2]; // B (from RGBA B)
-      bgra[idx + 1] = rgba[idx + 1]; // G (from RGBA G)
-      bgra[idx + 2] = rgba[idx + 0]; // R (from RGBA R)
-      bgra[idx + 3] = rgba[idx + 3]; // A (from RGBA A)
+  if (!renderer->accumulation) {
+    NSUInteger length = static_cast<NSUInteger>(renderer->width) * renderer->height * sizeof(float) * 4;
+    renderer->accumulation = [renderer->device newBufferWithLength:length options:MTLResourceStorageModePrivate];
+    renderer->accumulationSamples = -1;
+    if (!renderer->accumulation) {
+      NSLog(@"Failed to allocate accumulation buffer (%lu bytes), progressive refinement disabled",
+            (unsigned long)length);
+      renderer->accumulationEnabled = false;
+      return -1;
     }
+  }
+  // Past the cap the kernel only re-resolves the mean
+  renderer->accumulationSamples = std::min(renderer->accumulationSamples + 1, kMaxAccumulationSamples);
+  return renderer->accumulationSamples;
+}
 
-    // Pixel debug logging removed for performance
+// Post chain of a frame traced into renderer->radiance (width x height
+// viewport): bloom down/up pyramid, then exposure, tone mapping and sRGB
+// encoding into output. raw (diagnostics heatmap) copies the values as they are
+static void encodePostChain(MetalRTRenderer *renderer, id<MTLComputeCommandEncoder> encoder, id<MTLTexture> output,
+                            int width, int height, bool raw) {
+  MTLSize threadgroupSize = MTLSizeMake(8, 8, 1);
+  PostParams params = {};
+  params.exposure = renderer->exposure;
+  params.bloomThreshold = kBloomThreshold;
+  params.raw = raw ? 1 : 0;
+  bool bloom = !raw && renderer->bloomStrength > 0.0f && renderer->bloomPrefilterPipelineState;
+
+  uint32_t levelSize[kBloomLevels][2];
+  levelSize[0][0] = std::max(width / 2, 1);
+  levelSize[0][1] = std::max(height / 2, 1);
+  for (int i = 1; i < kBloomLevels; i++) {
+    levelSize[i][0] = std::max(levelSize[i - 1][0] / 2, 1u);
+    levelSize[i][1] = std::max(levelSize[i - 1][1] / 2, 1u);
+  }
+  auto dispatchPass = [&](const uint32_t source[2], const uint32_t target[2]) {
+    params.sourceSize[0] = source[0];
+    params.sourceSize[1] = source[1];
+    params.targetSize[0] = target[0];
+    params.targetSize[1] = target[1];
+    [encoder setBytes:&params length:sizeof(PostParams) atIndex:0];
+    [encoder dispatchThreadgroups:threadgroupsFor(target[0], target[1], threadgroupSize)
+            threadsPerThreadgroup:threadgroupSize];
+  };
+
+  uint32_t frameSize[2] = {static_cast<uint32_t>(width), static_cast<uint32_t>(height)};
+  if (bloom) {
+    [encoder setComputePipelineState:renderer->bloomPrefilterPipelineState];
+    [encoder setTexture:renderer->radiance atIndex:0];
+    [encoder setTexture:renderer->bloomDown[0] atIndex:1];
+    dispatchPass(frameSize, levelSize[0]);
+    [encoder setComputePipelineState:renderer->bloomDownsamplePipelineState];
+    for (int i = 1; i < kBloomLevels; i++) {
+      [encoder setTexture:renderer->bloomDown[i - 1] atIndex:0];
+      [encoder setTexture:renderer->bloomDown[i] atIndex:1];
+      dispatchPass(levelSize[i - 1], levelSize[i]);
+    }
+    [encoder setComputePipelineState:renderer->bloomUpsamplePipelineState];
+    for (int i = kBloomLevels - 2; i >= 0; i--) {
+      [encoder setTexture:i == kBloomLevels - 2 ? renderer->bloomDown[i + 1] : renderer->bloomUp[i + 1] atIndex:0];
+      [encoder setTexture:renderer->bloomUp[i] atIndex:1];
+      [encoder setTexture:renderer->bloomDown[i] atIndex:2];
+      dispatchPass(levelSize[i + 1], levelSize[i]);
+    }
+    // The up chain sums every level: normalize so the strength is a share of the thresholded light
+    params.bloomStrength = renderer->bloomStrength / kBloomLevels;
   }
+
+  [encoder setComputePipelineState:renderer->compositePipelineState];
+  [encoder setTexture:renderer->radiance atIndex:0];
+  [encoder setTexture:bloom ? renderer->bloomUp[0] : renderer->radiance atIndex:1];
+  [encoder setTexture:output atIndex:2];
+  dispatchPass(levelSize[0], frameSize);
 }
 
-const void *metal_rt_renderer_get_pixels(MetalRTRenderer *renderer) {
-  return renderer->pixelData.data();
+// Allocate the per-tile foveation targets at the maximum render size
+static bool ensureFoveationTargets(MetalRTRenderer *renderer) {
+  if (renderer->coarseRays && renderer->tileFlags) {
+    return true;
+  }
+  int tilesX = (renderer->width + kFoveaTile - 1) / kFoveaTile;
+  int tilesY = (renderer->height + kFoveaTile - 1) / kFoveaTile;
+
+  MTLTextureDescriptor *desc = [MTLTextureDescriptor texture2DDescriptorWithPixelFormat:MTLPixelFormatRGBA32Float
+                                                                                   width:tilesX
+                                                                                  height:tilesY
+                                                                               mipmapped:NO];
+  desc.usage = MTLTextureUsageShaderRead | MTLTextureUsageShaderWrite;
+  desc.storageMode = MTLStorageModePrivate;
+  renderer->coarseRays = [renderer->device newTextureWithDescriptor:desc];
+  desc.pixelFormat = MTLPixelFormatR8Uint;
+  renderer->tileFlags = [renderer->device newTextureWithDescriptor:desc];
+
+  if (!renderer->coarseRays || !renderer->tileFlags) {
+    NSLog(@"Failed to allocate foveation targets (%dx%d tiles)", tilesX, tilesY);
+    renderer->coarseRays = nil;
+    renderer->tileFlags = nil;
+    return false;
+  }
+  return true;
 }
 
-// Render and get pixels atomically - ensures we get fresh pixels with correct color mode
-const void *metal_rt_renderer_render_and_get_pixels(MetalRTRenderer *renderer,
-                                                     const CameraData *camera, float time, int colorMode, float colorIntensity) {
-  if (!renderer) return nullptr;
-  
-  @autoreleasepool {
-    // Update uniforms with explicit colorMode
-    Uniforms *uniforms = (Uniforms *)[renderer->uniformBuffer contents];
-    
-    // Log the colorMode being set
-    NSLog(@"render_and_get_pixels: Setting colorMode=%d (input=%d)", colorMode, colorMode);
-    
-    memcpy(uniforms->camera.position, camera->position, sizeof(float) * 3);
-    memcpy(uniforms->camera.forward, camera->forward, sizeof(float) * 3);
-    memcpy(uniforms->camera.right, camera->right, sizeof(float) * 3);
-    memcpy(uniforms->camera.up, camera->up, sizeof(float) * 3);
-    uniforms->camera.fov = camera->fov;
-    uniforms->resolution[0] = renderer->width;
-    uniforms->resolution[1] = renderer->height;
-    uniforms->time = time;
-    uniforms->colorMode = colorMode;  // Set colorMode explicitly
-    uniforms->colorIntensity = colorIntensity;
-    
-    // Verify it was set
-    if (uniforms->colorMode != colorMode) {
-      NSLog(@"ERROR: Failed to set colorMode! Expected %d, got %d", colorMode, uniforms->colorMode);
-      uniforms->colorMode = colorMode;  // Force it
+// Allocate every slot's diagnostics texture and counters at the render size
+static bool ensureDiagnosticsTargets(MetalRTRenderer *renderer) {
+  MTLTextureDescriptor *desc = [MTLTextureDescriptor texture2DDescriptorWithPixelFormat:MTLPixelFormatRGBA32Float
+                                                                                   width:renderer->width
+                                                                                  height:renderer->height
+                                                                               mipmapped:NO];
+  desc.usage = MTLTextureUsageShaderWrite;
+  desc.storageMode = MTLStorageModeShared;  // Read back by metal_rt_renderer_save_diagnostics
+  for (int i = 0; i < kFrameSlots; i++) {
+    FrameSlot &slot = renderer->slots[i];
+    if (!slot.diagnosticsTexture) {
+      slot.diagnosticsTexture = [renderer->device newTextureWithDescriptor:desc];
     }
-    
-    // Mark buffer as modified for managed storage mode
-    NSRange modifiedRange = NSMakeRange(0, sizeof(Uniforms));
-    #if TARGET_OS_OSX
-    if (renderer->uniformBuffer.storageMode == MTLStorageModeManaged) {
-      [renderer->uniformBuffer didModifyRange:modifiedRange];
+    if (!slot.diagnosticsCounters) {
+      slot.diagnosticsCounters = [renderer->device newBufferWithLength:kDiagnosticCounters * sizeof(uint32_t)
+                                                               options:MTLResourceStorageModeShared];
     }
-    #endif
-    
-    // Force a blit to ensure uniform buffer is synchronized (for managed mode)
-    #if TARGET_OS_OSX
-    if (renderer->uniformBuffer.storageMode == MTLStorageModeManaged) {
-      id<MTLCommandBuffer> blitCommandBuffer = [renderer->commandQueue commandBuffer];
-      id<MTLBlitCommandEncoder> blitEncoder = [blitCommandBuffer blitCommandEncoder];
-      [blitEncoder synchronizeResource:renderer->uniformBuffer];
-      [blitEncoder endEncoding];
-      [blitCommandBuffer commit];
-      [blitCommandBuffer waitUntilCompleted];
-    }
-    #endif
-    
-    // Create command buffer and render
-    id<MTLCommandBuffer> commandBuffer = [renderer->commandQueue commandBuffer];
-    id<MTLComputeCommandEncoder> encoder = [commandBuffer computeCommandEncoder];
-    
-    [encoder setComputePipelineState:renderer->pipelineState];
-    [encoder setTexture:renderer->outputTexture atIndex:0];
-    [encoder setBuffer:renderer->uniformBuffer offset:0 atIndex:0];
-    
-    MTLSize threadgroupSize = MTLSizeMake(8, 8, 1);
-    MTLSize threadgroupCount = MTLSizeMake(
-        (renderer->width + threadgroupSize.width - 1) / threadgroupSize.width,
-        (renderer->height + threadgroupSize.height - 1) / threadgroupSize.height,
-        1);
+    if (!slot.diagnosticsTexture || !slot.diagnosticsCounters) {
+      NSLog(@"Failed to allocate diagnostics targets at %dx%d, diagnostics view disabled",
+            renderer->width, renderer->height);
+      renderer->diagnosticsEnabled = false;
+      return false;
+    }
+  }
+  return true;
+}
+
+// Mean, p99 and maximum steps and the termination shares from a frame's counters
+static RayDiagnostics reduceDiagnostics(const uint32_t *counters, long frameIndex) {
+  RayDiagnostics result = {};
+  result.frameIndex = frameIndex;
+  uint64_t pixels = 0;
+  double steps = 0.0;
+  for (int bin = 0; bin < kDiagnosticStepBins; bin++) {
+    pixels += counters[bin];
+    steps += static_cast<double>(bin) * counters[bin];  // The last bin counts as its lower edge
+    if (counters[bin] > 0) result.maxSteps = bin;
+  }
+  if (pixels == 0) return result;
+
+  result.meanSteps = steps / pixels;
+  uint64_t rank = (pixels * 99 + 99) / 100;  // ceil(0.99 * pixels)
+  uint64_t seen = 0;
+  for (int bin = 0; bin < kDiagnosticStepBins; bin++) {
+    seen += counters[bin];
+    if (seen >= rank) {
+      result.p99Steps = bin;
+      break;
+    }
+  }
+  for (int i = 0; i < METAL_RT_TERMINATION_COUNT; i++) {
+    result.terminationFraction[i] = static_cast<double>(counters[kDiagnosticStepBins + i]) / pixels;
+  }
+  return result;
+}
+
+// Pick a free slot, encode the kernel into it and commit without waiting.
+// Blocks only while kMaxFramesInFlight frames are already on the GPU.
+// Returns the slot index, or -1 on error.
+// fullQuality (screenshots) traces the whole texture without foveation.
+// captureHDR also writes the linear color into hdrTexture (allocated by the caller).
+static int submitFrame(MetalRTRenderer *renderer, const CameraData *camera, float time,
+                       int colorMode, float colorIntensity, bool fullQuality, bool captureHDR = false) {
+  int savedViewportWidth = renderer->viewportWidth;
+  int savedViewportHeight = renderer->viewportHeight;
+  if (fullQuality) {
+    renderer->viewportWidth = renderer->width;
+    renderer->viewportHeight = renderer->height;
+  }
+
+  dispatch_semaphore_wait(renderer->inFlightSemaphore, DISPATCH_TIME_FOREVER);
+
+  int slotIndex = -1;
+  long frameIndex;
+  {
+    std::lock_guard<std::mutex> lock(renderer->slotMutex);
+    // Oldest slot that is neither on the GPU nor being displayed
+    for (int i = 0; i < kFrameSlots; i++) {
+      const FrameSlot &slot = renderer->slots[i];
+      if (slot.inFlight || i == renderer->displayedSlot) continue;
+      if (slotIndex < 0 || slot.frameIndex < renderer->slots[slotIndex].frameIndex) {
+        slotIndex = i;
+      }
+    }
+    if (slotIndex < 0) {
+      dispatch_semaphore_signal(renderer->inFlightSemaphore);
+      return -1;
+    }
+    frameIndex = renderer->nextFrameIndex++;
+    renderer->slots[slotIndex].inFlight = true;
+    renderer->slots[slotIndex].frameIndex = frameIndex;
+    renderer->slots[slotIndex].viewportWidth = renderer->viewportWidth;
+    renderer->slots[slotIndex].viewportHeight = renderer->viewportHeight;
+  }
+  FrameSlot &slot = renderer->slots[slotIndex];
+
+  // Uniforms are copied into the command buffer at encode time
+  Uniforms uniforms = {};
+  writeUniforms(renderer, &uniforms, camera, time, colorMode, colorIntensity);
+  bool diagnostics = renderer->diagnosticsEnabled && ensureDiagnosticsTargets(renderer);
+  slot.diagnostics = diagnostics;
+  uniforms.diagnostics = diagnostics ? 1 : 0;
+  // The foveation kernels classify tiles with Schwarzschild traces
+  bool foveated = !fullQuality && !diagnostics && renderer->foveationEnabled && renderer->coarsePipelineState &&
+                  renderer->spin == 0.0f && ensureFoveationTargets(renderer);
+  // Screenshots neither accumulate nor reset the running mean (they trace the full texture)
+  bool repeated = false;
+  int accumulationIndex = fullQuality ? -1
+                                      : prepareAccumulation(renderer, camera, time, colorMode, colorIntensity,
+                                                            diagnostics, foveated, repeated);
+  uniforms.accumulationIndex = accumulationIndex;
+  // Nothing to trace when the frame repeats the one in radiance (converged or
+  // not refining): exposure and bloom changes only re-run the post chain
+  bool postOnly = repeated && renderer->radianceValid && !diagnostics &&
+                  (accumulationIndex < 0 || accumulationIndex >= kMaxAccumulationSamples);
+  renderer->radianceValid = !fullQuality;
+  bool writeCache = false;
+  bool shadeFromCache =
+      !postOnly && prepareGeodesicCache(renderer, camera, foveated || accumulationIndex >= 0, writeCache);
+  renderer->viewportWidth = savedViewportWidth;
+  renderer->viewportHeight = savedViewportHeight;
+  uniforms.writeCache = writeCache ? 1 : 0;
+  captureHDR = captureHDR && !diagnostics && !foveated && renderer->hdrTexture != nil;
+  uniforms.captureHDR = captureHDR ? 1 : 0;
+
+  if (renderer->verbose && (colorMode != renderer->loggedColorMode || frameIndex % 60 == 0)) {
+    NSLog(@"Metal frame %ld: colorMode=%d (was %d), colorIntensity=%.2f, time=%.2f", frameIndex,
+          uniforms.colorMode, renderer->loggedColorMode, uniforms.colorIntensity, uniforms.time);
+    renderer->loggedColorMode = colorMode;
+  }
+
+  // Create command buffer
+  id<MTLCommandBuffer> commandBuffer = [renderer->commandQueue commandBuffer];
+  if (diagnostics) {
+    id<MTLBlitCommandEncoder> clearEncoder = [commandBuffer blitCommandEncoder];
+    [clearEncoder fillBuffer:slot.diagnosticsCounters range:NSMakeRange(0, slot.diagnosticsCounters.length) value:0];
+    [clearEncoder endEncoding];
+  }
+  id<MTLComputeCommandEncoder> encoder =
+      [commandBuffer computeCommandEncoder];
+
+  MTLSize threadgroupSize = MTLSizeMake(8, 8, 1);
+  [encoder setTexture:renderer->radiance atIndex:0];
+  [encoder setTexture:renderer->lutRadius atIndex:1];
+  [encoder setTexture:renderer->lutAngle atIndex:2];
+  [encoder setTexture:renderer->lutBranch atIndex:3];
+  [encoder setTexture:renderer->diskProfile atIndex:6];
+  [encoder setTexture:renderer->blackbody atIndex:7];
+  [encoder setTexture:renderer->sky atIndex:8];
+  [encoder setBytes:&uniforms length:sizeof(Uniforms) atIndex:0];
+
+  if (postOnly) {
+    // radiance already holds this frame
+  } else if (foveated) {
+    // Coarse rays and tile flags; dispatches in one (serial) encoder run in order
+    int tilesX = (slot.viewportWidth + kFoveaTile - 1) / kFoveaTile;
+    int tilesY = (slot.viewportHeight + kFoveaTile - 1) / kFoveaTile;
+    [encoder setTexture:renderer->coarseRays atIndex:4];
+    [encoder setTexture:renderer->tileFlags atIndex:5];
+
+    [encoder setComputePipelineState:renderer->coarsePipelineState];
+    [encoder dispatchThreadgroups:threadgroupsFor(tilesX, tilesY, threadgroupSize)
+            threadsPerThreadgroup:threadgroupSize];
+    [encoder setComputePipelineState:renderer->classifyPipelineState];
+    [encoder dispatchThreadgroups:threadgroupsFor(tilesX, tilesY, threadgroupSize)
+            threadsPerThreadgroup:threadgroupSize];
+    [encoder setComputePipelineState:renderer->foveatedPipelineState];
+  } else {
+    bool cacheBound = shadeFromCache || writeCache;
+    [encoder setComputePipelineState:framePipeline(renderer, colorMode, shadeFromCache)];
+    [encoder setBuffer:cacheBound ? renderer->geodesicCache : renderer->placeholderCache offset:0 atIndex:1];
+    [encoder setTexture:diagnostics ? slot.diagnosticsTexture : renderer->placeholderDiagnostics atIndex:4];
+    [encoder setBuffer:diagnostics ? slot.diagnosticsCounters : renderer->placeholderCache offset:0 atIndex:2];
+    [encoder setTexture:captureHDR ? renderer->hdrTexture : renderer->placeholderDiagnostics atIndex:5];
+    [encoder setBuffer:accumulationIndex >= 0 ? renderer->accumulation : renderer->placeholderCache offset:0 atIndex:3];
+  }
+
+  // Dispatch threads, then the post chain into the slot's output
+  if (!postOnly) {
+    [encoder dispatchThreadgroups:threadgroupsFor(slot.viewportWidth, slot.viewportHeight, threadgroupSize)
+            threadsPerThreadgroup:threadgroupSize];
+  }
+  encodePostChain(renderer, encoder, slot.outputTexture, slot.viewportWidth, slot.viewportHeight, diagnostics);
+  [encoder endEncoding];
+
+  // Release the slot from the GPU side; the CPU never waits here
+  [commandBuffer addCompletedHandler:^(id<MTLCommandBuffer> completed) {
+    // Check for errors
+    if (completed.error) {
+      NSLog(@"Command buffer error: %@", completed.error);
+    }
+    {
+      std::lock_guard<std::mutex> lock(renderer->slotMutex);
+      FrameSlot &completedSlot = renderer->slots[slotIndex];
+      if (completedSlot.diagnostics && !completed.error) {
+        renderer->latestDiagnostics = reduceDiagnostics(
+            static_cast<const uint32_t *>([completedSlot.diagnosticsCounters contents]), completedSlot.frameIndex);
+        renderer->diagnosticsValid = true;
+      }
+      completedSlot.inFlight = false;
+      // Feeds the dynamic quality controller
+      renderer->lastGPUTimeMs = (completed.GPUEndTime - completed.GPUStartTime) * 1000.0;
+    }
+    dispatch_semaphore_signal(renderer->inFlightSemaphore);
+  }];
+
+  slot.commandBuffer = commandBuffer;
+  [commandBuffer commit];
+  return slotIndex;
+}
+
+long metal_rt_renderer_begin_frame(MetalRTRenderer *renderer,
+                                   const CameraData *camera, float time, int colorMode, float colorIntensity) {
+  if (!renderer || !camera) return -1;
+  @autoreleasepool {
+    int slotIndex = submitFrame(renderer, camera, time, colorMode, colorIntensity, false);
+    return slotIndex < 0 ? -1 : renderer->slots[slotIndex].frameIndex;
+  }
+}
+
+long metal_rt_renderer_acquire_completed(MetalRTRenderer *renderer) {
+  if (!renderer) return -1;
+
+  std::lock_guard<std::mutex> lock(renderer->slotMutex);
+  long displayedFrame = renderer->displayedSlot >= 0
+                            ? renderer->slots[renderer->displayedSlot].frameIndex
+                            : -1;
+  // Newest finished frame that is newer than the one already displayed
+  int newest = -1;
+  for (int i = 0; i < kFrameSlots; i++) {
+    const FrameSlot &slot = renderer->slots[i];
+    if (slot.inFlight || slot.frameIndex <= displayedFrame) continue;
+    if (newest < 0 || slot.frameIndex > renderer->slots[newest].frameIndex) {
+      newest = i;
+    }
+  }
+  if (newest >= 0) {
+    renderer->displayedSlot = newest;
+    renderer->outputTexture = renderer->slots[newest].outputTexture;
+    renderer->displayedWidth = renderer->slots[newest].viewportWidth;
+    renderer->displayedHeight = renderer->slots[newest].viewportHeight;
+    renderer->pixelsDirty = true;
+    displayedFrame = renderer->slots[newest].frameIndex;
+  }
+  return displayedFrame;
+}
+
+// Make a finished slot the displayed frame, unless it has been reused for a
+// newer frame since `frameIndex` was submitted
+static bool latchSlot(MetalRTRenderer *renderer, int slotIndex, long frameIndex) {
+  std::lock_guard<std::mutex> lock(renderer->slotMutex);
+  FrameSlot &slot = renderer->slots[slotIndex];
+  if (slot.frameIndex != frameIndex) {
+    return false;
+  }
+  renderer->displayedSlot = slotIndex;
+  renderer->outputTexture = slot.outputTexture;
+  renderer->displayedWidth = slot.viewportWidth;
+  renderer->displayedHeight = slot.viewportHeight;
+  renderer->pixelsDirty = true;
+  return true;
+}
+
+bool metal_rt_renderer_display_frame(MetalRTRenderer *renderer, long frameIndex) {
+  if (!renderer || frameIndex < 0) return false;
+
+  int slotIndex = -1;
+  id<MTLCommandBuffer> commandBuffer = nil;
+  {
+    std::lock_guard<std::mutex> lock(renderer->slotMutex);
+    for (int i = 0; i < kFrameSlots; i++) {
+      if (renderer->slots[i].frameIndex == frameIndex) {
+        slotIndex = i;
+        commandBuffer = renderer->slots[i].commandBuffer;
+        break;
+      }
+    }
+  }
+  if (slotIndex < 0 || !commandBuffer) {
+    return false;  // Never submitted, or its slot has been reused
+  }
+
+  [commandBuffer waitUntilCompleted];
+  if (commandBuffer.status != MTLCommandBufferStatusCompleted) {
+    NSLog(@"Frame %ld failed: %@", frameIndex, commandBuffer.error);
+    return false;
+  }
+
+  return latchSlot(renderer, slotIndex, frameIndex);
+}
+
+void metal_rt_renderer_render(MetalRTRenderer *renderer,
+                              const CameraData *camera, float time, int colorMode, float colorIntensity) {
+  @autoreleasepool {
+    // Synchronous render: submit, wait for this frame and latch it for display
+    int slotIndex = submitFrame(renderer, camera, time, colorMode, colorIntensity, false);
+    if (slotIndex < 0) return;
+
+    // Commit and wait - this ensures the frame is fully rendered
+    long frameIndex = renderer->slots[slotIndex].frameIndex;
+    [renderer->slots[slotIndex].commandBuffer waitUntilCompleted];
     
-    [encoder dispatchThreadgroups:threadgroupCount threadsPerThreadgroup:threadgroupSize];
-    [encoder endEncoding];
+    // Time verification removed for performance
+
+    // No readback here: the frame stays on the GPU until a caller actually
+    // needs pixels (metal_rt_renderer_get_pixels for screenshots/recording
+    // or the SDL texture fallback). Presentation uses metal_rt_renderer_present.
+    // Latch this slot directly: the completed handler that clears inFlight may
+    // not have run yet, so acquire_completed could pick an older frame
+    latchSlot(renderer, slotIndex, frameIndex);
+
+    // Pixel debug logging removed for performance
+  }
+}
+
+const void *metal_rt_renderer_get_pixels(MetalRTRenderer *renderer) {
+  if (!renderer->outputTexture) {
+    return nullptr;  // Nothing has completed yet
+  }
+  if (renderer->pixelsDirty) {
+    readBackPixels(renderer, renderer->pixelData);
+    renderer->pixelsDirty = false;
+  }
+  return renderer->pixelData.data();
+}
+
+// Build (or rebuild for a new drawable format) the fullscreen-triangle pipeline
+// used to draw the output texture into a CAMetalLayer drawable
+static bool ensurePresentPipeline(MetalRTRenderer *renderer, MTLPixelFormat pixelFormat) {
+  if (renderer->presentPipeline && renderer->presentPixelFormat == pixelFormat) {
+    return true;
+  }
+
+  id<MTLFunction> vertexFunction = [renderer->library newFunctionWithName:@"present_vertex"];
+  id<MTLFunction> fragmentFunction = [renderer->library newFunctionWithName:@"present_fragment"];
+  if (!vertexFunction || !fragmentFunction) {
+    NSLog(@"Failed to find presentation shader functions");
+    return false;
+  }
+
+  MTLRenderPipelineDescriptor *desc = [[MTLRenderPipelineDescriptor alloc] init];
+  desc.vertexFunction = vertexFunction;
+  desc.fragmentFunction = fragmentFunction;
+  desc.colorAttachments[0].pixelFormat = pixelFormat;
+
+  NSError *error = nil;
+  renderer->presentPipeline = [renderer->device newRenderPipelineStateWithDescriptor:desc
+                                                                               error:&error];
+  if (!renderer->presentPipeline) {
+    NSLog(@"Failed to create presentation pipeline: %@", error);
+    renderer->presentPixelFormat = MTLPixelFormatInvalid;
+    return false;
+  }
+  renderer->presentPixelFormat = pixelFormat;
+
+  if (!renderer->presentSampler) {
+    MTLSamplerDescriptor *samplerDesc = [[MTLSamplerDescriptor alloc] init];
+    samplerDesc.minFilter = MTLSamplerMinMagFilterLinear;
+    samplerDesc.magFilter = MTLSamplerMinMagFilterLinear;
+    samplerDesc.sAddressMode = MTLSamplerAddressModeClampToEdge;
+    samplerDesc.tAddressMode = MTLSamplerAddressModeClampToEdge;
+    renderer->presentSampler = [renderer->device newSamplerStateWithDescriptor:samplerDesc];
+  }
+  return true;
+}
+
+bool metal_rt_renderer_present(MetalRTRenderer *renderer, void *renderEncoder, void *metalLayer,
+                               int x, int y, int w, int h) {
+  if (!renderer || !renderEncoder || !metalLayer || w <= 0 || h <= 0) return false;
+
+  @autoreleasepool {
+    if (!renderer->outputTexture) {
+      return false;  // Nothing has completed yet
+    }
+    CAMetalLayer *layer = (__bridge CAMetalLayer *)metalLayer;
+    // The drawable must live on our device, otherwise the texture can't be sampled
+    if (layer.device && layer.device != renderer->device) {
+      return false;
+    }
+    if (!ensurePresentPipeline(renderer, layer.pixelFormat)) {
+      return false;
+    }
+
+    id<MTLRenderCommandEncoder> encoder = (__bridge id<MTLRenderCommandEncoder>)renderEncoder;
+    MTLViewport viewport = {static_cast<double>(x), static_cast<double>(y),
+                            static_cast<double>(w), static_cast<double>(h), 0.0, 1.0};
+    [encoder setViewport:viewport];
+    [encoder setRenderPipelineState:renderer->presentPipeline];
+    [encoder setFragmentTexture:renderer->outputTexture atIndex:0];
+    [encoder setFragmentSamplerState:renderer->presentSampler atIndex:0];
+    float uvScale[2] = {static_cast<float>(renderer->displayedWidth) / renderer->width,
+                        static_cast<float>(renderer->displayedHeight) / renderer->height};
+    [encoder setFragmentBytes:uvScale length:sizeof(uvScale) atIndex:0];
+    [encoder drawPrimitives:MTLPrimitiveTypeTriangle vertexStart:0 vertexCount:3];
+    return true;
+  }
+}
+
+// Lazily create the NV12 conversion pipeline and the CVPixelBuffer -> MTLTexture cache
+static bool ensureNV12Pipeline(MetalRTRenderer *renderer) {
+  if (renderer->nv12PipelineState && renderer->textureCache && renderer->conversionQueue) {
+    return true;
+  }
+
+  id<MTLFunction> function = [renderer->library newFunctionWithName:@"bgra_to_nv12"];
+  if (!function) {
+    NSLog(@"Failed to find bgra_to_nv12 kernel");
+    return false;
+  }
+  NSError *error = nil;
+  renderer->nv12PipelineState = [renderer->device newComputePipelineStateWithFunction:function error:&error];
+  if (!renderer->nv12PipelineState) {
+    NSLog(@"Failed to create NV12 conversion pipeline: %@", error);
+    return false;
+  }
+
+  if (CVMetalTextureCacheCreate(kCFAllocatorDefault, nullptr, renderer->device, nullptr,
+                                &renderer->textureCache) != kCVReturnSuccess) {
+    NSLog(@"Failed to create CVMetalTextureCache");
+    renderer->textureCache = nullptr;
+    return false;
+  }
+
+  // The converted frame has already completed, so it needs no ordering against
+  // the frames still being traced on the main queue
+  renderer->conversionQueue = [renderer->device newCommandQueue];
+  return renderer->conversionQueue != nil;
+}
+
+// Wrap one plane of an IOSurface-backed pixel buffer as a Metal texture (no copy)
+static id<MTLTexture> texturePlane(MetalRTRenderer *renderer, CVPixelBufferRef pixelBuffer, size_t plane,
+                                   MTLPixelFormat format, CVMetalTextureRef *textureRef) {
+  size_t width = CVPixelBufferGetWidthOfPlane(pixelBuffer, plane);
+  size_t height = CVPixelBufferGetHeightOfPlane(pixelBuffer, plane);
+  if (CVMetalTextureCacheCreateTextureFromImage(kCFAllocatorDefault, renderer->textureCache, pixelBuffer,
+                                                nullptr, format, width, height, plane,
+                                                textureRef) != kCVReturnSuccess) {
+    *textureRef = nullptr;
+    return nil;
+  }
+  return CVMetalTextureGetTexture(*textureRef);
+}
+
+bool metal_rt_renderer_convert_to_nv12(MetalRTRenderer *renderer, void *pixelBuffer) {
+  if (!renderer || !pixelBuffer || !renderer->outputTexture) return false;
+
+  @autoreleasepool {
+    CVPixelBufferRef buffer = static_cast<CVPixelBufferRef>(pixelBuffer);
+    OSType format = CVPixelBufferGetPixelFormatType(buffer);
+    if (format != kCVPixelFormatType_420YpCbCr8BiPlanarVideoRange || !CVPixelBufferGetIOSurface(buffer)) {
+      NSLog(@"NV12 conversion needs an IOSurface-backed 420v pixel buffer");
+      return false;
+    }
+    if (!ensureNV12Pipeline(renderer)) {
+      return false;
+    }
+
+    CVMetalTextureRef lumaRef = nullptr;
+    CVMetalTextureRef chromaRef = nullptr;
+    id<MTLTexture> luma = texturePlane(renderer, buffer, 0, MTLPixelFormatR8Unorm, &lumaRef);
+    id<MTLTexture> chroma = texturePlane(renderer, buffer, 1, MTLPixelFormatRG8Unorm, &chromaRef);
+    bool ok = luma && chroma;
+
+    if (ok) {
+      id<MTLCommandBuffer> commandBuffer = [renderer->conversionQueue commandBuffer];
+      id<MTLComputeCommandEncoder> encoder = [commandBuffer computeCommandEncoder];
+      [encoder setComputePipelineState:renderer->nv12PipelineState];
+      [encoder setTexture:renderer->outputTexture atIndex:0];
+      [encoder setTexture:luma atIndex:1];
+      [encoder setTexture:chroma atIndex:2];
+      float uvScale[2] = {static_cast<float>(renderer->displayedWidth) / renderer->width,
+                          static_cast<float>(renderer->displayedHeight) / renderer->height};
+      [encoder setBytes:uvScale length:sizeof(uvScale) atIndex:0];
+      MTLSize threadgroupSize = MTLSizeMake(8, 8, 1);
+      [encoder dispatchThreadgroups:threadgroupsFor(static_cast<int>(chroma.width), static_cast<int>(chroma.height),
+                                                    threadgroupSize)
+              threadsPerThreadgroup:threadgroupSize];
+      [encoder endEncoding];
+      [commandBuffer commit];
+
+      // The encoder reads the IOSurface as soon as the frame is handed over
+      [commandBuffer waitUntilCompleted];
+      if (commandBuffer.error) {
+        NSLog(@"NV12 conversion failed: %@", commandBuffer.error);
+        ok = false;
+      }
+    } else {
+      NSLog(@"Failed to map pixel buffer planes as Metal textures");
+    }
+
+    if (lumaRef) CFRelease(lumaRef);
+    if (chromaRef) CFRelease(chromaRef);
+    CVMetalTextureCacheFlush(renderer->textureCache, 0);
+    return ok;
+  }
+}
+
+bool metal_rt_renderer_render_and_present(MetalRTRenderer *renderer,
+                                          const CameraData *camera, float time, int colorMode, float colorIntensity,
+                                          void *renderEncoder, void *metalLayer,
+                                          int x, int y, int w, int h) {
+  if (!renderer) return false;
+  metal_rt_renderer_render(renderer, camera, time, colorMode, colorIntensity);
+  return metal_rt_renderer_present(renderer, renderEncoder, metalLayer, x, y, w, h);
+}
+
+// Render and get pixels atomically - ensures we get fresh pixels with correct color mode
+const void *metal_rt_renderer_render_and_get_pixels(MetalRTRenderer *renderer,
+                                                     const CameraData *camera, float time, int colorMode, float colorIntensity) {
+  if (!renderer) return nullptr;
+  
+  @autoreleasepool {
+    // Submit at full size/quality and wait for completion. The uniforms travel
+    // inside the command buffer, so the frame always sees this call's colorMode
+    int slotIndex = submitFrame(renderer, camera, time, colorMode, colorIntensity, true);
+    if (slotIndex < 0) return nullptr;
+    FrameSlot &slot = renderer->slots[slotIndex];
+    [slot.commandBuffer waitUntilCompleted];
     
-    // Commit and WAIT for completion - critical for screenshots
+    // The screenshot frame becomes the displayed frame (latched directly, as
+    // its completed handler may still be pending)
+    latchSlot(renderer, slotIndex, slot.frameIndex);
+    
+    // Read pixels directly from texture (fresh data, already BGRA - no swizzle)
+    readBackPixels(renderer, renderer->screenshotBuffer);
+    if (renderer->verbose) {
+      const uint8_t *bgra = renderer->screenshotBuffer.data();
+      NSLog(@"Screenshot frame %ld: colorMode=%d, first pixel BGRA: B=%d G=%d R=%d", slot.frameIndex, colorMode,
+            bgra[0], bgra[1], bgra[2]);
+    }
+    return renderer->screenshotBuffer.data();
+  }
+}
+
+// Allocate the HDR capture target at the render size
+static bool ensureHDRTarget(MetalRTRenderer *renderer) {
+  if (renderer->hdrTexture) {
+    return true;
+  }
+  MTLTextureDescriptor *desc = [MTLTextureDescriptor texture2DDescriptorWithPixelFormat:MTLPixelFormatRGBA32Float
+                                                                                   width:renderer->width
+                                                                                  height:renderer->height
+                                                                               mipmapped:NO];
+  desc.usage = MTLTextureUsageShaderWrite;
+  desc.storageMode = MTLStorageModePrivate;  // Only ever copied into a capture's staging buffer
+  renderer->hdrTexture = [renderer->device newTextureWithDescriptor:desc];
+  if (!renderer->hdrTexture) {
+    NSLog(@"Failed to allocate %dx%d HDR capture target", renderer->width, renderer->height);
+    return false;
+  }
+  return true;
+}
+
+// Reuse a staging buffer if it is large enough
+static id<MTLBuffer> stagingBuffer(MetalRTRenderer *renderer, id<MTLBuffer> buffer, NSUInteger length) {
+  if (buffer && buffer.length >= length) {
+    return buffer;
+  }
+  return [renderer->device newBufferWithLength:length options:MTLResourceStorageModeShared];
+}
+
+// Reserve a free capture slot; -1 if every staging buffer is held
+static int acquireCaptureSlot(MetalRTRenderer *renderer, long &captureId) {
+  std::lock_guard<std::mutex> lock(renderer->captureMutex);
+  for (int i = 0; i < kCaptureSlots; i++) {
+    CaptureSlot &capture = renderer->captures[i];
+    if (!capture.inUse) {
+      captureId = renderer->nextCaptureId++;
+      capture.inUse = true;
+      capture.captureId = captureId;
+      capture.copyCommandBuffer = nil;
+      return i;
+    }
+  }
+  return -1;
+}
+
+long metal_rt_renderer_begin_capture(MetalRTRenderer *renderer, const CameraData *camera, float time,
+                                     int colorMode, float colorIntensity, bool hdr) {
+  if (!renderer || !camera) return -1;
+
+  @autoreleasepool {
+    long captureId;
+    int captureIndex = acquireCaptureSlot(renderer, captureId);
+    if (captureIndex < 0) {
+      return -1;
+    }
+    CaptureSlot &capture = renderer->captures[captureIndex];
+
+    int width = renderer->width;
+    int height = renderer->height;
+    NSUInteger bytesPerRow = static_cast<NSUInteger>(width) * 4;
+    NSUInteger hdrBytesPerRow = static_cast<NSUInteger>(width) * sizeof(float) * 4;
+    hdr = hdr && !renderer->diagnosticsEnabled && ensureHDRTarget(renderer);
+    capture.pixels = stagingBuffer(renderer, capture.pixels, bytesPerRow * height);
+    if (hdr) {
+      capture.hdrPixels = stagingBuffer(renderer, capture.hdrPixels, hdrBytesPerRow * height);
+    }
+    if (!capture.pixels || (hdr && !capture.hdrPixels)) {
+      NSLog(@"Failed to allocate %dx%d capture staging buffers", width, height);
+      metal_rt_renderer_release_capture(renderer, captureId);
+      return -1;
+    }
+
+    // Full-size frame; the copy is queued right behind it, so later frames
+    // can't overwrite the slot or the HDR target before it has been copied
+    int slotIndex = submitFrame(renderer, camera, time, colorMode, colorIntensity, true, hdr);
+    if (slotIndex < 0) {
+      metal_rt_renderer_release_capture(renderer, captureId);
+      return -1;
+    }
+    id<MTLCommandBuffer> commandBuffer = [renderer->commandQueue commandBuffer];
+    id<MTLBlitCommandEncoder> blit = [commandBuffer blitCommandEncoder];
+    [blit copyFromTexture:renderer->slots[slotIndex].outputTexture
+                     sourceSlice:0
+                     sourceLevel:0
+                    sourceOrigin:MTLOriginMake(0, 0, 0)
+                      sourceSize:MTLSizeMake(width, height, 1)
+                        toBuffer:capture.pixels
+               destinationOffset:0
+          destinationBytesPerRow:bytesPerRow
+        destinationBytesPerImage:bytesPerRow * height];
+    if (hdr) {
+      [blit copyFromTexture:renderer->hdrTexture
+                       sourceSlice:0
+                       sourceLevel:0
+                      sourceOrigin:MTLOriginMake(0, 0, 0)
+                        sourceSize:MTLSizeMake(width, height, 1)
+                          toBuffer:capture.hdrPixels
+                 destinationOffset:0
+            destinationBytesPerRow:hdrBytesPerRow
+          destinationBytesPerImage:hdrBytesPerRow * height];
+    }
+    [blit endEncoding];
     [commandBuffer commit];
+
+    std::lock_guard<std::mutex> lock(renderer->captureMutex);
+    capture.copyCommandBuffer = commandBuffer;
+    capture.hdr = hdr;
+    capture.width = width;
+    capture.height = height;
+    return captureId;
+  }
+}
+
+long metal_rt_renderer_begin_readback(MetalRTRenderer *renderer, int width, int height) {
+  if (!renderer || !renderer->outputTexture || width <= 0 || height <= 0) return -1;
+
+  @autoreleasepool {
+    if (!renderer->resamplePipelineState) {
+      id<MTLFunction> function = [renderer->library newFunctionWithName:@"bgra_resample"];
+      NSError *error = nil;
+      renderer->resamplePipelineState =
+          function ? [renderer->device newComputePipelineStateWithFunction:function error:&error] : nil;
+      if (!renderer->resamplePipelineState) {
+        NSLog(@"Failed to create recording readback pipeline: %@", error);
+        return -1;
+      }
+    }
+
+    long captureId;
+    int captureIndex = acquireCaptureSlot(renderer, captureId);
+    if (captureIndex < 0) {
+      return -1;
+    }
+    CaptureSlot &capture = renderer->captures[captureIndex];
+    NSUInteger bytesPerRow = static_cast<NSUInteger>(width) * 4;
+    capture.pixels = stagingBuffer(renderer, capture.pixels, bytesPerRow * height);
+    if (!capture.pixels) {
+      NSLog(@"Failed to allocate %dx%d readback staging buffer", width, height);
+      metal_rt_renderer_release_capture(renderer, captureId);
+      return -1;
+    }
+
+    // Same queue as the frames: the displayed slot can't be traced over before
+    // this has read it, and nothing here waits for the GPU
+    id<MTLCommandBuffer> commandBuffer = [renderer->commandQueue commandBuffer];
+    id<MTLComputeCommandEncoder> encoder = [commandBuffer computeCommandEncoder];
+    [encoder setComputePipelineState:renderer->resamplePipelineState];
+    [encoder setTexture:renderer->outputTexture atIndex:0];
+    [encoder setBuffer:capture.pixels offset:0 atIndex:0];
+    float uvScale[2] = {static_cast<float>(renderer->displayedWidth) / renderer->width,
+                        static_cast<float>(renderer->displayedHeight) / renderer->height};
+    uint32_t size[2] = {static_cast<uint32_t>(width), static_cast<uint32_t>(height)};
+    [encoder setBytes:uvScale length:sizeof(uvScale) atIndex:1];
+    [encoder setBytes:size length:sizeof(size) atIndex:2];
+    MTLSize threadgroupSize = MTLSizeMake(8, 8, 1);
+    [encoder dispatchThreadgroups:threadgroupsFor(width, height, threadgroupSize)
+            threadsPerThreadgroup:threadgroupSize];
+    [encoder endEncoding];
+    [commandBuffer commit];
+
+    std::lock_guard<std::mutex> lock(renderer->captureMutex);
+    capture.copyCommandBuffer = commandBuffer;
+    capture.hdr = false;
+    capture.width = width;
+    capture.height = height;
+    return captureId;
+  }
+}
+
+bool metal_rt_renderer_capture_ready(MetalRTRenderer *renderer, long captureId) {
+  if (!renderer) return true;
+  std::lock_guard<std::mutex> lock(renderer->captureMutex);
+  for (int i = 0; i < kCaptureSlots; i++) {
+    const CaptureSlot &capture = renderer->captures[i];
+    if (capture.inUse && capture.captureId == captureId) {
+      if (!capture.copyCommandBuffer) return true;  // Nothing queued, finish_capture fails at once
+      MTLCommandBufferStatus status = capture.copyCommandBuffer.status;
+      return status == MTLCommandBufferStatusCompleted || status == MTLCommandBufferStatusError;
+    }
+  }
+  return true;  // Unknown or released: finish_capture won't wait either
+}
+
+bool metal_rt_renderer_finish_capture(MetalRTRenderer *renderer, long captureId, MetalRTCapture *result) {
+  if (!renderer || !result) return false;
+
+  id<MTLCommandBuffer> commandBuffer = nil;
+  CaptureSlot *capture = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(renderer->captureMutex);
+    for (int i = 0; i < kCaptureSlots; i++) {
+      if (renderer->captures[i].inUse && renderer->captures[i].captureId == captureId) {
+        capture = &renderer->captures[i];
+        commandBuffer = capture->copyCommandBuffer;
+        break;
+      }
+    }
+  }
+  if (!capture || !commandBuffer) {
+    return false;
+  }
+
+  // The copy waits for the frame itself (same queue)
+  [commandBuffer waitUntilCompleted];
+  if (commandBuffer.status != MTLCommandBufferStatusCompleted) {
+    NSLog(@"Capture %ld failed: %@", captureId, commandBuffer.error);
+    return false;
+  }
+  result->pixels = [capture->pixels contents];
+  result->hdrPixels = capture->hdr ? static_cast<const float *>([capture->hdrPixels contents]) : nullptr;
+  result->width = capture->width;
+  result->height = capture->height;
+  result->bytesPerRow = static_cast<size_t>(capture->width) * 4;
+  result->hdrBytesPerRow = static_cast<size_t>(capture->width) * sizeof(float) * 4;
+  return true;
+}
+
+void metal_rt_renderer_release_capture(MetalRTRenderer *renderer, long captureId) {
+  if (!renderer) return;
+  std::lock_guard<std::mutex> lock(renderer->captureMutex);
+  for (int i = 0; i < kCaptureSlots; i++) {
+    CaptureSlot &capture = renderer->captures[i];
+    if (capture.inUse && capture.captureId == captureId) {
+      // A copy still queued only writes the staging buffer, which the next
+      // capture overwrites again behind it on the same queue
+      capture.inUse = false;
+      capture.captureId = -1;
+      capture.copyCommandBuffer = nil;
+    }
+  }
+}
+
+// Grow the offline tile targets to hold a width x height tile
+static bool ensureTileTargets(MetalRTRenderer *renderer, int width, int height) {
+  if (renderer->tileOutput && width <= renderer->tileCapacityWidth && height <= renderer->tileCapacityHeight) {
+    return true;
+  }
+  width = std::max(width, renderer->tileCapacityWidth);
+  height = std::max(height, renderer->tileCapacityHeight);
+  renderer->tileAccumulation = [renderer->device newBufferWithLength:(NSUInteger)width * height * sizeof(float) * 4
+                                                             options:MTLResourceStorageModePrivate];
+  renderer->tileOutput = createOutputTexture(renderer->device, width, height);
+  if (!renderer->tileAccumulation || !renderer->tileOutput) {
+    NSLog(@"Failed to allocate %dx%d tile targets", width, height);
+    renderer->tileAccumulation = nil;
+    renderer->tileOutput = nil;
+    renderer->tileCapacityWidth = 0;
+    renderer->tileCapacityHeight = 0;
+    return false;
+  }
+  renderer->tileCapacityWidth = width;
+  renderer->tileCapacityHeight = height;
+  return true;
+}
+
+bool metal_rt_renderer_render_tile(MetalRTRenderer *renderer, const CameraData *camera, float time,
+                                   int colorMode, float colorIntensity, int imageWidth, int imageHeight,
+                                   int tileX, int tileY, int tileWidth, int tileHeight, int samples,
+                                   void *pixels) {
+  if (!renderer || !camera || !pixels || !renderer->tilePipelineState) return false;
+  if (tileWidth <= 0 || tileHeight <= 0 || samples <= 0 || tileX < 0 || tileY < 0 ||
+      tileX + tileWidth > imageWidth || tileY + tileHeight > imageHeight) {
+    NSLog(@"Invalid tile %dx%d at %d,%d for a %dx%d image", tileWidth, tileHeight, tileX, tileY,
+          imageWidth, imageHeight);
+    return false;
+  }
+
+  @autoreleasepool {
+    // Tiles never overlap the interactive frame ring
+    metal_rt_renderer_wait_idle(renderer);
+    if (!ensureTileTargets(renderer, tileWidth, tileHeight)) {
+      return false;
+    }
+
+    Uniforms uniforms = {};
+    writeUniforms(renderer, &uniforms, camera, time, colorMode, colorIntensity);
+    uniforms.resolution[0] = imageWidth;
+    uniforms.resolution[1] = imageHeight;
+    uniforms.writeCache = 0;
+
+    TileParams tile = {};
+    tile.origin[0] = tileX;
+    tile.origin[1] = tileY;
+    tile.size[0] = tileWidth;
+    tile.size[1] = tileHeight;
+    tile.exposure = renderer->exposure;
+
+    MTLSize threadgroupSize = MTLSizeMake(8, 8, 1);
+    MTLSize threadgroupCount = threadgroupsFor(tileWidth, tileHeight, threadgroupSize);
+
+    // One command buffer per pass keeps every submission short (GPU watchdog)
+    id<MTLCommandBuffer> commandBuffer = nil;
+    for (int s = 0; s < samples; s++) {
+      tile.sampleIndex = s;
+      commandBuffer = [renderer->commandQueue commandBuffer];
+      id<MTLComputeCommandEncoder> encoder = [commandBuffer computeCommandEncoder];
+      [encoder setComputePipelineState:renderer->tilePipelineState];
+      [encoder setTexture:renderer->lutRadius atIndex:1];
+      [encoder setTexture:renderer->lutAngle atIndex:2];
+      [encoder setTexture:renderer->lutBranch atIndex:3];
+      [encoder setTexture:renderer->diskProfile atIndex:6];
+      [encoder setTexture:renderer->blackbody atIndex:7];
+      [encoder setTexture:renderer->sky atIndex:8];
+      [encoder setBytes:&uniforms length:sizeof(Uniforms) atIndex:0];
+      [encoder setBytes:&tile length:sizeof(TileParams) atIndex:1];
+      [encoder setBuffer:renderer->tileAccumulation offset:0 atIndex:2];
+      [encoder dispatchThreadgroups:threadgroupCount threadsPerThreadgroup:threadgroupSize];
+
+      if (s == samples - 1) {
+        [encoder setComputePipelineState:renderer->resolvePipelineState];
+        [encoder setTexture:renderer->tileOutput atIndex:0];
+        [encoder dispatchThreadgroups:threadgroupCount threadsPerThreadgroup:threadgroupSize];
+      }
+      [encoder endEncoding];
+      [commandBuffer commit];
+    }
+
+    // Passes execute in submission order; the last one completes the tile
     [commandBuffer waitUntilCompleted];
-    
-    // Read pixels directly from texture (fresh data)
-    size_t bytesPerRow = renderer->width * 4;
-    size_t totalBytes = bytesPerRow * renderer->height;
-    
-    std::vector<uint8_t> tempBuffer(totalBytes);
-    [renderer->outputTexture getBytes:tempBuffer.data()
-                            bytesPerRow:bytesPerRow
-                         fromRegion:MTLRegionMake2D(0, 0, renderer->width, renderer->height)
+    if (commandBuffer.error) {
+      NSLog(@"Tile %d,%d failed: %@", tileX, tileY, commandBuffer.error);
+      return false;
+    }
+
+    [renderer->tileOutput getBytes:pixels
+                       bytesPerRow:tileWidth * 4
+                        fromRegion:MTLRegionMake2D(0, 0, tileWidth, tileHeight)
+                       mipmapLevel:0];
+    return true;
+  }
+}
+
+void metal_rt_renderer_set_trace_mode(MetalRTRenderer *renderer, int traceMode) {
+  if (!renderer) return;
+  if (traceMode < 0 || traceMode >= METAL_RT_TRACE_MODE_COUNT) {
+    NSLog(@"Ignoring unknown trace mode %d", traceMode);
+    return;
+  }
+  // The background LUT build takes a few tens of milliseconds at most
+  if (traceMode == METAL_RT_TRACE_GEODESIC_LUT && !ensureGeodesicLUT(renderer, true)) {
+    NSLog(@"Geodesic LUT unavailable, keeping trace mode %d", renderer->traceMode);
+    return;
+  }
+  renderer->traceMode = traceMode;
+}
+
+void metal_rt_renderer_set_integrator_tolerance(MetalRTRenderer *renderer, float tolerance) {
+  if (!renderer || !isfinite(tolerance)) return;
+  renderer->integratorTolerance = std::clamp(tolerance, 1e-7f, 1e-3f);
+  // Cached crossings were traced with the old tolerance
+  renderer->geodesicCacheValid = false;
+}
+
+bool metal_rt_renderer_set_spin(MetalRTRenderer *renderer, float spin, int colorMode) {
+  if (!renderer || !isfinite(spin)) return false;
+  spin = std::clamp(spin, -kMaxSpin, kMaxSpin);
+  if (spin != 0.0f) {
+    if (colorMode < 0 || colorMode >= kColorModes) return false;
+    // Kerr variants are compiled with the others at startup (cold launch: ~ a
+    // second). Give them a moment, but never hold the UI thread until they land
+    bool compiling = dispatch_group_wait(renderer->variantGroup,
+                                         dispatch_time(DISPATCH_TIME_NOW, kSpinVariantWaitMs * NSEC_PER_MSEC)) != 0;
+    std::lock_guard<std::mutex> lock(renderer->variantMutex);
+    if (!renderer->kerrVariants[colorMode]) {
+      NSLog(@"Kerr pipeline for palette %d %s, keeping spin %.3f", colorMode,
+            compiling ? "is still compiling" : "failed to compile", renderer->spin);
+      return false;
+    }
+  }
+  renderer->spin = spin;
+  return true;
+}
+
+void metal_rt_renderer_set_viewport(MetalRTRenderer *renderer, int width, int height) {
+  if (!renderer) return;
+  renderer->viewportWidth = std::clamp(width, 1, renderer->width);
+  renderer->viewportHeight = std::clamp(height, 1, renderer->height);
+}
+
+void metal_rt_renderer_get_displayed_size(MetalRTRenderer *renderer, int *width, int *height) {
+  if (!renderer) return;
+  if (width) *width = renderer->displayedWidth;
+  if (height) *height = renderer->displayedHeight;
+}
+
+double metal_rt_renderer_get_gpu_time_ms(MetalRTRenderer *renderer) {
+  if (!renderer) return 0.0;
+  std::lock_guard<std::mutex> lock(renderer->slotMutex);
+  return renderer->lastGPUTimeMs;
+}
+
+void metal_rt_renderer_set_verbose(MetalRTRenderer *renderer, bool enabled) {
+  if (!renderer) return;
+  renderer->verbose = enabled;
+}
+
+bool metal_rt_renderer_set_foveation(MetalRTRenderer *renderer, bool enabled) {
+  if (!renderer) return false;
+  renderer->foveationEnabled = enabled && renderer->coarsePipelineState;
+  if (!renderer->foveationEnabled) {
+    renderer->coarseRays = nil;
+    renderer->tileFlags = nil;
+  }
+  return renderer->foveationEnabled == enabled;
+}
+
+bool metal_rt_renderer_load_skybox(MetalRTRenderer *renderer, const char *path) {
+  if (!renderer || !path) return false;
+
+  @autoreleasepool {
+    NSURL *url = [NSURL fileURLWithPath:[NSString stringWithUTF8String:path]];
+    NSString *extension = [[url pathExtension] lowercaseString];
+    id<MTLTexture> source = nil;
+    if ([extension isEqualToString:@"ktx"] || [extension isEqualToString:@"ktx2"]) {
+      // Cubemap container, decoded as stored: the file's own pixel format says
+      // whether it is sRGB, linear or HDR, so the loader must not force sRGB
+      MTKTextureLoader *loader = [[MTKTextureLoader alloc] initWithDevice:renderer->device];
+      NSError *error = nil;
+      source = [loader newTextureWithContentsOfURL:url
+                                           options:@{MTKTextureLoaderOptionSRGB: @NO}
+                                             error:&error];
+      if (!source) {
+        NSLog(@"Skybox %s: %@", path, error);
+      }
+      if (source && source.textureType != MTLTextureTypeCube) {
+        NSLog(@"Skybox %s is not a cubemap", path);
+        return false;
+      }
+    } else {
+      source = loadEquirectTexture(renderer->device, url);
+    }
+    if (!source) {
+      NSLog(@"Failed to load skybox %s", path);
+      return false;
+    }
+
+    bool cube = source.textureType == MTLTextureTypeCube;
+    int sourceFace = cube ? static_cast<int>(source.width) : static_cast<int>(source.width) / 4;
+    int faceSize = std::clamp(sourceFace, 1, kSkyMaxFaceSize);
+    id<MTLTexture> sky = bakeSky(renderer, cube ? @"skybox_from_cube" : @"skybox_from_equirect", source, faceSize);
+    if (!sky) return false;
+    // Frames already encoded keep the old cubemap alive until they complete
+    renderer->sky = sky;
+    renderer->accumulationSamples = -1;  // A still scene restarts with the new sky
+    renderer->radianceValid = false;
+    NSLog(@"Loaded skybox %s (%d x %d cubemap faces, %lu mip levels)", path, faceSize, faceSize,
+          (unsigned long)sky.mipmapLevelCount);
+    return true;
+  }
+}
+
+void metal_rt_renderer_set_geodesic_cache(MetalRTRenderer *renderer, bool enabled) {
+  if (!renderer) return;
+  renderer->geodesicCacheEnabled = enabled;
+  renderer->geodesicCacheValid = false;
+  if (!enabled) {
+    renderer->geodesicCache = nil;
+  }
+}
+
+void metal_rt_renderer_set_exposure(MetalRTRenderer *renderer, float exposure) {
+  if (!renderer || !isfinite(exposure)) return;
+  renderer->exposure = std::clamp(exposure, 1.0f / 64.0f, 64.0f);
+}
+
+void metal_rt_renderer_set_bloom(MetalRTRenderer *renderer, float strength) {
+  if (!renderer || !isfinite(strength)) return;
+  renderer->bloomStrength = std::clamp(strength, 0.0f, 1.0f);
+}
+
+void metal_rt_renderer_set_progressive(MetalRTRenderer *renderer, bool enabled) {
+  if (!renderer) return;
+  renderer->accumulationEnabled = enabled;
+  renderer->accumulationSamples = -1;
+  if (!enabled) {
+    renderer->accumulation = nil;
+  }
+}
+
+void metal_rt_renderer_set_repeat_detection(MetalRTRenderer *renderer, bool enabled) {
+  if (!renderer) return;
+  renderer->repeatDetection = enabled;
+  renderer->accumulationSamples = -1;
+}
+
+int metal_rt_renderer_get_accumulated_samples(MetalRTRenderer *renderer) {
+  if (!renderer) return 0;
+  return std::clamp(renderer->accumulationSamples + 1, 0, kMaxAccumulationSamples);
+}
+
+void metal_rt_renderer_set_diagnostics(MetalRTRenderer *renderer, bool enabled) {
+  if (!renderer) return;
+  renderer->diagnosticsEnabled = enabled;
+  std::lock_guard<std::mutex> lock(renderer->slotMutex);
+  renderer->diagnosticsValid = false;
+}
+
+bool metal_rt_renderer_get_diagnostics(MetalRTRenderer *renderer, RayDiagnostics *diagnostics) {
+  if (!renderer || !diagnostics) return false;
+  std::lock_guard<std::mutex> lock(renderer->slotMutex);
+  if (!renderer->diagnosticsValid) return false;
+  *diagnostics = renderer->latestDiagnostics;
+  return true;
+}
+
+bool metal_rt_renderer_save_diagnostics(MetalRTRenderer *renderer, const char *path) {
+  if (!renderer || !path || renderer->displayedSlot < 0) return false;
+  const FrameSlot &slot = renderer->slots[renderer->displayedSlot];
+  if (!slot.diagnostics || !slot.diagnosticsTexture) {
+    return false;
+  }
+
+  int width = renderer->displayedWidth;
+  int height = renderer->displayedHeight;
+  std::vector<float> rgba(static_cast<size_t>(width) * height * 4);
+  [slot.diagnosticsTexture getBytes:rgba.data()
+                        bytesPerRow:static_cast<NSUInteger>(width) * 4 * sizeof(float)
+                         fromRegion:MTLRegionMake2D(0, 0, width, height)
                         mipmapLevel:0];
-    
-    // Ensure screenshotBuffer is allocated
-    size_t totalBytesNeeded = static_cast<size_t>(renderer->width) * static_cast<size_t>(renderer->height) * 4;
-    renderer->screenshotBuffer.resize(totalBytesNeeded);
-    
-    // Convert RGBA to BGRA into SCREENSHOT BUFFER (not pixelData!)
-    uint8_t *rgba = tempBuffer.data();
-    uint8_t *bgra = renderer->screenshotBuffer.data();
-    size_t pixelCount = static_cast<size_t>(renderer->width) * static_cast<size_t>(renderer->height);
-    for (size_t i = 0; i < pixelCount; i++) {
-      size_t idx = i * 4;
-      bgra[idx + 0] = rgba[idx + 2]; // B
-      bgra[idx + 1] = rgba[idx + 1]; // G
-      bgra[idx + 2] = rgba[idx + 0]; // R
-      bgra[idx + 3] = rgba[idx + 3]; // A
+
+  FILE *file = fopen(path, "wb");
+  if (!file) {
+    NSLog(@"Failed to open %s for the diagnostics dump", path);
+    return false;
+  }
+  // PFM: RGB float rows from bottom to top, negative scale = little-endian
+  fprintf(file, "PF\n%d %d\n-1.0\n", width, height);
+  std::vector<float> row(static_cast<size_t>(width) * 3);
+  bool ok = true;
+  for (int y = height - 1; y >= 0 && ok; y--) {
+    const float *src = &rgba[static_cast<size_t>(y) * width * 4];
+    for (int x = 0; x < width; x++) {
+      row[x * 3 + 0] = src[x * 4 + 0];
+      row[x * 3 + 1] = src[x * 4 + 1];
+      row[x * 3 + 2] = src[x * 4 + 2];
     }
-    
-    // Debug: Log first pixel color
-    NSLog(@"render_and_get_pixels: Render complete, colorMode was %d. First pixel BGRA: B=%d G=%d R=%d", 
-          uniforms->colorMode, bgra[0], bgra[1], bgra[2]);
-    
-    return renderer->screenshotBuffer.data();
+    ok = fwrite(row.data(), sizeof(float), row.size(), file) == row.size();
+  }
+  ok = fclose(file) == 0 && ok;
+  if (!ok) {
+    NSLog(@"Failed to write the diagnostics dump %s", path);
   }
+  return ok;
 }
 
 size_t metal_rt_renderer_get_pixel_data_size(MetalRTRenderer *renderer) {
@@ -0,0 +1,172 @@
+#include "../../include/rendering/OfflineRenderer.hpp"
+#include "../../include/utils/Screenshot.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+// External logging function
+extern void appLog(const std::string& message, bool isError = false);
+
+OfflineRenderer::OfflineRenderer(const OfflineRenderSettings &settings)
+    : settings(settings) {}
+
+OfflineRenderer::~OfflineRenderer() {
+  for (MetalRTRenderer *renderer : renderers) {
+    metal_rt_renderer_destroy(renderer);
+  }
+}
+
+std::vector<MetalRTRenderer *> OfflineRenderer::createRenderers(int gpuCount, int width, int height,
+                                                                const std::string &tag) {
+  std::vector<MetalRTRenderer *> created;
+  int deviceCount = metal_rt_renderer_get_device_count();
+  int wanted = gpuCount > 0 ? std::min(gpuCount, deviceCount) : deviceCount;
+  for (int device = 0; device < wanted; device++) {
+    MetalRTRenderer *renderer = metal_rt_renderer_create_on_device(device, width, height);
+    if (!renderer) {
+      continue;
+    }
+    char name[256];
+    if (metal_rt_renderer_get_device_name(device, name, sizeof(name))) {
+      appLog("[" + tag + "] GPU " + std::to_string(device) + ": " + name);
+    }
+    created.push_back(renderer);
+  }
+  if (created.empty()) {
+    if (MetalRTRenderer *renderer = metal_rt_renderer_create(width, height)) {
+      created.push_back(renderer);
+    }
+  }
+  return created;
+}
+
+void OfflineRenderer::toCameraData(const Camera &camera, CameraData &data) {
+  Vector3 forward = camera.forward.normalized();
+  Vector3 right = camera.right.normalized();
+  Vector3 up = camera.up.normalized();
+  data.position[0] = camera.position.x;
+  data.position[1] = camera.position.y;
+  data.position[2] = camera.position.z;
+  data.forward[0] = forward.x;
+  data.forward[1] = forward.y;
+  data.forward[2] = forward.z;
+  data.right[0] = right.x;
+  data.right[1] = right.y;
+  data.right[2] = right.z;
+  data.up[0] = up.x;
+  data.up[1] = up.y;
+  data.up[2] = up.z;
+  data.fov = camera.fov;
+}
+
+bool OfflineRenderer::render(const Camera &camera) {
+  if (settings.width <= 0 || settings.height <= 0 || settings.tileSize <= 0 || settings.samples <= 0) {
+    appLog("[STILL] Invalid render settings", true);
+    return false;
+  }
+
+  int tileSize = std::min({settings.tileSize, settings.width, settings.height});
+  int tilesX = (settings.width + tileSize - 1) / tileSize;
+  int tilesY = (settings.height + tileSize - 1) / tileSize;
+
+  // The frame ring only ever needs to hold one tile
+  renderers = createRenderers(settings.gpuCount, tileSize, tileSize, "STILL");
+  if (renderers.empty()) {
+    appLog("[STILL] Failed to create Metal renderer", true);
+    return false;
+  }
+  for (MetalRTRenderer *renderer : renderers) {
+    metal_rt_renderer_set_trace_mode(renderer, settings.traceMode);
+    if (!settings.skyboxPath.empty() && !metal_rt_renderer_load_skybox(renderer, settings.skyboxPath.c_str())) {
+      appLog("[STILL] Failed to load skybox " + settings.skyboxPath + ", using the starfield", true);
+    }
+  }
+  int gpus = static_cast<int>(renderers.size());
+
+  PNGStreamWriter writer;
+  if (!writer.open(settings.outputPath, settings.width, settings.height)) {
+    return false;
+  }
+
+  {
+    std::ostringstream logMsg;
+    logMsg << "[STILL] Rendering " << settings.width << "x" << settings.height << " in "
+           << tilesX << "x" << tilesY << " tiles of " << tileSize << "px, "
+           << settings.samples << " samples per pixel on " << gpus << " GPU" << (gpus > 1 ? "s" : "");
+    appLog(logMsg.str());
+  }
+
+  CameraData gpuCam;
+  toCameraData(camera, gpuCam);
+
+  auto start = std::chrono::high_resolution_clock::now();
+  size_t stripStride = static_cast<size_t>(settings.width) * 4;
+  std::vector<uint8_t> strip(stripStride * tileSize);
+  std::vector<std::vector<uint8_t>> tilePixels(gpus, std::vector<uint8_t>(static_cast<size_t>(tileSize) * tileSize * 4));
+
+  for (int ty = 0; ty < tilesY; ty++) {
+    int y0 = ty * tileSize;
+    int h = std::min(tileSize, settings.height - y0);
+
+    // GPU g renders tiles g, g + gpus, ... of the strip into disjoint columns
+    std::atomic<bool> failed(false);
+    auto renderColumns = [&](int gpu) {
+      for (int tx = gpu; tx < tilesX && !failed; tx += gpus) {
+        int x0 = tx * tileSize;
+        int w = std::min(tileSize, settings.width - x0);
+        uint8_t *pixels = tilePixels[gpu].data();
+        if (!metal_rt_renderer_render_tile(renderers[gpu], &gpuCam, settings.time, settings.colorMode,
+                                           settings.colorIntensity, settings.width, settings.height,
+                                           x0, y0, w, h, settings.samples, pixels)) {
+          std::ostringstream logMsg;
+          logMsg << "[STILL] Tile " << tx << "," << ty << " failed on GPU " << gpu;
+          appLog(logMsg.str(), true);
+          failed = true;
+          return;
+        }
+        for (int row = 0; row < h; row++) {
+          std::memcpy(&strip[row * stripStride + static_cast<size_t>(x0) * 4],
+                      &pixels[static_cast<size_t>(row) * w * 4], static_cast<size_t>(w) * 4);
+        }
+      }
+    };
+    std::vector<std::thread> workers;
+    for (int gpu = 1; gpu < gpus; gpu++) {
+      workers.emplace_back(renderColumns, gpu);
+    }
+    renderColumns(0);
+    for (std::thread &worker : workers) {
+      worker.join();
+    }
+    if (failed) {
+      return false;
+    }
+
+    // The strip is complete: stream it out and reuse the buffer
+    if (!writer.writeRows(strip.data(), h, static_cast<int>(stripStride))) {
+      return false;
+    }
+
+    double elapsed = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+    std::cout << "\r[STILL] " << std::fixed << std::setprecision(1)
+              << 100.0 * (ty + 1) / tilesY << "% (" << elapsed << " s)" << std::flush;
+  }
+  std::cout << std::endl;
+
+  if (!writer.close()) {
+    return false;
+  }
+
+  double elapsed = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+  std::ostringstream logMsg;
+  logMsg << "[STILL] Saved " << settings.outputPath << " in " << std::fixed << std::setprecision(1)
+         << elapsed << " s";
+  appLog(logMsg.str());
+  return true;
+}
@@ -0,0 +1,254 @@
+#include "../../include/rendering/SequenceRenderer.hpp"
+#include "../../include/camera/CameraPath.hpp"
+#include "../../include/rendering/OfflineRenderer.hpp"
+#include "../../include/utils/Screenshot.h"
+#include "../../include/utils/VideoRecorder.hpp"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+// External logging function
+extern void appLog(const std::string& message, bool isError = false);
+
+SequenceRenderer::SequenceRenderer(const SequenceRenderSettings &settings)
+    : settings(settings) {}
+
+SequenceRenderer::~SequenceRenderer() {
+  for (MetalRTRenderer *renderer : renderers) {
+    metal_rt_renderer_destroy(renderer);
+  }
+}
+
+bool SequenceRenderer::applyShard(SequenceRenderSettings &settings, int first, int last, int index, int count) {
+  if (first < 0 || last < first || count <= 0 || index < 1 || index > count) {
+    return false;
+  }
+  // Contiguous split; shard sizes differ by at most one frame
+  long total = static_cast<long>(last) - first + 1;
+  long begin = first + total * (index - 1) / count;
+  long end = first + total * index / count;
+  if (end <= begin) {
+    return false;  // More shards than frames
+  }
+  settings.firstFrame = static_cast<int>(begin);
+  settings.frameCount = static_cast<int>(end - begin);
+  return true;
+}
+
+bool SequenceRenderer::isVideoPath(const std::string &path) {
+  size_t dot = path.find_last_of('.');
+  if (dot == std::string::npos) {
+    return false;
+  }
+  std::string ext = path.substr(dot + 1);
+  std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return std::tolower(c); });
+  return ext == "mp4" || ext == "mov" || ext == "m4v";
+}
+
+bool SequenceRenderer::isFramePattern(const std::string &path) {
+  int conversions = 0;
+  for (size_t i = 0; i < path.size(); i++) {
+    if (path[i] != '%') {
+      continue;
+    }
+    if (++i < path.size() && path[i] == '%') {
+      continue;
+    }
+    while (i < path.size() && std::strchr("0-+ #", path[i])) {
+      i++;
+    }
+    size_t widthStart = i;
+    while (i < path.size() && std::isdigit(static_cast<unsigned char>(path[i]))) {
+      i++;
+    }
+    if (i - widthStart > 3 || i >= path.size() || (path[i] != 'd' && path[i] != 'i')) {
+      return false;
+    }
+    conversions++;
+  }
+  return conversions == 1;
+}
+
+bool SequenceRenderer::cameraPoses(const Camera &camera, std::vector<Camera> &poses) const {
+  if (!settings.cameraPath.empty()) {
+    CameraPath path;
+    std::string error;
+    if (!path.load(settings.cameraPath, error)) {
+      appLog("[SEQUENCE] Failed to load camera path: " + error, true);
+      return false;
+    }
+    path.evaluateFrames(settings.firstFrame, settings.frameCount, settings.fps, poses);
+    return true;
+  }
+
+  Camera cam = camera;
+  CinematicCamera cinematic(cam, camera.position);
+  cinematic.setMode(settings.cameraMode);
+  poses.clear();
+  poses.reserve(settings.frameCount);
+  const double frameTime = 1.0 / settings.fps;
+  for (int i = 0; i < settings.firstFrame + settings.frameCount; i++) {
+    // Fixed timestep; the zero step on frame 0 places the camera on its path.
+    // Frames before the shard only advance the camera
+    cinematic.update(i == 0 ? 0.0 : frameTime, nullptr);
+    if (i >= settings.firstFrame) {
+      poses.push_back(cam);
+    }
+  }
+  return true;
+}
+
+bool SequenceRenderer::render(const Camera &camera) {
+  if (settings.width <= 0 || settings.height <= 0 || settings.fps <= 0 || settings.firstFrame < 0 ||
+      settings.frameCount <= 0) {
+    appLog("[SEQUENCE] Invalid render settings", true);
+    return false;
+  }
+  bool video = isVideoPath(settings.outputPath);
+  if (!video && !isFramePattern(settings.outputPath)) {
+    appLog("[SEQUENCE] Image sequence output needs exactly one frame number pattern (e.g. frames/blackhole_%05d.png)"
+           " and %% for any other percent sign",
+           true);
+    return false;
+  }
+  std::vector<Camera> poses;
+  if (!cameraPoses(camera, poses)) {
+    return false;
+  }
+
+  renderers = OfflineRenderer::createRenderers(settings.gpuCount, settings.width, settings.height, "SEQUENCE");
+  if (renderers.empty()) {
+    appLog("[SEQUENCE] Failed to create Metal renderer", true);
+    return false;
+  }
+  for (MetalRTRenderer *renderer : renderers) {
+    metal_rt_renderer_set_trace_mode(renderer, settings.traceMode);
+    if (!settings.skyboxPath.empty() && !metal_rt_renderer_load_skybox(renderer, settings.skyboxPath.c_str())) {
+      appLog("[SEQUENCE] Failed to load skybox " + settings.skyboxPath + ", using the starfield", true);
+    }
+  }
+  size_t gpus = renderers.size();
+  int lastFrame = settings.firstFrame + settings.frameCount - 1;
+
+  // Offline output must never lose a frame: the render loop waits for the encoder instead
+  VideoRecorder recorder;
+  if (video) {
+    recorder.setQueuePolicy(VideoRecorder::QueuePolicy::Block);
+    if (!recorder.startRecording(settings.outputPath, settings.width, settings.height, settings.fps, "",
+                                 VideoRecorder::Backend::Hardware)) {
+      appLog("[SEQUENCE] Hardware encoder unavailable, using software encoder");
+      if (!recorder.startRecording(settings.outputPath, settings.width, settings.height, settings.fps)) {
+        appLog("[SEQUENCE] Failed to start encoder", true);
+        return false;
+      }
+    }
+  }
+
+  {
+    std::ostringstream logMsg;
+    std::string cameraName =
+        settings.cameraPath.empty() ? getCinematicModeName(settings.cameraMode) : settings.cameraPath;
+    logMsg << "[SEQUENCE] Rendering frames " << settings.firstFrame << "-" << lastFrame << " at "
+           << settings.width << "x" << settings.height << ", " << settings.fps << " fps (" << cameraName << ") on "
+           << gpus << " GPU" << (gpus > 1 ? "s" : "") << " to " << settings.outputPath;
+    appLog(logMsg.str());
+  }
+
+  // A frame on the GPU, identified by its renderer's frame index
+  struct PendingFrame {
+    MetalRTRenderer *renderer;
+    long frameIndex;
+    int sequenceIndex;  // Global frame number
+  };
+
+  // Wait for one frame, then encode or save it while the GPUs trace the next ones
+  auto emitFrame = [&](const PendingFrame &frame) {
+    MetalRTRenderer *renderer = frame.renderer;
+    if (!metal_rt_renderer_display_frame(renderer, frame.frameIndex)) {
+      return false;
+    }
+    if (video && recorder.getBackend() == VideoRecorder::Backend::Hardware) {
+      void *pixelBuffer = recorder.acquireHardwareFrame();
+      if (!pixelBuffer) {
+        return false;
+      }
+      if (!metal_rt_renderer_convert_to_nv12(renderer, pixelBuffer)) {
+        recorder.cancelHardwareFrame();
+        return false;
+      }
+      return recorder.submitHardwareFrame();
+    }
+    const void *pixels = metal_rt_renderer_get_pixels(renderer);
+    if (!pixels) {
+      return false;
+    }
+    if (video) {
+      return recorder.addFrame(pixels, settings.width, settings.height);
+    }
+    char path[1024];
+    std::snprintf(path, sizeof(path), settings.outputPath.c_str(), frame.sequenceIndex);
+    return savePNG(pixels, settings.width, settings.height, path);
+  };
+
+  auto start = std::chrono::high_resolution_clock::now();
+  std::deque<PendingFrame> pending;
+  bool ok = true;
+
+  for (int i = settings.firstFrame; i <= lastFrame && ok; i++) {
+    int rendered = i - settings.firstFrame;
+    CameraData gpuCam;
+    OfflineRenderer::toCameraData(poses[rendered], gpuCam);
+    float time = static_cast<float>(static_cast<double>(i) / settings.fps);
+
+    MetalRTRenderer *renderer = renderers[rendered % gpus];
+    long frameIndex = metal_rt_renderer_begin_frame(renderer, &gpuCam, time, settings.colorMode,
+                                                    settings.colorIntensity);
+    if (frameIndex < 0) {
+      ok = false;
+      break;
+    }
+    pending.push_back({renderer, frameIndex, i});
+
+    // Keep every GPU one frame ahead of the frame being encoded
+    if (pending.size() > gpus) {
+      ok = emitFrame(pending.front());
+      pending.pop_front();
+    }
+
+    double elapsed = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+    std::cout << "\r[SEQUENCE] Frame " << (rendered + 1) << "/" << settings.frameCount << " ("
+              << std::fixed << std::setprecision(1) << (rendered + 1) / std::max(elapsed, 1e-6) << " fps)"
+              << std::flush;
+  }
+  while (ok && !pending.empty()) {
+    ok = emitFrame(pending.front());
+    pending.pop_front();
+  }
+  std::cout << std::endl;
+  for (MetalRTRenderer *renderer : renderers) {
+    metal_rt_renderer_wait_idle(renderer);
+  }
+
+  if (video) {
+    recorder.stopRecording();
+  }
+  if (!ok) {
+    appLog("[SEQUENCE] Rendering failed", true);
+    return false;
+  }
+
+  double elapsed = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+  std::ostringstream logMsg;
+  logMsg << "[SEQUENCE] Wrote " << settings.frameCount << " frames ("
+         << std::fixed << std::setprecision(2) << static_cast<double>(settings.frameCount) / settings.fps
+         << " s of video) in " << std::setprecision(1) << elapsed << " s, "
+         << settings.frameCount / std::max(elapsed, 1e-6) << " fps";
+  appLog(logMsg.str());
+  return true;
+}
@@ -1,7 +1,9 @@
 #include "../../include/ui/HUD.hpp"
 #include "../../include/utils/Vector3.hpp"
 #include "../../include/utils/ResolutionManager.hpp"
+#include "../../include/utils/FrameProfiler.hpp"
 #include <string>
+#include <algorithm>
 #include <cmath>
 #include <sstream>
 #include <iomanip>
@@ -48,8 +50,8 @@ void HUD::renderHints(bool showHints, CinematicMode mode, int fps, int windowWid
   std::string resolutionStr = formatResolution(windowWidth, windowHeight, resolutionManager);
   
   // Color mode names
-  const char* colorNames[] = {"Blue", "Orange", "Red", "White"};
-  std::string colorModeStr = colorNames[colorMode % 4];
+  const char* colorNames[] = {"Blue", "Orange", "Red", "White", "Blackbody"};
+  std::string colorModeStr = colorNames[colorMode % 5];
   
   // Format intensity
   std::ostringstream intensityStream;
@@ -285,6 +287,119 @@ void HUD::renderMusicCredits(bool isMusicMuted, int windowWidth, int windowHeigh
   }
 }
 
+void HUD::renderProfiler(const FrameProfiler &profiler, int windowWidth, int windowHeight,
+                         const RayDiagnostics *diagnostics) {
+  (void)windowHeight;
+
+  // One stacked column per frame, newest on the right
+  const int columnWidth = 2;
+  const int graphWidth = FrameProfiler::HISTORY * columnWidth;
+  const int graphHeight = 120;
+  const double graphMs = 33.3; // Top of the graph (two 60 Hz frames)
+  const int padding = 12;
+  const int textPadding = 16;
+  const int lineHeight = 26;
+
+  static const SDL_Color stageColors[FrameProfiler::STAGE_COUNT] = {
+      {255, 120, 60, 255},  // GPU
+      {100, 200, 255, 255}, // Submit
+      {255, 220, 80, 255},  // Readback
+      {150, 255, 150, 255}, // Upload
+      {200, 140, 255, 255}, // HUD
+      {255, 100, 100, 255}, // Encode
+      {180, 180, 190, 255}, // Present
+  };
+
+  int legendLines = 1 + (FrameProfiler::STAGE_COUNT + 1) / 2 + (diagnostics ? 2 : 0);
+  int overlayWidth = graphWidth + textPadding * 2;
+  int overlayHeight = graphHeight + legendLines * lineHeight + textPadding * 3;
+  int overlayX = windowWidth - overlayWidth - padding;
+  int overlayY = padding;
+
+  SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+  SDL_SetRenderDrawColor(renderer, 15, 15, 25, 220);
+  SDL_Rect overlay = {overlayX, overlayY, overlayWidth, overlayHeight};
+  SDL_RenderFillRect(renderer, &overlay);
+  SDL_SetRenderDrawColor(renderer, 60, 100, 180, 180);
+  SDL_RenderDrawRect(renderer, &overlay);
+
+  int graphX = overlayX + textPadding;
+  int graphBottom = overlayY + textPadding + graphHeight;
+  double pixelsPerMs = graphHeight / graphMs;
+
+  // Stages stacked bottom-up; the GPU runs alongside the CPU stages, so it
+  // gets its own thin column next to them instead of adding to the stack
+  int frames = profiler.getFrameCount();
+  for (int age = 0; age < frames; age++) {
+    int x = graphX + graphWidth - (age + 1) * columnWidth;
+    double gpuMs = profiler.getStageTime(age, FrameProfiler::STAGE_GPU);
+    int gpuHeight = std::min(graphHeight, static_cast<int>(gpuMs * pixelsPerMs + 0.5));
+    const SDL_Color &gpuColor = stageColors[FrameProfiler::STAGE_GPU];
+    SDL_SetRenderDrawColor(renderer, gpuColor.r, gpuColor.g, gpuColor.b, 160);
+    SDL_RenderDrawLine(renderer, x, graphBottom - 1, x, graphBottom - gpuHeight);
+
+    double stackedMs = 0.0;
+    for (int stage = FrameProfiler::STAGE_GPU + 1; stage < FrameProfiler::STAGE_COUNT; stage++) {
+      double ms = profiler.getStageTime(age, static_cast<FrameProfiler::Stage>(stage));
+      int y0 = graphBottom - static_cast<int>(stackedMs * pixelsPerMs + 0.5);
+      stackedMs += ms;
+      int y1 = graphBottom - std::min(graphHeight, static_cast<int>(stackedMs * pixelsPerMs + 0.5));
+      if (y1 < y0) {
+        const SDL_Color &color = stageColors[stage];
+        SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, 220);
+        SDL_RenderDrawLine(renderer, x + 1, y0 - 1, x + 1, y1);
+      }
+    }
+  }
+
+  // 60 Hz and 30 Hz budget lines
+  SDL_SetRenderDrawColor(renderer, 220, 220, 230, 90);
+  for (double budgetMs : {16.6, 33.3}) {
+    int y = graphBottom - static_cast<int>(budgetMs * pixelsPerMs + 0.5);
+    SDL_RenderDrawLine(renderer, graphX, y, graphX + graphWidth - 1, y);
+  }
+
+  if (!font)
+    return;
+
+  // Legend: frame time and the average of every stage over the graph window
+  double frameMs = 0.0;
+  for (int age = 0; age < frames; age++) {
+    frameMs += profiler.getFrameTime(age);
+  }
+  frameMs = frames > 0 ? frameMs / frames : 0.0;
+
+  std::ostringstream header;
+  header << std::fixed << std::setprecision(2) << "Frame " << frameMs << " ms"
+         << (profiler.isExporting() ? "  (exporting)" : "");
+  int y = graphBottom + textPadding;
+  renderText(header.str().c_str(), graphX, y, {220, 220, 230, 255});
+  y += lineHeight;
+
+  int columnX[2] = {graphX, graphX + graphWidth / 2};
+  for (int stage = 0; stage < FrameProfiler::STAGE_COUNT; stage++) {
+    std::ostringstream line;
+    line << std::fixed << std::setprecision(2) << FrameProfiler::stageName(static_cast<FrameProfiler::Stage>(stage))
+         << " " << profiler.getAverageStageTime(static_cast<FrameProfiler::Stage>(stage)) << " ms";
+    renderText(line.str().c_str(), columnX[stage % 2], y + (stage / 2) * lineHeight, stageColors[stage]);
+  }
+
+  if (diagnostics) {
+    y += ((FrameProfiler::STAGE_COUNT + 1) / 2) * lineHeight;
+    const double *share = diagnostics->terminationFraction;
+    std::ostringstream steps;
+    steps << std::fixed << std::setprecision(1) << "Steps/px: mean " << diagnostics->meanSteps
+          << "  p99 " << diagnostics->p99Steps << "  max " << diagnostics->maxSteps;
+    std::ostringstream terminations;
+    terminations << std::fixed << std::setprecision(1) << "Escaped " << share[METAL_RT_TERMINATION_ESCAPED] * 100.0
+                 << "%  Horizon " << share[METAL_RT_TERMINATION_HORIZON] * 100.0
+                 << "%  Opaque " << share[METAL_RT_TERMINATION_OPAQUE] * 100.0
+                 << "%  Exhausted " << share[METAL_RT_TERMINATION_EXHAUSTED] * 100.0 << "%";
+    renderText(steps.str().c_str(), graphX, y, {220, 220, 230, 255});
+    renderText(terminations.str().c_str(), graphX, y + lineHeight, {220, 220, 230, 255});
+  }
+}
+
 void HUD::renderCameraAxes(const Camera *camera, int windowWidth, int windowHeight) {
   if (!camera || !renderer)
     return;
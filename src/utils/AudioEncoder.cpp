@@ -0,0 +1,268 @@
+#include "../../include/utils/AudioEncoder.hpp"
+#include <sstream>
+
+// External logging function from main.cpp
+extern void appLog(const std::string& message, bool isError = false);
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/audio_fifo.h>
+#include <libavutil/channel_layout.h>
+#include <libavutil/error.h>
+#include <libswresample/swresample.h>
+}
+
+namespace {
+constexpr int OUTPUT_SAMPLE_RATE = 48000;
+constexpr int OUTPUT_CHANNELS = 2;
+constexpr int64_t OUTPUT_BIT_RATE = 192000;
+constexpr int DEFAULT_FRAME_SIZE = 1024; // AAC frame, for encoders that accept any size
+
+std::string errorString(int ret) {
+  char errbuf[AV_ERROR_MAX_STRING_SIZE];
+  av_strerror(ret, errbuf, AV_ERROR_MAX_STRING_SIZE);
+  return errbuf;
+}
+} // namespace
+
+AudioEncoder::AudioEncoder()
+    : inputContext(nullptr), decoderContext(nullptr), encoderContext(nullptr), outputContext(nullptr),
+      stream(nullptr), resampler(nullptr), fifo(nullptr), decodedFrame(nullptr), encoderFrame(nullptr),
+      packet(nullptr), inputStreamIndex(-1), nextPts(0), sourceEnded(false) {
+}
+
+AudioEncoder::~AudioEncoder() {
+  close();
+}
+
+bool AudioEncoder::open(const std::string& audioFile, AVFormatContext* output) {
+  close();
+  outputContext = output;
+
+  int ret = avformat_open_input(&inputContext, audioFile.c_str(), nullptr, nullptr);
+  if (ret < 0) {
+    appLog("[FFMPEG] Could not open audio input " + audioFile + ": " + errorString(ret), true);
+    close();
+    return false;
+  }
+  avformat_find_stream_info(inputContext, nullptr);
+
+  const AVCodec* decoder = nullptr;
+  inputStreamIndex = av_find_best_stream(inputContext, AVMEDIA_TYPE_AUDIO, -1, -1, &decoder, 0);
+  if (inputStreamIndex < 0 || !decoder) {
+    appLog("[FFMPEG] No audio stream in " + audioFile, true);
+    close();
+    return false;
+  }
+  decoderContext = avcodec_alloc_context3(decoder);
+  if (!decoderContext ||
+      avcodec_parameters_to_context(decoderContext, inputContext->streams[inputStreamIndex]->codecpar) < 0 ||
+      (ret = avcodec_open2(decoderContext, decoder, nullptr)) < 0) {
+    appLog("[FFMPEG] Could not open audio decoder: " + errorString(ret), true);
+    close();
+    return false;
+  }
+  if (decoderContext->ch_layout.order == AV_CHANNEL_ORDER_UNSPEC) {
+    // WAV files often don't say which channels they hold
+    av_channel_layout_default(&decoderContext->ch_layout, decoderContext->ch_layout.nb_channels);
+  }
+
+  const AVCodec* encoder = avcodec_find_encoder(AV_CODEC_ID_AAC);
+  encoderContext = encoder ? avcodec_alloc_context3(encoder) : nullptr;
+  if (!encoderContext) {
+    appLog("[FFMPEG] AAC encoder not available", true);
+    close();
+    return false;
+  }
+  encoderContext->sample_fmt = AV_SAMPLE_FMT_FLTP; // FFmpeg's native AAC encoder
+  encoderContext->sample_rate = OUTPUT_SAMPLE_RATE;
+  av_channel_layout_default(&encoderContext->ch_layout, OUTPUT_CHANNELS);
+  encoderContext->bit_rate = OUTPUT_BIT_RATE;
+  encoderContext->time_base = {1, OUTPUT_SAMPLE_RATE};
+  if (outputContext->oformat->flags & AVFMT_GLOBALHEADER) {
+    encoderContext->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+  }
+  ret = avcodec_open2(encoderContext, encoder, nullptr);
+  if (ret < 0) {
+    appLog("[FFMPEG] Could not open AAC encoder: " + errorString(ret), true);
+    close();
+    return false;
+  }
+
+  stream = avformat_new_stream(outputContext, nullptr);
+  if (!stream) {
+    appLog("[FFMPEG] Could not create audio stream", true);
+    close();
+    return false;
+  }
+  stream->id = outputContext->nb_streams - 1;
+  stream->time_base = encoderContext->time_base;
+  avcodec_parameters_from_context(stream->codecpar, encoderContext);
+
+  ret = swr_alloc_set_opts2(&resampler, &encoderContext->ch_layout, encoderContext->sample_fmt,
+                            encoderContext->sample_rate, &decoderContext->ch_layout, decoderContext->sample_fmt,
+                            decoderContext->sample_rate, 0, nullptr);
+  if (ret < 0 || swr_init(resampler) < 0) {
+    appLog("[FFMPEG] Could not create audio resampler", true);
+    close();
+    return false;
+  }
+
+  int frameSize = encoderContext->frame_size > 0 ? encoderContext->frame_size : DEFAULT_FRAME_SIZE;
+  fifo = av_audio_fifo_alloc(encoderContext->sample_fmt, encoderContext->ch_layout.nb_channels, frameSize);
+  decodedFrame = av_frame_alloc();
+  encoderFrame = av_frame_alloc();
+  packet = av_packet_alloc();
+  if (!fifo || !decodedFrame || !encoderFrame || !packet) {
+    appLog("[FFMPEG] Could not allocate audio buffers", true);
+    close();
+    return false;
+  }
+  encoderFrame->nb_samples = frameSize;
+  encoderFrame->format = encoderContext->sample_fmt;
+  encoderFrame->sample_rate = encoderContext->sample_rate;
+  av_channel_layout_copy(&encoderFrame->ch_layout, &encoderContext->ch_layout);
+  if (av_frame_get_buffer(encoderFrame, 0) < 0) {
+    appLog("[FFMPEG] Could not allocate audio frame", true);
+    close();
+    return false;
+  }
+
+  std::ostringstream logMsg;
+  logMsg << "[FFMPEG] Live audio from " << audioFile << " (" << decoderContext->sample_rate << " Hz -> AAC "
+         << OUTPUT_SAMPLE_RATE << " Hz stereo, " << OUTPUT_BIT_RATE / 1000 << " kbps)";
+  appLog(logMsg.str());
+  return true;
+}
+
+bool AudioEncoder::writeUntil(double seconds) {
+  if (!encoderContext || sourceEnded) {
+    return false;
+  }
+
+  int frameSize = encoderFrame->nb_samples;
+  int64_t target = static_cast<int64_t>(seconds * encoderContext->sample_rate);
+  while (nextPts < target) {
+    if (!fill(frameSize)) {
+      sourceEnded = true;
+      appLog("[FFMPEG] Audio source ended, continuing without audio", true);
+      return false;
+    }
+    if (av_frame_make_writable(encoderFrame) < 0) {
+      return false;
+    }
+    av_audio_fifo_read(fifo, reinterpret_cast<void**>(encoderFrame->data), frameSize);
+    encoderFrame->pts = nextPts;
+    nextPts += frameSize;
+    if (!encode(encoderFrame)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void AudioEncoder::finish(double seconds) {
+  if (!encoderContext) {
+    return;
+  }
+  writeUntil(seconds);
+  encode(nullptr);
+}
+
+bool AudioEncoder::fill(int samples) {
+  bool restarted = false; // Looped without decoding anything since
+  while (av_audio_fifo_size(fifo) < samples) {
+    int ret = av_read_frame(inputContext, packet);
+    if (ret < 0) {
+      // End of the track: drain the decoder and start over, like the in-app music
+      avcodec_send_packet(decoderContext, nullptr);
+      while (avcodec_receive_frame(decoderContext, decodedFrame) >= 0) {
+        queueSamples(decodedFrame);
+        av_frame_unref(decodedFrame);
+      }
+      if (restarted || av_seek_frame(inputContext, inputStreamIndex, 0, AVSEEK_FLAG_BACKWARD) < 0) {
+        return false;
+      }
+      avcodec_flush_buffers(decoderContext);
+      restarted = true;
+      continue;
+    }
+
+    if (packet->stream_index == inputStreamIndex && avcodec_send_packet(decoderContext, packet) >= 0) {
+      while (avcodec_receive_frame(decoderContext, decodedFrame) >= 0) {
+        if (!queueSamples(decodedFrame)) {
+          av_frame_unref(decodedFrame);
+          av_packet_unref(packet);
+          return false;
+        }
+        av_frame_unref(decodedFrame);
+        restarted = false;
+      }
+    }
+    av_packet_unref(packet);
+  }
+  return true;
+}
+
+bool AudioEncoder::queueSamples(const AVFrame* frame) {
+  int inSamples = frame ? frame->nb_samples : 0;
+  int outSamples = swr_get_out_samples(resampler, inSamples);
+  if (outSamples <= 0) {
+    return true;
+  }
+
+  uint8_t* planes[AV_NUM_DATA_POINTERS] = {};
+  if (av_samples_alloc(planes, nullptr, encoderContext->ch_layout.nb_channels, outSamples,
+                       encoderContext->sample_fmt, 0) < 0) {
+    return false;
+  }
+  int converted = swr_convert(resampler, planes, outSamples,
+                              frame ? const_cast<const uint8_t**>(frame->extended_data) : nullptr, inSamples);
+  bool queued = converted >= 0 && av_audio_fifo_write(fifo, reinterpret_cast<void**>(planes), converted) == converted;
+  av_freep(&planes[0]);
+  return queued;
+}
+
+bool AudioEncoder::encode(AVFrame* frame) {
+  int ret = avcodec_send_frame(encoderContext, frame);
+  if (ret < 0) {
+    appLog("[FFMPEG] Error sending audio frame: " + errorString(ret), true);
+    return false;
+  }
+
+  while (ret >= 0) {
+    ret = avcodec_receive_packet(encoderContext, packet);
+    if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
+      break;
+    } else if (ret < 0) {
+      appLog("[FFMPEG] Error encoding audio frame: " + errorString(ret), true);
+      return false;
+    }
+
+    av_packet_rescale_ts(packet, encoderContext->time_base, stream->time_base);
+    packet->stream_index = stream->index;
+    av_interleaved_write_frame(outputContext, packet);
+    av_packet_unref(packet);
+  }
+  return true;
+}
+
+void AudioEncoder::close() {
+  av_packet_free(&packet);
+  av_frame_free(&encoderFrame);
+  av_frame_free(&decodedFrame);
+  if (fifo) {
+    av_audio_fifo_free(fifo);
+    fifo = nullptr;
+  }
+  swr_free(&resampler);
+  avcodec_free_context(&encoderContext);
+  avcodec_free_context(&decoderContext);
+  avformat_close_input(&inputContext);
+  outputContext = nullptr;
+  stream = nullptr; // Freed with the output context
+  inputStreamIndex = -1;
+  nextPts = 0;
+  sourceEnded = false;
+}
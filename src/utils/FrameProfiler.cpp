@@ -0,0 +1,144 @@
+#include "../../include/utils/FrameProfiler.hpp"
+#include <cstring>
+#include <iomanip>
+
+namespace {
+// Chrome trace rows
+constexpr int FRAME_THREAD = 1;
+constexpr int CPU_THREAD = 2;
+constexpr int GPU_THREAD = 3;
+
+bool endsWith(const std::string &text, const std::string &suffix) {
+  return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+} // namespace
+
+FrameProfiler::FrameProfiler()
+    : frameCount(0), sessionStart(Clock::now()), frameStart(sessionStart), chromeTrace(false),
+      firstTraceEvent(true) {
+  std::memset(history, 0, sizeof(history));
+  std::memset(&current, 0, sizeof(current));
+}
+
+FrameProfiler::~FrameProfiler() {
+  stopExport();
+}
+
+const char *FrameProfiler::stageName(Stage stage) {
+  static const char *names[STAGE_COUNT] = {"GPU", "Submit", "Readback", "Upload", "HUD", "Encode", "Present"};
+  return stage >= 0 && stage < STAGE_COUNT ? names[stage] : "?";
+}
+
+void FrameProfiler::beginFrame() {
+  std::memset(&current, 0, sizeof(current));
+  frameStart = Clock::now();
+}
+
+void FrameProfiler::endFrame() {
+  Clock::time_point now = Clock::now();
+  current.frameMs = std::chrono::duration<double, std::milli>(now - frameStart).count();
+  history[frameCount % HISTORY] = current;
+
+  if (exportFile.is_open()) {
+    if (chromeTrace) {
+      double startUs = microsecondsSinceStart(frameStart);
+      writeTraceEvent("Frame", FRAME_THREAD, startUs, current.frameMs * 1000.0);
+      // The GPU time belongs to an earlier submission; it is drawn from the
+      // start of the frame that picked it up
+      if (current.stageMs[STAGE_GPU] > 0.0) {
+        writeTraceEvent(stageName(STAGE_GPU), GPU_THREAD, startUs, current.stageMs[STAGE_GPU] * 1000.0);
+      }
+    } else {
+      exportFile << frameCount << ',' << microsecondsSinceStart(frameStart) / 1000.0 << ',' << current.frameMs;
+      for (int stage = 0; stage < STAGE_COUNT; stage++) {
+        exportFile << ',' << current.stageMs[stage];
+      }
+      exportFile << '\n';
+    }
+  }
+  frameCount++;
+}
+
+void FrameProfiler::beginStage(Stage stage) {
+  stageStart[stage] = Clock::now();
+}
+
+void FrameProfiler::endStage(Stage stage) {
+  Clock::time_point now = Clock::now();
+  double ms = std::chrono::duration<double, std::milli>(now - stageStart[stage]).count();
+  current.stageMs[stage] += ms;
+  if (exportFile.is_open() && chromeTrace) {
+    writeTraceEvent(stageName(stage), CPU_THREAD, microsecondsSinceStart(stageStart[stage]), ms * 1000.0);
+  }
+}
+
+void FrameProfiler::addStageTime(Stage stage, double ms) {
+  current.stageMs[stage] += ms;
+}
+
+double FrameProfiler::getStageTime(int age, Stage stage) const {
+  if (age < 0 || age >= getFrameCount()) return 0.0;
+  return history[(frameCount - 1 - age) % HISTORY].stageMs[stage];
+}
+
+double FrameProfiler::getFrameTime(int age) const {
+  if (age < 0 || age >= getFrameCount()) return 0.0;
+  return history[(frameCount - 1 - age) % HISTORY].frameMs;
+}
+
+double FrameProfiler::getAverageStageTime(Stage stage) const {
+  int frames = getFrameCount();
+  if (frames == 0) return 0.0;
+  double sum = 0.0;
+  for (int age = 0; age < frames; age++) {
+    sum += getStageTime(age, stage);
+  }
+  return sum / frames;
+}
+
+bool FrameProfiler::startExport(const std::string &path) {
+  stopExport();
+  exportFile.open(path, std::ios::out | std::ios::trunc);
+  if (!exportFile.is_open()) {
+    return false;
+  }
+
+  // Fixed notation: microsecond timestamps grow past the default 6 significant digits
+  exportFile << std::fixed << std::setprecision(3);
+  chromeTrace = endsWith(path, ".json");
+  firstTraceEvent = true;
+  if (chromeTrace) {
+    exportFile << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    const char *threadNames[] = {"Frame", "CPU", "GPU"};
+    for (int thread = FRAME_THREAD; thread <= GPU_THREAD; thread++) {
+      exportFile << (firstTraceEvent ? "\n" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+                 << thread << ",\"args\":{\"name\":\"" << threadNames[thread - FRAME_THREAD] << "\"}}";
+      firstTraceEvent = false;
+    }
+  } else {
+    exportFile << "frame,start_ms,frame_ms";
+    for (int stage = 0; stage < STAGE_COUNT; stage++) {
+      exportFile << ',' << stageName(static_cast<Stage>(stage)) << "_ms";
+    }
+    exportFile << '\n';
+  }
+  return true;
+}
+
+void FrameProfiler::stopExport() {
+  if (!exportFile.is_open()) return;
+  if (chromeTrace) {
+    exportFile << "\n]}\n";
+  }
+  exportFile.close();
+}
+
+double FrameProfiler::microsecondsSinceStart(Clock::time_point time) const {
+  return std::chrono::duration<double, std::micro>(time - sessionStart).count();
+}
+
+void FrameProfiler::writeTraceEvent(const char *name, int thread, double startUs, double durationUs) {
+  exportFile << (firstTraceEvent ? "\n" : ",\n") << "{\"name\":\"" << name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+             << thread << ",\"ts\":" << startUs << ",\"dur\":" << durationUs << '}';
+  firstTraceEvent = false;
+}
@@ -0,0 +1,57 @@
+#include "../../include/utils/QualityController.hpp"
+#include <algorithm>
+#include <cmath>
+
+QualityController::QualityController(double targetFrameMs)
+    : targetMs(targetFrameMs), scale(MAX_SCALE), smoothedMs(0.0),
+      enabled(false), framesSinceChange(0) {}
+
+void QualityController::setEnabled(bool value) {
+  enabled = value;
+  if (!enabled) {
+    scale = MAX_SCALE;
+  }
+  reset();
+}
+
+void QualityController::setTargetFrameTime(double ms) {
+  targetMs = std::max(ms, 1.0);
+  framesSinceChange = 0;
+}
+
+void QualityController::reset() {
+  smoothedMs = 0.0;
+  framesSinceChange = 0;
+}
+
+bool QualityController::update(double gpuFrameMs) {
+  if (!enabled || gpuFrameMs <= 0.0) {
+    return false;
+  }
+
+  // The frame was rendered at the previous scale; the moving average restarts
+  // after each change so old measurements don't trigger a second correction
+  smoothedMs = (smoothedMs <= 0.0) ? gpuFrameMs
+                                   : smoothedMs + (gpuFrameMs - smoothedMs) * SMOOTHING;
+  if (++framesSinceChange < COOLDOWN_FRAMES) {
+    return false;
+  }
+
+  bool tooSlow = smoothedMs > targetMs * UPPER_BAND && scale > MIN_SCALE;
+  bool tooFast = smoothedMs < targetMs * LOWER_BAND && scale < MAX_SCALE;
+  if (!tooSlow && !tooFast) {
+    return false;
+  }
+
+  // Pixel cost ~ scale^2: aim for the scale that would hit the target exactly
+  double factor = std::sqrt(targetMs / smoothedMs);
+  factor = std::clamp(factor, MAX_STEP_DOWN, MAX_STEP_UP);
+  double newScale = std::clamp(scale * factor, MIN_SCALE, MAX_SCALE);
+  if (std::abs(newScale - scale) < 0.01) {
+    return false;
+  }
+
+  scale = newScale;
+  reset();
+  return true;
+}
@@ -1,91 +1,361 @@
 #include "../../include/utils/Screenshot.h"
+#include "../../include/utils/WorkStealingPool.hpp"
 #include <png.h>
+#include <zlib.h>
+#include <algorithm>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <vector>
 #include <stdexcept>
 
 // External logging function
 extern void appLog(const std::string& message, bool isError = false);
 
-bool savePNG(const void* pixels, int width, int height, const std::string& filename) {
+namespace {
+// Input of one parallel deflate band; bands are whole rows
+constexpr size_t PNG_BAND_BYTES = 256 * 1024;
+// Deflate window: each band is primed with this much of the preceding data
+constexpr size_t DEFLATE_WINDOW = 32768;
+
+// PNG filter type 4 predictor
+inline uint8_t paeth(int a, int b, int c) {
+    int p = a + b - c;
+    int pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+    if (pa <= pb && pa <= pc) return static_cast<uint8_t>(a);
+    return static_cast<uint8_t>(pb <= pc ? b : c);
+}
+
+void putBigEndian(std::vector<uint8_t>& out, uint32_t value) {
+    out.push_back(static_cast<uint8_t>(value >> 24));
+    out.push_back(static_cast<uint8_t>(value >> 16));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+bool writeChunk(FILE* fp, const char* type, const uint8_t* data, size_t length) {
+    std::vector<uint8_t> header;
+    putBigEndian(header, static_cast<uint32_t>(length));
+    header.insert(header.end(), type, type + 4);
+    uLong crc = crc32(0L, reinterpret_cast<const Bytef*>(type), 4);
+    if (length > 0) {
+        crc = crc32(crc, data, static_cast<uInt>(length));
+    }
+    std::vector<uint8_t> trailer;
+    putBigEndian(trailer, static_cast<uint32_t>(crc));
+    return fwrite(header.data(), 1, header.size(), fp) == header.size() &&
+           (length == 0 || fwrite(data, 1, length, fp) == length) &&
+           fwrite(trailer.data(), 1, trailer.size(), fp) == trailer.size();
+}
+} // namespace
+
+bool savePNG(const void* pixels, int width, int height, const std::string& filename,
+             int compressionLevel, WorkStealingPool* pool, int strideBytes) {
     if (!pixels || width <= 0 || height <= 0) {
         appLog("[SCREENSHOT] Invalid parameters for PNG save", true);
         return false;
     }
-    
+    compressionLevel = std::clamp(compressionLevel, 0, 9);
+    size_t stride = strideBytes > 0 ? static_cast<size_t>(strideBytes) : static_cast<size_t>(width) * 4;
+    const uint8_t* bgra = static_cast<const uint8_t*>(pixels);
+
+    // Filtered scanlines: a filter byte, then RGB. Stored files skip filtering;
+    // otherwise every row uses Paeth, which needs only the source rows above
+    size_t rowBytes = static_cast<size_t>(width) * 3 + 1;
+    std::vector<uint8_t> filtered(rowBytes * height);
+    auto filterRow = [&](int y) {
+        uint8_t* out = &filtered[rowBytes * y];
+        const uint8_t* cur = bgra + stride * y;
+        const uint8_t* up = y > 0 ? bgra + stride * (y - 1) : nullptr;
+        out[0] = compressionLevel == PNG_STORED ? 0 : 4;
+        for (int x = 0; x < width; x++) {
+            for (int c = 0; c < 3; c++) {
+                int channel = 2 - c;  // BGRA -> RGB
+                int value = cur[x * 4 + channel];
+                if (compressionLevel == PNG_STORED) {
+                    out[1 + x * 3 + c] = static_cast<uint8_t>(value);
+                    continue;
+                }
+                int left = x > 0 ? cur[(x - 1) * 4 + channel] : 0;
+                int above = up ? up[x * 4 + channel] : 0;
+                int aboveLeft = up && x > 0 ? up[(x - 1) * 4 + channel] : 0;
+                out[1 + x * 3 + c] = static_cast<uint8_t>(value - paeth(left, above, aboveLeft));
+            }
+        }
+    };
+
+    // Bands of rows deflate independently into raw streams; all but the last
+    // end on a byte-aligned sync flush, so they concatenate into one stream
+    int rowsPerBand = static_cast<int>(std::max<size_t>(1, PNG_BAND_BYTES / rowBytes));
+    int bandCount = (height + rowsPerBand - 1) / rowsPerBand;
+    std::vector<std::vector<uint8_t>> bands(bandCount);
+    std::vector<uLong> bandAdler(bandCount);
+    std::vector<char> bandFailed(bandCount, 0);
+    auto deflateBand = [&](int band) {
+        size_t begin = rowBytes * static_cast<size_t>(band) * rowsPerBand;
+        size_t end = std::min(filtered.size(), begin + rowBytes * rowsPerBand);
+        z_stream stream;
+        std::memset(&stream, 0, sizeof(stream));
+        if (deflateInit2(&stream, compressionLevel, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+            bandFailed[band] = 1;
+            return;
+        }
+        if (begin > 0 && compressionLevel != PNG_STORED) {
+            size_t window = std::min(begin, DEFLATE_WINDOW);
+            deflateSetDictionary(&stream, &filtered[begin - window], static_cast<uInt>(window));
+        }
+        bool last = band == bandCount - 1;
+        std::vector<uint8_t> &out = bands[band];
+        out.resize(deflateBound(&stream, static_cast<uLong>(end - begin)) + 16);
+        stream.next_in = &filtered[begin];
+        stream.avail_in = static_cast<uInt>(end - begin);
+        stream.next_out = out.data();
+        stream.avail_out = static_cast<uInt>(out.size());
+        int status = deflate(&stream, last ? Z_FINISH : Z_SYNC_FLUSH);
+        if ((last ? status != Z_STREAM_END : status != Z_OK) || stream.avail_in != 0) {
+            bandFailed[band] = 1;
+        }
+        out.resize(out.size() - stream.avail_out);
+        deflateEnd(&stream);
+        bandAdler[band] = adler32(adler32(0L, Z_NULL, 0), &filtered[begin], static_cast<uInt>(end - begin));
+    };
+
+    if (pool) {
+        pool->parallelFor(height, filterRow);
+        pool->parallelFor(bandCount, deflateBand);
+    } else {
+        for (int y = 0; y < height; y++) filterRow(y);
+        for (int band = 0; band < bandCount; band++) deflateBand(band);
+    }
+    if (std::find(bandFailed.begin(), bandFailed.end(), 1) != bandFailed.end()) {
+        appLog("[SCREENSHOT] Error during PNG compression", true);
+        return false;
+    }
+
     FILE *fp = fopen(filename.c_str(), "wb");
     if (!fp) {
         std::string errMsg = "[SCREENSHOT] Could not open file for writing: " + filename;
         appLog(errMsg, true);
         return false;
     }
-    
-    png_structp png = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
-    if (!png) {
-        fclose(fp);
-        appLog("[SCREENSHOT] Failed to create PNG write struct", true);
+
+    static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    std::vector<uint8_t> header;
+    putBigEndian(header, static_cast<uint32_t>(width));
+    putBigEndian(header, static_cast<uint32_t>(height));
+    header.insert(header.end(), {8, 2, 0, 0, 0});  // 8-bit RGB, deflate, adaptive filters, no interlace
+
+    // zlib header with the matching FLEVEL hint, bands as IDAT chunks, then the combined Adler-32
+    static const uint8_t zlibLevelFlags[4] = {0x01, 0x5E, 0x9C, 0xDA};
+    int flevel = compressionLevel < 2 ? 0 : compressionLevel < 6 ? 1 : compressionLevel == 6 ? 2 : 3;
+    uint8_t zlibHeader[2] = {0x78, zlibLevelFlags[flevel]};
+    uLong adler = adler32(0L, Z_NULL, 0);
+    for (int band = 0; band < bandCount; band++) {
+        size_t begin = rowBytes * static_cast<size_t>(band) * rowsPerBand;
+        size_t length = std::min(filtered.size(), begin + rowBytes * rowsPerBand) - begin;
+        adler = adler32_combine(adler, bandAdler[band], static_cast<z_off_t>(length));
+    }
+    std::vector<uint8_t> trailer;
+    putBigEndian(trailer, static_cast<uint32_t>(adler));
+
+    bool ok = fwrite(signature, 1, sizeof(signature), fp) == sizeof(signature) &&
+              writeChunk(fp, "IHDR", header.data(), header.size()) &&
+              writeChunk(fp, "IDAT", zlibHeader, sizeof(zlibHeader));
+    for (int band = 0; ok && band < bandCount; band++) {
+        ok = writeChunk(fp, "IDAT", bands[band].data(), bands[band].size());
+    }
+    ok = ok && writeChunk(fp, "IDAT", trailer.data(), trailer.size()) && writeChunk(fp, "IEND", nullptr, 0);
+    ok = fclose(fp) == 0 && ok;
+    if (!ok) {
+        appLog("[SCREENSHOT] Error while writing PNG: " + filename, true);
+    }
+    return ok;
+}
+
+bool saveFloatTIFF(const float* rgba, int width, int height, const std::string& filename, int strideBytes) {
+    if (!rgba || width <= 0 || height <= 0) {
+        appLog("[SCREENSHOT] Invalid parameters for TIFF save", true);
         return false;
     }
-    
-    png_infop info = png_create_info_struct(png);
-    if (!info) {
-        png_destroy_write_struct(&png, nullptr);
-        fclose(fp);
-        appLog("[SCREENSHOT] Failed to create PNG info struct", true);
+    size_t stride = strideBytes > 0 ? static_cast<size_t>(strideBytes) : static_cast<size_t>(width) * 16;
+    size_t rowBytes = static_cast<size_t>(width) * 3 * sizeof(float);
+    uint64_t imageBytes = static_cast<uint64_t>(rowBytes) * height;
+    if (imageBytes > 0xFFFFFFF0ull) {
+        appLog("[SCREENSHOT] Image too large for a classic TIFF", true);
         return false;
     }
-    
-    if (setjmp(png_jmpbuf(png))) {
-        png_destroy_write_struct(&png, &info);
-        fclose(fp);
-        appLog("[SCREENSHOT] Error during PNG creation", true);
+
+    FILE *fp = fopen(filename.c_str(), "wb");
+    if (!fp) {
+        appLog("[SCREENSHOT] Could not open file for writing: " + filename, true);
         return false;
     }
-    
-    png_init_io(png, fp);
-    
-    // Set image properties
-    // ARGB8888 format: we need to convert to RGBA for PNG
-    png_set_IHDR(png, info, width, height, 8, PNG_COLOR_TYPE_RGBA,
-                  PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT,
-                  PNG_FILTER_TYPE_DEFAULT);
-    
-    // Convert BGRA to RGBA for PNG
-    // Input is BGRA: B=byte0, G=byte1, R=byte2, A=byte3 (from Metal renderer)
-    // Output is RGBA: R=byte0, G=byte1, B=byte2, A=byte3 (for PNG)
-    const uint8_t* bgra = static_cast<const uint8_t*>(pixels);
-    std::vector<uint8_t> rgbaData(width * height * 4);
-    
-    for (int y = 0; y < height; y++) {
+
+    // Little-endian baseline TIFF: header, one IFD, the per-sample arrays, then a single strip
+    constexpr uint16_t entryCount = 11;
+    constexpr uint32_t ifdOffset = 8;
+    constexpr uint32_t bitsOffset = ifdOffset + 2 + entryCount * 12 + 4;
+    constexpr uint32_t formatOffset = bitsOffset + 6;
+    constexpr uint32_t dataOffset = formatOffset + 8;  // Keep the strip 4-byte aligned
+    std::vector<uint8_t> header;
+    auto put16 = [&](uint16_t value) {
+        header.push_back(static_cast<uint8_t>(value));
+        header.push_back(static_cast<uint8_t>(value >> 8));
+    };
+    auto put32 = [&](uint32_t value) {
+        put16(static_cast<uint16_t>(value));
+        put16(static_cast<uint16_t>(value >> 16));
+    };
+    auto entry = [&](uint16_t tag, uint16_t type, uint32_t count, uint32_t value) {
+        put16(tag);
+        put16(type);
+        put32(count);
+        if (type == 3 && count == 1) {
+            put16(static_cast<uint16_t>(value));
+            put16(0);
+        } else {
+            put32(value);
+        }
+    };
+    constexpr uint16_t SHORT = 3, LONG = 4;
+    header.insert(header.end(), {'I', 'I', 42, 0});
+    put32(ifdOffset);
+    put16(entryCount);
+    entry(256, LONG, 1, static_cast<uint32_t>(width));        // ImageWidth
+    entry(257, LONG, 1, static_cast<uint32_t>(height));       // ImageLength
+    entry(258, SHORT, 3, bitsOffset);                         // BitsPerSample
+    entry(259, SHORT, 1, 1);                                  // Compression: none
+    entry(262, SHORT, 1, 2);                                  // Photometric: RGB
+    entry(273, LONG, 1, dataOffset);                          // StripOffsets
+    entry(277, SHORT, 1, 3);                                  // SamplesPerPixel
+    entry(278, LONG, 1, static_cast<uint32_t>(height));       // RowsPerStrip
+    entry(279, LONG, 1, static_cast<uint32_t>(imageBytes));   // StripByteCounts
+    entry(284, SHORT, 1, 1);                                  // PlanarConfiguration: chunky
+    entry(339, SHORT, 3, formatOffset);                       // SampleFormat
+    put32(0);                                                 // No further IFDs
+    put16(32); put16(32); put16(32);                          // 32 bits per sample
+    put16(3); put16(3); put16(3);                             // IEEE floating point
+    header.resize(dataOffset, 0);
+
+    bool ok = fwrite(header.data(), 1, header.size(), fp) == header.size();
+    std::vector<float> row(static_cast<size_t>(width) * 3);
+    const uint8_t* src = reinterpret_cast<const uint8_t*>(rgba);
+    for (int y = 0; ok && y < height; y++) {
+        const float* in = reinterpret_cast<const float*>(src + stride * y);
         for (int x = 0; x < width; x++) {
-            int idx = (y * width + x) * 4;
-            uint8_t b = bgra[idx + 0];
-            uint8_t g = bgra[idx + 1];
-            uint8_t r = bgra[idx + 2];
-            uint8_t a = bgra[idx + 3];
-            
-            // Convert to RGBA
-            rgbaData[idx + 0] = r;
-            rgbaData[idx + 1] = g;
-            rgbaData[idx + 2] = b;
-            rgbaData[idx + 3] = a;
+            row[x * 3 + 0] = in[x * 4 + 0];
+            row[x * 3 + 1] = in[x * 4 + 1];
+            row[x * 3 + 2] = in[x * 4 + 2];
         }
+        ok = fwrite(row.data(), 1, rowBytes, fp) == rowBytes;
     }
-    
-    // Set row pointers
-    std::vector<png_bytep> rowPointers(height);
-    for (int y = 0; y < height; y++) {
-        rowPointers[y] = const_cast<png_bytep>(&rgbaData[y * width * 4]);
-    }
-    
-    // Write PNG using standard API
-    png_write_info(png, info);
-    png_write_image(png, rowPointers.data());
-    png_write_end(png, nullptr);
-    
-    png_destroy_write_struct(&png, &info);
-    fclose(fp);
-    
+    ok = fclose(fp) == 0 && ok;
+    if (!ok) {
+        appLog("[SCREENSHOT] Error while writing TIFF: " + filename, true);
+    }
+    return ok;
+}
+
+struct PNGStreamWriter::State {
+    FILE* fp = nullptr;
+    png_structp png = nullptr;
+    png_infop info = nullptr;
+    int width = 0;
+    int height = 0;
+    int rowsWritten = 0;
+    std::vector<uint8_t> row;
+};
+
+PNGStreamWriter::PNGStreamWriter() : state(nullptr) {}
+
+PNGStreamWriter::~PNGStreamWriter() {
+    if (state) {
+        png_destroy_write_struct(&state->png, &state->info);
+        if (state->fp) {
+            fclose(state->fp);
+        }
+        delete state;
+    }
+}
+
+bool PNGStreamWriter::open(const std::string& filename, int width, int height) {
+    if (state || width <= 0 || height <= 0) {
+        appLog("[SCREENSHOT] Invalid parameters for streamed PNG", true);
+        return false;
+    }
+
+    state = new State();
+    state->width = width;
+    state->height = height;
+    state->row.resize(static_cast<size_t>(width) * 3);
+
+    state->fp = fopen(filename.c_str(), "wb");
+    if (!state->fp) {
+        appLog("[SCREENSHOT] Could not open file for writing: " + filename, true);
+        return false;
+    }
+    state->png = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+    state->info = state->png ? png_create_info_struct(state->png) : nullptr;
+    if (!state->png || !state->info) {
+        appLog("[SCREENSHOT] Failed to create PNG write structs", true);
+        return false;
+    }
+    if (setjmp(png_jmpbuf(state->png))) {
+        appLog("[SCREENSHOT] Error while writing PNG header", true);
+        return false;
+    }
+
+    png_init_io(state->png, state->fp);
+    // Renders are opaque: RGB saves a quarter of the file
+    png_set_IHDR(state->png, state->info, width, height, 8, PNG_COLOR_TYPE_RGB,
+                 PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+    png_write_info(state->png, state->info);
+    return true;
+}
+
+bool PNGStreamWriter::writeRows(const void* bgraPixels, int rows, int strideBytes) {
+    if (!state || !state->png || !bgraPixels || state->rowsWritten + rows > state->height) {
+        appLog("[SCREENSHOT] Invalid rows for streamed PNG", true);
+        return false;
+    }
+    if (setjmp(png_jmpbuf(state->png))) {
+        appLog("[SCREENSHOT] Error while writing PNG rows", true);
+        return false;
+    }
+
+    const uint8_t* src = static_cast<const uint8_t*>(bgraPixels);
+    for (int y = 0; y < rows; y++) {
+        const uint8_t* bgra = src + static_cast<size_t>(y) * strideBytes;
+        for (int x = 0; x < state->width; x++) {
+            state->row[x * 3 + 0] = bgra[x * 4 + 2];
+            state->row[x * 3 + 1] = bgra[x * 4 + 1];
+            state->row[x * 3 + 2] = bgra[x * 4 + 0];
+        }
+        png_write_row(state->png, state->row.data());
+    }
+    state->rowsWritten += rows;
     return true;
 }
 
+bool PNGStreamWriter::close() {
+    if (!state || !state->png) {
+        return false;
+    }
+    bool complete = state->rowsWritten == state->height;
+    if (complete) {
+        if (setjmp(png_jmpbuf(state->png))) {
+            appLog("[SCREENSHOT] Error while finishing PNG", true);
+            return false;
+        }
+        png_write_end(state->png, nullptr);
+    } else {
+        appLog("[SCREENSHOT] Streamed PNG closed before all rows were written", true);
+    }
+
+    png_destroy_write_struct(&state->png, &state->info);
+    bool closed = fclose(state->fp) == 0;
+    state->fp = nullptr;
+    delete state;
+    state = nullptr;
+    return complete && closed;
+}
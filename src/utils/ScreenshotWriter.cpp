@@ -0,0 +1,118 @@
+#include "../../include/utils/ScreenshotWriter.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <sstream>
+
+// External logging function
+extern void appLog(const std::string& message, bool isError = false);
+
+namespace {
+// Leave a core to the render loop while a screenshot is encoding
+unsigned encoderThreads() {
+  unsigned hardware = std::thread::hardware_concurrency();
+  return hardware > 2 ? hardware - 1 : 1;
+}
+} // namespace
+
+ScreenshotWriter::ScreenshotWriter()
+    : pool(encoderThreads()), active(0), stopping(false) {
+  worker = std::thread(&ScreenshotWriter::workerLoop, this);
+}
+
+ScreenshotWriter::~ScreenshotWriter() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  jobReady.notify_all();
+  if (worker.joinable()) {
+    worker.join();
+  }
+}
+
+int ScreenshotWriter::compressionLevelFor(int width, int height) {
+  return static_cast<long>(width) * height > 3840L * 2160L ? PNG_FAST : PNG_DEFAULT;
+}
+
+void ScreenshotWriter::submit(Job job) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    jobs.push_back(std::move(job));
+  }
+  jobReady.notify_one();
+}
+
+void ScreenshotWriter::flush() {
+  std::unique_lock<std::mutex> lock(mutex);
+  jobsDone.wait(lock, [this] { return jobs.empty() && active == 0; });
+}
+
+int ScreenshotWriter::getPendingCount() {
+  std::lock_guard<std::mutex> lock(mutex);
+  return static_cast<int>(jobs.size()) + active;
+}
+
+void ScreenshotWriter::workerLoop() {
+  std::unique_lock<std::mutex> lock(mutex);
+  while (true) {
+    jobReady.wait(lock, [this] { return stopping || !jobs.empty(); });
+    if (jobs.empty()) {
+      return;  // Stopping and drained
+    }
+    Job job = std::move(jobs.front());
+    jobs.pop_front();
+    active++;
+    lock.unlock();
+    write(job);
+    lock.lock();
+    active--;
+    jobsDone.notify_all();
+  }
+}
+
+void ScreenshotWriter::write(Job &job) {
+  auto start = std::chrono::high_resolution_clock::now();
+  const void *pixels = job.pixels.empty() ? nullptr : job.pixels.data();
+  const float *hdrPixels = nullptr;
+  int stride = job.width * 4;
+  int hdrStride = 0;
+  MetalRTCapture capture = {};
+  if (job.renderer) {
+    if (metal_rt_renderer_finish_capture(job.renderer, job.capture, &capture)) {
+      pixels = capture.pixels;
+      hdrPixels = capture.hdrPixels;
+      job.width = capture.width;
+      job.height = capture.height;
+      stride = static_cast<int>(capture.bytesPerRow);
+      hdrStride = static_cast<int>(capture.hdrBytesPerRow);
+    }
+  }
+
+  bool saved = pixels && savePNG(pixels, job.width, job.height, job.path, job.compressionLevel, &pool, stride);
+  bool hdrSaved = true;
+  if (saved && !job.hdrPath.empty()) {
+    hdrSaved = hdrPixels && saveFloatTIFF(hdrPixels, job.width, job.height, job.hdrPath, hdrStride);
+  }
+  if (job.renderer) {
+    metal_rt_renderer_release_capture(job.renderer, job.capture);
+  }
+
+  double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+  std::ostringstream logMsg;
+  if (saved) {
+    logMsg << "[SCREENSHOT] Screenshot saved to: " << job.path << " (" << job.width << "×" << job.height
+           << ", deflate level " << job.compressionLevel << ", " << std::fixed << std::setprecision(0) << ms << " ms)";
+    appLog(logMsg.str());
+  } else {
+    logMsg << "[SCREENSHOT] Failed to save screenshot to: " << job.path;
+    appLog(logMsg.str(), true);
+  }
+  if (!job.hdrPath.empty()) {
+    if (saved && hdrSaved) {
+      appLog("[SCREENSHOT] HDR screenshot saved to: " + job.hdrPath);
+    } else {
+      appLog("[SCREENSHOT] Failed to save HDR screenshot to: " + job.hdrPath, true);
+    }
+  }
+}
@@ -1,4 +1,10 @@
 #include "../../include/utils/VideoRecorder.hpp"
+#include "../../include/utils/SPSCQueue.hpp"
+#include "../../include/utils/AudioEncoder.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
 #include <iostream>
 #include <cstring>
 #include <ctime>
@@ -17,10 +23,25 @@ extern "C" {
 #include <libavformat/avformat.h>
 #include <libavutil/imgutils.h>
 #include <libavutil/opt.h>
+#include <libavutil/dict.h>
 #include <libavutil/error.h>
+#include <libavutil/hwcontext.h>
 #include <libswscale/swscale.h>
 }
 
+// One slot of the encoder queue; the buffers are reused across frames
+struct QueuedFrame {
+  std::vector<uint8_t> pixels; // Software backend: BGRA copy of the frame
+  AVFrame* hwFrame = nullptr;  // Hardware backend: reference to a pooled CVPixelBuffer
+  int64_t pts = 0;
+  std::chrono::steady_clock::time_point queuedAt;
+  
+  QueuedFrame() = default;
+  QueuedFrame(const QueuedFrame&) = delete;
+  QueuedFrame& operator=(const QueuedFrame&) = delete;
+  ~QueuedFrame() { av_frame_free(&hwFrame); }
+};
+
 struct FFmpegContext {
   AVFormatContext* formatContext;
   AVCodecContext* codecContext;
@@ -28,18 +49,77 @@ struct FFmpegContext {
   AVFrame* frame;
   AVPacket* packet;
   SwsContext* swsContext;
-  int frameCount;
+  
+  // Hardware backend: VideoToolbox device and NV12 CVPixelBuffer pool
+  AVBufferRef* hwDeviceContext;
+  AVBufferRef* hwFramesContext;
+  AVFrame* hwFrame; // Frame handed out by acquireHardwareFrame
+  
+  // Live AAC track written by the encoder thread
+  AudioEncoder* audio;
+  
+  // Encoder thread and the frames waiting for it
+  SPSCQueue<QueuedFrame>* queue;
+  std::thread encoderThread;
+  std::atomic<bool> stopEncoder;
+  
+  // Statistics (written by both threads)
+  std::atomic<uint64_t> framesQueued;
+  std::atomic<uint64_t> framesEncoded;
+  std::atomic<uint64_t> framesDropped;
+  std::atomic<uint64_t> encodeMicrosTotal;
+  std::atomic<uint64_t> encodeMicrosMax;
+  std::atomic<uint64_t> latencyMicrosTotal;
+  std::atomic<size_t> maxQueueDepth;
 };
 
+// Muxer for a stream URL; nullptr lets FFmpeg guess from the file name
+static const char* streamFormatFor(const std::string& url) {
+  if (url.rfind("rtmp://", 0) == 0 || url.rfind("rtmps://", 0) == 0) {
+    return "flv";
+  }
+  if (url.rfind("srt://", 0) == 0 || url.rfind("udp://", 0) == 0) {
+    return "mpegts";
+  }
+  return nullptr;
+}
+
+static bool hasSuffix(const std::string& text, const std::string& suffix) {
+  return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+static VideoRecorder::Stats snapshotStats(const FFmpegContext* ctx) {
+  VideoRecorder::Stats stats = {};
+  stats.queueDepth = ctx->queue->size();
+  stats.maxQueueDepth = ctx->maxQueueDepth.load();
+  stats.queueCapacity = ctx->queue->capacity();
+  stats.framesQueued = ctx->framesQueued.load();
+  stats.framesEncoded = ctx->framesEncoded.load();
+  stats.framesDropped = ctx->framesDropped.load();
+  if (stats.framesEncoded > 0) {
+    stats.averageEncodeMs = ctx->encodeMicrosTotal.load() / 1000.0 / stats.framesEncoded;
+    stats.averageLatencyMs = ctx->latencyMicrosTotal.load() / 1000.0 / stats.framesEncoded;
+  }
+  stats.maxEncodeMs = ctx->encodeMicrosMax.load() / 1000.0;
+  return stats;
+}
+
 VideoRecorder::VideoRecorder()
-    : recording(false), filename(""), audioFilePath(""), frameWidth(0), frameHeight(0), frameRate(60), ffmpegContext(nullptr) {
+    : recording(false), streaming(false), filename(""), audioFilePath(""), frameWidth(0), frameHeight(0), frameRate(60),
+      backend(Backend::Software), queuePolicy(QueuePolicy::Degrade), queueCapacity(6), nextPts(0),
+      ffmpegContext(nullptr), finalStats() {
 }
 
 VideoRecorder::~VideoRecorder() {
   stopRecording();
 }
 
-bool VideoRecorder::startRecording(const std::string& file, int width, int height, int fps, const std::string& audioFile) {
+bool VideoRecorder::isStreamURL(const std::string& output) {
+  return streamFormatFor(output) != nullptr || hasSuffix(output, ".m3u8");
+}
+
+bool VideoRecorder::startRecording(const std::string& file, int width, int height, int fps, const std::string& audioFile,
+                                   Backend requestedBackend) {
   if (recording) {
     std::cerr << "Already recording!" << std::endl;
     return false;
@@ -50,6 +130,7 @@ bool VideoRecorder::startRecording(const std::string& file, int width, int heigh
   frameWidth = width;
   frameHeight = height;
   frameRate = fps;
+  backend = requestedBackend;
   
   // Generate filename with timestamp if not provided
   if (filename.empty()) {
@@ -60,10 +141,11 @@ bool VideoRecorder::startRecording(const std::string& file, int width, int heigh
         << std::put_time(&tm, "%Y%m%d_%H%M%S") << ".mp4";
     filename = oss.str();
   }
+  streaming = isStreamURL(filename);
   
   // Log the filename being used (for debugging)
   std::ostringstream logMsg;
-  logMsg << "[FFMPEG] Recording filename: " << filename;
+  logMsg << (streaming ? "[FFMPEG] Streaming to: " : "[FFMPEG] Recording filename: ") << filename;
   if (!audioFilePath.empty()) {
     logMsg << " (with audio from " << audioFilePath << ")";
   }
@@ -71,6 +153,12 @@ bool VideoRecorder::startRecording(const std::string& file, int width, int heigh
   
   // Initialize encoder first, only set recording flag if successful
   if (initializeEncoder()) {
+    FFmpegContext* ctx = static_cast<FFmpegContext*>(ffmpegContext);
+    ctx->queue = new SPSCQueue<QueuedFrame>(queueCapacity);
+    nextPts = 0;
+    streamStart = std::chrono::steady_clock::now();
+    finalStats = {};
+    ctx->encoderThread = std::thread(&VideoRecorder::encoderLoop, this);
     recording = true;
     return true;
   } else {
@@ -87,11 +175,24 @@ bool VideoRecorder::initializeEncoder() {
   ctx->frame = nullptr;
   ctx->packet = nullptr;
   ctx->swsContext = nullptr;
-  ctx->frameCount = 0;
+  ctx->hwDeviceContext = nullptr;
+  ctx->hwFramesContext = nullptr;
+  ctx->hwFrame = nullptr;
+  ctx->queue = nullptr;
+  ctx->audio = nullptr;
   ffmpegContext = ctx;
   
+  if (streaming) {
+    static bool networkInitialized = false;
+    if (!networkInitialized) {
+      avformat_network_init();
+      networkInitialized = true;
+    }
+  }
+  
   // Allocate format context
-  int ret = avformat_alloc_output_context2(&ctx->formatContext, nullptr, nullptr, filename.c_str());
+  int ret = avformat_alloc_output_context2(&ctx->formatContext, nullptr, streamFormatFor(filename),
+                                           filename.c_str());
   if (ret < 0 || !ctx->formatContext) {
     char errbuf[AV_ERROR_MAX_STRING_SIZE];
     av_strerror(ret, errbuf, AV_ERROR_MAX_STRING_SIZE);
@@ -103,13 +204,21 @@ bool VideoRecorder::initializeEncoder() {
     return false;
   }
   
-  // Find H.264 encoder - prefer libx264 software encoder (more reliable than VideoToolbox)
-  // Try to find libx264 explicitly first
+  // Find H.264 encoder - the hardware backend needs VideoToolbox; the software
+  // backend prefers libx264 (more reliable than VideoToolbox with CPU frames)
   const AVCodec* codec = nullptr;
+  if (backend == Backend::Hardware) {
+    codec = avcodec_find_encoder_by_name("h264_videotoolbox");
+    if (!codec) {
+      appLog("[FFMPEG] h264_videotoolbox not available for hardware recording", true);
+      cleanupEncoder();
+      return false;
+    }
+  }
   
   // List all available H.264 encoders to find libx264
   void* iter = nullptr;
-  while (true) {
+  while (!codec) {
     const AVCodec* c = av_codec_iterate(&iter);
     if (!c) break;
     if (c->id == AV_CODEC_ID_H264 && av_codec_is_encoder(c)) {
@@ -165,12 +274,16 @@ bool VideoRecorder::initializeEncoder() {
   bool isVideoToolbox = (strcmp(codec->name, "h264_videotoolbox") == 0);
   
   if (strcmp(codec->name, "libx264") == 0) {
-    // libx264 supports preset and crf
-    ctx->codecContext->gop_size = 10;
-    ctx->codecContext->max_b_frames = 1;
-    if (av_opt_set(ctx->codecContext->priv_data, "preset", "medium", 0) < 0) {
+    // libx264 supports preset and crf. Streams: no lookahead or B-frames, and a
+    // keyframe every 2 s so viewers can join and HLS can cut segments
+    ctx->codecContext->gop_size = streaming ? frameRate * 2 : 10;
+    ctx->codecContext->max_b_frames = streaming ? 0 : 1;
+    if (av_opt_set(ctx->codecContext->priv_data, "preset", streaming ? "veryfast" : "medium", 0) < 0) {
       std::cerr << "Warning: Could not set preset" << std::endl;
     }
+    if (streaming && av_opt_set(ctx->codecContext->priv_data, "tune", "zerolatency", 0) < 0) {
+      std::cerr << "Warning: Could not set zerolatency tune" << std::endl;
+    }
     if (av_opt_set(ctx->codecContext->priv_data, "crf", "23", 0) < 0) {
       std::cerr << "Warning: Could not set CRF" << std::endl;
     }
@@ -179,12 +292,13 @@ bool VideoRecorder::initializeEncoder() {
     // set bitrate properties internally. We need to work around this.
     
     // Set basic codec parameters
-    ctx->codecContext->gop_size = 0; // Let VideoToolbox decide
+    ctx->codecContext->gop_size = streaming ? frameRate * 2 : 0; // Let VideoToolbox decide (files)
     ctx->codecContext->max_b_frames = 0; // VideoToolbox doesn't support B-frames well
     
     // Set profile to baseline to avoid advanced features
+    // GPU frames (typically 4K) need a higher level than 4.0; let VideoToolbox pick it
     ctx->codecContext->profile = FF_PROFILE_H264_BASELINE;
-    ctx->codecContext->level = 40;
+    ctx->codecContext->level = backend == Backend::Hardware ? FF_LEVEL_UNKNOWN : 40;
     
     // Try setting a reasonable bitrate to avoid the error
     // VideoToolbox seems to require bitrate to be set, so set it explicitly
@@ -223,6 +337,11 @@ bool VideoRecorder::initializeEncoder() {
     
     std::cout << "VideoToolbox: Using bitrate " << (targetBitrate / 1000000) << " Mbps for " 
               << frameWidth << "×" << frameHeight << "@" << frameRate << "fps" << std::endl;
+    
+    if (backend == Backend::Hardware && !initializeHardwareFrames()) {
+      cleanupEncoder();
+      return false;
+    }
   } else {
     // For other encoders, try generic options
     ctx->codecContext->gop_size = 10;
@@ -230,6 +349,11 @@ bool VideoRecorder::initializeEncoder() {
     av_opt_set(ctx->codecContext->priv_data, "crf", "23", 0);
   }
   
+  // FLV, MP4 and fMP4 want SPS/PPS in the stream header rather than in-band
+  if (ctx->formatContext->oformat->flags & AVFMT_GLOBALHEADER) {
+    ctx->codecContext->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+  }
+  
   // Open codec
   ret = avcodec_open2(ctx->codecContext, codec, nullptr);
   if (ret < 0) {
@@ -260,7 +384,17 @@ bool VideoRecorder::initializeEncoder() {
   ctx->videoStream->time_base = {1, frameRate};
   avcodec_parameters_from_context(ctx->videoStream->codecpar, ctx->codecContext);
   
-  // Open output file
+  // The music is encoded live and interleaved with the video; nothing is remuxed afterwards
+  if (!audioFilePath.empty()) {
+    ctx->audio = new AudioEncoder();
+    if (!ctx->audio->open(audioFilePath, ctx->formatContext)) {
+      appLog(streaming ? "[FFMPEG] Streaming without audio" : "[FFMPEG] Recording without audio", true);
+      delete ctx->audio;
+      ctx->audio = nullptr;
+    }
+  }
+  
+  // Open output file (or connect to the stream URL)
   if (!(ctx->formatContext->oformat->flags & AVFMT_NOFILE)) {
     ret = avio_open(&ctx->formatContext->pb, filename.c_str(), AVIO_FLAG_WRITE);
     if (ret < 0) {
@@ -276,7 +410,27 @@ bool VideoRecorder::initializeEncoder() {
   }
   
   // Write header
-  ret = avformat_write_header(ctx->formatContext, nullptr);
+  AVDictionary* muxerOptions = nullptr;
+  if (streaming && strcmp(ctx->formatContext->oformat->name, "hls") == 0) {
+    av_dict_set(&muxerOptions, "hls_time", "2", 0);
+    av_dict_set(&muxerOptions, "hls_list_size", "6", 0);
+    av_dict_set(&muxerOptions, "hls_segment_type", "fmp4", 0);
+    av_dict_set(&muxerOptions, "hls_flags", "delete_segments+independent_segments", 0);
+  } else if (streaming && strcmp(ctx->formatContext->oformat->name, "flv") == 0) {
+    av_dict_set(&muxerOptions, "flvflags", "no_duration_filesize", 0);
+  } else if (strcmp(ctx->formatContext->oformat->name, "mp4") == 0 ||
+             strcmp(ctx->formatContext->oformat->name, "mov") == 0) {
+    // Fragmented MP4: a fragment at least every second, so a crash loses at
+    // most the last one and the trailer doesn't have to rewrite the file
+    av_dict_set(&muxerOptions, "movflags", "frag_keyframe+empty_moov+default_base_moof", 0);
+    av_dict_set(&muxerOptions, "frag_duration", "1000000", 0);
+  }
+  if (streaming) {
+    // Hand every packet to the network as soon as it is muxed
+    ctx->formatContext->flags |= AVFMT_FLAG_FLUSH_PACKETS;
+  }
+  ret = avformat_write_header(ctx->formatContext, &muxerOptions);
+  av_dict_free(&muxerOptions);
   if (ret < 0) {
     char errbuf[AV_ERROR_MAX_STRING_SIZE];
     av_strerror(ret, errbuf, AV_ERROR_MAX_STRING_SIZE);
@@ -288,6 +442,27 @@ bool VideoRecorder::initializeEncoder() {
     return false;
   }
   
+  // Allocate packet
+  ctx->packet = av_packet_alloc();
+  if (!ctx->packet) {
+    std::cerr << "Could not allocate packet" << std::endl;
+    cleanupEncoder();
+    return false;
+  }
+  
+  if (backend == Backend::Hardware) {
+    // Frames come from the hw_frames_ctx pool; no CPU frame or swscale needed
+    ctx->hwFrame = av_frame_alloc();
+    if (!ctx->hwFrame) {
+      std::cerr << "Could not allocate hardware frame" << std::endl;
+      cleanupEncoder();
+      return false;
+    }
+    std::cout << "Started hardware recording to: " << filename << " (" << frameWidth << "×" << frameHeight
+              << "@" << frameRate << "fps, GPU NV12 -> VideoToolbox)" << std::endl;
+    return true;
+  }
+  
   // Allocate frame
   ctx->frame = av_frame_alloc();
   if (!ctx->frame) {
@@ -306,14 +481,6 @@ bool VideoRecorder::initializeEncoder() {
     return false;
   }
   
-  // Allocate packet
-  ctx->packet = av_packet_alloc();
-  if (!ctx->packet) {
-    std::cerr << "Could not allocate packet" << std::endl;
-    cleanupEncoder();
-    return false;
-  }
-  
   // Initialize swscale context for BGRA to YUV conversion
   // Metal returns BGRA format (B=byte0, G=byte1, R=byte2, A=byte3)
   ctx->swsContext = sws_getContext(
@@ -332,35 +499,53 @@ bool VideoRecorder::initializeEncoder() {
   return true;
 }
 
-bool VideoRecorder::addFrame(const void* pixels, int width, int height) {
-  if (!recording || !ffmpegContext) {
-    return false;
-  }
-  
+bool VideoRecorder::initializeHardwareFrames() {
   FFmpegContext* ctx = static_cast<FFmpegContext*>(ffmpegContext);
   
-  if (width != frameWidth || height != frameHeight) {
-    std::cerr << "Frame size mismatch!" << std::endl;
+  int ret = av_hwdevice_ctx_create(&ctx->hwDeviceContext, AV_HWDEVICE_TYPE_VIDEOTOOLBOX, nullptr, nullptr, 0);
+  if (ret < 0) {
+    char errbuf[AV_ERROR_MAX_STRING_SIZE];
+    av_strerror(ret, errbuf, AV_ERROR_MAX_STRING_SIZE);
+    appLog(std::string("[FFMPEG] Could not create VideoToolbox device: ") + errbuf, true);
     return false;
   }
   
-  // Make frame writable
-  if (av_frame_make_writable(ctx->frame) < 0) {
+  // Pool of IOSurface-backed NV12 CVPixelBuffers; the GPU writes straight into them
+  ctx->hwFramesContext = av_hwframe_ctx_alloc(ctx->hwDeviceContext);
+  if (!ctx->hwFramesContext) {
+    appLog("[FFMPEG] Could not allocate hardware frames context", true);
+    return false;
+  }
+  AVHWFramesContext* frames = reinterpret_cast<AVHWFramesContext*>(ctx->hwFramesContext->data);
+  frames->format = AV_PIX_FMT_VIDEOTOOLBOX;
+  frames->sw_format = AV_PIX_FMT_NV12;
+  frames->width = frameWidth;
+  frames->height = frameHeight;
+  ret = av_hwframe_ctx_init(ctx->hwFramesContext);
+  if (ret < 0) {
+    char errbuf[AV_ERROR_MAX_STRING_SIZE];
+    av_strerror(ret, errbuf, AV_ERROR_MAX_STRING_SIZE);
+    appLog(std::string("[FFMPEG] Could not initialize hardware frames: ") + errbuf, true);
     return false;
   }
   
-  // Convert ARGB8888 to YUV420P
-  const uint8_t* srcData[1] = {static_cast<const uint8_t*>(pixels)};
-  int srcLinesize[1] = {width * 4}; // ARGB = 4 bytes per pixel
-  
-  sws_scale(ctx->swsContext, srcData, srcLinesize, 0, height,
-            ctx->frame->data, ctx->frame->linesize);
+  ctx->codecContext->pix_fmt = AV_PIX_FMT_VIDEOTOOLBOX;
+  ctx->codecContext->sw_pix_fmt = AV_PIX_FMT_NV12;
+  ctx->codecContext->hw_frames_ctx = av_buffer_ref(ctx->hwFramesContext);
   
-  // Set frame timestamp
-  ctx->frame->pts = ctx->frameCount++;
+  // Matches the bgra_to_nv12 kernel
+  ctx->codecContext->color_range = AVCOL_RANGE_MPEG;
+  ctx->codecContext->colorspace = AVCOL_SPC_BT709;
+  ctx->codecContext->color_primaries = AVCOL_PRI_BT709;
+  ctx->codecContext->color_trc = AVCOL_TRC_BT709;
+  return ctx->codecContext->hw_frames_ctx != nullptr;
+}
+
+bool VideoRecorder::encodeFrame(AVFrame* frame) {
+  FFmpegContext* ctx = static_cast<FFmpegContext*>(ffmpegContext);
   
   // Encode frame
-  int ret = avcodec_send_frame(ctx->codecContext, ctx->frame);
+  int ret = avcodec_send_frame(ctx->codecContext, frame);
   if (ret < 0) {
     char errbuf[AV_ERROR_MAX_STRING_SIZE];
     av_strerror(ret, errbuf, AV_ERROR_MAX_STRING_SIZE);
@@ -392,6 +577,189 @@ bool VideoRecorder::addFrame(const void* pixels, int width, int height) {
   return true;
 }
 
+bool VideoRecorder::admitFrame() {
+  FFmpegContext* ctx = static_cast<FFmpegContext*>(ffmpegContext);
+  SPSCQueue<QueuedFrame>* queue = ctx->queue;
+  int64_t pts = nextPts;
+  if (streaming) {
+    // Live streams follow the wall clock, so the timeline stays in real time
+    // when the render rate differs from frameRate. A frame that arrives before
+    // its tick has passed is skipped rather than pushing the stream ahead
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - streamStart).count();
+    int64_t wallPts = static_cast<int64_t>(elapsed * frameRate);
+    if (wallPts < nextPts) {
+      return false;
+    }
+    pts = wallPts;
+  }
+  nextPts = pts + 1;
+  
+  bool admit = true;
+  switch (queuePolicy) {
+    case QueuePolicy::Block:
+      queue->waitForSpace();
+      break;
+    case QueuePolicy::Drop:
+      admit = !queue->full();
+      break;
+    case QueuePolicy::Degrade:
+      // Falling behind: halve the recorded frame rate before losing runs of frames
+      admit = !queue->full() && (queue->size() < queue->capacity() / 2 || (pts % 2) == 0);
+      break;
+  }
+  if (!admit) {
+    ctx->framesDropped++;
+    return false;
+  }
+  
+  QueuedFrame* slot = queue->producerSlot();
+  slot->pts = pts;
+  slot->queuedAt = std::chrono::steady_clock::now();
+  return true;
+}
+
+void VideoRecorder::encoderLoop() {
+  FFmpegContext* ctx = static_cast<FFmpegContext*>(ffmpegContext);
+  
+  while (true) {
+    QueuedFrame* item = ctx->queue->front();
+    if (!item) {
+      // Drain everything that was queued before stopRecording
+      if (ctx->stopEncoder.load(std::memory_order_acquire)) {
+        break;
+      }
+      ctx->queue->waitForData([ctx] { return ctx->stopEncoder.load(std::memory_order_acquire); });
+      continue;
+    }
+    
+    auto start = std::chrono::steady_clock::now();
+    if (backend == Backend::Hardware) {
+      item->hwFrame->pts = item->pts;
+      encodeFrame(item->hwFrame);
+      av_frame_unref(item->hwFrame);
+    } else if (av_frame_make_writable(ctx->frame) >= 0) {
+      // Convert ARGB8888 to YUV420P
+      const uint8_t* srcData[1] = {item->pixels.data()};
+      int srcLinesize[1] = {frameWidth * 4}; // ARGB = 4 bytes per pixel
+      sws_scale(ctx->swsContext, srcData, srcLinesize, 0, frameHeight,
+                ctx->frame->data, ctx->frame->linesize);
+      ctx->frame->pts = item->pts;
+      encodeFrame(ctx->frame);
+    }
+    if (ctx->audio) {
+      // Keep the live audio just ahead of the video that has been written
+      ctx->audio->writeUntil(static_cast<double>(item->pts + 1) / frameRate);
+    }
+    auto end = std::chrono::steady_clock::now();
+    
+    uint64_t encodeMicros = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+    uint64_t latencyMicros = std::chrono::duration_cast<std::chrono::microseconds>(end - item->queuedAt).count();
+    ctx->encodeMicrosTotal += encodeMicros;
+    ctx->latencyMicrosTotal += latencyMicros;
+    if (encodeMicros > ctx->encodeMicrosMax.load(std::memory_order_relaxed)) {
+      ctx->encodeMicrosMax.store(encodeMicros, std::memory_order_relaxed);
+    }
+    ctx->framesEncoded++;
+    ctx->queue->pop();
+  }
+}
+
+VideoRecorder::Stats VideoRecorder::getStats() const {
+  const FFmpegContext* ctx = static_cast<const FFmpegContext*>(ffmpegContext);
+  if (!recording || !ctx || !ctx->queue) {
+    return finalStats;
+  }
+  return snapshotStats(ctx);
+}
+
+void* VideoRecorder::acquireHardwareFrame() {
+  if (!recording || !ffmpegContext || backend != Backend::Hardware) {
+    return nullptr;
+  }
+  
+  // Decide before the GPU spends time filling a frame the queue would reject
+  if (!admitFrame()) {
+    return nullptr;
+  }
+  
+  FFmpegContext* ctx = static_cast<FFmpegContext*>(ffmpegContext);
+  av_frame_unref(ctx->hwFrame);
+  if (av_hwframe_get_buffer(ctx->hwFramesContext, ctx->hwFrame, 0) < 0) {
+    std::cerr << "Could not get a hardware frame from the pool" << std::endl;
+    cancelHardwareFrame();
+    return nullptr;
+  }
+  // AV_PIX_FMT_VIDEOTOOLBOX frames carry their CVPixelBufferRef in data[3]
+  return ctx->hwFrame->data[3];
+}
+
+bool VideoRecorder::submitHardwareFrame() {
+  if (!recording || !ffmpegContext || backend != Backend::Hardware) {
+    return false;
+  }
+  
+  FFmpegContext* ctx = static_cast<FFmpegContext*>(ffmpegContext);
+  // acquireHardwareFrame admitted the frame, so the producer slot is free
+  QueuedFrame* slot = ctx->queue->producerSlot();
+  if (!ctx->hwFrame->data[3] || !slot) {
+    av_frame_unref(ctx->hwFrame);
+    return false;
+  }
+  if (!slot->hwFrame) {
+    slot->hwFrame = av_frame_alloc();
+    if (!slot->hwFrame) {
+      av_frame_unref(ctx->hwFrame);
+      return false;
+    }
+  }
+  // Hand the CVPixelBuffer reference to the encoder thread
+  av_frame_move_ref(slot->hwFrame, ctx->hwFrame);
+  ctx->queue->push();
+  ctx->framesQueued++;
+  ctx->maxQueueDepth.store(std::max(ctx->maxQueueDepth.load(), ctx->queue->size()));
+  return true;
+}
+
+void VideoRecorder::cancelHardwareFrame() {
+  if (!recording || !ffmpegContext || backend != Backend::Hardware) {
+    return;
+  }
+  
+  FFmpegContext* ctx = static_cast<FFmpegContext*>(ffmpegContext);
+  // Back to the pool, and the next frame takes over the reserved pts
+  av_frame_unref(ctx->hwFrame);
+  if (QueuedFrame* slot = ctx->queue->producerSlot()) {
+    nextPts = slot->pts;
+  }
+}
+
+bool VideoRecorder::addFrame(const void* pixels, int width, int height) {
+  if (!recording || !ffmpegContext || backend != Backend::Software) {
+    return false;
+  }
+  
+  FFmpegContext* ctx = static_cast<FFmpegContext*>(ffmpegContext);
+  
+  if (width != frameWidth || height != frameHeight) {
+    std::cerr << "Frame size mismatch!" << std::endl;
+    return false;
+  }
+  
+  if (!admitFrame()) {
+    return false;
+  }
+  
+  // Copy into the pooled slot buffer (its capacity is reused); the encoder
+  // thread does the colour conversion
+  QueuedFrame* slot = ctx->queue->producerSlot();
+  const uint8_t* src = static_cast<const uint8_t*>(pixels);
+  slot->pixels.assign(src, src + static_cast<size_t>(width) * height * 4);
+  ctx->queue->push();
+  ctx->framesQueued++;
+  ctx->maxQueueDepth.store(std::max(ctx->maxQueueDepth.load(), ctx->queue->size()));
+  return true;
+}
+
 void VideoRecorder::stopRecording() {
   if (!recording) {
     return;
@@ -399,21 +767,26 @@ void VideoRecorder::stopRecording() {
   
   FFmpegContext* ctx = static_cast<FFmpegContext*>(ffmpegContext);
   
+  if (ctx && ctx->encoderThread.joinable()) {
+    // Let the encoder thread drain the queue before flushing
+    ctx->stopEncoder.store(true, std::memory_order_release);
+    ctx->queue->wakeConsumer();
+    ctx->encoderThread.join();
+    
+    finalStats = snapshotStats(ctx);
+    std::ostringstream statsMsg;
+    statsMsg << "[FFMPEG] Encoded " << finalStats.framesEncoded << " frames, dropped " << finalStats.framesDropped
+             << ", encode avg " << std::fixed << std::setprecision(2) << finalStats.averageEncodeMs
+             << " ms / max " << finalStats.maxEncodeMs << " ms, latency avg " << finalStats.averageLatencyMs
+             << " ms, max queue depth " << finalStats.maxQueueDepth << "/" << finalStats.queueCapacity;
+    appLog(statsMsg.str());
+  }
+  
   if (ctx && ctx->codecContext) {
     // Flush encoder
-    int ret = avcodec_send_frame(ctx->codecContext, nullptr);
-    while (ret >= 0) {
-      ret = avcodec_receive_packet(ctx->codecContext, ctx->packet);
-      if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
-        break;
-      } else if (ret < 0) {
-        break;
-      }
-      
-      av_packet_rescale_ts(ctx->packet, ctx->codecContext->time_base, ctx->videoStream->time_base);
-      ctx->packet->stream_index = ctx->videoStream->index;
-      av_interleaved_write_frame(ctx->formatContext, ctx->packet);
-      av_packet_unref(ctx->packet);
+    encodeFrame(nullptr);
+    if (ctx->audio) {
+      ctx->audio->finish(static_cast<double>(nextPts) / frameRate);
     }
     
     // Write trailer
@@ -423,30 +796,15 @@ void VideoRecorder::stopRecording() {
     appLog("[FFMPEG] Video encoding complete");
   }
   
+  // The audio was interleaved while recording, so the file is already complete
+  bool liveAudio = ctx && ctx->audio;
   cleanupEncoder();
   recording = false;
   
-  // Mux audio with video if audio file was provided
-  if (!audioFilePath.empty()) {
-    std::cout << "\n========================================" << std::endl;
-    std::cout << "Mixing audio into video..." << std::endl;
-    std::cout << "Video file: " << filename << std::endl;
-    std::cout << "Audio file: " << audioFilePath << std::endl;
-    std::cout << "========================================" << std::endl;
-    appLog("[FFMPEG] Muxing audio with video...");
-    
-    if (muxAudioWithVideo()) {
-      std::cout << "✓ Audio mixed successfully!" << std::endl;
-      appLog("[FFMPEG] Audio muxing complete");
-    } else {
-      std::cerr << "✗ Failed to mix audio with video" << std::endl;
-      appLog("[FFMPEG] Audio muxing failed (video saved without audio)", true);
-    }
+  if (streaming) {
+    appLog(liveAudio ? "[FFMPEG] Stream ended (with live audio)" : "[FFMPEG] Stream ended");
   } else {
-    std::cout << "\n========================================" << std::endl;
-    std::cout << "No audio file provided - video saved without audio" << std::endl;
-    std::cout << "========================================" << std::endl;
-    appLog("[FFMPEG] No audio file - video only");
+    appLog(liveAudio ? "[FFMPEG] Video saved with audio" : "[FFMPEG] Video saved without audio");
   }
 }
 
@@ -505,6 +863,20 @@ void VideoRecorder::cleanupEncoder() {
   FFmpegContext* ctx = static_cast<FFmpegContext*>(ffmpegContext);
   
   if (ctx) {
+    if (ctx->encoderThread.joinable()) {
+      ctx->stopEncoder.store(true, std::memory_order_release);
+      ctx->queue->wakeConsumer();
+      ctx->encoderThread.join();
+    }
+    
+    // Releases the pooled buffers (and any frame references still queued)
+    delete ctx->queue;
+    ctx->queue = nullptr;
+    
+    // Its stream belongs to the format context, freed below
+    delete ctx->audio;
+    ctx->audio = nullptr;
+    
     if (ctx->swsContext) {
       sws_freeContext(ctx->swsContext);
       ctx->swsContext = nullptr;
@@ -518,10 +890,17 @@ void VideoRecorder::cleanupEncoder() {
       av_frame_free(&ctx->frame);
     }
     
+    if (ctx->hwFrame) {
+      av_frame_free(&ctx->hwFrame);
+    }
+    
     if (ctx->codecContext) {
       avcodec_free_context(&ctx->codecContext);
     }
     
+    av_buffer_unref(&ctx->hwFramesContext);
+    av_buffer_unref(&ctx->hwDeviceContext);
+    
     if (ctx->formatContext) {
       if (!(ctx->formatContext->oformat->flags & AVFMT_NOFILE)) {
         avio_closep(&ctx->formatContext->pb);
@@ -533,209 +912,3 @@ void VideoRecorder::cleanupEncoder() {
     ffmpegContext = nullptr;
   }
 }
-
-bool VideoRecorder::muxAudioWithVideo() {
-  std::cout << "[MUXING] Starting audio muxing using vcpkg FFmpeg libraries..." << std::endl;
-  appLog("[FFMPEG] Starting audio muxing using vcpkg FFmpeg libraries...");
-  
-  std::string tempFilename = filename + ".temp.mp4";
-  
-  AVFormatContext* videoInputCtx = nullptr;
-  AVFormatContext* audioInputCtx = nullptr;
-  AVFormatContext* outputCtx = nullptr;
-  int ret;
-  
-  // Open video input
-  std::cout << "[MUXING] Opening video file: " << filename << std::endl;
-  ret = avformat_open_input(&videoInputCtx, filename.c_str(), nullptr, nullptr);
-  if (ret < 0) {
-    char errbuf[AV_ERROR_MAX_STRING_SIZE];
-    av_strerror(ret, errbuf, AV_ERROR_MAX_STRING_SIZE);
-    std::cerr << "[MUXING ERROR] Could not open video: " << errbuf << std::endl;
-    appLog("[FFMPEG] Could not open video input", true);
-    return false;
-  }
-  avformat_find_stream_info(videoInputCtx, nullptr);
-  std::cout << "[MUXING] Video file opened successfully" << std::endl;
-  
-  // Open audio input
-  std::cout << "[MUXING] Opening audio file: " << audioFilePath << std::endl;
-  ret = avformat_open_input(&audioInputCtx, audioFilePath.c_str(), nullptr, nullptr);
-  if (ret < 0) {
-    char errbuf[AV_ERROR_MAX_STRING_SIZE];
-    av_strerror(ret, errbuf, AV_ERROR_MAX_STRING_SIZE);
-    std::cerr << "[MUXING ERROR] Could not open audio: " << errbuf << std::endl;
-    appLog("[FFMPEG] Could not open audio input", true);
-    avformat_close_input(&videoInputCtx);
-    return false;
-  }
-  avformat_find_stream_info(audioInputCtx, nullptr);
-  std::cout << "[MUXING] Audio file opened successfully" << std::endl;
-  
-  // Create output
-  avformat_alloc_output_context2(&outputCtx, nullptr, nullptr, tempFilename.c_str());
-  if (!outputCtx) {
-    appLog("[FFMPEG] Could not create output context", true);
-    avformat_close_input(&videoInputCtx);
-    avformat_close_input(&audioInputCtx);
-    return false;
-  }
-  
-  // Map streams
-  int videoStreamIdx = -1;
-  int audioStreamIdx = -1;
-  int streamMapping[2] = {-1, -1};
-  
-  // Add video stream to output
-  for (unsigned int i = 0; i < videoInputCtx->nb_streams; i++) {
-    if (videoInputCtx->streams[i]->codecpar->codec_type == AVMEDIA_TYPE_VIDEO) {
-      AVStream* outStream = avformat_new_stream(outputCtx, nullptr);
-      avcodec_parameters_copy(outStream->codecpar, videoInputCtx->streams[i]->codecpar);
-      outStream->codecpar->codec_tag = 0;
-      outStream->time_base = videoInputCtx->streams[i]->time_base;
-      videoStreamIdx = i;
-      streamMapping[0] = outStream->index;
-      break;
-    }
-  }
-  
-  // Add audio stream to output
-  for (unsigned int i = 0; i < audioInputCtx->nb_streams; i++) {
-    if (audioInputCtx->streams[i]->codecpar->codec_type == AVMEDIA_TYPE_AUDIO) {
-      AVStream* outStream = avformat_new_stream(outputCtx, nullptr);
-      avcodec_parameters_copy(outStream->codecpar, audioInputCtx->streams[i]->codecpar);
-      outStream->codecpar->codec_tag = 0;
-      
-      // Explicitly set channel layout for MP4 compatibility
-      if (outStream->codecpar->ch_layout.nb_channels == 2) {
-        av_channel_layout_default(&outStream->codecpar->ch_layout, 2); // Stereo
-        std::cout << "[MUXING] Set audio to stereo channel layout" << std::endl;
-      } else if (outStream->codecpar->ch_layout.nb_channels == 1) {
-        av_channel_layout_default(&outStream->codecpar->ch_layout, 1); // Mono
-        std::cout << "[MUXING] Set audio to mono channel layout" << std::endl;
-      }
-      
-      outStream->time_base = audioInputCtx->streams[i]->time_base;
-      audioStreamIdx = i;
-      streamMapping[1] = outStream->index;
-      break;
-    }
-  }
-  
-  // Open output file
-  if (!(outputCtx->oformat->flags & AVFMT_NOFILE)) {
-    ret = avio_open(&outputCtx->pb, tempFilename.c_str(), AVIO_FLAG_WRITE);
-    if (ret < 0) {
-      appLog("[FFMPEG] Could not open output file", true);
-      avformat_free_context(outputCtx);
-      avformat_close_input(&videoInputCtx);
-      avformat_close_input(&audioInputCtx);
-      return false;
-    }
-  }
-  
-  // Write header
-  ret = avformat_write_header(outputCtx, nullptr);
-  if (ret < 0) {
-    appLog("[FFMPEG] Failed to write header", true);
-    avio_closep(&outputCtx->pb);
-    avformat_free_context(outputCtx);
-    avformat_close_input(&videoInputCtx);
-    avformat_close_input(&audioInputCtx);
-    return false;
-  }
-  
-  // Get video duration in seconds
-  double videoDuration = (double)videoInputCtx->streams[videoStreamIdx]->duration * 
-                         av_q2d(videoInputCtx->streams[videoStreamIdx]->time_base);
-  if (videoDuration <= 0) {
-    // Try to get duration from format context
-    videoDuration = (double)videoInputCtx->duration / AV_TIME_BASE;
-  }
-  std::cout << "[MUXING] Video duration: " << videoDuration << " seconds" << std::endl;
-  
-  // Interleave packets based on timestamps
-  AVPacket* pkt = av_packet_alloc();
-  bool videoEOF = false;
-  bool audioEOF = false;
-  
-  while (!videoEOF || !audioEOF) {
-    // Determine which stream to read from based on timestamps
-    bool readVideo = false;
-    
-    if (!videoEOF && !audioEOF) {
-      // Both streams available - read based on timestamps
-      int64_t videoPTS = videoEOF ? INT64_MAX : 0;
-      int64_t audioPTS = audioEOF ? INT64_MAX : 0;
-      
-      // Compare timestamps to decide which to read
-      readVideo = (videoPTS <= audioPTS);
-    } else {
-      readVideo = !videoEOF;
-    }
-    
-    if (readVideo && !videoEOF) {
-      ret = av_read_frame(videoInputCtx, pkt);
-      if (ret < 0) {
-        videoEOF = true;
-        continue;
-      }
-      
-      if (pkt->stream_index == videoStreamIdx) {
-        pkt->stream_index = streamMapping[0];
-        av_packet_rescale_ts(pkt, videoInputCtx->streams[videoStreamIdx]->time_base,
-                            outputCtx->streams[streamMapping[0]]->time_base);
-        pkt->pos = -1;
-        av_interleaved_write_frame(outputCtx, pkt);
-      }
-      av_packet_unref(pkt);
-    } else if (!audioEOF) {
-      ret = av_read_frame(audioInputCtx, pkt);
-      if (ret < 0) {
-        audioEOF = true;
-        continue;
-      }
-      
-      if (pkt->stream_index == audioStreamIdx) {
-        // Calculate audio packet timestamp in seconds
-        double audioPTS_sec = (double)pkt->pts * av_q2d(audioInputCtx->streams[audioStreamIdx]->time_base);
-        
-        // Only write audio packets that fall within video duration
-        if (audioPTS_sec <= videoDuration) {
-          pkt->stream_index = streamMapping[1];
-          av_packet_rescale_ts(pkt, audioInputCtx->streams[audioStreamIdx]->time_base,
-                              outputCtx->streams[streamMapping[1]]->time_base);
-          pkt->pos = -1;
-          av_interleaved_write_frame(outputCtx, pkt);
-        } else {
-          // Audio packet is beyond video duration - stop reading audio
-          std::cout << "[MUXING] Audio trimmed at " << audioPTS_sec << "s (video ends at " << videoDuration << "s)" << std::endl;
-          audioEOF = true;
-        }
-      }
-      av_packet_unref(pkt);
-    }
-  }
-  
-  // Write trailer and cleanup
-  av_write_trailer(outputCtx);
-  av_packet_free(&pkt);
-  avio_closep(&outputCtx->pb);
-  avformat_free_context(outputCtx);
-  avformat_close_input(&videoInputCtx);
-  avformat_close_input(&audioInputCtx);
-  
-  // Replace original file
-  std::cout << "[MUXING] Replacing original file with muxed version..." << std::endl;
-  if (std::remove(filename.c_str()) != 0 || std::rename(tempFilename.c_str(), filename.c_str()) != 0) {
-    std::cerr << "[MUXING ERROR] Could not replace video file" << std::endl;
-    appLog("[FFMPEG] Could not replace file", true);
-    std::remove(tempFilename.c_str());
-    return false;
-  }
-  
-  std::cout << "[MUXING] ✓ Audio muxing complete!" << std::endl;
-  appLog("[FFMPEG] Audio muxing complete using vcpkg libraries!");
-  return true;
-}
-
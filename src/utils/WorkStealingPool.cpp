@@ -0,0 +1,131 @@
+#include "../../include/utils/WorkStealingPool.hpp"
+#include <algorithm>
+
+namespace {
+uint64_t packRange(uint32_t begin, uint32_t end) {
+  return (static_cast<uint64_t>(end) << 32) | begin;
+}
+
+uint32_t rangeBegin(uint64_t packed) { return static_cast<uint32_t>(packed); }
+uint32_t rangeEnd(uint64_t packed) { return static_cast<uint32_t>(packed >> 32); }
+} // namespace
+
+WorkStealingPool::WorkStealingPool(unsigned threadCount)
+    : ranges(threadCount > 0 ? threadCount : std::max(1u, std::thread::hardware_concurrency())),
+      task(nullptr), generation(0), busyWorkers(0), stopping(false) {
+  for (unsigned i = 1; i < ranges.size(); i++) {
+    workers.emplace_back(&WorkStealingPool::workerLoop, this, i);
+  }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  startSignal.notify_all();
+  for (std::thread &worker : workers) {
+    worker.join();
+  }
+}
+
+void WorkStealingPool::parallelFor(int count, const std::function<void(int)> &body) {
+  if (count <= 0) {
+    return;
+  }
+
+  // Even initial split; stealing evens out the actual cost
+  uint64_t threads = ranges.size();
+  for (uint64_t i = 0; i < threads; i++) {
+    uint32_t begin = static_cast<uint32_t>(count * i / threads);
+    uint32_t end = static_cast<uint32_t>(count * (i + 1) / threads);
+    ranges[i].packed.store(packRange(begin, end), std::memory_order_relaxed);
+  }
+
+  // The mutex publishes the ranges and the task to the workers
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    task = &body;
+    busyWorkers = static_cast<unsigned>(workers.size());
+    generation++;
+  }
+  startSignal.notify_all();
+
+  runTasks(0);
+
+  std::unique_lock<std::mutex> lock(mutex);
+  doneSignal.wait(lock, [this] { return busyWorkers == 0; });
+  task = nullptr;
+}
+
+void WorkStealingPool::workerLoop(unsigned index) {
+  uint64_t seenGeneration = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      startSignal.wait(lock, [&] { return stopping || generation != seenGeneration; });
+      if (stopping) {
+        return;
+      }
+      seenGeneration = generation;
+    }
+
+    runTasks(index);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (--busyWorkers == 0) {
+      doneSignal.notify_one();
+    }
+  }
+}
+
+void WorkStealingPool::runTasks(unsigned index) {
+  const std::function<void(int)> &body = *task;
+  int item;
+  do {
+    while (popFront(index, item)) {
+      body(item);
+    }
+  } while (stealHalf(index));
+}
+
+bool WorkStealingPool::popFront(unsigned index, int &item) {
+  std::atomic<uint64_t> &packed = ranges[index].packed;
+  uint64_t current = packed.load(std::memory_order_acquire);
+  while (true) {
+    uint32_t begin = rangeBegin(current);
+    uint32_t end = rangeEnd(current);
+    if (begin >= end) {
+      return false;
+    }
+    if (packed.compare_exchange_weak(current, packRange(begin + 1, end), std::memory_order_acq_rel,
+                                     std::memory_order_acquire)) {
+      item = static_cast<int>(begin);
+      return true;
+    }
+  }
+}
+
+bool WorkStealingPool::stealHalf(unsigned thief) {
+  unsigned threads = static_cast<unsigned>(ranges.size());
+  for (unsigned offset = 1; offset < threads; offset++) {
+    std::atomic<uint64_t> &victim = ranges[(thief + offset) % threads].packed;
+    uint64_t current = victim.load(std::memory_order_acquire);
+    while (true) {
+      uint32_t begin = rangeBegin(current);
+      uint32_t end = rangeEnd(current);
+      if (begin >= end) {
+        break;  // Nothing left here, try the next thread
+      }
+      // Take the back half (rounded up, so a single remaining item can be taken too)
+      uint32_t split = end - (end - begin + 1) / 2;
+      if (victim.compare_exchange_weak(current, packRange(begin, split), std::memory_order_acq_rel,
+                                       std::memory_order_acquire)) {
+        // Our own range is empty, so nobody else can be taking from it
+        ranges[thief].packed.store(packRange(split, end), std::memory_order_release);
+        return true;
+      }
+    }
+  }
+  return false;
+}